@@ -47,7 +47,7 @@
 #include <stdio.h>
 #include <stdint.h>
 #include <stdbool.h>
-#include <px4/attitude_estimator_bm/matrix.h> //TODO: move matrix.h to somewhere else?
+#include <systemlib/float_vect3.h>
 #include "ardrone_motor_control.h"
 #include <float.h>
 #include <math.h>
@@ -105,6 +105,7 @@ void control_attitude(const struct rc_channels_s *rc, const struct vehicle_attit
 	static float pid_att_lim;
 
 	static bool initialized;
+	static uint32_t param_generation;
 
 	static float_vect3 attitude_setpoint_navigationframe_from_positioncontroller;
 
@@ -157,8 +158,10 @@ void control_attitude(const struct rc_channels_s *rc, const struct vehicle_attit
 		initialized = true;
 	}
 
-	/* load new parameters with lower rate */
-	if (motor_skip_counter % 50 == 0) {
+	/* load new parameters when they have changed */
+	if (param_generation != global_data_parameter_storage->generation) {
+		param_generation = global_data_parameter_storage->generation;
+
 		pid_set_parameters(&yaw_pos_controller,
 				   (max_gas - min_gas) * global_data_parameter_storage->pm.param_values[PARAM_PID_YAWPOS_P],
 				   (max_gas - min_gas) * global_data_parameter_storage->pm.param_values[PARAM_PID_YAWPOS_I],
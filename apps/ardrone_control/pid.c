@@ -1,6 +1,6 @@
 #include "pid.h"
 
-#include <px4/attitude_estimator_bm/matrix.h> //TODO: move matrix.h to somewhere else?
+#include <systemlib/float_vect3.h>
 
 void pid_init(PID_t *pid, float kp, float ki, float kd, float intmax,
 	      uint8_t mode, uint8_t plot_i)
@@ -0,0 +1,363 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2012 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file attitude_ekf.cpp
+ * Attitude EKF, hand-written for the block structure of its matrices.
+ *
+ * The arguments are column-major as in the generated code; internally the
+ * 12x12 matrices are handled as 4x4 arrays of 3x3 blocks. The comments give
+ * the MATLAB the generated code came from.
+ */
+
+#include <string.h>
+
+#include "attitude_ekf.h"
+#include "ldlt.h"
+
+#include <systemlib/matrix.h>
+
+typedef math::Matrix<float, 3, 3> Block;
+typedef math::Vector<float, 3> Vector3;
+
+/** split a 12x12 matrix into blocks */
+static void
+to_blocks(Block b[4][4], const float m[144])
+{
+	for (unsigned bj = 0; bj < 4; bj++)
+		for (unsigned bi = 0; bi < 4; bi++)
+			for (unsigned j = 0; j < 3; j++)
+				for (unsigned i = 0; i < 3; i++)
+					b[bi][bj](i, j) = m[(3 * bi + i) + 12 * (3 * bj + j)];
+}
+
+/** assemble a 12x12 matrix from its upper blocks, mirroring the lower ones */
+static void
+from_upper_blocks(float m[144], Block b[4][4])
+{
+	for (unsigned bj = 0; bj < 4; bj++) {
+		for (unsigned bi = 0; bi < bj; bi++)
+			b[bj][bi] = b[bi][bj].transpose();
+	}
+
+	for (unsigned bj = 0; bj < 4; bj++)
+		for (unsigned bi = 0; bi < 4; bi++)
+			for (unsigned j = 0; j < 3; j++)
+				for (unsigned i = 0; i < 3; i++)
+					m[(3 * bi + i) + 12 * (3 * bj + j)] = b[bi][bj](i, j);
+}
+
+/**
+ * The rotation over dt at rates w.
+ *
+ * R_temp=[1,-dt*w(3),dt*w(2); dt*w(3),1,-dt*w(1); -dt*w(2),dt*w(1),1]
+ * Rt = R_temp'
+ */
+static void
+rate_rotation(float dt, const Vector3 &w, Block &Rt)
+{
+	const float rt[9] = {
+		1.0f, dt * w(2), -dt * w(1),
+		-dt * w(2), 1.0f, dt * w(0),
+		dt * w(1), -dt * w(0), 1.0f
+	};
+
+	Rt = Block(rt);
+}
+
+/**
+ * Cross product matrix for the sensitivity of a rotated vector to the
+ * rates, over dt.
+ *
+ * Ca = acc_temp_mat', Cm = mag_temp_mat'
+ */
+static void
+rate_sensitivity(float dt, const Vector3 &v, Block &C)
+{
+	const float c[9] = {
+		0.0f, -dt * v(2), dt * v(1),
+		dt * v(2), 0.0f, -dt * v(0),
+		-dt * v(1), dt * v(0), 0.0f
+	};
+
+	C = Block(c);
+}
+
+/**
+ * x_apriori=A_pred*x_aposteriori_k, A_pred being A without Ca and Cm.
+ *
+ * x_out may be x_in.
+ */
+static void
+predict_state(const Block &Rt, const float x_in[12], float x_out[12])
+{
+	const Vector3 a(&x_in[0]);
+	const Vector3 m(&x_in[3]);
+	Vector3 a_apriori = Rt * a;
+	Vector3 m_apriori = Rt * m;
+
+	for (unsigned i = 0; i < 3; i++) {
+		x_out[i] = a_apriori(i);
+		x_out[3 + i] = m_apriori(i);
+	}
+
+	if (x_out != x_in) {
+		for (unsigned i = 6; i < 12; i++)
+			x_out[i] = x_in[i];
+	}
+}
+
+/**
+ * P_apriori=A_lin*P_aposteriori_k*A_lin'+Q
+ *
+ * Only the first two block rows of A differ from the identity, so
+ * X = A*P only changes those rows; and as the result is symmetric only
+ * its upper blocks are computed. Q is added q_steps times.
+ *
+ * P_out may be P_in.
+ */
+static void
+predict_covariance(const Block &Rt, const Block &Ca, const Block &Cm, const float P_in[144],
+		   const float knownConst[7], float q_steps, float P_out[144])
+{
+	Block P[4][4];
+	Block X[2][4];
+
+	to_blocks(P, P_in);
+
+	for (unsigned j = 0; j < 4; j++) {
+		X[0][j] = Rt * P[0][j] + Ca * P[3][j];
+
+		if (j >= 1)
+			X[1][j] = Rt * P[1][j] + Cm * P[3][j];
+	}
+
+	/* (X*A')(i,0) = X(i,0)*Rt' + X(i,3)*Ca', and likewise for column 1 */
+	P[0][0] = X[0][0] * Rt.transpose() + X[0][3] * Ca.transpose();
+	P[0][1] = X[0][1] * Rt.transpose() + X[0][3] * Cm.transpose();
+	P[1][1] = X[1][1] * Rt.transpose() + X[1][3] * Cm.transpose();
+
+	/* columns 2 and 3 of A' are the identity */
+	P[0][2] = X[0][2];
+	P[0][3] = X[0][3];
+	P[1][2] = X[1][2];
+	P[1][3] = X[1][3];
+
+	/* Q */
+	for (unsigned b = 0; b < 4; b++)
+		for (unsigned i = 0; i < 3; i++)
+			P[b][b](i, i) += q_steps * knownConst[b];
+
+	from_upper_blocks(P_out, P);
+}
+
+/**
+ * The measurement update.
+ *
+ * The outputs may be the inputs.
+ *
+ * @return		False if S was not positive definite, in which case
+ *			the outputs are the inputs.
+ */
+static bool
+update(const float z_k[9], const float knownConst[7], const float x_apriori[12], const float P_apriori[144],
+       float x_aposteriori[12], float P_aposteriori[144])
+{
+	/*
+	 * S_k=H_k*P_apriori*H_k'+R
+	 *
+	 * Also symmetric; H folds the last two block rows and columns together.
+	 */
+	float S[81];
+	float PHt[108];
+
+	for (unsigned j = 0; j < 9; j++) {
+		for (unsigned i = 0; i < 12; i++) {
+			/* P_apriori*H_k', 12x9 */
+			if (j < 6) {
+				PHt[i + 12 * j] = P_apriori[i + 12 * j];
+
+			} else {
+				PHt[i + 12 * j] = P_apriori[i + 12 * j] + P_apriori[i + 12 * (j + 3)];
+			}
+		}
+
+		for (unsigned i = 0; i < 9; i++) {
+			if (i < 6) {
+				S[i + 9 * j] = PHt[i + 12 * j];
+
+			} else {
+				S[i + 9 * j] = PHt[i + 12 * j] + PHt[(i + 3) + 12 * j];
+			}
+		}
+	}
+
+	/* R */
+	for (unsigned i = 0; i < 9; i++)
+		S[i + 9 * i] += knownConst[4 + i / 3];
+
+	/*
+	 * K_k=(P_apriori*H_k'/(S_k))
+	 *
+	 * S is symmetric positive definite unless the filter has diverged;
+	 * if it is not, skip the update rather than fill the state with NaNs.
+	 */
+	float K[108];
+
+	if (!ldlt_mrdivide(PHt, S, K)) {
+		memmove(x_aposteriori, x_apriori, 12 * sizeof(float));
+		memmove(P_aposteriori, P_apriori, 144 * sizeof(float));
+		return false;
+	}
+
+	/*
+	 * y_k=z_k-H_k*x_apriori
+	 * x_aposteriori=x_apriori+K_k*y_k
+	 */
+	float y_k[9];
+
+	for (unsigned i = 0; i < 9; i++)
+		y_k[i] = z_k[i] - ((i < 6) ? x_apriori[i] : (x_apriori[i] + x_apriori[i + 3]));
+
+	for (unsigned i = 0; i < 12; i++) {
+		float sum = 0.0f;
+
+		for (unsigned k = 0; k < 9; k++)
+			sum += K[i + 12 * k] * y_k[k];
+
+		x_aposteriori[i] = x_apriori[i] + sum;
+	}
+
+	/*
+	 * P_aposteriori=(eye(12)-K_k*H_k)*P_apriori
+	 *
+	 * = P_apriori - K_k*(P_apriori*H_k')', and symmetric; fill in the
+	 * upper triangle and mirror it. Only upper elements are read, so this
+	 * works in place.
+	 */
+	for (unsigned j = 0; j < 12; j++) {
+		for (unsigned i = 0; i <= j; i++) {
+			float sum = 0.0f;
+
+			for (unsigned k = 0; k < 9; k++)
+				sum += K[i + 12 * k] * PHt[j + 12 * k];
+
+			P_aposteriori[i + 12 * j] = P_apriori[i + 12 * j] - sum;
+			P_aposteriori[j + 12 * i] = P_aposteriori[i + 12 * j];
+		}
+	}
+
+	return true;
+}
+
+/**
+ * earth_z=x_aposteriori(1:3)/norm(x_aposteriori(1:3))
+ * earth_x=cross(earth_z,x_aposteriori(4:6)/norm(x_aposteriori(4:6)))
+ * earth_y=cross(earth_x,earth_z)
+ * Rot_matrix=[earth_x,earth_y,earth_z]
+ */
+static void
+rotation(const float x[12], float Rot_matrix[9])
+{
+	const Vector3 a(&x[0]);
+	const Vector3 m(&x[3]);
+	Vector3 earth_z = a * (1.0f / math::norm(a));
+	Vector3 earth_x = math::cross(earth_z, m * (1.0f / math::norm(m)));
+	Vector3 earth_y = math::cross(earth_x, earth_z);
+
+	for (unsigned i = 0; i < 3; i++) {
+		Rot_matrix[i] = earth_x(i);
+		Rot_matrix[3 + i] = earth_y(i);
+		Rot_matrix[6 + i] = earth_z(i);
+	}
+}
+
+bool
+attitude_ekf(float dt, const float z_k[9], const float x_aposteriori_k[12],
+	     const float P_aposteriori_k[144], const float knownConst[7],
+	     float Rot_matrix[9], float x_aposteriori[12], float P_aposteriori[144])
+{
+	const Vector3 a(&x_aposteriori_k[0]);
+	const Vector3 m(&x_aposteriori_k[3]);
+	const Vector3 w(&x_aposteriori_k[9]);
+	Block Rt, Ca, Cm;
+
+	rate_rotation(dt, w, Rt);
+	rate_sensitivity(dt, a, Ca);
+	rate_sensitivity(dt, m, Cm);
+
+	float x_apriori[12];
+	float P_apriori[144];
+
+	predict_state(Rt, x_aposteriori_k, x_apriori);
+	predict_covariance(Rt, Ca, Cm, P_aposteriori_k, knownConst, 1.0f, P_apriori);
+
+	bool updated = update(z_k, knownConst, x_apriori, P_apriori, x_aposteriori, P_aposteriori);
+
+	rotation(x_aposteriori, Rot_matrix);
+	return updated;
+}
+
+void
+attitude_ekf_propagate(float dt, const float gyro[3], float x[12], float Rot_matrix[9])
+{
+	/* the measured rates less the estimated offset */
+	const Vector3 w_measured(gyro);
+	const Vector3 wo(&x[6]);
+	Block Rt;
+
+	rate_rotation(dt, w_measured - wo, Rt);
+	predict_state(Rt, x, x);
+	rotation(x, Rot_matrix);
+}
+
+bool
+attitude_ekf_correct(float dt, unsigned steps, const float z_k[9], const float knownConst[7],
+		     float x[12], float P[144], float Rot_matrix[9])
+{
+	const Vector3 a(&x[0]);
+	const Vector3 m(&x[3]);
+	const Vector3 w(&x[9]);
+	Block Rt, Ca, Cm;
+
+	rate_rotation(dt, w, Rt);
+	rate_sensitivity(dt, a, Ca);
+	rate_sensitivity(dt, m, Cm);
+
+	predict_covariance(Rt, Ca, Cm, P, knownConst, (float)steps, P);
+
+	bool updated = update(z_k, knownConst, x, P, x, P);
+
+	rotation(x, Rot_matrix);
+	return updated;
+}
@@ -0,0 +1,127 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2012 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file attitude_ekf.h
+ * Attitude EKF, hand-written for the block structure of its matrices.
+ *
+ * Computes the same filter as the MATLAB-generated attitudeKalmanfilter()
+ * in codegen/, with the same arguments and storage, to within float
+ * rounding. The state is four 3-vectors [a, m, wo, w] (acceleration,
+ * magnetic field, gyro offset, rates), and every matrix in the filter is
+ * made of 3x3 blocks, most of them zero or identity:
+ *
+ *	A = [ Rt  0   0   Ca ]	H = [ I  0  0  0 ]
+ *	    [ 0   Rt  0   Cm ]	    [ 0  I  0  0 ]
+ *	    [ 0   0   I   0  ]	    [ 0  0  I  I ]
+ *	    [ 0   0   0   I  ]
+ *
+ * with Q and R block-diagonal multiples of I. Working on the blocks skips
+ * the zero and identity products, and exploiting the symmetry of the
+ * covariance halves what remains.
+ *
+ * The filter can also be run at two rates: attitude_ekf_propagate() on
+ * every gyro sample, and attitude_ekf_correct() only when the accelerometer
+ * or magnetometer has something new.
+ */
+
+#ifndef ATTITUDE_EKF_H_
+#define ATTITUDE_EKF_H_
+
+#include <sys/cdefs.h>
+#include <stdbool.h>
+
+__BEGIN_DECLS
+
+/**
+ * Run one predict and update step of the attitude EKF.
+ *
+ * The outputs may be the same arrays as the inputs.
+ *
+ * @param dt		Time since the last step, seconds.
+ * @param z_k		Measurement vector [a, m, w].
+ * @param x_aposteriori_k The state after the last step.
+ * @param P_aposteriori_k The (symmetric) covariance after the last step,
+ *			12x12 column-major.
+ * @param knownConst	Process noise for a, m, wo and w, then measurement
+ *			noise for a, m and w.
+ * @param Rot_matrix	Returns the rotation matrix, 3x3 column-major.
+ * @param x_aposteriori	Returns the new state.
+ * @param P_aposteriori	Returns the new covariance.
+ * @return		True if the measurement update was applied; false if
+ *			the innovation covariance was not positive definite,
+ *			in which case the outputs are the prediction alone.
+ */
+__EXPORT extern bool	attitude_ekf(float dt, const float z_k[9], const float x_aposteriori_k[12],
+				     const float P_aposteriori_k[144], const float knownConst[7],
+				     float Rot_matrix[9], float x_aposteriori[12], float P_aposteriori[144]);
+
+/**
+ * Propagate the attitude with a gyro sample.
+ *
+ * The cheap half of a multi-rate filter: rotates the acceleration and
+ * magnetic field states by the measured rates less the estimated offset,
+ * leaving the covariance to be propagated by the next correction. Run
+ * on every gyro sample.
+ *
+ * @param dt		Time since the last propagation, seconds.
+ * @param gyro		The measured rates, as in z_k.
+ * @param x		The state, updated in place.
+ * @param Rot_matrix	Returns the rotation matrix.
+ */
+__EXPORT extern void	attitude_ekf_propagate(float dt, const float gyro[3], float x[12], float Rot_matrix[9]);
+
+/**
+ * Correct the attitude with a full measurement.
+ *
+ * The expensive half of a multi-rate filter: propagates the covariance
+ * over the time since the last correction, then runs the measurement
+ * update. Run when new accelerometer or magnetometer data arrives, after
+ * the propagation for the same sample.
+ *
+ * @param dt		Time since the last correction, seconds.
+ * @param steps		Propagation steps since the last correction; the
+ *			process noise, which is per step, is scaled by this.
+ * @param z_k		Measurement vector [a, m, w].
+ * @param knownConst	As for attitude_ekf().
+ * @param x		The state, updated in place.
+ * @param P		The covariance, updated in place.
+ * @param Rot_matrix	Returns the rotation matrix.
+ * @return		As for attitude_ekf().
+ */
+__EXPORT extern bool	attitude_ekf_correct(float dt, unsigned steps, const float z_k[9], const float knownConst[7],
+					     float x[12], float P[144], float Rot_matrix[9]);
+
+__END_DECLS
+
+#endif /* ATTITUDE_EKF_H_ */
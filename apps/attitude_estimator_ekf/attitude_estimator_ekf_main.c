@@ -62,9 +62,11 @@
 #include <uORB/topics/sensor_combined.h>
 #include <uORB/topics/vehicle_attitude.h>
 #include <arch/board/up_hrt.h>
+#include <systemlib/perf_counter.h>
 
 #include "codegen/attitudeKalmanfilter_initialize.h"
 #include "codegen/attitudeKalmanfilter.h"
+#include "attitude_ekf.h"
 
 __EXPORT int attitude_estimator_ekf_main(int argc, char *argv[]);
 
@@ -144,6 +146,20 @@ int attitude_estimator_ekf_main(int argc, char *argv[])
 	int loopcounter = 0;
 	int printcounter = 0;
 
+	/* count the steps where the filter had to skip its measurement update */
+	perf_counter_t ekf_not_pd = perf_alloc(PC_COUNT, "attitude EKF S not positive definite");
+	perf_counter_t ekf_propagate = perf_alloc(PC_ELAPSED, "attitude EKF propagate");
+	perf_counter_t ekf_correct = perf_alloc(PC_ELAPSED, "attitude EKF correct");
+
+	/* raw counters of the last sample seen, to tell which sensors have news */
+	uint16_t last_gyro_counter = 0;
+	uint16_t last_accel_counter = 0;
+	uint16_t last_mag_counter = 0;
+
+	/* time and propagation steps since the last correction */
+	float correct_dt = 0.0f;
+	unsigned correct_steps = 0;
+
 	/* Main loop*/
 	while (true) {
 
@@ -156,11 +172,16 @@ int attitude_estimator_ekf_main(int argc, char *argv[])
 		if (ret == 0) {
 			/* */
 
-			/* update successful, copy data on every 2nd run and execute filter */
-		} else if (loopcounter & 0x01) {
+			/* update successful, copy data and propagate on every new gyro sample */
+		} else {
 
 			orb_copy(ORB_ID(sensor_combined), sub_raw, &raw);
 
+			if (raw.gyro_raw_counter == last_gyro_counter)
+				continue;
+
+			last_gyro_counter = raw.gyro_raw_counter;
+
 			/* Calculate data time difference in seconds */
 			dt = (raw.timestamp - last_measurement) / 1000000.0f;
 			last_measurement = raw.timestamp;
@@ -198,13 +219,42 @@ int attitude_estimator_ekf_main(int argc, char *argv[])
 				overloadcounter++;
 			}
 
-//			now = hrt_absolute_time();
-			/* filter values */
 			/*
+			 * Rotate the attitude with every gyro sample, and run the
+			 * measurement update, with the covariance propagated over
+			 * the samples since the last one, only when the
+			 * accelerometer or magnetometer has something new.
+			 *
+			 * Together these compute the filter of
 			 * function [Rot_matrix,x_aposteriori,P_aposteriori] = attitudeKalmanfilter(dt,z_k,x_aposteriori_k,P_aposteriori_k,knownConst)
+			 * at the rate each sensor delivers.
 			 */
 			uint64_t timing_start = hrt_absolute_time();
-			attitudeKalmanfilter(dt, z_k, x_aposteriori, P_aposteriori, knownConst, Rot_matrix, x_aposteriori, P_aposteriori);
+
+			perf_begin(ekf_propagate);
+			attitude_ekf_propagate(dt, &z_k[6], x_aposteriori, Rot_matrix);
+			perf_end(ekf_propagate);
+
+			correct_dt += dt;
+			correct_steps++;
+
+			if ((raw.accelerometer_raw_counter != last_accel_counter) ||
+			    (raw.magnetometer_raw_counter != last_mag_counter)) {
+				last_accel_counter = raw.accelerometer_raw_counter;
+				last_mag_counter = raw.magnetometer_raw_counter;
+
+				perf_begin(ekf_correct);
+				bool updated = attitude_ekf_correct(correct_dt, correct_steps, z_k, knownConst,
+								    x_aposteriori, P_aposteriori, Rot_matrix);
+				perf_end(ekf_correct);
+
+				if (!updated)
+					perf_count(ekf_not_pd);
+
+				correct_dt = 0.0f;
+				correct_steps = 0;
+			}
+
 			uint64_t timing_diff = hrt_absolute_time() - timing_start;
 
 			/* print rotation matrix every 200th time */
@@ -230,21 +280,28 @@ int attitude_estimator_ekf_main(int argc, char *argv[])
 //			printf("%llu -> %llu = %llu\n", last_data, raw.timestamp, raw.timestamp - last_data);
 			last_data = raw.timestamp;
 
-			/* send out */
+			/* send out, at the gyro rate */
 			att.timestamp = raw.timestamp;
-			// att.roll = euler.x;
-			// att.pitch = euler.y;
-			// att.yaw = euler.z + F_M_PI;
 
-			// if (att.yaw > 2 * F_M_PI) {
-			// 	att.yaw -= 2 * F_M_PI;
-			// }
+			/* Rot_matrix holds the earth axes in body coordinates, column-major */
+			for (int i = 0; i < 3; i++) {
+				for (int j = 0; j < 3; j++) {
+					att.R[i][j] = Rot_matrix[j + 3 * i];
+				}
+			}
+
+			att.R_valid = true;
+
+			att.roll = atan2f(att.R[2][1], att.R[2][2]);
+			att.pitch = -asinf(att.R[2][0]);
+			att.yaw = atan2f(att.R[1][0], att.R[0][0]);
 
-			// att.rollspeed = rates.x;
-			// att.pitchspeed = rates.y;
-			// att.yawspeed = rates.z;
+			/* rates are the measured ones less the estimated offset */
+			att.rollspeed = z_k[6] - x_aposteriori[6];
+			att.pitchspeed = z_k[7] - x_aposteriori[7];
+			att.yawspeed = z_k[8] - x_aposteriori[8];
 
-			// memcpy()R
+			att.counter++;
 
 			// Broadcast
 			orb_publish(ORB_ID(vehicle_attitude), pub_att, &att);
@@ -0,0 +1,122 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2012 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file ldlt.c
+ * Fixed-size symmetric solver for the attitude EKF gain.
+ */
+
+#include <float.h>
+
+#include "ldlt.h"
+
+/**
+ * Smallest pivot accepted, relative to the diagonal element it came from.
+ *
+ * A pivot this small means the matrix has lost all but the last few bits of
+ * its positive definiteness to rounding, and the gain would be noise.
+ */
+#define LDLT_MIN_PIVOT	(4 * FLT_EPSILON)
+
+bool
+ldlt_mrdivide(const float A[LDLT_M * LDLT_N], const float B[LDLT_N * LDLT_N], float y[LDLT_M * LDLT_N])
+{
+	float L[LDLT_N][LDLT_N];	/* L[j][i] is L(i, j), i > j */
+	float D[LDLT_N];
+	float D_inv[LDLT_N];
+	float v[LDLT_N];
+
+	/*
+	 * B = L * D * L', column by column.
+	 *
+	 * The negated comparisons also reject NaNs.
+	 */
+	for (unsigned j = 0; j < LDLT_N; j++) {
+		float b_jj = B[j + LDLT_N * j];
+		float d = b_jj;
+
+		for (unsigned k = 0; k < j; k++) {
+			v[k] = L[k][j] * D[k];
+			d -= L[k][j] * v[k];
+		}
+
+		if (!(b_jj > 0.0f) || !(d > LDLT_MIN_PIVOT * b_jj))
+			return false;
+
+		D[j] = d;
+		D_inv[j] = 1.0f / d;
+
+		for (unsigned i = j + 1; i < LDLT_N; i++) {
+			float sum = B[i + LDLT_N * j];
+
+			for (unsigned k = 0; k < j; k++)
+				sum -= L[k][i] * v[k];
+
+			L[j][i] = sum * D_inv[j];
+		}
+	}
+
+	/*
+	 * Each row of y solves B * y(r, :)' = A(r, :)': forward through L,
+	 * scale by D, back through L'.
+	 */
+	for (unsigned r = 0; r < LDLT_M; r++) {
+		float z[LDLT_N];
+
+		for (unsigned i = 0; i < LDLT_N; i++) {
+			float sum = A[r + LDLT_M * i];
+
+			for (unsigned k = 0; k < i; k++)
+				sum -= L[k][i] * z[k];
+
+			z[i] = sum;
+		}
+
+		for (unsigned i = 0; i < LDLT_N; i++)
+			z[i] *= D_inv[i];
+
+		for (unsigned i = LDLT_N; i-- > 0;) {
+			float sum = z[i];
+
+			for (unsigned k = i + 1; k < LDLT_N; k++)
+				sum -= L[i][k] * z[k];
+
+			z[i] = sum;
+		}
+
+		for (unsigned i = 0; i < LDLT_N; i++)
+			y[r + LDLT_M * i] = z[i];
+	}
+
+	return true;
+}
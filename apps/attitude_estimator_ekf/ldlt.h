@@ -0,0 +1,73 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2012 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file ldlt.h
+ * Fixed-size symmetric solver for the attitude EKF gain.
+ *
+ * The innovation covariance S is symmetric positive definite, so the gain
+ * K = PH'/S can be had from an LDL' factorisation of S without pivoting,
+ * in about half the work of the LU decomposition in codegen/mrdivide.c,
+ * and without a square root. The dimensions are fixed at compile time to
+ * those of the filter.
+ */
+
+#ifndef LDLT_H_
+#define LDLT_H_
+
+#include <sys/cdefs.h>
+#include <stdbool.h>
+
+#define LDLT_N	9	/**< order of the symmetric matrix (measurements) */
+#define LDLT_M	12	/**< rows of the right-hand side (states) */
+
+__BEGIN_DECLS
+
+/**
+ * Compute y = A / B, that is y * B = A, for symmetric positive definite B.
+ *
+ * A replacement for the generated mrdivide() where B is known to be
+ * symmetric; only the lower triangle of B is read.
+ *
+ * @param A		LDLT_M x LDLT_N, column-major.
+ * @param B		LDLT_N x LDLT_N, column-major.
+ * @param y		Returns LDLT_M x LDLT_N, column-major. May be A.
+ * @return		True on success; false if B is not (numerically)
+ *			positive definite, in which case y is not written.
+ */
+__EXPORT extern bool	ldlt_mrdivide(const float A[LDLT_M * LDLT_N], const float B[LDLT_N * LDLT_N],
+				      float y[LDLT_M * LDLT_N]);
+
+__END_DECLS
+
+#endif /* LDLT_H_ */
@@ -380,6 +380,7 @@ void do_mag_calibration(int status_pub, struct vehicle_status_s *current_status)
 	global_data_parameter_storage->pm.param_values[PARAM_SENSOR_MAG_XOFFSET] = mag_offset[0];
 	global_data_parameter_storage->pm.param_values[PARAM_SENSOR_MAG_YOFFSET] = mag_offset[1];
 	global_data_parameter_storage->pm.param_values[PARAM_SENSOR_MAG_ZOFFSET] = mag_offset[2];
+	params_changed(global_data_parameter_storage);
 
 	free(mag_maxima[0]);
 	free(mag_maxima[1]);
@@ -431,6 +432,7 @@ void do_gyro_calibration(int status_pub, struct vehicle_status_s *current_status
 	global_data_parameter_storage->pm.param_values[PARAM_SENSOR_GYRO_XOFFSET] = gyro_offset[0];
 	global_data_parameter_storage->pm.param_values[PARAM_SENSOR_GYRO_YOFFSET] = gyro_offset[1];
 	global_data_parameter_storage->pm.param_values[PARAM_SENSOR_GYRO_ZOFFSET] = gyro_offset[2];
+	params_changed(global_data_parameter_storage);
 
 	char offset_output[50];
 	sprintf(offset_output, "[commander] gyro calibration finished, offsets: x:%d, y:%d, z:%d", (int)gyro_offset[0], (int)gyro_offset[1], (int)gyro_offset[2]);
@@ -38,6 +38,8 @@
 #include <nuttx/config.h>
 
 #include <device/spi.h>
+#include <device/ringbuffer.h>
+#include <device/decimator.h>
 
 #include <sys/types.h>
 #include <stdint.h>
@@ -84,28 +86,52 @@ public:
 protected:
 	virtual int		probe();
 
+	virtual void		burst_complete(uint8_t *recv, unsigned len, int result);
+
 private:
 
 	struct hrt_call		_call;
 	unsigned		_call_interval;
 
-	unsigned		_num_reports;
-	volatile unsigned	_next_report;
-	volatile unsigned	_oldest_report;
-	struct accel_report	*_reports;
+	device::RingBuffer<struct accel_report>	_reports;
+
+	unsigned		_lowpass;		/**< requested filter cutoff, Hz; zero for none */
+	device::Decimator	_filter;
 
 	struct accel_scale	_scale;
 	float			_range_scale;
 
+	int			_accel_topic;
+
+	/**
+	 * Measurement registers as read back from the device, from the X LSB
+	 * onwards; the command byte goes out while the padding byte comes in,
+	 * so that the samples are word-aligned.
+	 */
+	union {
+		uint8_t		bytes[10];
+		uint16_t	words[5];
+	}			_raw;
+	hrt_abstime		_raw_timestamp;		/**< time the burst for _raw was started */
+
 	unsigned		_reads;
+	unsigned		_read_errors;
+	unsigned		_overruns;		/**< measurements skipped because the previous burst was still running */
 
 	/**
-	 * Start automatic measurement.
+	 * Start automatic measurement at _call_interval.
+	 *
+	 * The decimation filter is designed for the resulting sample rate.
+	 *
+	 * @return		OK if measurement was started, -errno otherwise.
 	 */
-	void			start();
+	int			start();
 
 	/**
 	 * Stop automatic measurement.
+	 *
+	 * Waits for a burst that is already running to complete, so that the
+	 * report ring may be modified when this returns.
 	 */
 	void			stop();
 
@@ -121,10 +147,15 @@ private:
 	static void		measure_trampoline(void *arg);
 
 	/**
-	 * Fetch measurements from the sensor and update the report ring.
+	 * Start fetching measurements from the sensor.
 	 */
 	void			measure();
 
+	/**
+	 * Turn the registers in _raw into a report and post it.
+	 */
+	void			collect();
+
 	/**
 	 * Read a register from the BMA180
 	 *
@@ -170,9 +201,6 @@ private:
 	int			set_bandwidth(unsigned frequency);
 };
 
-/* helper macro for handling report buffer indices */
-#define INCREMENT(_x, _lim)	do { _x++; if (_x >= _lim) _x = 0; } while(0)
-
 #define DIR_READ			(1<<7)
 #define DIR_WRITE			(0<<7)
 
@@ -184,6 +212,9 @@ private:
 #define ADDR_ACC_Z_LSB			0x06
 #define ADDR_TEMPERATURE		0x08
 
+#define ADDR_CTRLREG0			0x0D
+#define REG0_WRITE_ENABLE			0x10
+
 #define ADDR_RESET			0x10
 #define SOFT_RESET				0xB6
 
@@ -198,6 +229,7 @@ private:
 #define BW_TCS_BW_600HZ				(6<<4)
 #define BW_TCS_BW_1200HZ			(7<<4)
 
+
 #define ADDR_HIGH_DUR			0x27
 #define HIGH_DUR_DIS_I2C			(1<<0)
 
@@ -219,6 +251,15 @@ private:
 #define ADDR_OFFSET_T			0x37
 #define OFFSET_T_READOUT_12BIT			(1<<0)
 
+#define BMA180_ONE_G			9.80665f
+
+/*
+ * Reports buffered for read(). The sensors task polls the BMA180 at
+ * 500 Hz, where the filter does not decimate, and reads what has queued
+ * at each 380 Hz gyro wakeup; this holds 16 ms, several missed wakeups.
+ */
+#define BMA180_REPORT_QUEUE_DEPTH	8
+
 /*
  * Driver 'main' command.
  */
@@ -227,11 +268,14 @@ extern "C" { int bma180_main(int argc, char *argv[]); }
 
 BMA180::BMA180(int bus, spi_dev_e device) :
 	SPI("BMA180", ACCEL_DEVICE_PATH, bus, device, SPIDEV_MODE3, 8000000),
-	_num_reports(0),
-	_next_report(0),
-	_oldest_report(0),
-	_reports(nullptr),
-	_reads(0)
+	_call_interval(0),
+	_lowpass(0),
+	_range_scale(0.0f),
+	_accel_topic(-1),
+	_raw_timestamp(0),
+	_reads(0),
+	_read_errors(0),
+	_overruns(0)
 {
 	// enable debug() calls
 	_debug_enabled = true;
@@ -243,16 +287,14 @@ BMA180::BMA180(int bus, spi_dev_e device) :
 	_scale.y_scale  = 1.0f;
 	_scale.z_offset = 0;
 	_scale.z_scale  = 1.0f;
+
+	memset(&_call, 0, sizeof(_call));
 }
 
 BMA180::~BMA180()
 {
 	/* make sure we are truly inactive */
 	stop();
-
-	/* free any existing reports */
-	if (_reports != nullptr)
-		delete[] _reports;
 }
 
 int
@@ -272,6 +314,9 @@ BMA180::init()
 		/* wait 10us (p49) */
 		usleep(10);
 
+		/* the configuration registers are only writable with ee_w set */
+		modify_reg(ADDR_CTRLREG0, 0, REG0_WRITE_ENABLE);
+
 		/* disable I2C interface */
 		modify_reg(ADDR_HIGH_DUR, HIGH_DUR_DIS_I2C, 0);
 
@@ -283,6 +328,17 @@ BMA180::init()
 
 		/* disable shadow-disable mode */
 		modify_reg(ADDR_GAIN_Y, GAIN_Y_SHADOW_DIS, 0);
+
+		/*
+		 * Publish as the next free instance so that a second accel can
+		 * coexist. If this fails (e.g. no object in the system) that's OK.
+		 */
+		struct accel_report a;
+		memset(&a, 0, sizeof(a));
+		_accel_topic = orb_advertise_multi(ORB_ID(sensor_accel), &a, nullptr);
+
+		if (_accel_topic < 0)
+			debug("failed to create sensor_accel object");
 	}
 
 	return ret;
@@ -291,13 +347,13 @@ BMA180::init()
 int
 BMA180::open_first(struct file *filp)
 {
-	/* reset to manual-poll mode */
+	/* reset to manual-poll mode, unfiltered */
 	_call_interval = 0;
+	_lowpass = 0;
 
 	/* allocate basic report buffers */
-	_num_reports = 2;
-	_reports = new struct accel_report[_num_reports];
-	_oldest_report = _next_report = 0;
+	if (!_reports.resize(BMA180_REPORT_QUEUE_DEPTH))
+		return -ENOMEM;
 
 	/* set default range and lowpass */
 	set_range(4);		/* 4G */
@@ -313,10 +369,9 @@ BMA180::close_last(struct file *filp)
 	stop();
 
 	/* free report buffers */
-	if (_reports != nullptr) {
-		delete[] _reports;
-		_num_reports = 0;
-	}
+	_reports.resize(0);
+
+	_call_interval = 0;
 
 	return OK;
 }
@@ -344,17 +399,10 @@ BMA180::read(struct file *filp, char *buffer, size_t buflen)
 	if (_call_interval > 0) {
 
 		/*
-		 * While there is space in the caller's buffer, and reports, copy them.
-		 * Note that we may be pre-empted by the measurement code while we are doing this;
-		 * we are careful to avoid racing with it.
+		 * Copy as many reports as there are, up to the space in the caller's
+		 * buffer. The ring is safe against the measurement code pre-empting us.
 		 */
-		while (count--) {
-			if (_oldest_report != _next_report) {
-				memcpy(buffer, _reports + _oldest_report, sizeof(*_reports));
-				ret += sizeof(_reports[0]);
-				INCREMENT(_oldest_report, _num_reports);
-			}
-		}
+		ret = _reports.get(reinterpret_cast<struct accel_report *>(buffer), count) * sizeof(struct accel_report);
 
 		_reads++;
 
@@ -363,12 +411,21 @@ BMA180::read(struct file *filp, char *buffer, size_t buflen)
 	}
 
 	/* manual measurement */
-	_oldest_report = _next_report = 0;
-	measure();
+	_reports.flush();
+
+	_raw.bytes[1] = ADDR_ACC_X_LSB | DIR_READ;
+	_raw_timestamp = hrt_absolute_time();
+
+	if (OK != transfer(&_raw.bytes[1], &_raw.bytes[1], 8)) {
+		_read_errors++;
+		return -EIO;
+	}
+
+	collect();
 
 	/* measurement will have generated a report, copy it out */
-	memcpy(buffer, _reports, sizeof(*_reports));
-	ret = sizeof(*_reports);
+	if (_reports.get(*reinterpret_cast<struct accel_report *>(buffer)))
+		ret = sizeof(struct accel_report);
 
 	return ret;
 }
@@ -396,9 +453,6 @@ BMA180::ioctl(struct file *filp, int cmd, unsigned long arg)
 
 				/* adjust to a legal polling interval in Hz */
 			default: {
-					/* do we need to start internal polling? */
-					bool want_start = (_call_interval == 0);
-
 					/* convert hz to hrt interval via microseconds */
 					unsigned ticks = 1000000 / arg;
 
@@ -406,15 +460,10 @@ BMA180::ioctl(struct file *filp, int cmd, unsigned long arg)
 					if (ticks < 1000)
 						return -EINVAL;
 
-					/* update interval for next measurement */
-					/* XXX this is a bit shady, but no other way to adjust... */
-					_call.period = _call_interval;
-
-					/* if we need to start the poll state machine, do it */
-					if (want_start)
-						start();
+					/* (re)start polling; the filter is redesigned for the new rate */
+					_call_interval = ticks;
 
-					return OK;
+					return start();
 				}
 			}
 		}
@@ -424,24 +473,36 @@ BMA180::ioctl(struct file *filp, int cmd, unsigned long arg)
 			if ((arg < 2) || (arg > 100))
 				return -EINVAL;
 
-			/* allocate new buffer */
-			struct accel_report *buf = new struct accel_report[arg];
+			/* the ring must not be written while it is resized */
+			stop();
 
-			if (nullptr == buf)
-				return -ENOMEM;
+			int ret = _reports.resize(arg) ? OK : -ENOMEM;
 
-			/* reset the measurement state machine with the new buffer, free the old */
-			stop();
-			delete[] _reports;
-			_num_reports = arg;
-			_reports = buf;
-			start();
+			/* restart automatic measurement if it was running */
+			if (_call_interval > 0)
+				start();
 
-			return OK;
+			return ret;
 		}
 
-	case ACCELIOCSLOWPASS:
-		return set_bandwidth(arg);
+	case ACCELIOCSLOWPASS: {
+			/*
+			 * The on-chip filter is set at or above the cutoff to limit
+			 * aliasing, and the decimation filter does the rest.
+			 */
+			int ret = set_bandwidth(arg);
+
+			if (ret != OK)
+				return ret;
+
+			_lowpass = arg;
+
+			/* redesign the filter if measuring */
+			if (_call_interval > 0)
+				return start();
+
+			return OK;
+		}
 
 	case ACCELIORANGE:
 		return set_range(arg);
@@ -526,7 +587,9 @@ BMA180::set_range(unsigned max_g)
 
 	/* adjust sensor configuration */
 	modify_reg(ADDR_OFFSET_LSB1, OFFSET_LSB1_RANGE_MASK, rangebits);
-	_range_scale = rangescale;
+
+	/* the table above is in mg/LSB, reports are in m/s^2 */
+	_range_scale = rangescale * (BMA180_ONE_G / 1000.0f);
 
 	return OK;
 }
@@ -570,23 +633,34 @@ BMA180::set_bandwidth(unsigned frequency)
 	return OK;
 }
 
-void
+int
 BMA180::start()
 {
 	/* make sure we are stopped first */
 	stop();
 
 	/* reset the report ring */
-	_oldest_report = _next_report = 0;
+	_reports.flush();
+
+	/* filter for the rate samples will arrive at */
+	_filter.configure(1000000 / _call_interval, _lowpass);
 
 	/* start polling at the specified rate */
 	hrt_call_every(&_call, 1000, _call_interval, (hrt_callout)&BMA180::measure_trampoline, this);
+
+	return OK;
 }
 
 void
 BMA180::stop()
 {
 	hrt_cancel(&_call);
+
+	burst_cancel();
+
+	/* a burst that has already started will still report; let it */
+	while (burst_busy())
+		usleep(1000);
 }
 
 void
@@ -601,56 +675,91 @@ BMA180::measure_trampoline(void *arg)
 void
 BMA180::measure()
 {
-	/*
-	 * This evil is to deal with the stupid layout of the BMA180
-	 * measurement registers vs. the SPI transaction model.
-	 */
-	union {
-		uint8_t bytes[10];
-		uint16_t words[5];
-	} buf;
+	/* if the work queue hasn't got to the last one yet, skip this one */
+	if (burst_busy()) {
+		_overruns++;
+		return;
+	}
 
 	/*
 	 * Fetch the full set of measurements from the BMA180 in one pass;
-	 * 7 bytes starting from the X LSB.
+	 * 7 bytes starting from the X LSB, off the interrupt.  The time the
+	 * burst is started is the best approximation of the sample time.
 	 */
-	buf.bytes[1] = ADDR_ACC_X_LSB;
-	transfer(&buf.bytes[1], &buf.bytes[1], 8);
+	_raw.bytes[1] = ADDR_ACC_X_LSB | DIR_READ;
+	_raw_timestamp = hrt_absolute_time();
+
+	if (OK != burst_start(&_raw.bytes[1], &_raw.bytes[1], 8))
+		_overruns++;
+}
+
+void
+BMA180::burst_complete(uint8_t *recv, unsigned len, int result)
+{
+	if (result != OK) {
+		_read_errors++;
+		return;
+	}
 
+	collect();
+}
+
+void
+BMA180::collect()
+{
 	/*
-	 * Adjust and scale results to mg.
+	 * Adjust and scale results to m/s^2.
 	 *
 	 * Note that we ignore the "new data" bits.  At any time we read, each
 	 * of the axis measurements are the "most recent", even if we've seen
 	 * them before.  There is no good way to synchronise with the internal
 	 * measurement flow without using the external interrupt.
+	 *
+	 * The 14-bit values are left-justified; shift them down as signed.
 	 */
-	_reports[_next_report].timestamp = hrt_absolute_time();
-	_reports[_next_report].x = (buf.words[1] >> 2) * _range_scale;
-	_reports[_next_report].y = (buf.words[2] >> 2) * _range_scale;
-	_reports[_next_report].z = (buf.words[3] >> 2) * _range_scale;
+	struct accel_report report;
+	int16_t sample[3] = {
+		(int16_t)(((int16_t)_raw.words[1]) >> 2),
+		(int16_t)(((int16_t)_raw.words[2]) >> 2),
+		(int16_t)(((int16_t)_raw.words[3]) >> 2)
+	};
 
 	/*
-	 * @todo Apply additional scaling / calibration factors here.
+	 * When measuring automatically every sample goes through the filter,
+	 * and only the decimated ones are reported.
 	 */
+	if ((_call_interval > 0) && !_filter.put(sample, sample))
+		return;
 
-	/* post a report to the ring - note, not locked */
-	INCREMENT(_next_report, _num_reports);
+	report.timestamp = _raw_timestamp;
+	report.x_raw = sample[0];
+	report.y_raw = sample[1];
+	report.z_raw = sample[2];
+	report.x = (report.x_raw * _range_scale) * _scale.x_scale + _scale.x_offset;
+	report.y = (report.y_raw * _range_scale) * _scale.y_scale + _scale.y_offset;
+	report.z = (report.z_raw * _range_scale) * _scale.z_scale + _scale.z_offset;
 
-	/* if we are running up against the oldest report, fix it */
-	if (_next_report == _oldest_report)
-		INCREMENT(_oldest_report, _num_reports);
+	/* post a report to the ring, dropping the oldest if the reader is behind */
+	_reports.force(report);
 
 	/* notify anyone waiting for data */
 	poll_notify(POLLIN);
+
+	/* and publish for subscribers */
+	if (_accel_topic >= 0)
+		orb_publish(ORB_ID(sensor_accel), _accel_topic, &report);
 }
 
 void
 BMA180::print_info()
 {
 	printf("reads:          %u\n", _reads);
-	printf("report queue:   %u (%u/%u @ %p)\n",
-	       _num_reports, _oldest_report, _next_report, _reports);
+	printf("read errors:    %u\n", _read_errors);
+	printf("overruns:       %u\n", _overruns);
+	printf("poll interval:  %u us\n", _call_interval);
+	printf("lowpass:        %u Hz, %u taps, decimation %u\n", _filter.cutoff(), _filter.taps(), _filter.factor());
+	printf("report queue:   %u/%u, %u overflows\n",
+	       _reports.count(), _reports.size(), _reports.overflows());
 }
 
 /**
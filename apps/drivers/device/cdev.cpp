@@ -94,16 +94,22 @@ CDev::CDev(const char *name,
 	// private
 	_devname(devname),
 	_registered(false),
-	_open_count(0)
+	_open_count(0),
+	_pollwaiters(nullptr),
+	_pollfree(nullptr)
 {
-	for (unsigned i = 0; i < _max_pollwaiters; i++)
-		_pollset[i] = nullptr;
 }
 
 CDev::~CDev()
 {
 	if (_registered)
 		unregister_driver(_devname);
+
+	while (_pollfree != nullptr) {
+		PollWaiter *w = _pollfree;
+		_pollfree = w->next;
+		delete w;
+	}
 }
 
 int
@@ -235,15 +241,11 @@ CDev::poll(struct file *filp, struct pollfd *fds, bool setup)
 
 	if (setup) {
 		/*
-		 * Save the file pointer in the pollfd for the subclass'
-		 * benefit.
-		 */
-		fds->priv = (void *)filp;
-
-		/*
-		 * Handle setup requests.
+		 * Handle setup requests. Clear the private pointer first so that
+		 * a teardown after a failed setup is recognised as bad.
 		 */
-		ret = store_poll_waiter(fds);
+		fds->priv = nullptr;
+		ret = store_poll_waiter(filp, fds);
 
 		if (ret == OK) {
 
@@ -276,9 +278,8 @@ CDev::poll_notify(pollevent_t events)
 	/* lock against poll() as well as other wakeups */
 	irqstate_t state = irqsave();
 
-	for (unsigned i = 0; i < _max_pollwaiters; i++)
-		if (nullptr != _pollset[i])
-			poll_notify_one(_pollset[i], events);
+	for (PollWaiter *w = _pollwaiters; w != nullptr; w = w->next)
+		poll_notify_one(w->fds, events);
 
 	irqrestore(state);
 }
@@ -302,39 +303,78 @@ CDev::poll_state(struct file *filp)
 	return 0;
 }
 
+struct file *
+CDev::poll_file(struct pollfd *fds)
+{
+	return ((PollWaiter *)fds->priv)->filp;
+}
+
 int
-CDev::store_poll_waiter(struct pollfd *fds)
+CDev::store_poll_waiter(struct file *filp, struct pollfd *fds)
 {
-	/*
-	 * Look for a free slot.
-	 */
-	for (unsigned i = 0; i < _max_pollwaiters; i++) {
-		if (nullptr == _pollset[i]) {
+	PollWaiter *w = _pollfree;
 
-			/* save the pollfd */
-			_pollset[i] = fds;
+	/* reuse a record if we can, otherwise grow the pool */
+	if (w != nullptr) {
+		_pollfree = w->next;
 
-			return OK;
-		}
+	} else {
+		w = new PollWaiter;
+
+		if (w == nullptr)
+			return -ENOMEM;
 	}
 
-	return ENOMEM;
+	w->fds = fds;
+	w->filp = filp;
+	w->prev = nullptr;
+	fds->priv = (void *)w;
+
+	/* poll_notify may be walking the list from interrupt context */
+	irqstate_t state = irqsave();
+
+	w->next = _pollwaiters;
+
+	if (_pollwaiters != nullptr)
+		_pollwaiters->prev = w;
+
+	_pollwaiters = w;
+
+	irqrestore(state);
+
+	return OK;
 }
 
 int
 CDev::remove_poll_waiter(struct pollfd *fds)
 {
-	for (unsigned i = 0; i < _max_pollwaiters; i++) {
-		if (fds == _pollset[i]) {
+	PollWaiter *w = (PollWaiter *)fds->priv;
 
-			_pollset[i] = nullptr;
-			return OK;
+	if ((w == nullptr) || (w->fds != fds)) {
+		puts("poll: bad fd state");
+		return -EINVAL;
+	}
 
-		}
+	irqstate_t state = irqsave();
+
+	if (w->prev != nullptr) {
+		w->prev->next = w->next;
+
+	} else {
+		_pollwaiters = w->next;
 	}
 
-	puts("poll: bad fd state");
-	return -EINVAL;
+	if (w->next != nullptr)
+		w->next->prev = w->prev;
+
+	irqrestore(state);
+
+	fds->priv = nullptr;
+	w->fds = nullptr;
+	w->next = _pollfree;
+	_pollfree = w;
+
+	return OK;
 }
 
 static int
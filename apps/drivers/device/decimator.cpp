@@ -0,0 +1,194 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2012 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file Fixed-point anti-aliasing and decimation filter for sensor drivers.
+ */
+
+#include <nuttx/config.h>
+
+#include <math.h>
+#include <string.h>
+#include <errno.h>
+
+#include "decimator.h"
+
+namespace device
+{
+
+Decimator::Decimator() :
+	_cutoff(0),
+	_taps(1),
+	_factor(1),
+	_phase(0),
+	_newest(0),
+	_primed(false)
+{
+	memset(_coef, 0, sizeof(_coef));
+	memset(_history, 0, sizeof(_history));
+}
+
+int
+Decimator::configure(unsigned sample_hz, unsigned cutoff_hz)
+{
+	if (sample_hz == 0)
+		return -EINVAL;
+
+	reset();
+
+	/* pass through */
+	if ((cutoff_hz == 0) || ((2 * cutoff_hz) >= sample_hz)) {
+		_cutoff = 0;
+		_taps = 1;
+		_factor = 1;
+		return OK;
+	}
+
+	/*
+	 * About two samples per tap per cycle of the cutoff gives the Hamming
+	 * window's ~3.3 / taps transition band a width comparable to the
+	 * cutoff itself; keep it odd so that the delay is a whole sample.
+	 */
+	unsigned taps = (2 * sample_hz) / cutoff_hz + 1;
+
+	if (taps > max_taps)
+		taps = max_taps;
+
+	taps |= 1;
+
+	/* decimate as far as the start of the stopband allows */
+	float fc = (float)cutoff_hz / sample_hz;
+	float stopband = fc + 1.65f / taps;
+	unsigned factor = (unsigned)(1.0f / (2.0f * stopband));
+
+	if (factor < 1)
+		factor = 1;
+
+	/* windowed sinc, normalised for unity gain at DC */
+	float h[max_taps];
+	float sum = 0.0f;
+	int mid = taps / 2;
+
+	for (int i = 0; i < (int)taps; i++) {
+		int n = i - mid;
+		float sinc = (n == 0) ? (2.0f * fc) : (sinf(2.0f * (float)M_PI * fc * n) / ((float)M_PI * n));
+		float window = 0.54f - 0.46f * cosf(2.0f * (float)M_PI * i / (taps - 1));
+
+		h[i] = sinc * window;
+		sum += h[i];
+	}
+
+	/* quantise, and put the rounding residue in the centre tap so that DC is exact */
+	int32_t qsum = 0;
+
+	for (unsigned i = 0; i < taps; i++) {
+		float q = h[i] / sum * 32768.0f;
+
+		_coef[i] = (int16_t)((q >= 0.0f) ? (q + 0.5f) : (q - 0.5f));
+		qsum += _coef[i];
+	}
+
+	_coef[mid] += 32768 - qsum;
+
+	_cutoff = cutoff_hz;
+	_taps = taps;
+	_factor = factor;
+
+	return OK;
+}
+
+void
+Decimator::reset()
+{
+	_phase = 0;
+	_newest = 0;
+	_primed = false;
+}
+
+bool
+Decimator::put(const int16_t in[3], int16_t out[3])
+{
+	if (_taps == 1) {
+		out[0] = in[0];
+		out[1] = in[1];
+		out[2] = in[2];
+		return true;
+	}
+
+	/* fill the history with the first sample, so there is no start-up step */
+	if (!_primed) {
+		for (unsigned axis = 0; axis < 3; axis++) {
+			for (unsigned i = 0; i < 2 * _taps; i++)
+				_history[axis][i] = in[axis];
+		}
+
+		_primed = true;
+		_phase = _factor - 1;
+	}
+
+	_newest = (_newest == 0) ? (_taps - 1) : (_newest - 1);
+
+	for (unsigned axis = 0; axis < 3; axis++) {
+		_history[axis][_newest] = in[axis];
+		_history[axis][_newest + _taps] = in[axis];
+	}
+
+	/* only the samples that are reported need filtering */
+	if (++_phase < _factor)
+		return false;
+
+	_phase = 0;
+
+	for (unsigned axis = 0; axis < 3; axis++) {
+		const int16_t *x = &_history[axis][_newest];
+		int32_t acc = 1 << 14;
+
+		for (unsigned i = 0; i < _taps; i++)
+			acc += (int32_t)_coef[i] * x[i];
+
+		acc >>= 15;
+
+		if (acc > 32767) {
+			acc = 32767;
+
+		} else if (acc < -32768) {
+			acc = -32768;
+		}
+
+		out[axis] = acc;
+	}
+
+	return true;
+}
+
+} // namespace device
@@ -0,0 +1,122 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2012 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file Fixed-point anti-aliasing and decimation filter for sensor drivers.
+ */
+
+#ifndef _DEVICE_DECIMATOR_H
+#define _DEVICE_DECIMATOR_H
+
+#include <stdint.h>
+
+namespace device __EXPORT
+{
+
+/**
+ * Lowpass FIR filter and decimator for three-axis sensor samples.
+ *
+ * A driver feeds every raw sample it reads through put(), and only
+ * reports the samples that come out. The filter is a Hamming-windowed
+ * sinc with Q15 coefficients and up to max_taps taps; the output is
+ * decimated as far as the filter's stopband allows, so the reader gets
+ * anti-aliased samples at a rate it can keep up with rather than the
+ * sensor's full rate.
+ *
+ * The coefficients are computed in configure(), in thread context; put()
+ * is integer-only and may be called from interrupt context. The producer
+ * must be stopped while the filter is configured.
+ *
+ * The output lags the input by (taps() - 1) / 2 input samples.
+ */
+class __EXPORT Decimator
+{
+public:
+	static const unsigned	max_taps = 31;
+
+	Decimator();
+
+	/**
+	 * Design the filter.
+	 *
+	 * @param sample_hz	The rate at which samples will be put.
+	 * @param cutoff_hz	The -6dB frequency of the filter. Zero, or a
+	 *			cutoff at or above the Nyquist frequency, passes
+	 *			every sample through unchanged.
+	 * @return		OK, or -EINVAL if sample_hz is zero.
+	 */
+	int			configure(unsigned sample_hz, unsigned cutoff_hz);
+
+	/**
+	 * Forget the sample history; the next sample primes the filter.
+	 */
+	void			reset();
+
+	/**
+	 * Add a sample.
+	 *
+	 * @param in		The raw sample.
+	 * @param out		Receives the filtered sample when one is due;
+	 *			may be the same array as in.
+	 * @return		True if out was written.
+	 */
+	bool			put(const int16_t in[3], int16_t out[3]);
+
+	unsigned		cutoff() const { return _cutoff; }
+	unsigned		taps() const { return _taps; }
+
+	/**
+	 * @return		The number of input samples per output sample.
+	 */
+	unsigned		factor() const { return _factor; }
+
+private:
+	unsigned		_cutoff;
+	unsigned		_taps;
+	unsigned		_factor;
+	unsigned		_phase;		/**< samples since the last output */
+	unsigned		_newest;	/**< history index of the newest sample */
+	bool			_primed;
+
+	int16_t			_coef[max_taps];	/**< Q15 */
+
+	/**
+	 * Sample history per axis, newest first; stored twice over so that
+	 * the taps are always a contiguous run from _newest.
+	 */
+	int16_t			_history[3][2 * max_taps];
+};
+
+} // namespace device
+
+#endif /* _DEVICE_DECIMATOR_H */
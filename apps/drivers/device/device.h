@@ -83,7 +83,7 @@ protected:
 	 */
 	Device(const char *name,
 	       int irq = 0);
-	~Device();
+	virtual ~Device();
 
 	/**
 	 * Initialise the driver and make it ready for use.
@@ -187,7 +187,7 @@ public:
 	/**
 	 * Destructor
 	 */
-	~CDev();
+	virtual ~CDev();
 
 	virtual int	init();
 
@@ -318,6 +318,16 @@ protected:
 	 */
 	virtual void	poll_notify_one(struct pollfd *fds, pollevent_t events);
 
+	/**
+	 * Return the file a poll waiter is polling.
+	 *
+	 * For use by poll_notify_one; fds->priv belongs to the poll machinery.
+	 *
+	 * @param fds		A poll waiter passed to poll_notify_one.
+	 * @return		The file that is being polled.
+	 */
+	static struct file *poll_file(struct pollfd *fds);
+
 	/**
 	 * Notification of the first open.
 	 *
@@ -345,22 +355,38 @@ protected:
 	virtual int	close_last(struct file *filp);
 
 private:
-	static const unsigned _max_pollwaiters = 8;
+	/**
+	 * A poll in progress on the device.
+	 *
+	 * The record is found from the pollfd via fds->priv, so waiters are
+	 * added and removed in constant time. Records are kept for reuse rather
+	 * than freed, so the pool grows to the largest number of simultaneous
+	 * polls the device has seen.
+	 */
+	struct PollWaiter {
+		struct pollfd	*fds;
+		struct file	*filp;
+		PollWaiter	*prev;
+		PollWaiter	*next;
+	};
 
 	const char	*_devname;		/**< device node name */
 	bool		_registered;		/**< true if device name was registered */
 	unsigned	_open_count;		/**< number of successful opens */
 
-	struct pollfd	*_pollset[_max_pollwaiters];
+	PollWaiter	*_pollwaiters;		/**< polls in progress, walked by poll_notify */
+	PollWaiter	*_pollfree;		/**< records for reuse */
 
 	/**
-	 * Store a pollwaiter in a slot where we can find it later.
+	 * Store a pollwaiter where we can find it later.
 	 *
 	 * Expands the pollset as required.  Must be called with the driver locked.
 	 *
+	 * @param filp		The file being polled.
+	 * @param fds		The poll waiter.
 	 * @return		OK, or -errno on error.
 	 */
-	int		store_poll_waiter(struct pollfd *fds);
+	int		store_poll_waiter(struct file *filp, struct pollfd *fds);
 
 	/**
 	 * Remove a poll waiter.
@@ -431,7 +457,7 @@ protected:
 	}
 
 private:
-	uint32_t	_base;
+	uintptr_t	_base;
 };
 
 } // namespace device
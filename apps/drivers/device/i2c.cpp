@@ -40,9 +40,235 @@
 
 #include "i2c.h"
 
+#include <nuttx/config.h>
+
+#include <arch/irq.h>
+
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include <arch/board/up_hrt.h>
+#include <systemlib/perf_counter.h>
+
 namespace device
 {
 
+/**
+ * Transaction queue for an I2C bus.
+ *
+ * One of these is created for each bus the first time a device on it is
+ * initialised. It owns a thread that performs the queued transactions of
+ * all the devices on the bus, one at a time and highest priority first.
+ */
+class I2CBus
+{
+public:
+	/**
+	 * Find the queue for a bus, starting it if necessary.
+	 *
+	 * @param bus		The bus number as passed to up_i2cinitialize.
+	 * @return		The queue, or nullptr if it could not be started.
+	 */
+	static I2CBus	*get(int bus);
+
+	/**
+	 * Queue a transaction; may be called from interrupt context.
+	 *
+	 * @param dev		The device the transaction is addressed to.
+	 * @param t		The transaction.
+	 * @return		OK, or -EBUSY if the transaction is already queued.
+	 */
+	int		submit(I2C *dev, I2C::Transaction *t);
+
+	/**
+	 * @return		The pid of the bus thread.
+	 */
+	pid_t		task() const { return _task; }
+
+	/**
+	 * Print utilisation and queue statistics.
+	 */
+	void		print_info();
+
+private:
+	static const unsigned	_max_buses = 4;
+	static I2CBus		*_buses[_max_buses];
+
+	int			_bus;
+	pid_t			_task;
+	sem_t			_pending;	/**< one count per queued transaction */
+	I2C::Transaction	*_queue;	/**< queued transactions, by descending priority */
+	unsigned		_depth;		/**< number of queued transactions */
+	hrt_abstime		_start;		/**< time the bus thread started */
+	hrt_abstime		_busy;		/**< total time spent performing transactions */
+	perf_counter_t		_transfer_perf;
+	perf_counter_t		_queue_perf;
+	char			_transfer_name[16];	/**< perf counters keep their name pointers */
+	char			_queue_name[16];
+
+	I2CBus(int bus);
+	~I2CBus();
+
+	static int	task_main_trampoline(int argc, char *argv[]);
+	void		task_main() __attribute__((noreturn));
+};
+
+I2CBus	*I2CBus::_buses[I2CBus::_max_buses];
+
+I2CBus::I2CBus(int bus) :
+	_bus(bus),
+	_task(-1),
+	_queue(nullptr),
+	_depth(0),
+	_start(0),
+	_busy(0),
+	_transfer_perf(nullptr),
+	_queue_perf(nullptr)
+{
+	sem_init(&_pending, 0, 0);
+
+	snprintf(_transfer_name, sizeof(_transfer_name), "i2c%d transfer", bus);
+	_transfer_perf = perf_alloc(PC_ELAPSED, _transfer_name);
+	snprintf(_queue_name, sizeof(_queue_name), "i2c%d queue", bus);
+	_queue_perf = perf_alloc(PC_LEVEL, _queue_name);
+}
+
+I2CBus::~I2CBus()
+{
+	perf_free(_transfer_perf);
+	perf_free(_queue_perf);
+	sem_destroy(&_pending);
+}
+
+I2CBus *
+I2CBus::get(int bus)
+{
+	if ((bus < 0) || ((unsigned)bus >= _max_buses))
+		return nullptr;
+
+	/* keep the bus thread from running until we are done with the table */
+	sched_lock();
+
+	if (_buses[bus] == nullptr) {
+		I2CBus *b = new I2CBus(bus);
+
+		if (b != nullptr) {
+			char name[8];
+			char busarg[4];
+			const char *argv[] = { busarg, nullptr };
+
+			snprintf(name, sizeof(name), "i2c%d", bus);
+			snprintf(busarg, sizeof(busarg), "%d", bus);
+			_buses[bus] = b;
+			b->_task = task_create(name,
+					       SCHED_PRIORITY_MAX - 10,
+					       2048,
+					       &I2CBus::task_main_trampoline,
+					       argv);
+
+			if (b->_task < 0) {
+				_buses[bus] = nullptr;
+				delete b;
+			}
+		}
+	}
+
+	I2CBus *result = _buses[bus];
+	sched_unlock();
+
+	return result;
+}
+
+int
+I2CBus::submit(I2C *dev, I2C::Transaction *t)
+{
+	irqstate_t flags = irqsave();
+
+	if (t->_dev != nullptr) {
+		irqrestore(flags);
+		return -EBUSY;
+	}
+
+	t->_dev = dev;
+	t->_address = dev->_address;
+
+	/* insert behind everything of the same or higher priority */
+	I2C::Transaction **pt = &_queue;
+
+	while ((*pt != nullptr) && ((*pt)->priority >= t->priority))
+		pt = &(*pt)->_next;
+
+	t->_next = *pt;
+	*pt = t;
+	perf_set(_queue_perf, ++_depth);
+
+	irqrestore(flags);
+
+	sem_post(&_pending);
+	return OK;
+}
+
+void
+I2CBus::print_info()
+{
+	hrt_abstime elapsed = hrt_absolute_time() - _start;
+
+	printf("i2c%d: %u queued, utilisation %u%%\n",
+	       _bus, _depth, (elapsed > 0) ? (unsigned)((_busy * 100) / elapsed) : 0);
+	perf_print_counter(_transfer_perf);
+	perf_print_counter(_queue_perf);
+}
+
+int
+I2CBus::task_main_trampoline(int argc, char *argv[])
+{
+	_buses[atoi(argv[1])]->task_main();
+}
+
+void
+I2CBus::task_main()
+{
+	_start = hrt_absolute_time();
+
+	for (;;) {
+		/* wait for something to do */
+		while (sem_wait(&_pending) != OK)
+			;
+
+		irqstate_t flags = irqsave();
+		I2C::Transaction *t = _queue;
+		_queue = t->_next;
+		perf_set(_queue_perf, --_depth);
+		irqrestore(flags);
+
+		hrt_abstime start = hrt_absolute_time();
+		perf_begin(_transfer_perf);
+		int result = t->_dev->perform(t);
+		perf_end(_transfer_perf);
+		_busy += hrt_absolute_time() - start;
+
+		/*
+		 * Release the transaction before reporting on it, so that it can be
+		 * submitted again from the completion callback. A synchronous
+		 * transaction lives on the caller's stack and must not be touched
+		 * once the caller has been woken.
+		 */
+		I2C *dev = t->_dev;
+		t->_dev = nullptr;
+
+		if (t->_done != nullptr) {
+			t->_result = result;
+			sem_post(t->_done);
+
+		} else {
+			dev->transaction_complete(t, result);
+		}
+	}
+}
+
 I2C::I2C(const char *name,
 	 const char *devname,
 	 int bus,
@@ -57,7 +283,9 @@ I2C::I2C(const char *name,
 	_bus(bus),
 	_address(address),
 	_frequency(frequency),
-	_dev(nullptr)
+	_dev(nullptr),
+	_priority(PRIORITY_DEFAULT),
+	_scheduler(nullptr)
 {
 }
 
@@ -81,6 +309,15 @@ I2C::init()
 		goto out;
 	}
 
+	// find or start the transaction queue for the bus
+	_scheduler = I2CBus::get(_bus);
+
+	if (_scheduler == nullptr) {
+		debug("failed to start I2C bus thread");
+		ret = -ENOMEM;
+		goto out;
+	}
+
 	// call the probe function to check whether the device is present
 	ret = probe();
 
@@ -113,37 +350,102 @@ I2C::probe()
 
 int
 I2C::transfer(uint8_t *send, unsigned send_len, uint8_t *recv, unsigned recv_len)
+{
+	Transaction t;
+
+//	debug("transfer out %p/%u  in %p/%u", send, send_len, recv, recv_len);
+
+	t.send = send;
+	t.send_len = send_len;
+	t.recv = recv;
+	t.recv_len = recv_len;
+	t.priority = _priority;
+	t.retries = 0;
+	t._dev = nullptr;
+	t._done = nullptr;
+
+	// before init, or on the bus thread (from a completion callback), go direct
+	if ((_scheduler == nullptr) || (getpid() == _scheduler->task()))
+		return perform(&t);
+
+	sem_t done;
+	sem_init(&done, 0, 0);
+	t._done = &done;
+
+	int ret = _scheduler->submit(this, &t);
+
+	if (ret == OK) {
+		while (sem_wait(&done) != OK)
+			;
+
+		ret = t._result;
+	}
+
+	sem_destroy(&done);
+
+	return ret;
+}
+
+int
+I2C::submit(Transaction *t)
+{
+	if (_scheduler == nullptr)
+		return -ENODEV;
+
+	if ((t->send_len == 0) && (t->recv_len == 0))
+		return -EINVAL;
+
+	t->_done = nullptr;
+	return _scheduler->submit(this, t);
+}
+
+void
+I2C::transaction_complete(Transaction *t, int result)
+{
+}
+
+void
+I2C::print_bus_info()
+{
+	if (_scheduler != nullptr)
+		_scheduler->print_info();
+}
+
+int
+I2C::perform(Transaction *t)
 {
 	struct i2c_msg_s msgv[2];
 	unsigned msgs;
+	uint16_t address = (t->_dev != nullptr) ? t->_address : _address;
+	unsigned retries = t->retries;
 	int ret;
 
-//	debug("transfer out %p/%u  in %p/%u", send, send_len, recv, recv_len);
-
 	msgs = 0;
 
-	if (send_len > 0) {
-		msgv[msgs].addr = _address;
+	if (t->send_len > 0) {
+		msgv[msgs].addr = address;
 		msgv[msgs].flags = 0;
-		msgv[msgs].buffer = send;
-		msgv[msgs].length = send_len;
+		msgv[msgs].buffer = t->send;
+		msgv[msgs].length = t->send_len;
 		msgs++;
 	}
 
-	if (recv_len > 0) {
-		msgv[msgs].addr = _address;
+	if (t->recv_len > 0) {
+		msgv[msgs].addr = address;
 		msgv[msgs].flags = I2C_M_READ;
-		msgv[msgs].buffer = recv;
-		msgv[msgs].length = recv_len;
+		msgv[msgs].buffer = t->recv;
+		msgv[msgs].length = t->recv_len;
 		msgs++;
 	}
 
 	if (msgs == 0)
 		return -EINVAL;
 
-	ret = I2C_TRANSFER(_dev, &msgv[0], msgs);
+	do {
+		ret = I2C_TRANSFER(_dev, &msgv[0], msgs);
+	} while ((ret != OK) && (retries-- > 0));
 
 	return ret;
 }
 
-} // namespace device
\ No newline at end of file
+} // namespace device
@@ -42,14 +42,54 @@
 
 #include <nuttx/i2c.h>
 
+#include <semaphore.h>
+
 namespace device __EXPORT 
 {
 
+class I2CBus;
+
 /**
  * Abstract class for character device on I2C
+ *
+ * All transactions on a bus, whether made with transfer() or submit(),
+ * are performed one at a time by a thread belonging to the bus, highest
+ * priority first, so that a device with a time-critical transaction is
+ * not held up behind queued transactions of less important devices.
  */
 class __EXPORT I2C : public CDev
 {
+public:
+	/**
+	 * Transaction priorities; any value may be used, higher goes first.
+	 */
+	static const unsigned	PRIORITY_LOW = 0;
+	static const unsigned	PRIORITY_DEFAULT = 100;
+	static const unsigned	PRIORITY_HIGH = 200;
+
+	/**
+	 * An I2C transaction to be performed asynchronously.
+	 *
+	 * The driver fills in the public fields and passes the transaction to
+	 * submit(); it must not touch it again until transaction_complete()
+	 * has been called for it. The private fields must be zeroed before
+	 * the transaction is first submitted.
+	 */
+	struct Transaction {
+		uint8_t		*send;		/**< bytes to send */
+		unsigned	send_len;	/**< number of bytes to send */
+		uint8_t		*recv;		/**< buffer for bytes received */
+		unsigned	recv_len;	/**< number of bytes to receive */
+		unsigned	priority;	/**< transactions of higher priority are performed first */
+		unsigned	retries;	/**< number of times to retry a failed transfer */
+
+		/* private to the bus */
+		I2C		*_dev;		/**< device that submitted the transaction, nullptr when idle */
+		uint16_t	_address;	/**< device address at the time of submission */
+		Transaction	*_next;		/**< next transaction in the bus queue */
+		sem_t		*_done;		/**< for transfer(), posted on completion */
+		int		_result;	/**< for transfer(), the result */
+	};
 
 protected:
 	/**
@@ -92,6 +132,53 @@ protected:
 	int		transfer(uint8_t *send, unsigned send_len,
 				 uint8_t *recv, unsigned recv_len);
 
+	/**
+	 * Queue an I2C transaction to the device.
+	 *
+	 * May be called from interrupt context, e.g. an hrt_call, or from the
+	 * work queue. The transaction is performed by the bus thread and
+	 * transaction_complete() is called there with the result.
+	 *
+	 * @param t		The transaction.
+	 * @return		OK if the transaction was queued, -EBUSY if it is
+	 *			already queued, -errno otherwise.
+	 */
+	int		submit(Transaction *t);
+
+	/**
+	 * Handle the completion of a transaction queued with submit().
+	 *
+	 * Called on the bus thread. The transaction may be submitted again
+	 * from here. The default implementation does nothing.
+	 *
+	 * @param t		The transaction.
+	 * @param result	OK if the transfer was successful, -errno
+	 *			otherwise.
+	 */
+	virtual void	transaction_complete(Transaction *t, int result);
+
+	/**
+	 * Test whether a transaction is queued or being performed.
+	 *
+	 * @param t		The transaction.
+	 * @return		True until the bus is done with the transaction.
+	 */
+	bool		transaction_busy(Transaction *t) { return t->_dev != nullptr; }
+
+	/**
+	 * Set the priority of transactions made with transfer().
+	 *
+	 * @param priority	The new priority, PRIORITY_DEFAULT initially.
+	 */
+	void		set_priority(unsigned priority) {
+		_priority = priority;
+	}
+
+	/**
+	 * Print the bus utilisation and queue statistics.
+	 */
+	void		print_bus_info();
+
 	/**
 	 * Change the bus address.
 	 *
@@ -105,10 +192,23 @@ protected:
 	}
 
 private:
+	friend class I2CBus;
+
 	int			_bus;
 	uint16_t		_address;
 	uint32_t		_frequency;
 	struct i2c_dev_s	*_dev;
+	unsigned		_priority;
+	I2CBus			*_scheduler;	/**< transaction queue for the bus */
+
+	/**
+	 * Perform a transaction on the bus; called by the bus thread.
+	 *
+	 * @param t		The transaction.
+	 * @return		OK if the transfer was successful, -errno
+	 *			otherwise.
+	 */
+	int			perform(Transaction *t);
 };
 
 } // namespace device
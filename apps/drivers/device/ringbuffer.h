@@ -0,0 +1,324 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2012 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file A report ring buffer shared between a driver's measurement code and its readers.
+ */
+
+#ifndef _DEVICE_RINGBUFFER_H
+#define _DEVICE_RINGBUFFER_H
+
+#include <stddef.h>
+
+namespace device __EXPORT
+{
+
+/**
+ * Single-producer, single-consumer ring buffer of reports.
+ *
+ * The producer is the measurement code, typically running from an
+ * hrt_call or work queue; the consumer is the driver's read(). Neither
+ * side takes a lock or masks interrupts. The producer may discard the
+ * oldest report to make room for a new one (force), so the consumer
+ * claims each report by advancing the tail with a compare-and-swap and
+ * retries if the producer moved it in the meantime.
+ *
+ * Head and tail are free-running positions rather than slot indices;
+ * the slot is the position modulo the size. A tail that has gone round
+ * the ring is then a different value, so a compare-and-swap cannot
+ * mistake it for the one it read (ABA), short of 2^32 reports passing
+ * during one copy. Positions wrap at a multiple of the size so that the
+ * slot mapping stays continuous.
+ */
+template<typename T>
+class __EXPORT RingBuffer
+{
+public:
+	/**
+	 * Constructor.
+	 *
+	 * @param size		Number of reports the buffer holds; if zero, or if
+	 *			the allocation fails, the buffer holds nothing until
+	 *			resized.
+	 */
+	RingBuffer(unsigned size = 0);
+	~RingBuffer();
+
+	/**
+	 * Add a report, unless the buffer is full.
+	 *
+	 * Producer side.
+	 *
+	 * @param val		The report to add.
+	 * @return		True if the report was added.
+	 */
+	bool			put(const T &val);
+
+	/**
+	 * Add a report, discarding the oldest one if the buffer is full.
+	 *
+	 * Producer side. Discarded reports are counted as overflows.
+	 *
+	 * @param val		The report to add.
+	 * @return		True if a report was discarded to make room.
+	 */
+	bool			force(const T &val);
+
+	/**
+	 * Remove the oldest report.
+	 *
+	 * Consumer side.
+	 *
+	 * @param val		Receives the report.
+	 * @return		True if there was a report.
+	 */
+	bool			get(T &val);
+
+	/**
+	 * Remove up to count of the oldest reports, oldest first.
+	 *
+	 * Consumer side.
+	 *
+	 * @param vals		Receives the reports.
+	 * @param count		The number of reports vals has room for.
+	 * @return		The number of reports removed.
+	 */
+	unsigned		get(T *vals, unsigned count);
+
+	/**
+	 * Discard all reports.
+	 *
+	 * Consumer side.
+	 */
+	void			flush();
+
+	/**
+	 * Change the number of reports the buffer holds.
+	 *
+	 * Any reports in the buffer are discarded. The producer must be
+	 * stopped while the buffer is resized.
+	 *
+	 * @param size		The new number of reports; zero frees the buffer.
+	 * @return		True on success; on failure the buffer is unchanged.
+	 */
+	bool			resize(unsigned size);
+
+	bool			empty() const { return _tail == _head; }
+	bool			full() const { return (_buf != nullptr) && (distance(_tail, _head) >= _size); }
+
+	/**
+	 * @return		The number of reports the buffer holds.
+	 */
+	unsigned		size() const { return _size; }
+
+	/**
+	 * @return		The number of reports in the buffer.
+	 */
+	unsigned		count() const;
+
+	/**
+	 * @return		The number of reports discarded by force().
+	 */
+	unsigned		overflows() const { return _overflows; }
+
+private:
+	T			*_buf;
+	unsigned		_size;
+	unsigned		_limit;		/**< positions run from 0 to _limit - 1, a multiple of _size */
+	volatile unsigned	_head;		/**< position of the next report to write, owned by the producer */
+	volatile unsigned	_tail;		/**< position of the oldest report, advanced by both sides */
+	volatile unsigned	_overflows;
+
+	unsigned		next(unsigned pos) const { return ((pos + 1) < _limit) ? (pos + 1) : 0; }
+	unsigned		slot(unsigned pos) const { return pos % _size; }
+	unsigned		distance(unsigned from, unsigned to) const {
+		return (to >= from) ? (to - from) : (to + (_limit - from));
+	}
+
+	/* do not allow copying */
+	RingBuffer(const RingBuffer &);
+	RingBuffer		&operator=(const RingBuffer &);
+};
+
+template<typename T>
+RingBuffer<T>::RingBuffer(unsigned size) :
+	_buf(nullptr),
+	_size(0),
+	_limit(0),
+	_head(0),
+	_tail(0),
+	_overflows(0)
+{
+	if (size > 0)
+		resize(size);
+}
+
+template<typename T>
+RingBuffer<T>::~RingBuffer()
+{
+	if (_buf != nullptr)
+		delete[] _buf;
+}
+
+template<typename T>
+bool
+RingBuffer<T>::put(const T &val)
+{
+	unsigned head = _head;
+
+	if ((_buf == nullptr) || (distance(_tail, head) >= _size))
+		return false;
+
+	_buf[slot(head)] = val;
+
+	/* the report must be complete before the consumer can see it */
+	__sync_synchronize();
+	_head = next(head);
+
+	return true;
+}
+
+template<typename T>
+bool
+RingBuffer<T>::force(const T &val)
+{
+	bool discarded = false;
+
+	if (_buf == nullptr)
+		return false;
+
+	while (!put(val)) {
+		unsigned tail = _tail;
+
+		/*
+		 * The consumer may have made room since put() looked, or emptied
+		 * the ring altogether; only discard if it is full at this tail.
+		 * If the consumer moves the tail after this check, the
+		 * compare-and-swap fails and we look again.
+		 */
+		if (distance(tail, _head) < _size)
+			continue;
+
+		if (__sync_bool_compare_and_swap(&_tail, tail, next(tail))) {
+			_overflows++;
+			discarded = true;
+		}
+	}
+
+	return discarded;
+}
+
+template<typename T>
+bool
+RingBuffer<T>::get(T &val)
+{
+	for (;;) {
+		unsigned tail = _tail;
+
+		if (tail == _head)
+			return false;
+
+		/* don't read the report before seeing that it was published */
+		__sync_synchronize();
+		val = _buf[slot(tail)];
+
+		/*
+		 * If the producer discarded this report while we were copying it,
+		 * the copy may be torn; the tail will have moved, so try again.
+		 */
+		if (__sync_bool_compare_and_swap(&_tail, tail, next(tail)))
+			return true;
+	}
+}
+
+template<typename T>
+unsigned
+RingBuffer<T>::get(T *vals, unsigned count)
+{
+	unsigned n = 0;
+
+	while ((n < count) && get(vals[n]))
+		n++;
+
+	return n;
+}
+
+template<typename T>
+void
+RingBuffer<T>::flush()
+{
+	T junk;
+
+	while (get(junk))
+		;
+}
+
+template<typename T>
+bool
+RingBuffer<T>::resize(unsigned size)
+{
+	T *buf = nullptr;
+
+	if (size > 0) {
+		buf = new T[size];
+
+		if (buf == nullptr)
+			return false;
+	}
+
+	if (_buf != nullptr)
+		delete[] _buf;
+
+	_buf = buf;
+	_size = (buf != nullptr) ? size : 0;
+	_limit = (buf != nullptr) ? (size * (~0U / size)) : 0;
+	_head = _tail = 0;
+
+	return true;
+}
+
+template<typename T>
+unsigned
+RingBuffer<T>::count() const
+{
+	unsigned tail = _tail;
+	unsigned head = _head;
+	unsigned n = (_buf != nullptr) ? distance(tail, head) : 0;
+
+	/* the producer may have discarded and refilled between the two reads */
+	return (n < _size) ? n : _size;
+}
+
+} // namespace device
+
+#endif /* _DEVICE_RINGBUFFER_H */
@@ -39,10 +39,16 @@
 
 #include "spi.h"
 
+#include <arch/irq.h>
+
 #ifndef CONFIG_SPI_EXCHANGE
 # error This driver requires CONFIG_SPI_EXCHANGE
 #endif
 
+#ifndef CONFIG_SCHED_WORKQUEUE
+# error Burst transfers require CONFIG_SCHED_WORKQUEUE
+#endif
+
 namespace device
 {
 
@@ -62,12 +68,20 @@ SPI::SPI(const char *name,
 	_device(device),
 	_mode(mode),
 	_frequency(frequency),
-	_dev(nullptr)
+	_dev(nullptr),
+	_burst_send(nullptr),
+	_burst_recv(nullptr),
+	_burst_len(0),
+	_burst_chained(false)
 {
+	// work_cancel in the dtor will explode if we don't do this...
+	_burst_work.worker = nullptr;
 }
 
 SPI::~SPI()
 {
+	burst_cancel();
+
 	// XXX no way to let go of the bus...
 }
 
@@ -139,4 +153,99 @@ SPI::transfer(uint8_t *send, uint8_t *recv, unsigned len)
 	return OK;
 }
 
-} // namespace device
\ No newline at end of file
+int
+SPI::burst_start(uint8_t *send, uint8_t *recv, unsigned len)
+{
+	if ((recv == nullptr) || (len == 0))
+		return -EINVAL;
+
+	/* claim the burst; we may be racing another caller in interrupt context */
+	irqstate_t flags = irqsave();
+
+	if (_burst_len != 0) {
+		irqrestore(flags);
+		return -EBUSY;
+	}
+
+	_burst_send = send;
+	_burst_recv = recv;
+	_burst_len = len;
+
+	irqrestore(flags);
+
+	int ret = work_queue(&_burst_work, (worker_t)&SPI::burst_trampoline, this, 0);
+
+	if (ret != OK)
+		_burst_len = 0;
+
+	return ret;
+}
+
+void
+SPI::burst_complete(uint8_t *recv, unsigned len, int result)
+{
+}
+
+int
+SPI::burst_chain(uint8_t *send, uint8_t *recv, unsigned len)
+{
+	if ((recv == nullptr) || (len == 0))
+		return -EINVAL;
+
+	/* the completing burst still holds _burst_len, so nobody else can claim it */
+	_burst_send = send;
+	_burst_recv = recv;
+	_burst_len = len;
+	_burst_chained = true;
+
+	int ret = work_queue(&_burst_work, (worker_t)&SPI::burst_trampoline, this, 0);
+
+	/* burst_run will release the burst */
+	if (ret != OK)
+		_burst_chained = false;
+
+	return ret;
+}
+
+void
+SPI::burst_cancel()
+{
+	irqstate_t flags = irqsave();
+
+	/*
+	 * The work queue clears the worker pointer as it dequeues the work;
+	 * after that the transfer is running and clears _burst_len itself.
+	 */
+	if (_burst_work.worker != nullptr) {
+		work_cancel(&_burst_work);
+		_burst_len = 0;
+	}
+
+	irqrestore(flags);
+}
+
+void
+SPI::burst_trampoline(void *arg)
+{
+	SPI *dev = reinterpret_cast<SPI *>(arg);
+
+	dev->burst_run();
+}
+
+void
+SPI::burst_run()
+{
+	uint8_t *recv = _burst_recv;
+	unsigned len = _burst_len;
+
+	int result = transfer(_burst_send, recv, len);
+
+	/* keep the burst claimed while the driver handles it */
+	_burst_chained = false;
+	burst_complete(recv, len, result);
+
+	if (!_burst_chained)
+		_burst_len = 0;
+}
+
+} // namespace device
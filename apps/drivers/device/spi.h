@@ -41,6 +41,7 @@
 #include "device.h"
 
 #include <nuttx/spi.h>
+#include <nuttx/wqueue.h>
 
 namespace device __EXPORT
 {
@@ -93,12 +94,95 @@ protected:
 	 */
 	int		transfer(uint8_t *send, uint8_t *recv, unsigned len);
 
+	/**
+	 * Start an asynchronous burst transfer.
+	 *
+	 * The transfer is performed as a single chip-select transaction on the
+	 * work queue thread, using DMA where the SPI driver supports it, and
+	 * burst_complete is called there when it is done. This lets a driver
+	 * drain a sensor FIFO in one transaction from its hrt_call without
+	 * blocking the caller or the reader of the device.
+	 *
+	 * May be called from interrupt context. The buffers must remain valid
+	 * until burst_complete has been called.
+	 *
+	 * @param send		Bytes to send to the device, or nullptr to send
+	 *			whatever the SPI driver sends when receiving.
+	 * @param recv		Buffer for the bytes received from the device.
+	 * @param len		Number of bytes to transfer.
+	 * @return		OK if the transfer was started, -EBUSY if a burst
+	 *			is already in progress, -errno otherwise.
+	 */
+	int		burst_start(uint8_t *send, uint8_t *recv, unsigned len);
+
+	/**
+	 * Handle the completion of a burst transfer.
+	 *
+	 * Called on the work queue thread. A driver would typically unpack the
+	 * received FIFO contents into its report ring and call poll_notify.
+	 * The burst stays busy until this returns, so burst_start from
+	 * interrupt context cannot overwrite the buffers or any state that
+	 * goes with them; use burst_chain to follow on with another burst.
+	 *
+	 * The default implementation does nothing.
+	 *
+	 * @param recv		The receive buffer passed to burst_start.
+	 * @param len		Number of bytes transferred.
+	 * @param result	OK if the exchange was successful, -errno otherwise.
+	 */
+	virtual void	burst_complete(uint8_t *recv, unsigned len, int result);
+
+	/**
+	 * Queue a follow-on burst transfer from burst_complete.
+	 *
+	 * The burst stays busy from the completed transfer to the end of the
+	 * chained one. Must only be called from burst_complete.
+	 *
+	 * @param send		Bytes to send to the device, as for burst_start.
+	 * @param recv		Buffer for the bytes received from the device.
+	 * @param len		Number of bytes to transfer.
+	 * @return		OK if the transfer was queued, -errno otherwise.
+	 */
+	int		burst_chain(uint8_t *send, uint8_t *recv, unsigned len);
+
+	/**
+	 * Test whether a burst transfer is in progress.
+	 */
+	bool		burst_busy() { return _burst_len != 0; }
+
+	/**
+	 * Cancel a burst transfer that has not started yet.
+	 *
+	 * A transfer that is already running on the work queue still
+	 * completes; drivers stopping measurement should wait for
+	 * burst_busy() to clear before freeing the buffers.
+	 */
+	void		burst_cancel();
+
 private:
 	int			_bus;
 	enum spi_dev_e		_device;
 	enum spi_mode_e		_mode;
 	uint32_t		_frequency;
 	struct spi_dev_s	*_dev;
+
+	struct work_s		_burst_work;
+	uint8_t			*_burst_send;
+	uint8_t			*_burst_recv;
+	volatile unsigned	_burst_len;	/**< nonzero while a burst is queued, running or completing */
+	bool			_burst_chained;	/**< burst_complete queued a follow-on burst */
+
+	/**
+	 * Perform a queued burst transfer.
+	 */
+	void			burst_run();
+
+	/**
+	 * Bridge from the work queue to burst_run.
+	 *
+	 * @param arg		SPI pointer for which the burst is performed.
+	 */
+	static void		burst_trampoline(void *arg);
 };
 
 } // namespace device
@@ -50,9 +50,12 @@
  * structure.
  */
 struct accel_report {
-	float x;
+	float x;		/**< acceleration in m/s^2 */
 	float y;
 	float z;
+	int16_t x_raw;		/**< unscaled sensor value */
+	int16_t y_raw;
+	int16_t z_raw;
 	uint64_t timestamp;
 };
 
@@ -90,7 +93,10 @@ ORB_DECLARE(sensor_accel);
 /** set the accel internal sample rate to at least (arg) Hz */
 #define ACCELIOCSSAMPLERATE	_ACCELIOC(2)
 
-/** set the accel internal lowpass filter to no lower than (arg) Hz */
+/**
+ * set the accel lowpass filter to no lower than (arg) Hz, zero for none; drivers
+ * with a digital filter report at the lowest rate that carries its passband
+ */
 #define ACCELIOCSLOWPASS	_ACCELIOC(3)
 
 /** set the report format to (arg); zero is the standard, 1-10 are reserved, all others are driver-specific. */
@@ -50,9 +50,12 @@
  * structure.
  */
 struct gyro_report {
-	float x;
+	float x;		/**< angular velocity in rad/s */
 	float y;
 	float z;
+	int16_t x_raw;		/**< unscaled sensor value */
+	int16_t y_raw;
+	int16_t z_raw;
 	uint64_t timestamp;
 };
 
@@ -90,7 +93,10 @@ ORB_DECLARE(sensor_gyro);
 /** set the gyro internal sample rate to at least (arg) Hz */
 #define GYROIOCSSAMPLERATE	_GYROIOC(2)
 
-/** set the gyro internal lowpass filter to no lower than (arg) Hz */
+/**
+ * set the gyro lowpass filter to no lower than (arg) Hz, zero for none; drivers
+ * with a digital filter report at the lowest rate that carries its passband
+ */
 #define GYROIOCSLOWPASS		_GYROIOC(3)
 
 /** set the report format to (arg); zero is the standard, 1-10 are reserved, all others are driver-specific. */
@@ -99,4 +105,10 @@ ORB_DECLARE(sensor_gyro);
 /** set the gyro scaling constants to (arg) */
 #define GYROIOCSSCALE		_GYROIOC(5)
 
+/** set the gyro measurement range to handle at least (arg) degrees per second */
+#define GYROIOCSRANGE		_GYROIOC(6)
+
+/** return the rate in Hz at which the driver produces reports in *(unsigned *)arg, zero when polled manually */
+#define GYROIOCGETRATE		_GYROIOC(7)
+
 #endif /* _DRV_GYRO_H */
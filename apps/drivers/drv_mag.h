@@ -50,9 +50,12 @@
  * structure.
  */
 struct mag_report {
-	float x;
+	float x;		/**< magnetic field in Gauss */
 	float y;
 	float z;
+	int16_t x_raw;		/**< unscaled sensor value */
+	int16_t y_raw;
+	int16_t z_raw;
 	uint64_t timestamp;
 };
 
@@ -76,7 +79,7 @@ ORB_DECLARE(sensor_mag);
  */
 
 #define _MAGIOCBASE		(0x2300)
-#define _MAGIOC(_n)		(_IOC(_MAGIOBASE, _n))
+#define _MAGIOC(_n)		(_IOC(_MAGIOCBASE, _n))
 
 /** set the driver polling rate to (arg) Hz, or one of the MAG_POLLRATE constants */
 #define MAGIOCSPOLLRATE		_MAGIOC(0)
@@ -99,4 +102,7 @@ ORB_DECLARE(sensor_mag);
 /** set the mag scaling constants to the structure pointed to by (arg) */
 #define MAGIOCSSCALE		_MAGIOC(5)
 
+/** set the mag measurement range to handle at least (arg) Gauss */
+#define MAGIOCSRANGE		_MAGIOC(6)
+
 #endif /* _DRV_MAG_H */
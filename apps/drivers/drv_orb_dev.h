@@ -58,6 +58,9 @@
 /** maximum ogbject name length */
 #define ORB_MAXNAME		32
 
+/** maximum number of updates a topic can queue for its subscribers */
+#define ORB_MAX_QUEUE_SIZE	32
+
 #define _ORBIOCBASE		(0x2500)
 #define _ORBIOC(_n)		(_IOC(_ORBIOCBASE, _n))
 
@@ -81,4 +84,22 @@
 /** Set the minimum interval at which the topic can be seen to be updated for this subscription */
 #define ORBIOCSETINTERVAL	_ORBIOC(12)
 
+/** Set the number of updates the topic queues for its subscribers to (arg) */
+#define ORBIOCSETQUEUESIZE	_ORBIOC(13)
+
+/**
+ * Fetch the number of queued updates this subscription has lost to overruns into *(unsigned *)arg.
+ * Updates skipped by a subscription with an interval set are not counted.
+ */
+#define ORBIOCGETOVERRUNS	_ORBIOC(14)
+
+/** Reserve the slot for the next update and return a pointer to it in *(void **)arg */
+#define ORBIOCPUBLISHBEGIN	_ORBIOC(15)
+
+/** Publish the update written to the slot reserved by ORBIOCPUBLISHBEGIN */
+#define ORBIOCPUBLISHCOMMIT	_ORBIOC(16)
+
+/** Make the subscription a member of a wait set, or remove it if (arg) is zero; internal to the uORB library */
+#define ORBIOCSETWAITSET	_ORBIOC(17)
+
 #endif /* _DRV_UORB_H */
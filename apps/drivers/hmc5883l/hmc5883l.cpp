@@ -0,0 +1,740 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2012 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file Driver for the Honeywell HMC5883L magnetometer connected via I2C.
+ */
+
+#include <nuttx/config.h>
+
+#include <drivers/device/i2c.h>
+#include <drivers/device/ringbuffer.h>
+
+#include <sys/types.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <semaphore.h>
+#include <string.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <errno.h>
+#include <stdio.h>
+#include <math.h>
+#include <unistd.h>
+
+#include <nuttx/arch.h>
+#include <nuttx/clock.h>
+
+#include <arch/board/board.h>
+#include <arch/board/up_hrt.h>
+
+#include <drivers/drv_mag.h>
+
+/* register addresses */
+#define ADDR_CONF_A			0x00
+#define CONF_A_RATE_MASK			(7<<2)
+#define CONF_A_AVERAGING_8			(3<<5)
+
+#define ADDR_CONF_B			0x01
+#define CONF_B_GAIN_SHIFT			5
+
+#define ADDR_MODE			0x02
+#define MODE_REG_CONTINOUS_MODE			(0<<0)
+
+#define ADDR_DATA_OUT_X_MSB		0x03
+#define ADDR_STATUS			0x09
+#define ADDR_ID_A			0x0A
+#define ID_A_WHO_AM_I				'H'
+#define ID_B_WHO_AM_I				'4'
+#define ID_C_WHO_AM_I				'3'
+
+/* default settings */
+#define HMC5883L_DEFAULT_RATE		75	/* Hz */
+#define HMC5883L_DEFAULT_RANGE_GA	1
+
+extern "C" { __EXPORT int hmc5883l_main(int argc, char *argv[]); }
+
+class HMC5883L : public device::I2C
+{
+public:
+	HMC5883L(int bus);
+	~HMC5883L();
+
+	virtual int		init();
+
+	virtual ssize_t		read(struct file *filp, char *buffer, size_t buflen);
+	virtual int		ioctl(struct file *filp, int cmd, unsigned long arg);
+
+	virtual int		open_first(struct file *filp);
+	virtual int		close_last(struct file *filp);
+
+	/**
+	 * Diagnostics - print some basic information about the driver.
+	 */
+	void			print_info();
+
+protected:
+	virtual int		probe();
+
+	virtual void		transaction_complete(Transaction *t, int result);
+
+private:
+
+	struct hrt_call		_call;
+	unsigned		_call_interval;
+
+	device::RingBuffer<struct mag_report>	_reports;
+
+	struct mag_scale	_scale;
+	float			_range_scale;
+
+	int			_mag_topic;
+
+	Transaction		_txn;			/**< data register read queued from the hrt_call */
+	uint8_t			_cmd;
+	uint8_t			_raw[6];		/**< data registers, big-endian X, Z, Y */
+	hrt_abstime		_raw_timestamp;		/**< time the read for _raw was queued */
+
+	unsigned		_reads;
+	unsigned		_read_errors;
+	unsigned		_overruns;		/**< measurements skipped because the previous read was still queued */
+
+	/**
+	 * Start automatic measurement.
+	 */
+	void			start();
+
+	/**
+	 * Stop automatic measurement.
+	 *
+	 * Waits for a queued read to complete, so that the report ring may be
+	 * modified when this returns.
+	 */
+	void			stop();
+
+	/**
+	 * Static trampoline from the hrt_call context; because we don't have a
+	 * generic hrt wrapper yet.
+	 *
+	 * Called by the HRT in interrupt context at the specified rate if
+	 * automatic polling is enabled.
+	 *
+	 * @param arg		Instance pointer for the driver that is polling.
+	 */
+	static void		measure_trampoline(void *arg);
+
+	/**
+	 * Queue a read of the data registers on the bus.
+	 */
+	void			measure();
+
+	/**
+	 * Turn the registers in _raw into a report and post it.
+	 */
+	void			collect();
+
+	/**
+	 * Write a register in the HMC5883L
+	 *
+	 * @param reg		The register to write.
+	 * @param value		The new value to write.
+	 * @return		OK on success, -errno otherwise.
+	 */
+	int			write_reg(uint8_t reg, uint8_t value);
+
+	/**
+	 * Set the HMC5883L measurement range.
+	 *
+	 * @param max_ga	The range is set to permit reading at least
+	 *			this field strength in Gauss.
+	 * @return		OK if the value can be supported, -ERANGE otherwise.
+	 */
+	int			set_range(unsigned max_ga);
+
+	/**
+	 * Set the HMC5883L output data rate.
+	 *
+	 * @param frequency	The output rate is set to not less than this value.
+	 * @return		OK if the value can be supported, -ERANGE otherwise.
+	 */
+	int			set_samplerate(unsigned frequency);
+};
+
+HMC5883L::HMC5883L(int bus) :
+	I2C("HMC5883L", MAG_DEVICE_PATH, bus, PX4_I2C_OBDEV_HMC5883, 400000),
+	_call_interval(0),
+	_range_scale(0.0f),
+	_mag_topic(-1),
+	_cmd(ADDR_DATA_OUT_X_MSB),
+	_raw_timestamp(0),
+	_reads(0),
+	_read_errors(0),
+	_overruns(0)
+{
+	// enable debug() calls
+	_debug_enabled = true;
+
+	// the mag is read at a fixed rate; don't let slower devices on the bus delay it
+	set_priority(PRIORITY_HIGH);
+
+	// default scale factors
+	_scale.x_offset = 0;
+	_scale.x_scale  = 1.0f;
+	_scale.y_offset = 0;
+	_scale.y_scale  = 1.0f;
+	_scale.z_offset = 0;
+	_scale.z_scale  = 1.0f;
+
+	memset(&_call, 0, sizeof(_call));
+
+	// the read transaction is the same every time
+	memset(&_txn, 0, sizeof(_txn));
+	_txn.send = &_cmd;
+	_txn.send_len = 1;
+	_txn.recv = &_raw[0];
+	_txn.recv_len = sizeof(_raw);
+	_txn.priority = PRIORITY_HIGH;
+	_txn.retries = 1;
+}
+
+HMC5883L::~HMC5883L()
+{
+	/* make sure we are truly inactive */
+	stop();
+}
+
+int
+HMC5883L::init()
+{
+	int ret;
+
+	/* do I2C init (and probe) first */
+	ret = I2C::init();
+
+	/* if probe/setup successful, finish chip init */
+	if (ret == OK) {
+
+		set_range(HMC5883L_DEFAULT_RANGE_GA);
+		set_samplerate(HMC5883L_DEFAULT_RATE);
+
+		/* measure continuously, so that a read is a single transaction */
+		write_reg(ADDR_MODE, MODE_REG_CONTINOUS_MODE);
+
+		/*
+		 * Publish as the next free instance so that a second mag can
+		 * coexist. If this fails (e.g. no object in the system) that's OK.
+		 */
+		struct mag_report m;
+		memset(&m, 0, sizeof(m));
+		_mag_topic = orb_advertise_multi(ORB_ID(sensor_mag), &m, nullptr);
+
+		if (_mag_topic < 0)
+			debug("failed to create sensor_mag object");
+	}
+
+	return ret;
+}
+
+int
+HMC5883L::open_first(struct file *filp)
+{
+	/* reset to manual-poll mode */
+	_call_interval = 0;
+
+	/* allocate basic report buffers */
+	if (!_reports.resize(2))
+		return -ENOMEM;
+
+	return OK;
+}
+
+int
+HMC5883L::close_last(struct file *filp)
+{
+	/* stop measurement */
+	stop();
+
+	/* free report buffers */
+	_reports.resize(0);
+
+	_call_interval = 0;
+
+	return OK;
+}
+
+int
+HMC5883L::probe()
+{
+	uint8_t cmd = ADDR_ID_A;
+	uint8_t id[3];
+
+	if (OK != transfer(&cmd, 1, &id[0], sizeof(id)))
+		return -EIO;
+
+	if ((id[0] != ID_A_WHO_AM_I) ||
+	    (id[1] != ID_B_WHO_AM_I) ||
+	    (id[2] != ID_C_WHO_AM_I))
+		return -EIO;
+
+	return OK;
+}
+
+ssize_t
+HMC5883L::read(struct file *filp, char *buffer, size_t buflen)
+{
+	unsigned count = buflen / sizeof(struct mag_report);
+	int ret = 0;
+
+	/* buffer must be large enough */
+	if (count < 1)
+		return -ENOSPC;
+
+	/* if automatic measurement is enabled */
+	if (_call_interval > 0) {
+
+		/*
+		 * Copy as many reports as there are, up to the space in the caller's
+		 * buffer. The ring is safe against the measurement code pre-empting us.
+		 */
+		ret = _reports.get(reinterpret_cast<struct mag_report *>(buffer), count) * sizeof(struct mag_report);
+
+		_reads++;
+
+		/* if there was no data, warn the caller */
+		return ret ? ret : -EAGAIN;
+	}
+
+	/* manual measurement; the device is measuring continuously */
+	_reports.flush();
+	_raw_timestamp = hrt_absolute_time();
+
+	if (OK != transfer(&_cmd, 1, &_raw[0], sizeof(_raw))) {
+		_read_errors++;
+		return -EIO;
+	}
+
+	collect();
+
+	/* measurement will have generated a report, copy it out */
+	if (_reports.get(*reinterpret_cast<struct mag_report *>(buffer)))
+		ret = sizeof(struct mag_report);
+
+	return ret;
+}
+
+int
+HMC5883L::ioctl(struct file *filp, int cmd, unsigned long arg)
+{
+	switch (cmd) {
+
+	case MAGIOCSPOLLRATE: {
+			switch (arg) {
+
+				/* switching to manual polling */
+			case MAG_POLLRATE_MANUAL:
+				stop();
+				_call_interval = 0;
+				return OK;
+
+				/* external signalling not supported */
+			case MAG_POLLRATE_EXTERNAL:
+
+				/* zero would be bad */
+			case 0:
+				return -EINVAL;
+
+				/* adjust to a legal polling interval in Hz */
+			default: {
+					/* do we need to start internal polling? */
+					bool want_start = (_call_interval == 0);
+
+					/* convert hz to hrt interval via microseconds */
+					unsigned ticks = 1000000 / arg;
+
+					/* check against maximum rate */
+					if (ticks < (1000000 / HMC5883L_DEFAULT_RATE))
+						return -EINVAL;
+
+					/* update interval for next measurement */
+					/* XXX this is a bit shady, but no other way to adjust... */
+					_call_interval = ticks;
+					_call.period = _call_interval;
+
+					/* if we need to start the poll state machine, do it */
+					if (want_start)
+						start();
+
+					return OK;
+				}
+			}
+		}
+
+	case MAGIOCSQUEUEDEPTH: {
+			/* lower bound is mandatory, upper bound is a sanity check */
+			if ((arg < 2) || (arg > 100))
+				return -EINVAL;
+
+			/* the ring must not be written while it is resized */
+			stop();
+
+			int ret = _reports.resize(arg) ? OK : -ENOMEM;
+
+			/* restart automatic measurement if it was running */
+			if (_call_interval > 0)
+				start();
+
+			return ret;
+		}
+
+	case MAGIOCSSAMPLERATE:
+		return set_samplerate(arg);
+
+	case MAGIOCSRANGE:
+		return set_range(arg);
+
+	case MAGIOCSSCALE:
+		/* copy scale in */
+		memcpy(&_scale, (struct mag_scale *)arg, sizeof(_scale));
+		return OK;
+
+	case MAGIOCSLOWPASS:		/* no on-chip filter beyond averaging */
+	case MAGIOCSREPORTFORMAT:	/* no alternate report formats */
+		return -EINVAL;
+
+	default:
+		/* give it to the superclass */
+		return I2C::ioctl(filp, cmd, arg);
+	}
+}
+
+int
+HMC5883L::write_reg(uint8_t reg, uint8_t value)
+{
+	uint8_t cmd[2] = { reg, value };
+
+	return transfer(&cmd[0], sizeof(cmd), nullptr, 0);
+}
+
+int
+HMC5883L::set_range(unsigned max_ga)
+{
+	uint8_t gain;
+	float lsb_per_ga;
+
+	if (max_ga > 8) {
+		return -ERANGE;
+
+	} else if (max_ga > 5) {	/* 8.1Ga */
+		gain = 7;
+		lsb_per_ga = 230.0f;
+
+	} else if (max_ga > 4) {	/* 5.6Ga */
+		gain = 6;
+		lsb_per_ga = 330.0f;
+
+	} else if (max_ga > 2) {	/* 4.0Ga */
+		gain = 4;
+		lsb_per_ga = 440.0f;
+
+	} else if (max_ga > 1) {	/* 2.5Ga */
+		gain = 3;
+		lsb_per_ga = 660.0f;
+
+	} else if (max_ga > 0) {	/* 1.3Ga */
+		gain = 1;
+		lsb_per_ga = 1090.0f;
+
+	} else {			/* 0.88Ga */
+		gain = 0;
+		lsb_per_ga = 1370.0f;
+	}
+
+	/* adjust sensor configuration */
+	if (OK != write_reg(ADDR_CONF_B, gain << CONF_B_GAIN_SHIFT))
+		return -EIO;
+
+	_range_scale = 1.0f / lsb_per_ga;
+
+	return OK;
+}
+
+int
+HMC5883L::set_samplerate(unsigned frequency)
+{
+	uint8_t rate;
+
+	if (frequency > 75) {
+		return -ERANGE;
+
+	} else if (frequency > 30) {
+		rate = 6;
+
+	} else if (frequency > 15) {
+		rate = 5;
+
+	} else if (frequency > 7) {
+		rate = 4;
+
+	} else if (frequency > 3) {
+		rate = 3;
+
+	} else if (frequency > 1) {
+		rate = 2;
+
+	} else {
+		rate = 1;
+	}
+
+	/* adjust sensor configuration */
+	if (OK != write_reg(ADDR_CONF_A, CONF_A_AVERAGING_8 | (rate << 2)))
+		return -EIO;
+
+	return OK;
+}
+
+void
+HMC5883L::start()
+{
+	/* make sure we are stopped first */
+	stop();
+
+	/* reset the report ring */
+	_reports.flush();
+
+	/* start polling at the specified rate */
+	hrt_call_every(&_call, 1000, _call_interval, (hrt_callout)&HMC5883L::measure_trampoline, this);
+}
+
+void
+HMC5883L::stop()
+{
+	hrt_cancel(&_call);
+
+	/* a read that has been queued will still report; let it */
+	while (transaction_busy(&_txn))
+		usleep(1000);
+}
+
+void
+HMC5883L::measure_trampoline(void *arg)
+{
+	HMC5883L *dev = (HMC5883L *)arg;
+
+	/* make another measurement */
+	dev->measure();
+}
+
+void
+HMC5883L::measure()
+{
+	/*
+	 * Queue a read of the data registers; the bus thread performs it ahead
+	 * of any lower-priority transactions and calls transaction_complete.
+	 */
+	_raw_timestamp = hrt_absolute_time();
+
+	if (OK != submit(&_txn))
+		_overruns++;
+}
+
+void
+HMC5883L::transaction_complete(Transaction *t, int result)
+{
+	if (result != OK) {
+		_read_errors++;
+		return;
+	}
+
+	collect();
+}
+
+void
+HMC5883L::collect()
+{
+	struct mag_report report;
+
+	/* registers are big-endian, in X, Z, Y order */
+	report.timestamp = _raw_timestamp;
+	report.x_raw = (int16_t)((_raw[0] << 8) | _raw[1]);
+	report.z_raw = (int16_t)((_raw[2] << 8) | _raw[3]);
+	report.y_raw = (int16_t)((_raw[4] << 8) | _raw[5]);
+	report.x = (report.x_raw * _range_scale) * _scale.x_scale + _scale.x_offset;
+	report.y = (report.y_raw * _range_scale) * _scale.y_scale + _scale.y_offset;
+	report.z = (report.z_raw * _range_scale) * _scale.z_scale + _scale.z_offset;
+
+	/* post a report to the ring, dropping the oldest if the reader is behind */
+	_reports.force(report);
+
+	/* notify anyone waiting for data */
+	poll_notify(POLLIN);
+
+	/* and publish for subscribers */
+	if (_mag_topic >= 0)
+		orb_publish(ORB_ID(sensor_mag), _mag_topic, &report);
+}
+
+void
+HMC5883L::print_info()
+{
+	printf("reads:          %u\n", _reads);
+	printf("read errors:    %u\n", _read_errors);
+	printf("overruns:       %u\n", _overruns);
+	printf("poll interval:  %u us\n", _call_interval);
+	printf("report queue:   %u/%u, %u overflows\n",
+	       _reports.count(), _reports.size(), _reports.overflows());
+	print_bus_info();
+}
+
+/**
+ * Local functions in support of the shell command.
+ */
+namespace
+{
+
+HMC5883L	*g_dev;
+
+/*
+ * XXX this should just be part of the generic sensors test...
+ */
+
+int
+test()
+{
+	int fd = -1;
+	struct mag_report report;
+	ssize_t sz;
+	const char *reason = "test OK";
+
+	do {
+
+		/* get the driver */
+		fd = open(MAG_DEVICE_PATH, O_RDONLY);
+
+		if (fd < 0) {
+			reason = "can't open driver";
+			break;
+		}
+
+		/* do a simple demand read */
+		sz = read(fd, &report, sizeof(report));
+
+		if (sz != sizeof(report)) {
+			reason = "immediate read failed";
+			break;
+		}
+
+		printf("single read\n");
+		fflush(stdout);
+		printf("time:        %lld\n", report.timestamp);
+		printf("x:           %f\t(%d raw)\n", report.x, report.x_raw);
+		printf("y:           %f\t(%d raw)\n", report.y, report.y_raw);
+		printf("z:           %f\t(%d raw)\n", report.z, report.z_raw);
+
+	} while (0);
+
+	if (fd >= 0)
+		close(fd);
+
+	printf("HMC5883L: %s\n", reason);
+
+	return OK;
+}
+
+int
+info()
+{
+	if (g_dev == nullptr) {
+		fprintf(stderr, "HMC5883L: driver not running\n");
+		return -ENOENT;
+	}
+
+	printf("state @ %p\n", g_dev);
+	g_dev->print_info();
+
+	return OK;
+}
+
+
+} // namespace
+
+int
+hmc5883l_main(int argc, char *argv[])
+{
+	/*
+	 * Start/load the driver.
+	 *
+	 * XXX it would be nice to have a wrapper for this...
+	 */
+	if (!strcmp(argv[1], "start")) {
+
+		if (g_dev != nullptr) {
+			fprintf(stderr, "HMC5883L: already loaded\n");
+			return -EBUSY;
+		}
+
+		/* create the driver */
+		g_dev = new HMC5883L(PX4_I2C_BUS_ONBOARD);
+
+		if (g_dev == nullptr) {
+			fprintf(stderr, "HMC5883L: driver alloc failed\n");
+			return -ENOMEM;
+		}
+
+		if (OK != g_dev->init()) {
+			fprintf(stderr, "HMC5883L: driver init failed\n");
+			usleep(100000);
+			delete g_dev;
+			g_dev = nullptr;
+			return -EIO;
+		}
+
+		printf("HMC5883L: driver started\n");
+		return OK;
+	}
+
+	/*
+	 * Test the driver/device.
+	 */
+	if (!strcmp(argv[1], "test"))
+		return test();
+
+	/*
+	 * Print driver information.
+	 */
+	if (!strcmp(argv[1], "info"))
+		return info();
+
+	fprintf(stderr, "unrecognised command, try 'start', 'test' or 'info'\n");
+	return -EINVAL;
+}
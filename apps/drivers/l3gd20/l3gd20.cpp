@@ -0,0 +1,953 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2012 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file Driver for the ST L3GD20 MEMS gyroscope connected via SPI.
+ */
+
+#include <nuttx/config.h>
+
+#include <drivers/device/spi.h>
+#include <drivers/device/ringbuffer.h>
+#include <drivers/device/decimator.h>
+
+#include <sys/types.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <semaphore.h>
+#include <string.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <errno.h>
+#include <stdio.h>
+#include <math.h>
+#include <unistd.h>
+
+#include <nuttx/arch.h>
+#include <nuttx/clock.h>
+
+#include <arch/board/board.h>
+#include <arch/board/up_hrt.h>
+
+#include <drivers/drv_gyro.h>
+
+/* SPI protocol address bits */
+#define DIR_READ			(1<<7)
+#define DIR_WRITE			(0<<7)
+#define ADDR_INCREMENT			(1<<6)
+
+/* register addresses */
+#define ADDR_WHO_AM_I			0x0F
+#define WHO_I_AM				0xD4
+
+#define ADDR_CTRL_REG1			0x20
+#define REG1_RATE_LP_MASK			0xF0
+#define REG1_RATE_95HZ_LP_25HZ			((0<<6) | (1<<4))
+#define REG1_RATE_190HZ_LP_50HZ			((1<<6) | (2<<4))
+#define REG1_RATE_380HZ_LP_100HZ		((2<<6) | (3<<4))
+#define REG1_RATE_760HZ_LP_100HZ		((3<<6) | (3<<4))
+#define REG1_POWER_NORMAL			(1<<3)
+#define REG1_Z_ENABLE				(1<<2)
+#define REG1_Y_ENABLE				(1<<1)
+#define REG1_X_ENABLE				(1<<0)
+
+#define ADDR_CTRL_REG2			0x21
+#define ADDR_CTRL_REG3			0x22
+#define ADDR_CTRL_REG4			0x23
+#define REG4_BDU				(1<<7)
+#define REG4_RANGE_MASK				(3<<4)
+#define REG4_RANGE_250DPS			(0<<4)
+#define REG4_RANGE_500DPS			(1<<4)
+#define REG4_RANGE_2000DPS			(3<<4)
+
+#define ADDR_CTRL_REG5			0x24
+#define REG5_FIFO_ENABLE			(1<<6)
+#define ADDR_OUT_TEMP			0x26
+#define ADDR_STATUS_REG			0x27
+#define STATUS_ZYXDA				(1<<3)
+#define ADDR_OUT_X_L			0x28
+
+#define ADDR_FIFO_CTRL_REG		0x2E
+#define FIFO_CTRL_BYPASS_MODE			(0<<5)
+#define FIFO_CTRL_STREAM_MODE			(2<<5)
+#define ADDR_FIFO_SRC_REG		0x2F
+#define FIFO_SRC_OVERRUN			(1<<6)
+#define FIFO_SRC_EMPTY				(1<<5)
+#define FIFO_SRC_LEVEL_MASK			0x1F
+
+#define L3GD20_FIFO_DEPTH		32	/* samples */
+
+/*
+ * Reports buffered for read(). The sensors task reads the L3GD20 at 380 Hz
+ * (760 Hz decimated by 2) and takes what has queued at each wakeup; a
+ * delayed poll can drain a full FIFO at once, which is this many reports.
+ */
+#define L3GD20_REPORT_QUEUE_DEPTH	(L3GD20_FIFO_DEPTH / 2)
+
+/* default settings */
+#define L3GD20_DEFAULT_RATE		760	/* Hz */
+#define L3GD20_DEFAULT_RANGE_DPS	500
+
+extern "C" { __EXPORT int l3gd20_main(int argc, char *argv[]); }
+
+class L3GD20 : public device::SPI
+{
+public:
+	L3GD20(int bus, spi_dev_e device);
+	~L3GD20();
+
+	virtual int		init();
+
+	virtual ssize_t		read(struct file *filp, char *buffer, size_t buflen);
+	virtual int		ioctl(struct file *filp, int cmd, unsigned long arg);
+
+	virtual int		open_first(struct file *filp);
+	virtual int		close_last(struct file *filp);
+
+	/**
+	 * Diagnostics - print some basic information about the driver.
+	 */
+	void			print_info();
+
+protected:
+	virtual int		probe();
+
+	virtual void		burst_complete(uint8_t *recv, unsigned len, int result);
+
+private:
+
+	struct hrt_call		_call;
+	unsigned		_call_interval;
+
+	device::RingBuffer<struct gyro_report>	_reports;
+
+	unsigned		_samplerate;		/**< on-chip data rate, Hz */
+	unsigned		_lowpass;		/**< requested filter cutoff, Hz; zero for none */
+	device::Decimator	_filter;
+
+	struct gyro_scale	_scale;
+	float			_range_scale;
+
+	int			_gyro_topic;
+
+	/**
+	 * Status and data registers as read back from the device; the layout
+	 * matches the register map from OUT_TEMP onwards.
+	 */
+#pragma pack(push, 1)
+	struct {
+		uint8_t		cmd;
+		int8_t		temp;
+		uint8_t		status;
+		int16_t		x;
+		int16_t		y;
+		int16_t		z;
+	}			_raw;
+#pragma pack(pop)
+	hrt_abstime		_raw_timestamp;		/**< time the burst for _raw was started */
+
+	/**
+	 * FIFO_SRC and the FIFO contents as read back while measuring
+	 * automatically. Reads of the data registers roll over from OUT_Z_H
+	 * to OUT_X_L while the FIFO is enabled, so one burst drains it.
+	 */
+	uint8_t			_fifo_src[2];
+#pragma pack(push, 1)
+	struct {
+		uint8_t		cmd;
+		int16_t		sample[L3GD20_FIFO_DEPTH][3];
+	}			_fifo;
+#pragma pack(pop)
+	hrt_abstime		_fifo_timestamp;	/**< time FIFO_SRC was read; the newest sample is about this old */
+
+	unsigned		_reads;
+	unsigned		_read_errors;
+	unsigned		_overruns;		/**< measurements skipped because the previous burst was still running */
+	unsigned		_fifo_overruns;		/**< times the FIFO filled and dropped samples before it was drained */
+
+	/**
+	 * Start automatic measurement at _call_interval.
+	 *
+	 * Every sample the sensor takes is drained from its FIFO, so the
+	 * decimation filter is designed for the on-chip data rate whatever
+	 * the measurement rate is.
+	 *
+	 * @return		OK if measurement was started, -errno otherwise.
+	 */
+	int			start();
+
+	/**
+	 * Stop automatic measurement.
+	 *
+	 * Waits for a burst that is already running to complete, so that the
+	 * report ring may be modified when this returns.
+	 */
+	void			stop();
+
+	/**
+	 * Static trampoline from the hrt_call context;
+	 * because we don't have a generic hrt wrapper yet.
+	 *
+	 * Called in interrupt context at the specified rate, or when the
+	 * sensor signals new data, if automatic polling is enabled.
+	 *
+	 * @param arg		Instance pointer for the driver that is polling.
+	 */
+	static void		measure_trampoline(void *arg);
+
+	/**
+	 * Start fetching the samples queued in the sensor's FIFO.
+	 *
+	 * The first burst reads the FIFO level; burst_complete then chains a
+	 * second to read that many samples.
+	 */
+	void			measure();
+
+	/**
+	 * Turn the registers in _raw into a report and post it.
+	 */
+	void			collect();
+
+	/**
+	 * Pass the samples read from the FIFO through the filter, and post
+	 * a report for each one that comes out.
+	 *
+	 * @param count		The number of samples in _fifo.
+	 */
+	void			collect_fifo(unsigned count);
+
+	/**
+	 * Scale a sample and post it as a report.
+	 *
+	 * @param sample	The raw sample.
+	 * @param timestamp	The time the sample was taken.
+	 */
+	void			report(const int16_t sample[3], hrt_abstime timestamp);
+
+	/**
+	 * Read a register from the L3GD20
+	 *
+	 * @param		The register to read.
+	 * @return		The value that was read.
+	 */
+	uint8_t			read_reg(unsigned reg);
+
+	/**
+	 * Write a register in the L3GD20
+	 *
+	 * @param reg		The register to write.
+	 * @param value		The new value to write.
+	 */
+	void			write_reg(unsigned reg, uint8_t value);
+
+	/**
+	 * Modify a register in the L3GD20
+	 *
+	 * Bits are cleared before bits are set.
+	 *
+	 * @param reg		The register to modify.
+	 * @param clearbits	Bits in the register to clear.
+	 * @param setbits	Bits in the register to set.
+	 */
+	void			modify_reg(unsigned reg, uint8_t clearbits, uint8_t setbits);
+
+	/**
+	 * Set the L3GD20 measurement range.
+	 *
+	 * @param max_dps	The measurement range is set to permit reading at least
+	 *			this rate in degrees per second.
+	 * @return		OK if the value can be supported, -ERANGE otherwise.
+	 */
+	int			set_range(unsigned max_dps);
+
+	/**
+	 * Set the L3GD20 internal sampling frequency.
+	 *
+	 * The on-chip lowpass filter is set to suit the rate.
+	 *
+	 * @param frequency	The internal sampling frequency is set to not less than
+	 *			this value.
+	 * @return		OK if the value can be supported, -ERANGE otherwise.
+	 */
+	int			set_samplerate(unsigned frequency);
+};
+
+L3GD20::L3GD20(int bus, spi_dev_e device) :
+	SPI("L3GD20", GYRO_DEVICE_PATH, bus, device, SPIDEV_MODE3, 8000000),
+	_call_interval(0),
+	_samplerate(0),
+	_lowpass(0),
+	_range_scale(0.0f),
+	_gyro_topic(-1),
+	_raw_timestamp(0),
+	_fifo_timestamp(0),
+	_reads(0),
+	_read_errors(0),
+	_overruns(0),
+	_fifo_overruns(0)
+{
+	// enable debug() calls
+	_debug_enabled = true;
+
+	// default scale factors
+	_scale.x_offset = 0;
+	_scale.x_scale  = 1.0f;
+	_scale.y_offset = 0;
+	_scale.y_scale  = 1.0f;
+	_scale.z_offset = 0;
+	_scale.z_scale  = 1.0f;
+
+	memset(&_call, 0, sizeof(_call));
+}
+
+L3GD20::~L3GD20()
+{
+	/* make sure we are truly inactive */
+	stop();
+}
+
+int
+L3GD20::init()
+{
+	int ret;
+
+	/* do SPI init (and probe) first */
+	ret = SPI::init();
+
+	/* if probe/setup successful, finish chip init */
+	if (ret == OK) {
+
+		/* all axes on, no high-pass, no interrupts, FIFO off until measuring automatically */
+		write_reg(ADDR_CTRL_REG1, REG1_POWER_NORMAL | REG1_Z_ENABLE | REG1_Y_ENABLE | REG1_X_ENABLE);
+		write_reg(ADDR_CTRL_REG2, 0);
+		write_reg(ADDR_CTRL_REG3, 0);
+		write_reg(ADDR_CTRL_REG4, REG4_BDU);
+		write_reg(ADDR_CTRL_REG5, 0);
+		write_reg(ADDR_FIFO_CTRL_REG, FIFO_CTRL_BYPASS_MODE);
+
+		set_range(L3GD20_DEFAULT_RANGE_DPS);
+		set_samplerate(L3GD20_DEFAULT_RATE);
+
+		/*
+		 * Publish as the next free instance so that a second gyro can
+		 * coexist. If this fails (e.g. no object in the system) that's OK.
+		 */
+		struct gyro_report g;
+		memset(&g, 0, sizeof(g));
+		_gyro_topic = orb_advertise_multi(ORB_ID(sensor_gyro), &g, nullptr);
+
+		if (_gyro_topic < 0)
+			debug("failed to create sensor_gyro object");
+	}
+
+	return ret;
+}
+
+int
+L3GD20::open_first(struct file *filp)
+{
+	/* reset to manual-poll mode, unfiltered */
+	_call_interval = 0;
+	_lowpass = 0;
+
+	/* allocate basic report buffers */
+	if (!_reports.resize(L3GD20_REPORT_QUEUE_DEPTH))
+		return -ENOMEM;
+
+	return OK;
+}
+
+int
+L3GD20::close_last(struct file *filp)
+{
+	/* stop measurement */
+	stop();
+
+	/* free report buffers */
+	_reports.resize(0);
+
+	_call_interval = 0;
+
+	return OK;
+}
+
+int
+L3GD20::probe()
+{
+	/* read dummy value to void to clear SPI statemachine on sensor */
+	(void)read_reg(ADDR_WHO_AM_I);
+
+	if (read_reg(ADDR_WHO_AM_I) == WHO_I_AM)
+		return OK;
+
+	return -EIO;
+}
+
+ssize_t
+L3GD20::read(struct file *filp, char *buffer, size_t buflen)
+{
+	unsigned count = buflen / sizeof(struct gyro_report);
+	int ret = 0;
+
+	/* buffer must be large enough */
+	if (count < 1)
+		return -ENOSPC;
+
+	/* if automatic measurement is enabled */
+	if (_call_interval > 0) {
+
+		/*
+		 * Copy as many reports as there are, up to the space in the caller's
+		 * buffer. The ring is safe against the measurement code pre-empting us.
+		 */
+		ret = _reports.get(reinterpret_cast<struct gyro_report *>(buffer), count) * sizeof(struct gyro_report);
+
+		_reads++;
+
+		/* if there was no data, warn the caller */
+		return ret ? ret : -EAGAIN;
+	}
+
+	/* manual measurement */
+	_reports.flush();
+
+	_raw.cmd = ADDR_OUT_TEMP | DIR_READ | ADDR_INCREMENT;
+	_raw_timestamp = hrt_absolute_time();
+
+	if (OK != transfer((uint8_t *)&_raw, (uint8_t *)&_raw, sizeof(_raw))) {
+		_read_errors++;
+		return -EIO;
+	}
+
+	collect();
+
+	/* measurement will have generated a report, copy it out */
+	if (_reports.get(*reinterpret_cast<struct gyro_report *>(buffer)))
+		ret = sizeof(struct gyro_report);
+
+	return ret;
+}
+
+int
+L3GD20::ioctl(struct file *filp, int cmd, unsigned long arg)
+{
+	switch (cmd) {
+
+	case GYROIOCSPOLLRATE: {
+			switch (arg) {
+
+				/* switching to manual polling */
+			case GYRO_POLLRATE_MANUAL:
+				stop();
+				_call_interval = 0;
+				return OK;
+
+				/* external signalling not supported */
+			case GYRO_POLLRATE_EXTERNAL:
+
+				/* zero would be bad */
+			case 0:
+				return -EINVAL;
+
+				/* adjust to a legal polling interval in Hz */
+			default: {
+					/* convert hz to hrt interval via microseconds */
+					unsigned ticks = 1000000 / arg;
+
+					/* check against maximum sane rate */
+					if (ticks < 1000)
+						return -EINVAL;
+
+					/* the FIFO must be drained before it fills */
+					if (ticks > (L3GD20_FIFO_DEPTH * 1000000) / _samplerate)
+						return -EINVAL;
+
+					/* (re)start polling */
+					_call_interval = ticks;
+
+					return start();
+				}
+			}
+		}
+
+	case GYROIOCSQUEUEDEPTH: {
+			/* lower bound is mandatory, upper bound is a sanity check */
+			if ((arg < 2) || (arg > 100))
+				return -EINVAL;
+
+			/* the ring must not be written while it is resized */
+			stop();
+
+			int ret = _reports.resize(arg) ? OK : -ENOMEM;
+
+			/* restart automatic measurement if it was running */
+			if (_call_interval > 0)
+				start();
+
+			return ret;
+		}
+
+	case GYROIOCSSAMPLERATE: {
+			int ret = set_samplerate(arg);
+
+			/* the filter follows the data rate */
+			if ((ret == OK) && (_call_interval > 0))
+				ret = start();
+
+			return ret;
+		}
+
+	case GYROIOCSLOWPASS:
+		_lowpass = arg;
+
+		/* redesign the filter if measuring */
+		if (_call_interval > 0)
+			return start();
+
+		return OK;
+
+	case GYROIOCSRANGE:
+		return set_range(arg);
+
+	case GYROIOCGETRATE:
+		/* every FIFO sample goes through the filter, which decimates */
+		*(unsigned *)arg = (_call_interval > 0) ? (_samplerate / _filter.factor()) : 0;
+		return OK;
+
+	case GYROIOCSSCALE:
+		/* copy scale in */
+		memcpy(&_scale, (struct gyro_scale *)arg, sizeof(_scale));
+		return OK;
+
+	case GYROIOCSREPORTFORMAT:	/* no alternate report formats */
+		return -EINVAL;
+
+	default:
+		/* give it to the superclass */
+		return SPI::ioctl(filp, cmd, arg);
+	}
+}
+
+uint8_t
+L3GD20::read_reg(unsigned reg)
+{
+	uint8_t cmd[2];
+
+	cmd[0] = reg | DIR_READ;
+
+	transfer(cmd, cmd, sizeof(cmd));
+
+	return cmd[1];
+}
+
+void
+L3GD20::write_reg(unsigned reg, uint8_t value)
+{
+	uint8_t	cmd[2];
+
+	cmd[0] = reg | DIR_WRITE;
+	cmd[1] = value;
+
+	transfer(cmd, nullptr, sizeof(cmd));
+}
+
+void
+L3GD20::modify_reg(unsigned reg, uint8_t clearbits, uint8_t setbits)
+{
+	uint8_t	val;
+
+	val = read_reg(reg);
+	val &= ~clearbits;
+	val |= setbits;
+	write_reg(reg, val);
+}
+
+int
+L3GD20::set_range(unsigned max_dps)
+{
+	uint8_t rangebits;
+	float mdps_per_lsb;
+
+	if (max_dps > 2000) {
+		return -ERANGE;
+
+	} else if (max_dps > 500) {
+		rangebits = REG4_RANGE_2000DPS;
+		mdps_per_lsb = 70.0f;
+
+	} else if (max_dps > 250) {
+		rangebits = REG4_RANGE_500DPS;
+		mdps_per_lsb = 17.5f;
+
+	} else {
+		rangebits = REG4_RANGE_250DPS;
+		mdps_per_lsb = 8.75f;
+	}
+
+	/* adjust sensor configuration */
+	modify_reg(ADDR_CTRL_REG4, REG4_RANGE_MASK, rangebits);
+
+	/* reports are in rad/s */
+	_range_scale = mdps_per_lsb / 1000.0f * (M_PI / 180.0f);
+
+	return OK;
+}
+
+int
+L3GD20::set_samplerate(unsigned frequency)
+{
+	uint8_t bits;
+
+	if (frequency > 760) {
+		return -ERANGE;
+
+	} else if (frequency > 380) {
+		bits = REG1_RATE_760HZ_LP_100HZ;
+		_samplerate = 760;
+
+	} else if (frequency > 190) {
+		bits = REG1_RATE_380HZ_LP_100HZ;
+		_samplerate = 380;
+
+	} else if (frequency > 95) {
+		bits = REG1_RATE_190HZ_LP_50HZ;
+		_samplerate = 190;
+
+	} else {
+		bits = REG1_RATE_95HZ_LP_25HZ;
+		_samplerate = 95;
+	}
+
+	/* adjust sensor configuration */
+	modify_reg(ADDR_CTRL_REG1, REG1_RATE_LP_MASK, bits);
+
+	return OK;
+}
+
+int
+L3GD20::start()
+{
+	/* make sure we are stopped first */
+	stop();
+
+	/* reset the report ring */
+	_reports.flush();
+
+	/* filter for the rate the sensor takes samples at */
+	_filter.configure(_samplerate, _lowpass);
+
+	/* empty the FIFO by passing through bypass mode, then let it collect samples */
+	write_reg(ADDR_FIFO_CTRL_REG, FIFO_CTRL_BYPASS_MODE);
+	modify_reg(ADDR_CTRL_REG5, 0, REG5_FIFO_ENABLE);
+	write_reg(ADDR_FIFO_CTRL_REG, FIFO_CTRL_STREAM_MODE);
+
+	/* start polling at the specified rate */
+	hrt_call_every(&_call, 1000, _call_interval, (hrt_callout)&L3GD20::measure_trampoline, this);
+
+	return OK;
+}
+
+void
+L3GD20::stop()
+{
+	hrt_cancel(&_call);
+
+	burst_cancel();
+
+	/*
+	 * A burst that has already started will still report; let it. A FIFO
+	 * read chained from the level read keeps the burst busy throughout.
+	 */
+	while (burst_busy())
+		usleep(1000);
+
+	/* back to reading the data registers directly */
+	if (_call_interval > 0) {
+		write_reg(ADDR_FIFO_CTRL_REG, FIFO_CTRL_BYPASS_MODE);
+		modify_reg(ADDR_CTRL_REG5, REG5_FIFO_ENABLE, 0);
+	}
+}
+
+void
+L3GD20::measure_trampoline(void *arg)
+{
+	L3GD20 *dev = (L3GD20 *)arg;
+
+	/* make another measurement */
+	dev->measure();
+}
+
+void
+L3GD20::measure()
+{
+	/* if the work queue hasn't got to the last one yet, skip this one */
+	if (burst_busy()) {
+		_overruns++;
+		return;
+	}
+
+	/*
+	 * Read the FIFO level, off the interrupt. The newest sample in the
+	 * FIFO is stamped with the time the read was requested, which is the
+	 * closest we can get to its sample time.
+	 */
+	_fifo_src[0] = ADDR_FIFO_SRC_REG | DIR_READ;
+	_fifo_timestamp = hrt_absolute_time();
+
+	if (OK != burst_start(_fifo_src, _fifo_src, sizeof(_fifo_src)))
+		_overruns++;
+}
+
+void
+L3GD20::burst_complete(uint8_t *recv, unsigned len, int result)
+{
+	if (result != OK) {
+		_read_errors++;
+		return;
+	}
+
+	/* FIFO samples read; filter and report them */
+	if (recv != _fifo_src) {
+		collect_fifo((len - 1) / sizeof(_fifo.sample[0]));
+		return;
+	}
+
+	/* FIFO level read; if there is anything there, read it out */
+	uint8_t src = _fifo_src[1];
+	unsigned count;
+
+	if (src & FIFO_SRC_OVERRUN) {
+		/* full, and we have lost samples */
+		_fifo_overruns++;
+		count = L3GD20_FIFO_DEPTH;
+
+	} else if (src & FIFO_SRC_EMPTY) {
+		return;
+
+	} else {
+		count = src & FIFO_SRC_LEVEL_MASK;
+	}
+
+	/*
+	 * The burst stays claimed until the data read completes, so a
+	 * measurement can't restamp _fifo_timestamp under these samples.
+	 */
+	_fifo.cmd = ADDR_OUT_X_L | DIR_READ | ADDR_INCREMENT;
+
+	if (OK != burst_chain((uint8_t *)&_fifo, (uint8_t *)&_fifo, 1 + count * sizeof(_fifo.sample[0])))
+		_read_errors++;
+}
+
+void
+L3GD20::collect()
+{
+	int16_t sample[3] = { _raw.x, _raw.y, _raw.z };	/* the device is little-endian, as are we */
+
+	report(sample, _raw_timestamp);
+}
+
+void
+L3GD20::collect_fifo(unsigned count)
+{
+	/* the samples are oldest first and one data period apart */
+	unsigned period = 1000000 / _samplerate;
+
+	for (unsigned i = 0; i < count; i++) {
+		int16_t sample[3] = { _fifo.sample[i][0], _fifo.sample[i][1], _fifo.sample[i][2] };
+
+		/* every sample goes through the filter, and only the decimated ones are reported */
+		if (_filter.put(sample, sample))
+			report(sample, _fifo_timestamp - (count - 1 - i) * period);
+	}
+}
+
+void
+L3GD20::report(const int16_t sample[3], hrt_abstime timestamp)
+{
+	struct gyro_report report;
+
+	report.timestamp = timestamp;
+	report.x_raw = sample[0];
+	report.y_raw = sample[1];
+	report.z_raw = sample[2];
+	report.x = (report.x_raw * _range_scale) * _scale.x_scale + _scale.x_offset;
+	report.y = (report.y_raw * _range_scale) * _scale.y_scale + _scale.y_offset;
+	report.z = (report.z_raw * _range_scale) * _scale.z_scale + _scale.z_offset;
+
+	/* post a report to the ring, dropping the oldest if the reader is behind */
+	_reports.force(report);
+
+	/* notify anyone waiting for data */
+	poll_notify(POLLIN);
+
+	/* and publish for subscribers */
+	if (_gyro_topic >= 0)
+		orb_publish(ORB_ID(sensor_gyro), _gyro_topic, &report);
+}
+
+void
+L3GD20::print_info()
+{
+	printf("reads:          %u\n", _reads);
+	printf("read errors:    %u\n", _read_errors);
+	printf("overruns:       %u\n", _overruns);
+	printf("FIFO overruns:  %u\n", _fifo_overruns);
+	printf("poll interval:  %u us\n", _call_interval);
+	printf("lowpass:        %u Hz, %u taps, decimation %u\n", _filter.cutoff(), _filter.taps(), _filter.factor());
+	printf("report queue:   %u/%u, %u overflows\n",
+	       _reports.count(), _reports.size(), _reports.overflows());
+}
+
+/**
+ * Local functions in support of the shell command.
+ */
+namespace
+{
+
+L3GD20	*g_dev;
+
+/*
+ * XXX this should just be part of the generic sensors test...
+ */
+
+int
+test()
+{
+	int fd = -1;
+	struct gyro_report report;
+	ssize_t sz;
+	const char *reason = "test OK";
+
+	do {
+
+		/* get the driver */
+		fd = open(GYRO_DEVICE_PATH, O_RDONLY);
+
+		if (fd < 0) {
+			reason = "can't open driver";
+			break;
+		}
+
+		/* do a simple demand read */
+		sz = read(fd, &report, sizeof(report));
+
+		if (sz != sizeof(report)) {
+			reason = "immediate read failed";
+			break;
+		}
+
+		printf("single read\n");
+		fflush(stdout);
+		printf("time:        %lld\n", report.timestamp);
+		printf("x:           %f\t(%d raw)\n", report.x, report.x_raw);
+		printf("y:           %f\t(%d raw)\n", report.y, report.y_raw);
+		printf("z:           %f\t(%d raw)\n", report.z, report.z_raw);
+
+	} while (0);
+
+	if (fd >= 0)
+		close(fd);
+
+	printf("L3GD20: %s\n", reason);
+
+	return OK;
+}
+
+int
+info()
+{
+	if (g_dev == nullptr) {
+		fprintf(stderr, "L3GD20: driver not running\n");
+		return -ENOENT;
+	}
+
+	printf("state @ %p\n", g_dev);
+	g_dev->print_info();
+
+	return OK;
+}
+
+
+} // namespace
+
+int
+l3gd20_main(int argc, char *argv[])
+{
+	/*
+	 * Start/load the driver.
+	 *
+	 * XXX it would be nice to have a wrapper for this...
+	 */
+	if (!strcmp(argv[1], "start")) {
+
+		if (g_dev != nullptr) {
+			fprintf(stderr, "L3GD20: already loaded\n");
+			return -EBUSY;
+		}
+
+		/* create the driver */
+		g_dev = new L3GD20(1, (spi_dev_e)PX4_SPIDEV_GYRO);
+
+		if (g_dev == nullptr) {
+			fprintf(stderr, "L3GD20: driver alloc failed\n");
+			return -ENOMEM;
+		}
+
+		if (OK != g_dev->init()) {
+			fprintf(stderr, "L3GD20: driver init failed\n");
+			usleep(100000);
+			delete g_dev;
+			g_dev = nullptr;
+			return -EIO;
+		}
+
+		printf("L3GD20: driver started\n");
+		return OK;
+	}
+
+	/*
+	 * Test the driver/device.
+	 */
+	if (!strcmp(argv[1], "test"))
+		return test();
+
+	/*
+	 * Print driver information.
+	 */
+	if (!strcmp(argv[1], "info"))
+		return info();
+
+	fprintf(stderr, "unrecognised command, try 'start', 'test' or 'info'\n");
+	return -EINVAL;
+}
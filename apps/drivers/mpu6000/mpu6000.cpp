@@ -0,0 +1,1154 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2012 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file Driver for the Invensense MPU6000 connected via SPI.
+ *
+ * The MPU6000 measures acceleration and angular rate; the accelerometer is
+ * presented by the main device and the gyro by a second device node that
+ * shares the same measurement cycle.
+ */
+
+#include <nuttx/config.h>
+
+#include <drivers/device/spi.h>
+#include <drivers/device/ringbuffer.h>
+
+#include <sys/types.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <semaphore.h>
+#include <string.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <errno.h>
+#include <stdio.h>
+#include <math.h>
+#include <unistd.h>
+
+#include <nuttx/arch.h>
+#include <nuttx/clock.h>
+
+#include <arch/board/board.h>
+#include <arch/board/up_hrt.h>
+
+#include <drivers/drv_accel.h>
+#include <drivers/drv_gyro.h>
+
+#define MPU6000_ACCEL_DEVICE_PATH	"/dev/mpu6000_accel"
+#define MPU6000_GYRO_DEVICE_PATH	"/dev/mpu6000_gyro"
+
+/* SPI protocol address bits; the MPU6000 auto-increments on its own */
+#define DIR_READ			(1<<7)
+#define DIR_WRITE			(0<<7)
+
+/* register addresses */
+#define MPUREG_SMPLRT_DIV		0x19
+#define MPUREG_CONFIG			0x1A
+#define MPUREG_GYRO_CONFIG		0x1B
+#define MPUREG_ACCEL_CONFIG		0x1C
+#define MPUREG_INT_PIN_CFG		0x37
+#define MPUREG_INT_ENABLE		0x38
+#define MPUREG_INT_STATUS		0x3A
+#define MPUREG_ACCEL_XOUT_H		0x3B
+#define MPUREG_USER_CTRL		0x6A
+#define MPUREG_PWR_MGMT_1		0x6B
+#define MPUREG_PRODUCT_ID		0x0C
+
+/* configuration bits */
+#define BIT_H_RESET				0x80
+#define MPU_CLK_SEL_PLLGYROZ			0x03
+#define BIT_I2C_IF_DIS				0x10
+#define BIT_RAW_RDY_EN				0x01
+#define BIT_INT_ANYRD_2CLEAR			0x10
+
+#define BITS_FS_250DPS				0x00
+#define BITS_FS_500DPS				0x08
+#define BITS_FS_1000DPS				0x10
+#define BITS_FS_2000DPS				0x18
+#define BITS_FS_MASK				0x18
+
+#define BITS_DLPF_CFG_256HZ_NOLPF2		0x00
+#define BITS_DLPF_CFG_188HZ			0x01
+#define BITS_DLPF_CFG_98HZ			0x02
+#define BITS_DLPF_CFG_42HZ			0x03
+#define BITS_DLPF_CFG_20HZ			0x04
+#define BITS_DLPF_CFG_10HZ			0x05
+#define BITS_DLPF_CFG_5HZ			0x06
+#define BITS_DLPF_CFG_MASK			0x07
+
+/* product ID, high nibble is the part and low nibble the revision */
+#define MPU6000ES_REV_C4		0x14
+#define MPU6000ES_REV_C5		0x15
+#define MPU6000ES_REV_D6		0x16
+#define MPU6000ES_REV_D7		0x17
+#define MPU6000ES_REV_D8		0x18
+#define MPU6000_REV_C4			0x54
+#define MPU6000_REV_C5			0x55
+#define MPU6000_REV_D6			0x56
+#define MPU6000_REV_D7			0x57
+#define MPU6000_REV_D8			0x58
+#define MPU6000_REV_D9			0x59
+#define MPU6000_REV_D10			0x5A
+
+#define MPU6000_ONE_G			9.80665f
+
+/* the internal sample rate with the DLPF enabled */
+#define MPU6000_INTERNAL_RATE		1000	/* Hz */
+
+/*
+ * Reports buffered per node for read(). Nothing in the tree reads the
+ * MPU6000 in automatic mode; it reaches the system as the second
+ * sensor_accel and sensor_gyro instance, and 'sensors test' reads it in
+ * manual mode. At the 1 kHz maximum poll rate this holds 8 ms, so a
+ * reader collecting at 125 Hz or faster loses nothing.
+ */
+#define MPU6000_REPORT_QUEUE_DEPTH	8
+
+extern "C" { __EXPORT int mpu6000_main(int argc, char *argv[]); }
+
+class MPU6000_gyro;
+
+class MPU6000 : public device::SPI
+{
+public:
+	MPU6000(int bus, spi_dev_e device);
+	~MPU6000();
+
+	virtual int		init();
+
+	virtual ssize_t		read(struct file *filp, char *buffer, size_t buflen);
+	virtual int		ioctl(struct file *filp, int cmd, unsigned long arg);
+
+	virtual int		close_last(struct file *filp);
+
+	/**
+	 * Diagnostics - print some basic information about the driver.
+	 */
+	void			print_info();
+
+protected:
+	virtual int		probe();
+
+	virtual void		burst_complete(uint8_t *recv, unsigned len, int result);
+
+	friend class MPU6000_gyro;
+
+	virtual ssize_t		gyro_read(struct file *filp, char *buffer, size_t buflen);
+	virtual int		gyro_ioctl(struct file *filp, int cmd, unsigned long arg);
+	virtual int		gyro_close_last(struct file *filp);
+
+private:
+	MPU6000_gyro		*_gyro;
+	uint8_t			_product;
+
+	struct hrt_call		_call;
+	unsigned		_call_interval;
+
+	device::RingBuffer<struct accel_report>	_accel_reports;
+	device::RingBuffer<struct gyro_report>	_gyro_reports;
+
+	struct accel_scale	_accel_scale;
+	float			_accel_range_scale;
+	struct gyro_scale	_gyro_scale;
+	float			_gyro_range_scale;
+
+	int			_accel_topic;
+	int			_gyro_topic;
+
+	/**
+	 * Data registers as read back from the device, big-endian; the layout
+	 * matches the register map from ACCEL_XOUT_H onwards.
+	 */
+#pragma pack(push, 1)
+	struct {
+		uint8_t		cmd;
+		uint8_t		accel_x[2];
+		uint8_t		accel_y[2];
+		uint8_t		accel_z[2];
+		uint8_t		temp[2];
+		uint8_t		gyro_x[2];
+		uint8_t		gyro_y[2];
+		uint8_t		gyro_z[2];
+	}			_raw;
+#pragma pack(pop)
+	hrt_abstime		_raw_timestamp;		/**< time the burst for _raw was started */
+
+	unsigned		_reads;
+	unsigned		_read_errors;
+	unsigned		_overruns;		/**< measurements skipped because the previous burst was still running */
+
+	/**
+	 * Start automatic measurement.
+	 */
+	void			start();
+
+	/**
+	 * Stop automatic measurement.
+	 *
+	 * Waits for a burst that is already running to complete, so that the
+	 * report rings may be modified when this returns.
+	 */
+	void			stop();
+
+	/**
+	 * Static trampoline from the hrt_call context; because we don't have a
+	 * generic hrt wrapper yet.
+	 *
+	 * Called by the HRT in interrupt context at the specified rate if
+	 * automatic polling is enabled.
+	 *
+	 * @param arg		Instance pointer for the driver that is polling.
+	 */
+	static void		measure_trampoline(void *arg);
+
+	/**
+	 * Start fetching a measurement from the sensor.
+	 */
+	void			measure();
+
+	/**
+	 * Fetch a measurement synchronously, for reads in manual-poll mode.
+	 *
+	 * @return		OK if reports were generated, -errno otherwise.
+	 */
+	int			measure_now();
+
+	/**
+	 * Turn the registers in _raw into accel and gyro reports and post them.
+	 */
+	void			collect();
+
+	/**
+	 * Handle a poll rate request for either device.
+	 *
+	 * @param arg		The rate in Hz, or one of the POLLRATE constants.
+	 * @return		OK if the rate can be supported, -errno otherwise.
+	 */
+	int			set_pollrate(unsigned long arg);
+
+	/**
+	 * Read a register from the MPU6000
+	 *
+	 * @param		The register to read.
+	 * @return		The value that was read.
+	 */
+	uint8_t			read_reg(unsigned reg);
+
+	/**
+	 * Write a register in the MPU6000
+	 *
+	 * @param reg		The register to write.
+	 * @param value		The new value to write.
+	 */
+	void			write_reg(unsigned reg, uint8_t value);
+
+	/**
+	 * Modify a register in the MPU6000
+	 *
+	 * Bits are cleared before bits are set.
+	 *
+	 * @param reg		The register to modify.
+	 * @param clearbits	Bits in the register to clear.
+	 * @param setbits	Bits in the register to set.
+	 */
+	void			modify_reg(unsigned reg, uint8_t clearbits, uint8_t setbits);
+
+	/**
+	 * Set the gyro measurement range.
+	 *
+	 * @param max_dps	The range is set to permit reading at least
+	 *			this rate in degrees per second.
+	 * @return		OK if the value can be supported, -ERANGE otherwise.
+	 */
+	int			set_gyro_range(unsigned max_dps);
+
+	/**
+	 * Set the output data rate of both sensors.
+	 *
+	 * @param frequency	The sample rate is set to not less than this value.
+	 * @return		OK if the value can be supported, -ERANGE otherwise.
+	 */
+	int			set_samplerate(unsigned frequency);
+
+	/**
+	 * Set the on-chip lowpass filter, which is shared by both sensors.
+	 *
+	 * @param frequency	Set the lowpass filter cutoff frequency to no less than
+	 *			this frequency.
+	 * @return		OK if the value can be supported, -ERANGE otherwise.
+	 */
+	int			set_lowpass(unsigned frequency);
+};
+
+/**
+ * Helper class implementing the gyro device node.
+ */
+class MPU6000_gyro : public device::CDev
+{
+public:
+	MPU6000_gyro(MPU6000 *parent);
+
+	virtual ssize_t		read(struct file *filp, char *buffer, size_t buflen);
+	virtual int		ioctl(struct file *filp, int cmd, unsigned long arg);
+
+	virtual int		close_last(struct file *filp);
+
+protected:
+	friend class MPU6000;
+
+	void			parent_poll_notify();
+
+private:
+	MPU6000			*_parent;
+};
+
+MPU6000::MPU6000(int bus, spi_dev_e device) :
+	SPI("MPU6000", MPU6000_ACCEL_DEVICE_PATH, bus, device, SPIDEV_MODE3, 10000000),
+	_gyro(new MPU6000_gyro(this)),
+	_product(0),
+	_call_interval(0),
+	_accel_range_scale(0.0f),
+	_gyro_range_scale(0.0f),
+	_accel_topic(-1),
+	_gyro_topic(-1),
+	_raw_timestamp(0),
+	_reads(0),
+	_read_errors(0),
+	_overruns(0)
+{
+	// enable debug() calls
+	_debug_enabled = true;
+
+	// default scale factors
+	_accel_scale.x_offset = 0;
+	_accel_scale.x_scale  = 1.0f;
+	_accel_scale.y_offset = 0;
+	_accel_scale.y_scale  = 1.0f;
+	_accel_scale.z_offset = 0;
+	_accel_scale.z_scale  = 1.0f;
+
+	_gyro_scale.x_offset = 0;
+	_gyro_scale.x_scale  = 1.0f;
+	_gyro_scale.y_offset = 0;
+	_gyro_scale.y_scale  = 1.0f;
+	_gyro_scale.z_offset = 0;
+	_gyro_scale.z_scale  = 1.0f;
+
+	memset(&_call, 0, sizeof(_call));
+}
+
+MPU6000::~MPU6000()
+{
+	/* make sure we are truly inactive */
+	stop();
+
+	/* delete the gyro subdriver */
+	delete _gyro;
+}
+
+int
+MPU6000::init()
+{
+	int ret;
+
+	/* do SPI init (and probe) first */
+	ret = SPI::init();
+
+	if (ret != OK)
+		return ret;
+
+	/* the gyro node shares our measurement cycle */
+	if (_gyro == nullptr)
+		return -ENOMEM;
+
+	ret = _gyro->init();
+
+	if (ret != OK)
+		return ret;
+
+	/*
+	 * Allocate basic report buffers. They are shared by both nodes, so
+	 * they live as long as the driver.
+	 */
+	if (!_accel_reports.resize(MPU6000_REPORT_QUEUE_DEPTH) ||
+	    !_gyro_reports.resize(MPU6000_REPORT_QUEUE_DEPTH))
+		return -ENOMEM;
+
+	/* wake up the device on the gyro Z clock and disable its I2C interface */
+	write_reg(MPUREG_PWR_MGMT_1, MPU_CLK_SEL_PLLGYROZ);
+	usleep(1000);
+	write_reg(MPUREG_USER_CTRL, BIT_I2C_IF_DIS);
+	usleep(1000);
+
+	set_lowpass(98);
+	set_samplerate(MPU6000_INTERNAL_RATE);
+	set_gyro_range(2000);
+
+	/*
+	 * Accel range is fixed at 8G (4096 LSB/g); revision C parts are
+	 * twice as sensitive for the same setting.
+	 */
+	switch (_product) {
+	case MPU6000ES_REV_C4:
+	case MPU6000ES_REV_C5:
+	case MPU6000_REV_C4:
+	case MPU6000_REV_C5:
+		write_reg(MPUREG_ACCEL_CONFIG, 1 << 3);
+		break;
+
+	default:
+		write_reg(MPUREG_ACCEL_CONFIG, 2 << 3);
+		break;
+	}
+
+	_accel_range_scale = MPU6000_ONE_G / 4096.0f;
+
+	/* data-ready interrupt, cleared by any read */
+	write_reg(MPUREG_INT_ENABLE, BIT_RAW_RDY_EN);
+	write_reg(MPUREG_INT_PIN_CFG, BIT_INT_ANYRD_2CLEAR);
+
+	/*
+	 * Publish as the next free instances so that other accels and gyros
+	 * can coexist. If this fails (e.g. no object in the system) that's OK.
+	 */
+	struct accel_report a;
+	memset(&a, 0, sizeof(a));
+	_accel_topic = orb_advertise_multi(ORB_ID(sensor_accel), &a, nullptr);
+
+	if (_accel_topic < 0)
+		debug("failed to create sensor_accel object");
+
+	struct gyro_report g;
+	memset(&g, 0, sizeof(g));
+	_gyro_topic = orb_advertise_multi(ORB_ID(sensor_gyro), &g, nullptr);
+
+	if (_gyro_topic < 0)
+		debug("failed to create sensor_gyro object");
+
+	return OK;
+}
+
+int
+MPU6000::close_last(struct file *filp)
+{
+	/* measurement is shared; stop it when neither node is open */
+	if (!_gyro->is_open()) {
+		stop();
+		_call_interval = 0;
+	}
+
+	return OK;
+}
+
+int
+MPU6000::gyro_close_last(struct file *filp)
+{
+	if (!is_open()) {
+		stop();
+		_call_interval = 0;
+	}
+
+	return OK;
+}
+
+int
+MPU6000::probe()
+{
+	/* reset the chip, which also sets up the SPI state machine */
+	write_reg(MPUREG_PWR_MGMT_1, BIT_H_RESET);
+	usleep(10000);
+
+	_product = read_reg(MPUREG_PRODUCT_ID);
+
+	switch (_product) {
+	case MPU6000ES_REV_C4:
+	case MPU6000ES_REV_C5:
+	case MPU6000_REV_C4:
+	case MPU6000_REV_C5:
+	case MPU6000ES_REV_D6:
+	case MPU6000ES_REV_D7:
+	case MPU6000ES_REV_D8:
+	case MPU6000_REV_D6:
+	case MPU6000_REV_D7:
+	case MPU6000_REV_D8:
+	case MPU6000_REV_D9:
+	case MPU6000_REV_D10:
+		debug("product id 0x%02x", _product);
+		return OK;
+	}
+
+	debug("unexpected product id 0x%02x", _product);
+	return -EIO;
+}
+
+ssize_t
+MPU6000::read(struct file *filp, char *buffer, size_t buflen)
+{
+	unsigned count = buflen / sizeof(struct accel_report);
+	int ret = 0;
+
+	/* buffer must be large enough */
+	if (count < 1)
+		return -ENOSPC;
+
+	/* manual measurement */
+	if (_call_interval == 0) {
+		_accel_reports.flush();
+
+		ret = measure_now();
+
+		if (ret != OK)
+			return ret;
+	}
+
+	/*
+	 * Copy as many reports as there are, up to the space in the caller's
+	 * buffer. The ring is safe against the measurement code pre-empting us.
+	 */
+	ret = _accel_reports.get(reinterpret_cast<struct accel_report *>(buffer), count) * sizeof(struct accel_report);
+
+	_reads++;
+
+	/* if there was no data, warn the caller */
+	return ret ? ret : -EAGAIN;
+}
+
+ssize_t
+MPU6000::gyro_read(struct file *filp, char *buffer, size_t buflen)
+{
+	unsigned count = buflen / sizeof(struct gyro_report);
+	int ret = 0;
+
+	/* buffer must be large enough */
+	if (count < 1)
+		return -ENOSPC;
+
+	/* manual measurement */
+	if (_call_interval == 0) {
+		_gyro_reports.flush();
+
+		ret = measure_now();
+
+		if (ret != OK)
+			return ret;
+	}
+
+	ret = _gyro_reports.get(reinterpret_cast<struct gyro_report *>(buffer), count) * sizeof(struct gyro_report);
+
+	_reads++;
+
+	/* if there was no data, warn the caller */
+	return ret ? ret : -EAGAIN;
+}
+
+int
+MPU6000::set_pollrate(unsigned long arg)
+{
+	switch (arg) {
+
+		/* switching to manual polling */
+	case ACC_POLLRATE_MANUAL:
+		stop();
+		_call_interval = 0;
+		return OK;
+
+		/* external signalling not supported */
+	case ACC_POLLRATE_EXTERNAL:
+
+		/* zero would be bad */
+	case 0:
+		return -EINVAL;
+
+		/* adjust to a legal polling interval in Hz */
+	default: {
+			/* do we need to start internal polling? */
+			bool want_start = (_call_interval == 0);
+
+			/* convert hz to hrt interval via microseconds */
+			unsigned ticks = 1000000 / arg;
+
+			/* check against maximum sane rate */
+			if (ticks < 1000)
+				return -EINVAL;
+
+			/* update interval for next measurement */
+			/* XXX this is a bit shady, but no other way to adjust... */
+			_call_interval = ticks;
+			_call.period = _call_interval;
+
+			/* if we need to start the poll state machine, do it */
+			if (want_start)
+				start();
+
+			return OK;
+		}
+	}
+}
+
+int
+MPU6000::ioctl(struct file *filp, int cmd, unsigned long arg)
+{
+	switch (cmd) {
+
+	case ACCELIOCSPOLLRATE:
+		return set_pollrate(arg);
+
+	case ACCELIOCSQUEUEDEPTH: {
+			/* lower bound is mandatory, upper bound is a sanity check */
+			if ((arg < 2) || (arg > 100))
+				return -EINVAL;
+
+			/* the ring must not be written while it is resized */
+			stop();
+
+			int ret = _accel_reports.resize(arg) ? OK : -ENOMEM;
+
+			/* restart automatic measurement if it was running */
+			if (_call_interval > 0)
+				start();
+
+			return ret;
+		}
+
+	case ACCELIOCSSAMPLERATE:
+		return set_samplerate(arg);
+
+	case ACCELIOCSLOWPASS:
+		return set_lowpass(arg);
+
+	case ACCELIORANGE:
+		/* fixed at 8G */
+		return (arg <= 8) ? OK : -ERANGE;
+
+	case ACCELIOCSSCALE:
+		/* copy scale in */
+		memcpy(&_accel_scale, (struct accel_scale *)arg, sizeof(_accel_scale));
+		return OK;
+
+	case ACCELIOCSREPORTFORMAT:	/* no alternate report formats */
+		return -EINVAL;
+
+	default:
+		/* give it to the superclass */
+		return SPI::ioctl(filp, cmd, arg);
+	}
+}
+
+int
+MPU6000::gyro_ioctl(struct file *filp, int cmd, unsigned long arg)
+{
+	switch (cmd) {
+
+	case GYROIOCSPOLLRATE:
+		return set_pollrate(arg);
+
+	case GYROIOCSQUEUEDEPTH: {
+			/* lower bound is mandatory, upper bound is a sanity check */
+			if ((arg < 2) || (arg > 100))
+				return -EINVAL;
+
+			/* the ring must not be written while it is resized */
+			stop();
+
+			int ret = _gyro_reports.resize(arg) ? OK : -ENOMEM;
+
+			/* restart automatic measurement if it was running */
+			if (_call_interval > 0)
+				start();
+
+			return ret;
+		}
+
+	case GYROIOCSSAMPLERATE:
+		return set_samplerate(arg);
+
+	case GYROIOCSLOWPASS:
+		return set_lowpass(arg);
+
+	case GYROIOCSRANGE:
+		return set_gyro_range(arg);
+
+	case GYROIOCGETRATE:
+		/* one report per poll */
+		*(unsigned *)arg = (_call_interval > 0) ? (1000000 / _call_interval) : 0;
+		return OK;
+
+	case GYROIOCSSCALE:
+		/* copy scale in */
+		memcpy(&_gyro_scale, (struct gyro_scale *)arg, sizeof(_gyro_scale));
+		return OK;
+
+	case GYROIOCSREPORTFORMAT:	/* no alternate report formats */
+		return -EINVAL;
+
+	default:
+		/* give it to the superclass */
+		return SPI::ioctl(filp, cmd, arg);
+	}
+}
+
+uint8_t
+MPU6000::read_reg(unsigned reg)
+{
+	uint8_t cmd[2];
+
+	cmd[0] = reg | DIR_READ;
+
+	transfer(cmd, cmd, sizeof(cmd));
+
+	return cmd[1];
+}
+
+void
+MPU6000::write_reg(unsigned reg, uint8_t value)
+{
+	uint8_t	cmd[2];
+
+	cmd[0] = reg | DIR_WRITE;
+	cmd[1] = value;
+
+	transfer(cmd, nullptr, sizeof(cmd));
+}
+
+void
+MPU6000::modify_reg(unsigned reg, uint8_t clearbits, uint8_t setbits)
+{
+	uint8_t	val;
+
+	val = read_reg(reg);
+	val &= ~clearbits;
+	val |= setbits;
+	write_reg(reg, val);
+}
+
+int
+MPU6000::set_gyro_range(unsigned max_dps)
+{
+	uint8_t rangebits;
+	float lsb_per_dps;
+
+	if (max_dps > 2000) {
+		return -ERANGE;
+
+	} else if (max_dps > 1000) {
+		rangebits = BITS_FS_2000DPS;
+		lsb_per_dps = 16.4f;
+
+	} else if (max_dps > 500) {
+		rangebits = BITS_FS_1000DPS;
+		lsb_per_dps = 32.8f;
+
+	} else if (max_dps > 250) {
+		rangebits = BITS_FS_500DPS;
+		lsb_per_dps = 65.5f;
+
+	} else {
+		rangebits = BITS_FS_250DPS;
+		lsb_per_dps = 131.0f;
+	}
+
+	/* adjust sensor configuration */
+	modify_reg(MPUREG_GYRO_CONFIG, BITS_FS_MASK, rangebits);
+
+	/* reports are in rad/s */
+	_gyro_range_scale = (M_PI / 180.0f) / lsb_per_dps;
+
+	return OK;
+}
+
+int
+MPU6000::set_samplerate(unsigned frequency)
+{
+	if ((frequency == 0) || (frequency > MPU6000_INTERNAL_RATE))
+		return -ERANGE;
+
+	/* the output rate is the internal rate divided by (1 + divider) */
+	unsigned divider = (MPU6000_INTERNAL_RATE / frequency) - 1;
+
+	if (divider > 255)
+		divider = 255;
+
+	write_reg(MPUREG_SMPLRT_DIV, divider);
+
+	return OK;
+}
+
+int
+MPU6000::set_lowpass(unsigned frequency)
+{
+	uint8_t filter;
+
+	/* the filter is only usable up to 188Hz; beyond that the internal rate changes */
+	if (frequency > 188) {
+		return -ERANGE;
+
+	} else if (frequency > 98) {
+		filter = BITS_DLPF_CFG_188HZ;
+
+	} else if (frequency > 42) {
+		filter = BITS_DLPF_CFG_98HZ;
+
+	} else if (frequency > 20) {
+		filter = BITS_DLPF_CFG_42HZ;
+
+	} else if (frequency > 10) {
+		filter = BITS_DLPF_CFG_20HZ;
+
+	} else if (frequency > 5) {
+		filter = BITS_DLPF_CFG_10HZ;
+
+	} else {
+		filter = BITS_DLPF_CFG_5HZ;
+	}
+
+	/* adjust sensor configuration */
+	modify_reg(MPUREG_CONFIG, BITS_DLPF_CFG_MASK, filter);
+
+	return OK;
+}
+
+void
+MPU6000::start()
+{
+	/* make sure we are stopped first */
+	stop();
+
+	/* reset the report rings */
+	_accel_reports.flush();
+	_gyro_reports.flush();
+
+	/* start polling at the specified rate */
+	hrt_call_every(&_call, 1000, _call_interval, (hrt_callout)&MPU6000::measure_trampoline, this);
+}
+
+void
+MPU6000::stop()
+{
+	hrt_cancel(&_call);
+	burst_cancel();
+
+	/* a burst that has already started will still report; let it */
+	while (burst_busy())
+		usleep(1000);
+}
+
+void
+MPU6000::measure_trampoline(void *arg)
+{
+	MPU6000 *dev = (MPU6000 *)arg;
+
+	/* make another measurement */
+	dev->measure();
+}
+
+void
+MPU6000::measure()
+{
+	/* if the work queue hasn't got to the last one yet, skip this one */
+	if (burst_busy()) {
+		_overruns++;
+		return;
+	}
+
+	/*
+	 * Read both sensors in one transaction, off the interrupt. The reports
+	 * are stamped with the time the read was requested, which is the
+	 * closest we can get to the sample time without the data-ready line.
+	 */
+	_raw.cmd = MPUREG_ACCEL_XOUT_H | DIR_READ;
+	_raw_timestamp = hrt_absolute_time();
+
+	if (OK != burst_start((uint8_t *)&_raw, (uint8_t *)&_raw, sizeof(_raw)))
+		_overruns++;
+}
+
+int
+MPU6000::measure_now()
+{
+	_raw.cmd = MPUREG_ACCEL_XOUT_H | DIR_READ;
+	_raw_timestamp = hrt_absolute_time();
+
+	if (OK != transfer((uint8_t *)&_raw, (uint8_t *)&_raw, sizeof(_raw))) {
+		_read_errors++;
+		return -EIO;
+	}
+
+	collect();
+	return OK;
+}
+
+void
+MPU6000::burst_complete(uint8_t *recv, unsigned len, int result)
+{
+	if (result != OK) {
+		_read_errors++;
+		return;
+	}
+
+	collect();
+}
+
+void
+MPU6000::collect()
+{
+#define BE16(_b)	((int16_t)(((uint16_t)(_b)[0] << 8) | (_b)[1]))
+
+	struct accel_report arb;
+	struct gyro_report grb;
+
+	arb.timestamp = _raw_timestamp;
+	arb.x_raw = BE16(_raw.accel_x);
+	arb.y_raw = BE16(_raw.accel_y);
+	arb.z_raw = BE16(_raw.accel_z);
+	arb.x = (arb.x_raw * _accel_range_scale) * _accel_scale.x_scale + _accel_scale.x_offset;
+	arb.y = (arb.y_raw * _accel_range_scale) * _accel_scale.y_scale + _accel_scale.y_offset;
+	arb.z = (arb.z_raw * _accel_range_scale) * _accel_scale.z_scale + _accel_scale.z_offset;
+
+	grb.timestamp = _raw_timestamp;
+	grb.x_raw = BE16(_raw.gyro_x);
+	grb.y_raw = BE16(_raw.gyro_y);
+	grb.z_raw = BE16(_raw.gyro_z);
+	grb.x = (grb.x_raw * _gyro_range_scale) * _gyro_scale.x_scale + _gyro_scale.x_offset;
+	grb.y = (grb.y_raw * _gyro_range_scale) * _gyro_scale.y_scale + _gyro_scale.y_offset;
+	grb.z = (grb.z_raw * _gyro_range_scale) * _gyro_scale.z_scale + _gyro_scale.z_offset;
+
+#undef BE16
+
+	/* post reports to the rings, dropping the oldest if the reader is behind */
+	_accel_reports.force(arb);
+	_gyro_reports.force(grb);
+
+	/* notify anyone waiting for data */
+	poll_notify(POLLIN);
+	_gyro->parent_poll_notify();
+
+	/* and publish for subscribers */
+	if (_accel_topic >= 0)
+		orb_publish(ORB_ID(sensor_accel), _accel_topic, &arb);
+
+	if (_gyro_topic >= 0)
+		orb_publish(ORB_ID(sensor_gyro), _gyro_topic, &grb);
+}
+
+void
+MPU6000::print_info()
+{
+	printf("product id:     0x%02x\n", _product);
+	printf("reads:          %u\n", _reads);
+	printf("read errors:    %u\n", _read_errors);
+	printf("overruns:       %u\n", _overruns);
+	printf("poll interval:  %u us\n", _call_interval);
+	printf("accel queue:    %u/%u, %u overflows\n",
+	       _accel_reports.count(), _accel_reports.size(), _accel_reports.overflows());
+	printf("gyro queue:     %u/%u, %u overflows\n",
+	       _gyro_reports.count(), _gyro_reports.size(), _gyro_reports.overflows());
+}
+
+MPU6000_gyro::MPU6000_gyro(MPU6000 *parent) :
+	CDev("MPU6000_gyro", MPU6000_GYRO_DEVICE_PATH),
+	_parent(parent)
+{
+}
+
+void
+MPU6000_gyro::parent_poll_notify()
+{
+	poll_notify(POLLIN);
+}
+
+ssize_t
+MPU6000_gyro::read(struct file *filp, char *buffer, size_t buflen)
+{
+	return _parent->gyro_read(filp, buffer, buflen);
+}
+
+int
+MPU6000_gyro::ioctl(struct file *filp, int cmd, unsigned long arg)
+{
+	return _parent->gyro_ioctl(filp, cmd, arg);
+}
+
+int
+MPU6000_gyro::close_last(struct file *filp)
+{
+	return _parent->gyro_close_last(filp);
+}
+
+/**
+ * Local functions in support of the shell command.
+ */
+namespace
+{
+
+MPU6000	*g_dev;
+
+/*
+ * XXX this should just be part of the generic sensors test...
+ */
+
+int
+test()
+{
+	int fd = -1;
+	int fd_gyro = -1;
+	struct accel_report a_report;
+	struct gyro_report g_report;
+	ssize_t sz;
+	const char *reason = "test OK";
+
+	do {
+
+		/* get the driver */
+		fd = open(MPU6000_ACCEL_DEVICE_PATH, O_RDONLY);
+
+		if (fd < 0) {
+			reason = "can't open accel driver";
+			break;
+		}
+
+		/* get the gyro node */
+		fd_gyro = open(MPU6000_GYRO_DEVICE_PATH, O_RDONLY);
+
+		if (fd_gyro < 0) {
+			reason = "can't open gyro driver";
+			break;
+		}
+
+		/* do a simple demand read */
+		sz = read(fd, &a_report, sizeof(a_report));
+
+		if (sz != sizeof(a_report)) {
+			reason = "immediate accel read failed";
+			break;
+		}
+
+		sz = read(fd_gyro, &g_report, sizeof(g_report));
+
+		if (sz != sizeof(g_report)) {
+			reason = "immediate gyro read failed";
+			break;
+		}
+
+		printf("single read\n");
+		fflush(stdout);
+		printf("accel time:  %lld\n", a_report.timestamp);
+		printf("accel x:     %f\t(%d raw)\n", a_report.x, a_report.x_raw);
+		printf("accel y:     %f\t(%d raw)\n", a_report.y, a_report.y_raw);
+		printf("accel z:     %f\t(%d raw)\n", a_report.z, a_report.z_raw);
+		printf("gyro time:   %lld\n", g_report.timestamp);
+		printf("gyro x:      %f\t(%d raw)\n", g_report.x, g_report.x_raw);
+		printf("gyro y:      %f\t(%d raw)\n", g_report.y, g_report.y_raw);
+		printf("gyro z:      %f\t(%d raw)\n", g_report.z, g_report.z_raw);
+
+	} while (0);
+
+	if (fd_gyro >= 0)
+		close(fd_gyro);
+
+	if (fd >= 0)
+		close(fd);
+
+	printf("MPU6000: %s\n", reason);
+
+	return OK;
+}
+
+int
+info()
+{
+	if (g_dev == nullptr) {
+		fprintf(stderr, "MPU6000: driver not running\n");
+		return -ENOENT;
+	}
+
+	printf("state @ %p\n", g_dev);
+	g_dev->print_info();
+
+	return OK;
+}
+
+
+} // namespace
+
+int
+mpu6000_main(int argc, char *argv[])
+{
+	/*
+	 * Start/load the driver.
+	 *
+	 * XXX it would be nice to have a wrapper for this...
+	 */
+	if (!strcmp(argv[1], "start")) {
+
+		if (g_dev != nullptr) {
+			fprintf(stderr, "MPU6000: already loaded\n");
+			return -EBUSY;
+		}
+
+		/* create the driver */
+		g_dev = new MPU6000(1, (spi_dev_e)PX4_SPIDEV_MPU);
+
+		if (g_dev == nullptr) {
+			fprintf(stderr, "MPU6000: driver alloc failed\n");
+			return -ENOMEM;
+		}
+
+		if (OK != g_dev->init()) {
+			fprintf(stderr, "MPU6000: driver init failed\n");
+			usleep(100000);
+			delete g_dev;
+			g_dev = nullptr;
+			return -EIO;
+		}
+
+		printf("MPU6000: driver started\n");
+		return OK;
+	}
+
+	/*
+	 * Test the driver/device.
+	 */
+	if (!strcmp(argv[1], "test"))
+		return test();
+
+	/*
+	 * Print driver information.
+	 */
+	if (!strcmp(argv[1], "info"))
+		return info();
+
+	fprintf(stderr, "unrecognised command, try 'start', 'test' or 'info'\n");
+	return -EINVAL;
+}
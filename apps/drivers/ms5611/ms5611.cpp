@@ -39,6 +39,7 @@
 #include <nuttx/config.h>
 
 #include <drivers/device/i2c.h>
+#include <drivers/device/ringbuffer.h>
 
 #include <sys/types.h>
 #include <stdint.h>
@@ -60,6 +61,10 @@
 
 #include <drivers/drv_baro.h>
 
+#ifndef CONFIG_SCHED_WORKQUEUE
+# error This driver requires CONFIG_SCHED_WORKQUEUE
+#endif
+
 /**
  * Calibration PROM as reported by the device.
  */
@@ -106,16 +111,21 @@ public:
 protected:
 	virtual int		probe();
 
+	virtual void		transaction_complete(Transaction *t, int result);
+
 private:
 	union ms5611_prom_u	_prom;
 
 	struct work_s		_work;
 	unsigned		_measure_ticks;
+	volatile bool		_running;		/**< cleared by stop() so that nothing reschedules the cycle */
+
+	Transaction		_txn;			/**< conversion command or data read queued by cycle() */
+	uint8_t			_cmd;
+	uint8_t			_data[3];		/**< conversion result, big-endian */
 
-	unsigned		_num_reports;
-	volatile unsigned	_next_report;
-	volatile unsigned	_oldest_report;
-	struct baro_report	*_reports;
+	device::RingBuffer<struct baro_report>	_reports;
+	struct baro_report	_report;		/**< report being assembled by the measurement cycle */
 
 	bool			_collect_phase;
 	unsigned		_measure_phase;
@@ -128,7 +138,6 @@ private:
 	unsigned		_reads;
 	unsigned		_measure_errors;
 	unsigned		_read_errors;
-	unsigned		_buf_overflows;
 
 	/**
 	 * Test whether the device supported by the driver is present at a
@@ -153,12 +162,14 @@ private:
 	void			stop();
 
 	/**
-	 * Perform a poll cycle; collect from the previous measurement
-	 * and start a new one.
+	 * Perform a poll cycle; queue either the collection of the previous
+	 * measurement or the command for a new one.
 	 *
 	 * This is the heart of the measurement state machine.  This function
 	 * alternately starts a measurement, or collects the data from the
-	 * previous measurement.
+	 * previous measurement.  It runs on the work queue and never waits
+	 * for the bus; transaction_complete() advances the state machine and
+	 * schedules the next cycle.
 	 *
 	 * When the interval between measurements is greater than the minimum
 	 * measurement interval, a gap is inserted between collection
@@ -176,17 +187,27 @@ private:
 	static void		cycle_trampoline(void *arg);
 
 	/**
-	 * Issue a measurement command for the current state.
+	 * Issue a measurement command for the current state and wait for
+	 * the bus; only for manual measurement from read().
 	 *
 	 * @return		OK if the measurement command was successful.
 	 */
 	int			measure();
 
 	/**
-	 * Collect the result of the most recent measurement.
+	 * Collect the result of the most recent measurement and wait for
+	 * the bus; only for manual measurement from read().
 	 */
 	int			collect();
 
+	/**
+	 * Convert the result of a measurement and advance the measurement
+	 * phase, publishing a report after each pressure measurement.
+	 *
+	 * @param data		The three data bytes read from the device.
+	 */
+	void			process(const uint8_t *data);
+
 	/**
 	 * Read the MS5611 PROM
 	 *
@@ -204,7 +225,7 @@ private:
 
 };
 
-/* helper macro for handling report buffer indices */
+/* helper macro for handling wrapping counters */
 #define INCREMENT(_x, _lim)	do { _x++; if (_x >= _lim) _x = 0; } while(0)
 
 /*
@@ -234,34 +255,36 @@ extern "C" __EXPORT int ms5611_main(int argc, char *argv[]);
 MS5611::MS5611(int bus) :
 	I2C("MS5611", BARO_DEVICE_PATH, bus, 0, 400000),
 	_measure_ticks(0),
-	_num_reports(0),
-	_next_report(0),
-	_oldest_report(0),
-	_reports(nullptr),
+	_running(false),
 	_collect_phase(false),
 	_measure_phase(0),
 	_dT(0),
 	_temp64(0),
 	_reads(0),
 	_measure_errors(0),
-	_read_errors(0),
-	_buf_overflows(0)
+	_read_errors(0)
 {
 	// enable debug() calls
 	_debug_enabled = true;
 
+	// conversions are slow and not time-critical; let other devices on the bus go first
+	set_priority(PRIORITY_LOW);
+
 	// work_cancel in the dtor will explode if we don't do this...
 	_work.worker = nullptr;
+
+	// conversion commands and data reads are queued from the work queue
+	memset(&_txn, 0, sizeof(_txn));
+	_txn.send = &_cmd;
+	_txn.send_len = 1;
+	_txn.priority = PRIORITY_LOW;
+	_txn.retries = 0;
 }
 
 MS5611::~MS5611()
 {
 	/* make sure we are truly inactive */
 	stop();
-
-	/* free any existing reports */
-	if (_reports != nullptr)
-		delete[] _reports;
 }
 
 int
@@ -276,9 +299,12 @@ MS5611::init()
 	if (ret == OK) {
 		struct baro_report b;
 
-		/* if this fails (e.g. no object in the system) that's OK */
+		/*
+		 * Publish as the next free instance so that a second barometer can
+		 * coexist. If this fails (e.g. no object in the system) that's OK.
+		 */
 		memset(&b, 0, sizeof(b));
-		_orbject = orb_advertise(ORB_ID(sensor_baro), &b);
+		_orbject = orb_advertise_multi(ORB_ID(sensor_baro), &b, nullptr);
 
 		if (_orbject < 0)
 			debug("failed to create sensor_baro object");
@@ -294,9 +320,8 @@ MS5611::open_first(struct file *filp)
 	_measure_ticks = 0;
 
 	/* allocate basic report buffers */
-	_num_reports = 2;
-	_reports = new struct baro_report[_num_reports];
-	_oldest_report = _next_report = 0;
+	if (!_reports.resize(2))
+		return -ENOMEM;
 
 	return OK;
 }
@@ -308,10 +333,7 @@ MS5611::close_last(struct file *filp)
 	stop();
 
 	/* free report buffers */
-	if (_reports != nullptr) {
-		delete[] _reports;
-		_num_reports = 0;
-	}
+	_reports.resize(0);
 
 	_measure_ticks = 0;
 
@@ -366,17 +388,10 @@ MS5611::read(struct file *filp, char *buffer, size_t buflen)
 	if (_measure_ticks > 0) {
 
 		/*
-		 * While there is space in the caller's buffer, and reports, copy them.
-		 * Note that we may be pre-empted by the workq thread while we are doing this;
-		 * we are careful to avoid racing with them.
+		 * Copy as many reports as there are, up to the space in the caller's
+		 * buffer. The ring is safe against the workq thread pre-empting us.
 		 */
-		while (count--) {
-			if (_oldest_report != _next_report) {
-				memcpy(buffer, _reports + _oldest_report, sizeof(*_reports));
-				ret += sizeof(_reports[0]);
-				INCREMENT(_oldest_report, _num_reports);
-			}
-		}
+		ret = _reports.get(reinterpret_cast<struct baro_report *>(buffer), count) * sizeof(struct baro_report);
 
 		_reads++;
 
@@ -388,7 +403,7 @@ MS5611::read(struct file *filp, char *buffer, size_t buflen)
 	/* XXX really it'd be nice to lock against other readers here */
 	do {
 		_measure_phase = 0;
-		_oldest_report = _next_report = 0;
+		_reports.flush();
 
 		/* do temperature first */
 		if (OK != measure()) {
@@ -417,8 +432,12 @@ MS5611::read(struct file *filp, char *buffer, size_t buflen)
 		}
 
 		/* state machine will have generated a report, copy it out */
-		memcpy(buffer, _reports, sizeof(*_reports));
-		ret = sizeof(*_reports);
+		if (!_reports.get(*reinterpret_cast<struct baro_report *>(buffer))) {
+			ret = -EIO;
+			break;
+		}
+
+		ret = sizeof(struct baro_report);
 		_reads++;
 
 	} while (0);
@@ -476,20 +495,16 @@ MS5611::ioctl(struct file *filp, int cmd, unsigned long arg)
 			if ((arg < 2) || (arg > 100))
 				return -EINVAL;
 
-			/* allocate new buffer */
-			struct baro_report *buf = new struct baro_report[arg];
+			/* the ring must not be written while it is resized */
+			stop();
 
-			if (nullptr == buf)
-				return -ENOMEM;
+			int ret = _reports.resize(arg) ? OK : -ENOMEM;
 
-			/* reset the measurement state machine with the new buffer, free the old */
-			stop();
-			delete[] _reports;
-			_num_reports = arg;
-			_reports = buf;
-			start();
+			/* restart automatic measurement if it was running */
+			if (_measure_ticks > 0)
+				start();
 
-			return OK;
+			return ret;
 		}
 
 	case BAROIOCSREPORTFORMAT:
@@ -510,15 +525,23 @@ MS5611::start()
 	/* reset the report ring and state machine */
 	_collect_phase = false;
 	_measure_phase = 0;
-	_oldest_report = _next_report = 0;
+	_reports.flush();
 
 	/* schedule a cycle to start things */
+	_running = true;
 	work_queue(&_work, (worker_t)&MS5611::cycle_trampoline, this, 1);
 }
 
 void
 MS5611::stop()
 {
+	_running = false;
+	work_cancel(&_work);
+
+	/* let a queued transaction finish, then drop anything it scheduled */
+	while (transaction_busy(&_txn))
+		usleep(1000);
+
 	work_cancel(&_work);
 }
 
@@ -533,16 +556,57 @@ MS5611::cycle_trampoline(void *arg)
 void
 MS5611::cycle()
 {
-	/* collection phase? */
+	if (!_running)
+		return;
+
 	if (_collect_phase) {
+		/* read the result of the conversion started by the last cycle */
+		_cmd = ADDR_DATA;
+		_txn.recv = &_data[0];
+		_txn.recv_len = sizeof(_data);
 
-		/* perform collection */
-		if (OK != collect()) {
-			log("FATAL collection error - restarting\n");
-			start();
-			return;
+		/* this should be fairly close to the end of the conversion, so the best approximation of the time */
+		_report.timestamp = hrt_absolute_time();
+
+	} else {
+		/* in phase zero, request temperature; in other phases, request pressure */
+		_cmd = (_measure_phase == 0) ? ADDR_CMD_CONVERT_D2 : ADDR_CMD_CONVERT_D1;
+		_txn.recv = nullptr;
+		_txn.recv_len = 0;
+	}
+
+	/*
+	 * The bus thread performs the transfer behind anything more urgent and
+	 * calls transaction_complete(); the work queue is free in the meantime.
+	 */
+	int ret = submit(&_txn);
+
+	if (OK != ret) {
+		transaction_complete(&_txn, ret);
+	}
+}
+
+void
+MS5611::transaction_complete(Transaction *t, int result)
+{
+	unsigned delay;
+
+	if (OK != result) {
+		if (_collect_phase) {
+			_read_errors++;
+
+		} else {
+			_measure_errors++;
 		}
 
+		/* start over with a temperature measurement */
+		_collect_phase = false;
+		_measure_phase = 0;
+		delay = 1;
+
+	} else if (_collect_phase) {
+		process(&_data[0]);
+
 		/* next phase is measurement */
 		_collect_phase = false;
 
@@ -553,31 +617,21 @@ MS5611::cycle()
 		 */
 		if ((_measure_phase != 0) &&
 		    (_measure_ticks > USEC2TICK(MS5611_CONVERSION_INTERVAL))) {
+			delay = _measure_ticks - USEC2TICK(MS5611_CONVERSION_INTERVAL);
 
-			/* schedule a fresh cycle call when we are ready to measure again */
-			work_queue(&_work,
-				   (worker_t)&MS5611::cycle_trampoline,
-				   this,
-				   _measure_ticks - USEC2TICK(MS5611_CONVERSION_INTERVAL));
-
-			return;
+		} else {
+			delay = 0;
 		}
-	}
 
-	/* measurement phase */
-	if (OK != measure()) {
-		log("FATAL measure error - restarting\n");
-		start();
+	} else {
+		/* next phase is collection, when the conversion is done */
+		_collect_phase = true;
+		delay = USEC2TICK(MS5611_CONVERSION_INTERVAL);
 	}
 
-	/* next phase is collection */
-	_collect_phase = true;
-
-	/* schedule a fresh cycle call when the measurement is done */
-	work_queue(&_work,
-		   (worker_t)&MS5611::cycle_trampoline,
-		   this,
-		   USEC2TICK(MS5611_CONVERSION_INTERVAL));
+	/* schedule a fresh cycle call; work_queue does not block */
+	if (_running)
+		work_queue(&_work, (worker_t)&MS5611::cycle_trampoline, this, delay);
 }
 
 int
@@ -611,13 +665,21 @@ MS5611::collect()
 	cmd = 0;
 
 	/* this should be fairly close to the end of the conversion, so the best approximation of the time */
-	_reports[_next_report].timestamp = hrt_absolute_time();
+	_report.timestamp = hrt_absolute_time();
 
 	if (OK != transfer(&cmd, 1, &data[0], 3)) {
 		_read_errors++;
 		return -EIO;
 	}
 
+	process(&data[0]);
+
+	return OK;
+}
+
+void
+MS5611::process(const uint8_t *data)
+{
 	/* fetch the raw value */
 	uint32_t raw = (((uint32_t)data[0]) << 16) | (((uint32_t)data[1]) << 8) | ((uint32_t)data[2]);
 
@@ -649,22 +711,16 @@ MS5611::collect()
 		int64_t press_int64 = (((raw * sens) / 2097152 - offset) / 32768);
 
 		/* generate a new report */
-		_reports[_next_report].temperature = _temp64 / 100.0f;
-		_reports[_next_report].pressure = press_int64 / 100.0f;
+		_report.temperature = _temp64 / 100.0f;
+		_report.pressure = press_int64 / 100.0f;
 		/* convert as double for max. precision, store as float (more than enough precision) */
-		_reports[_next_report].altitude = (44330.0 * (1.0 - pow((press_int64 / 101325.0), 0.190295)));
+		_report.altitude = (44330.0 * (1.0 - pow((press_int64 / 101325.0), 0.190295)));
 
 		/* publish it */
-		orb_publish(ORB_ID(sensor_baro), _orbject, &_reports[_next_report]);
+		orb_publish(ORB_ID(sensor_baro), _orbject, &_report);
 
-		/* post a report to the ring - note, not locked */
-		INCREMENT(_next_report, _num_reports);
-
-		/* if we are running up against the oldest report, toss it */
-		if (_next_report == _oldest_report) {
-			_buf_overflows++;
-			INCREMENT(_oldest_report, _num_reports);
-		}
+		/* post a report to the ring, tossing the oldest if the reader is behind */
+		_reports.force(_report);
 
 		/* notify anyone waiting for data */
 		poll_notify(POLLIN);
@@ -673,8 +729,6 @@ MS5611::collect()
 
 	/* update the measurement state machine */
 	INCREMENT(_measure_phase, MS5611_MEASUREMENT_RATIO + 1);
-
-	return OK;
 }
 
 int
@@ -747,11 +801,11 @@ MS5611::print_info()
 	printf("reads:          %u\n", _reads);
 	printf("measure errors: %u\n", _measure_errors);
 	printf("read errors:    %u\n", _read_errors);
-	printf("read overflows: %u\n", _buf_overflows);
+	printf("read overflows: %u\n", _reports.overflows());
 	printf("poll interval:  %u ticks\n", _measure_ticks);
-	printf("report queue:   %u (%u/%u @ %p)\n",
-	       _num_reports, _oldest_report, _next_report, _reports);
+	printf("report queue:   %u/%u\n", _reports.count(), _reports.size());
 	printf("dT/temp64:      %d/%lld\n", _dT, _temp64);
+	print_bus_info();
 }
 
 /**
@@ -61,6 +61,8 @@
 #include <uORB/topics/vehicle_status.h>
 #include <uORB/topics/fixedwing_control.h>
 
+#include "rotation.h"
+
 #ifndef F_M_PI
 #define F_M_PI ((float)M_PI)
 #endif
@@ -333,9 +335,14 @@ static void get_parameters(plane_data_t * plane_data)
  */
 static void calc_body_angular_rates(float roll, float pitch, float yaw, float rollspeed, float pitchspeed, float yawspeed)
 {
-	plane_data.p = rollspeed - sinf(pitch) * yawspeed;
-	plane_data.q = cosf(roll) * pitchspeed + sinf(roll) * cosf(pitch) * yawspeed;
-	plane_data.r = -sinf(roll) * pitchspeed + cosf(roll) * cosf(pitch) * yawspeed;
+	const float euler_rates[3] = { rollspeed, pitchspeed, yawspeed };
+	float rates[3];
+
+	rotation_body_rates(roll, pitch, euler_rates, rates);
+
+	plane_data.p = rates[0];
+	plane_data.q = rates[1];
+	plane_data.r = rates[2];
 }
 
 /**
@@ -351,13 +358,7 @@ static void calc_body_angular_rates(float roll, float pitch, float yaw, float ro
 
 static void calc_bodyframe_angles(float roll, float pitch, float yaw)
 {
-	plane_data.rollb = cosf(yaw) * cosf(pitch) * roll +
-			   (cosf(yaw) * sinf(pitch) * sinf(roll) + sinf(yaw) * cosf(roll)) * pitch
-			   + (-cosf(yaw) * sinf(pitch) * cosf(roll)  + sinf(yaw) * sinf(roll)) * yaw;
-	plane_data.pitchb = -sinf(yaw) * cosf(pitch) * roll +
-			    (-sinf(yaw) * sinf(pitch) * sinf(roll) + cosf(yaw) * cosf(roll)) * pitch
-			    + (sinf(yaw) * sinf(pitch) * cosf(roll) + cosf(yaw) * sinf(roll)) * yaw;
-	plane_data.yawb = sinf(pitch) * roll - cosf(pitch) * sinf(roll) * pitch + cosf(pitch) * cosf(roll) * yaw;
+	calc_rotation_matrix(roll, pitch, yaw, roll, pitch, yaw);
 }
 
 /**
@@ -376,13 +377,14 @@ static void calc_bodyframe_angles(float roll, float pitch, float yaw)
 
 static void calc_rotation_matrix(float roll, float pitch, float yaw, float x, float y, float z)
 {
-	plane_data.rollb = cosf(yaw) * cosf(pitch) * x +
-			   (cosf(yaw) * sinf(pitch) * sinf(roll) + sinf(yaw) * cosf(roll)) * y
-			   + (-cosf(yaw) * sinf(pitch) * cosf(roll)  + sinf(yaw) * sinf(roll)) * z;
-	plane_data.pitchb = -sinf(yaw) * cosf(pitch) * x +
-			    (-sinf(yaw) * sinf(pitch) * sinf(roll) + cosf(yaw) * cosf(roll)) * y
-			    + (sinf(yaw) * sinf(pitch) * cosf(roll) + cosf(yaw) * sinf(roll)) * z;
-	plane_data.yawb = sinf(pitch) * x - cosf(pitch) * sinf(roll) * y + cosf(pitch) * cosf(roll) * z;
+	const float nav[3] = { x, y, z };
+	float body[3];
+
+	rotation_to_body(roll, pitch, yaw, nav, body);
+
+	plane_data.rollb = body[0];
+	plane_data.pitchb = body[1];
+	plane_data.yawb = body[2];
 }
 
 /**
@@ -735,6 +737,9 @@ int fixedwing_control_main(int argc, char *argv[])
 	mixers[2].dest[0] = MOT;
 	mixers[2].dual_rate[0] = 1;
 
+	/* generation of the parameters in plane_data; zero is never current */
+	uint32_t param_generation = 0;
+
 	/*
 	 * Main control, navigation and servo routine
 	 */
@@ -772,8 +777,11 @@ int fixedwing_control_main(int argc, char *argv[])
 		plane_data.pitchspeed = att.pitchspeed;
 		plane_data.yawspeed = att.yawspeed;
 
-		/* parameter values */
-		get_parameters(&plane_data);
+		/* parameter values, when they have changed */
+		if (param_generation != global_data_parameter_storage->generation) {
+			param_generation = global_data_parameter_storage->generation;
+			get_parameters(&plane_data);
+		}
 
 		/* Attitude control part */
 
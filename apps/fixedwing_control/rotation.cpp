@@ -0,0 +1,83 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2012 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file rotation.cpp
+ * Euler angle rotations for the fixed wing controller.
+ */
+
+#include <math.h>
+
+#include <systemlib/matrix.h>
+
+#include "rotation.h"
+
+typedef math::Matrix<float, 3, 3> Matrix3;
+typedef math::Vector<float, 3> Vector3;
+
+void
+rotation_to_body(float roll, float pitch, float yaw, const float in[3], float out[3])
+{
+	float cr = cosf(roll), sr = sinf(roll);
+	float cp = cosf(pitch), sp = sinf(pitch);
+	float cy = cosf(yaw), sy = sinf(yaw);
+
+	const float r[9] = {
+		cy * cp,	cy * sp * sr + sy * cr,		-cy * sp * cr + sy * sr,
+		-sy * cp,	-sy * sp * sr + cy * cr,	sy * sp * cr + cy * sr,
+		sp,		-cp * sr,			cp * cr
+	};
+
+	Vector3 v = Matrix3(r) * Vector3(in);
+
+	for (unsigned i = 0; i < 3; i++)
+		out[i] = v(i);
+}
+
+void
+rotation_body_rates(float roll, float pitch, const float euler_rates[3], float body_rates[3])
+{
+	float cr = cosf(roll), sr = sinf(roll);
+	float cp = cosf(pitch), sp = sinf(pitch);
+
+	const float e[9] = {
+		1.0f,	0.0f,	-sp,
+		0.0f,	cr,	sr * cp,
+		0.0f,	-sr,	cr * cp
+	};
+
+	Vector3 v = Matrix3(e) * Vector3(euler_rates);
+
+	for (unsigned i = 0; i < 3; i++)
+		body_rates[i] = v(i);
+}
@@ -1,5 +1,6 @@
-/*
- *   Copyright (C) 2012 Lorenz Meier. All rights reserved.
+/****************************************************************************
+ *
+ *   Copyright (C) 2012 PX4 Development Team. All rights reserved.
  *
  * Redistribution and use in source and binary forms, with or without
  * modification, are permitted provided that the following conditions
@@ -11,7 +12,7 @@
  *    notice, this list of conditions and the following disclaimer in
  *    the documentation and/or other materials provided with the
  *    distribution.
- * 3. Neither the name of the author or the names of contributors may be
+ * 3. Neither the name PX4 nor the names of its contributors may be
  *    used to endorse or promote products derived from this software
  *    without specific prior written permission.
  *
@@ -27,66 +28,42 @@
  * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
  * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
  * POSSIBILITY OF SUCH DAMAGE.
- */
-
-/*
- * Driver for the Invense MPU-6000 gyroscope
- */
-
-/* IMPORTANT NOTES:
- *
- * SPI max. clock frequency: 10 Mhz
- * CS has to be high before transfer,
- * go low right before transfer and
- * go high again right after transfer
  *
- */
+ ****************************************************************************/
 
-#include <sys/ioctl.h>
-
-#define _MPU6000BASE	0x7600
-#define MPU6000C(_x)	_IOC(_MPU6000BASE, _x)
-
-/* 
- * Sets the sensor internal sampling rate, and if a buffer
- * has been configured, the rate at which entries will be
- * added to the buffer.
+/**
+ * @file rotation.h
+ * Euler angle rotations for the fixed wing controller.
  */
-#define MPU6000_SETRATE		MPU6000C(1)
 
-#define MPU6000_RATE_95HZ_LP_12_5HZ		((0<<7) | (0<<6) | (0<<5) | (0<<4))
-
-/*
- * Sets the sensor internal range.
- */
-#define MPU6000_SETRANGE		MPU6000C(2)
+#ifndef ROTATION_H_
+#define ROTATION_H_
 
-#define MPU6000_RANGE_250DPS			(0<<4)
-
-#define MPU6000_RATE_95HZ			((0<<6) | (0<<4))
+#include <sys/cdefs.h>
 
+__BEGIN_DECLS
 
+/**
+ * Rotate a vector from the navigation frame into the body frame.
+ *
+ * @param roll		Roll angle, radians.
+ * @param pitch		Pitch angle, radians.
+ * @param yaw		Yaw angle, radians.
+ * @param in		The vector in the navigation frame.
+ * @param out		Returns the vector in the body frame.
+ */
+__EXPORT extern void	rotation_to_body(float roll, float pitch, float yaw, const float in[3], float out[3]);
 
-/*
- * Sets the address of a shared MPU6000_buffer
- * structure that is maintained by the driver.
+/**
+ * Convert Euler angle rates to body angular rates.
  *
- * If zero is passed as the address, disables
- * the buffer updating.
+ * @param roll		Roll angle, radians.
+ * @param pitch		Pitch angle, radians.
+ * @param euler_rates	Roll, pitch and yaw rates, radians/second.
+ * @param body_rates	Returns the body rates p, q and r, radians/second.
  */
-#define MPU6000_SETBUFFER	MPU6000C(3)
+__EXPORT extern void	rotation_body_rates(float roll, float pitch, const float euler_rates[3], float body_rates[3]);
 
-struct MPU6000_buffer {
-	uint32_t	size;		/* number of entries in the samples[] array */
-	uint32_t	next;		/* the next entry that will be populated */
-	struct {
-		uint16_t	x;
-		uint16_t	y;
-		uint16_t	z;
-		uint16_t	roll;
-		uint16_t	pitch;
-		uint16_t	yaw;
-	} samples[];
-};
+__END_DECLS
 
-extern int	mpu6000_attach(struct spi_dev_s *spi, int spi_id);
+#endif /* ROTATION_H_ */
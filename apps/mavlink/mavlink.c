@@ -435,7 +435,7 @@ static void *uorb_receiveloop(void *arg)
 	const ssize_t fdsc = 15;
 	/* Sanity check variable and index */
 	ssize_t fdsc_count = 0;
-	/* file descriptors to wait for */
+	/* file descriptors to wait for, in the order of their bits below */
 	struct pollfd fds[fdsc];
 
 
@@ -537,10 +537,6 @@ static void *uorb_receiveloop(void *arg)
 	fds[fdsc_count].events = POLLIN;
 	fdsc_count++;
 
-	unsigned int sensors_raw_counter = 0;
-	unsigned int attitude_counter = 0;
-	unsigned int gps_counter = 0;
-
 	/* WARNING: If you get the error message below,
 	 * then the number of registered messages (fdsc)
 	 * differs from the number of messages in the above list.
@@ -550,6 +546,29 @@ static void *uorb_receiveloop(void *arg)
 		fdsc_count = fdsc;
 	}
 
+	/*
+	 * Wait on the subscriptions with a wait set, which registers them with
+	 * their topics once instead of on every poll(). Its bits follow the
+	 * order of fds[]; if it can't be set up, fall back to poll().
+	 */
+	orb_waitset_t subs = orb_waitset_create();
+
+	for (ssize_t i = 0; (subs != NULL) && (i < fdsc_count); i++) {
+		if (orb_waitset_add(subs, fds[i].fd) != i) {
+			int err = errno;
+			orb_waitset_destroy(subs);
+			subs = NULL;
+			errno = err;
+		}
+	}
+
+	if (subs == NULL)
+		fprintf(stderr, "[mavlink] uORB wait set failed (%d), using poll\n", errno);
+
+	unsigned int sensors_raw_counter = 0;
+	unsigned int attitude_counter = 0;
+	unsigned int gps_counter = 0;
+
 	/*
 	 * set up poll to block for new data,
 	 * wait for a maximum of 1000 ms (1 second)
@@ -559,7 +578,20 @@ static void *uorb_receiveloop(void *arg)
 	while (1) {
 		if (mavlink_exit_requested) break;
 
-		int poll_ret = poll(fds, fdsc_count, timeout);
+		uint32_t ready = 0;
+		int poll_ret;
+
+		if (subs != NULL) {
+			poll_ret = orb_waitset_wait(subs, timeout, &ready);
+
+		} else {
+			poll_ret = poll(fds, fdsc_count, timeout);
+
+			for (ssize_t i = 0; i < fdsc_count; i++) {
+				if (fds[i].revents & POLLIN)
+					ready |= (1 << i);
+			}
+		}
 
 		/* handle the poll result */
 		if (poll_ret == 0) {
@@ -569,7 +601,7 @@ static void *uorb_receiveloop(void *arg)
 		} else {
 
 			/* --- SENSORS RAW VALUE --- */
-			if (fds[0].revents & POLLIN) {
+			if (ready & (1 << 0)) {
 
 				/* copy sensors raw data into local buffer */
 				orb_copy(ORB_ID(sensor_combined), sensor_sub, &buf.raw);
@@ -585,7 +617,7 @@ static void *uorb_receiveloop(void *arg)
 			}
 
 			/* --- ATTITUDE VALUE --- */
-			if (fds[1].revents & POLLIN) {
+			if (ready & (1 << 1)) {
 
 				/* copy attitude data into local buffer */
 				orb_copy(ORB_ID(vehicle_attitude), att_sub, &buf.att);
@@ -597,7 +629,7 @@ static void *uorb_receiveloop(void *arg)
 			}
 
 			/* --- GPS VALUE --- */
-			if (fds[2].revents & POLLIN) {
+			if (ready & (1 << 2)) {
 				/* copy gps data into local buffer */
 				orb_copy(ORB_ID(vehicle_gps_position), gps_sub, &buf.gps);
 				/* GPS position */
@@ -611,7 +643,7 @@ static void *uorb_receiveloop(void *arg)
 			}
 
 			/* --- ARDRONE CONTROL OUTPUTS --- */
-			if (fds[3].revents & POLLIN) {
+			if (ready & (1 << 3)) {
 				/* copy ardrone control data into local buffer */
 				orb_copy(ORB_ID(ardrone_control), ar_sub, &buf.ar_control);
 				uint64_t timestamp    = buf.ar_control.timestamp;
@@ -631,7 +663,7 @@ static void *uorb_receiveloop(void *arg)
 			}
 
 			/* --- SYSTEM STATUS --- */
-			if (fds[4].revents & POLLIN) {
+			if (ready & (1 << 4)) {
 				/* immediately communicate state changes back to user */
 				orb_copy(ORB_ID(vehicle_status), status_sub, &v_status);
 				/* enable or disable HIL */
@@ -647,7 +679,7 @@ static void *uorb_receiveloop(void *arg)
 			}
 
 			/* --- RC CHANNELS --- */
-			if (fds[5].revents & POLLIN) {
+			if (ready & (1 << 5)) {
 				/* copy rc channels into local buffer */
 				orb_copy(ORB_ID(rc_channels), rc_sub, &rc);
 				/* Channels are sent in MAVLink main loop at a fixed interval */
@@ -655,7 +687,7 @@ static void *uorb_receiveloop(void *arg)
 			}
 
 			/* --- FIXED WING CONTROL CHANNELS --- */
-			if (fds[6].revents & POLLIN) {
+			if (ready & (1 << 6)) {
 				/* copy fixed wing control into local buffer */
 				orb_copy(ORB_ID(fixedwing_control), fw_sub, &fw_control);
 				/* send control output via MAVLink */
@@ -720,7 +752,7 @@ static void *uorb_receiveloop(void *arg)
 			}
 
 			/* --- VEHICLE GLOBAL POSITION --- */
-			if (fds[7].revents & POLLIN) {
+			if (ready & (1 << 7)) {
 				/* copy global position data into local buffer */
 				orb_copy(ORB_ID(vehicle_global_position), global_pos_sub, &global_pos);
 				uint64_t timestamp = global_pos.timestamp;
@@ -738,14 +770,14 @@ static void *uorb_receiveloop(void *arg)
 			}
 
 			/* --- VEHICLE LOCAL POSITION --- */
-			if (fds[8].revents & POLLIN) {
+			if (ready & (1 << 8)) {
 				/* copy local position data into local buffer */
 				orb_copy(ORB_ID(vehicle_local_position), local_pos_sub, &local_pos);
 				mavlink_msg_local_position_ned_send(MAVLINK_COMM_0, local_pos.timestamp / 1000, local_pos.x, local_pos.y, local_pos.z, local_pos.vx, local_pos.vy, local_pos.vz);
 			}
 
 			/* --- VEHICLE GLOBAL SETPOINT --- */
-			if (fds[9].revents & POLLIN) {
+			if (ready & (1 << 9)) {
 				/* copy local position data into local buffer */
 				orb_copy(ORB_ID(vehicle_global_position_setpoint), spg_sub, &buf.global_sp);
 				uint8_t coordinate_frame = MAV_FRAME_GLOBAL;
@@ -754,7 +786,7 @@ static void *uorb_receiveloop(void *arg)
 			}
 
 			/* --- VEHICLE LOCAL SETPOINT --- */
-			if (fds[10].revents & POLLIN) {
+			if (ready & (1 << 10)) {
 				/* copy local position data into local buffer */
 				orb_copy(ORB_ID(vehicle_local_position_setpoint), spl_sub, &buf.local_sp);
 				mavlink_msg_local_position_setpoint_send(MAVLINK_COMM_0, MAV_FRAME_LOCAL_NED, buf.local_sp.x, buf.local_sp.y, buf.local_sp.z, buf.local_sp.yaw);
@@ -762,6 +794,9 @@ static void *uorb_receiveloop(void *arg)
 		}
 	}
 
+	if (subs != NULL)
+		orb_waitset_destroy(subs);
+
 	return NULL;
 }
 
@@ -39,6 +39,7 @@
 
 #include "mavlink_parameters.h"
 #include <uORB/uORB.h>
+#include <systemlib/systemlib.h>
 #include "math.h" /* isinf / isnan checks */
 #include <assert.h>
 #include <stdio.h>
@@ -123,6 +124,7 @@ void mavlink_pm_message_handler(const mavlink_channel_t chan, const mavlink_mess
 						if (match) {
 							// XXX handle param type as well, assuming float here
 							global_data_parameter_storage->pm.param_values[i] = mavlink_param_set.param_value;
+							params_changed(global_data_parameter_storage);
 							mavlink_pm_send_one_parameter(i);
 						}
 					}
@@ -49,7 +49,7 @@
 #include <stdio.h>
 #include <stdint.h>
 #include <stdbool.h>
-#include <px4/attitude_estimator_bm/matrix.h> //TODO: move matrix.h to somewhere else?
+#include <systemlib/float_vect3.h>
 #include <float.h>
 #include <math.h>
 #include "pid.h"
@@ -112,6 +112,7 @@ void multirotor_control_attitude(const struct rc_channels_s *rc,
 	static float pid_att_lim;
 
 	static bool initialized;
+	static uint32_t param_generation;
 
 	// static float_vect3 attitude_setpoint_navigationframe_from_positioncontroller;
 
@@ -164,8 +165,10 @@ void multirotor_control_attitude(const struct rc_channels_s *rc,
 		initialized = true;
 	}
 
-	/* load new parameters with lower rate */
-	if (motor_skip_counter % 50 == 0) {
+	/* load new parameters when they have changed */
+	if (param_generation != global_data_parameter_storage->generation) {
+		param_generation = global_data_parameter_storage->generation;
+
 		pid_set_parameters(&yaw_pos_controller,
 				   (max_gas - min_gas) * global_data_parameter_storage->pm.param_values[PARAM_PID_YAWPOS_P],
 				   (max_gas - min_gas) * global_data_parameter_storage->pm.param_values[PARAM_PID_YAWPOS_I],
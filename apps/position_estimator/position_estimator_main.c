@@ -43,6 +43,7 @@
 #include <unistd.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <stdbool.h>
 #include <fcntl.h>
 #include <v1.0/common/mavlink.h>
@@ -59,8 +60,10 @@
 #include <uORB/topics/vehicle_gps_position.h>
 #include <uORB/topics/vehicle_global_position.h>
 #include <poll.h>
+#include <systemlib/perf_counter.h>
 
 #include "codegen/position_estimator.h"
+#include "state_history.h"
 
 #define N_STATES 6
 #define ERROR_COVARIANCE_INIT 3
@@ -69,6 +72,9 @@
 #define PROJECTION_INITIALIZE_COUNTER_LIMIT 5000
 #define REPROJECTION_COUNTER_LIMIT 125
 
+/* age of a GPS fix when it is published; UBX and MTK fixes arrive 100-200 ms late */
+#define GPS_LATENCY_US 150000
+
 __EXPORT int position_estimator_main(int argc, char *argv[]);
 
 static uint16_t position_estimator_counter_position_information;
@@ -230,11 +236,11 @@ int position_estimator_main(int argc, char *argv[])
 	static float z[3] = {0, 0, 0};
 	static float xapo[N_STATES] = {0, 0, 0, 0, 0, 0};
 	static float Papo[N_STATES * N_STATES] = {ERROR_COVARIANCE_INIT, 0, 0, 0, 0, 0,
-			ERROR_COVARIANCE_INIT, 0, 0, 0, 0, 0,
-			ERROR_COVARIANCE_INIT, 0, 0, 0, 0, 0,
-			ERROR_COVARIANCE_INIT, 0, 0, 0, 0, 0,
-			ERROR_COVARIANCE_INIT, 0, 0, 0, 0, 0,
-			ERROR_COVARIANCE_INIT, 0, 0, 0, 0, 0
+			0, ERROR_COVARIANCE_INIT, 0, 0, 0, 0,
+			0, 0, ERROR_COVARIANCE_INIT, 0, 0, 0,
+			0, 0, 0, ERROR_COVARIANCE_INIT, 0, 0,
+			0, 0, 0, 0, ERROR_COVARIANCE_INIT, 0,
+			0, 0, 0, 0, 0, ERROR_COVARIANCE_INIT
 						 };
 
 	static float xapo1[N_STATES];
@@ -242,10 +248,14 @@ int position_estimator_main(int argc, char *argv[])
 
 	static float gps_covariance[3] = {0.0f, 0.0f, 0.0f};
 
+	/* recent predictions, to fuse each GPS fix at the time it was taken */
+	static struct state_history_s history;
+	state_history_reset(&history);
+
 	static uint16_t counter = 0;
 	position_estimator_counter_position_information = 0;
 
-	uint8_t predict_only = 1;
+	uint16_t last_gps_counter = 0;
 
 	bool gps_valid = false;
 
@@ -265,8 +275,12 @@ int position_estimator_main(int argc, char *argv[])
 	int vehicle_gps_sub = orb_subscribe(ORB_ID(vehicle_gps_position));
 	int vehicle_status_sub = orb_subscribe(ORB_ID(vehicle_status));
 
-	/* subscribe to attitude at 100 Hz */
+	/* subscribe to attitude at the 250 Hz the model is discretised for */
 	int vehicle_attitude_sub = orb_subscribe(ORB_ID(vehicle_attitude));
+	orb_set_interval(vehicle_attitude_sub, 4);
+
+	perf_counter_t gps_fused = perf_alloc(PC_COUNT, "position estimator GPS fused");
+	perf_counter_t gps_too_old = perf_alloc(PC_COUNT, "position estimator GPS older than history");
 
 	/* wait until gps signal turns valid, only then can we initialize the projection */
 	while (!gps_valid) {
@@ -290,6 +304,7 @@ int position_estimator_main(int argc, char *argv[])
 	orb_copy(ORB_ID(vehicle_gps_position), vehicle_gps_sub, &gps);
 	lat_current = ((double)(gps.lat)) * 1e-7;
 	lon_current = ((double)(gps.lon)) * 1e-7;
+	last_gps_counter = gps.counter_pos_valid;
 
 	/* publish global position messages only after first GPS message */
 	struct vehicle_global_position_s global_pos = {
@@ -328,13 +343,34 @@ int position_estimator_main(int argc, char *argv[])
 				new_initialization = false;
 			}
 
+			/*
+			 * Predict with the attitude, and record the prediction: GPS
+			 * fixes are fused into the history at the time they were
+			 * taken, not here, so the output is never held back to the
+			 * GPS latency.
+			 */
+			if (true == new_initialization) {
+				xapo[0] = 0; //we have a new plane initialization. the current estimate is in the center of the plane
+				xapo[2] = 0;
+				xapo[4] = 0;
+				/* the recorded steps are in the old plane */
+				state_history_reset(&history);
+			}
+
+			position_estimator(u, z, xapo, Papo, gps_covariance, 1, xapo1, Papo1);
+
+			memcpy(xapo, xapo1, sizeof(xapo));
+			memcpy(Papo, Papo1, sizeof(Papo));
+
+			state_history_push(&history, att.timestamp, u, xapo, Papo);
+
 			/*check if new gps values are available */
 			gps_valid = vstatus.gps_valid;
 
+			if (gps_valid && (gps.counter_pos_valid != last_gps_counter)) { //we are safe to use the gps signal (it has good quality)
 
-			if (gps_valid) { //we are safe to use the gps signal (it has good quality)
+				last_gps_counter = gps.counter_pos_valid;
 
-				predict_only = 0;
 				/* Project gps lat lon (Geographic coordinate system) to plane*/
 				map_projection_project((double)(gps.lat) * 1e-7, (double)(gps.lon) * 1e-7, &(z[0]), &(z[1]));
 
@@ -345,35 +381,13 @@ int position_estimator_main(int argc, char *argv[])
 				gps_covariance[1] = gps.eph;
 				gps_covariance[2] = gps.epv;
 
-			} else {
-				/* we can not use the gps signal (it is of low quality) */
-				predict_only = 1;
-			}
-
-			//		predict_only = 0;																//TODO: only for testing, removeme, XXX
-			//		z[0] = sinf(((float)counter)/180.0f*3.14159265f);								//TODO: only for testing, removeme, XXX
-			//		usleep(100000);																	//TODO: only for testing, removeme, XXX
-
-
-			/*Get new estimation (this is calculated in the plane) */
-			//TODO: if new_initialization == true: use 0,0,0, else use xapo
-			if (true == new_initialization) {																								//TODO,XXX: uncomment!
-				xapo[0] = 0; //we have a new plane initialization. the current estimate is in the center of the plane
-				xapo[2] = 0;
-				xapo[4] = 0;
-				position_estimator(u, z, xapo, Papo, gps_covariance, predict_only, xapo1, Papo1);
-
-			} else {
-				position_estimator(u, z, xapo, Papo, gps_covariance, predict_only, xapo1, Papo1);
-			}
-
-
-
-			/* Copy values from xapo1 to xapo */
-			int i;
+				/* fuse at the step the fix was taken, and carry the correction forward to now */
+				if (state_history_fuse(&history, gps.timestamp - GPS_LATENCY_US, z, gps_covariance, xapo, Papo)) {
+					perf_count(gps_fused);
 
-			for (i = 0; i < N_STATES; i++) {
-				xapo[i] = xapo1[i];
+				} else {
+					perf_count(gps_too_old);
+				}
 			}
 
 			if ((counter % REPROJECTION_COUNTER_LIMIT == 0) || (counter % (PROJECTION_INITIALIZE_COUNTER_LIMIT - 1) == 0)) {
@@ -398,10 +412,10 @@ int position_estimator_main(int argc, char *argv[])
 
 				global_pos.lat = lat_current;
 				global_pos.lon = lon_current;
-				global_pos.alt = xapo1[4];
-				global_pos.vx = xapo1[1];
-				global_pos.vy = xapo1[3];
-				global_pos.vz = xapo1[5];
+				global_pos.alt = xapo[4];
+				global_pos.vx = xapo[1];
+				global_pos.vy = xapo[3];
+				global_pos.vz = xapo[5];
 
 				/* publish current estimate */
 				orb_publish(ORB_ID(vehicle_global_position), global_pos_pub, &global_pos);
@@ -0,0 +1,149 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2012 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file state_history.c
+ * Time-stamped state history for fusing delayed GPS fixes.
+ */
+
+#include <string.h>
+
+#include "codegen/position_estimator.h"
+#include "state_history.h"
+
+#define N	STATE_HISTORY_STATES
+
+/** index of the step age steps before the newest */
+static unsigned
+history_index(const struct state_history_s *history, unsigned age)
+{
+	return (history->newest + STATE_HISTORY_LENGTH - age) % STATE_HISTORY_LENGTH;
+}
+
+/**
+ * Carry a state and covariance correction one model step forward.
+ *
+ * With F the transition matrix, the corrections become F dx and F dP F'.
+ * F adds dt times each velocity to its position, so both products are a
+ * row operation (and for dP a column operation) per axis.
+ */
+static void
+carry_forward(float dx[N], float dP[N * N])
+{
+	for (unsigned r = 0; r < N; r += 2)
+		dx[r] += STATE_HISTORY_DT * dx[r + 1];
+
+	/* F dP: rows */
+	for (unsigned c = 0; c < N; c++) {
+		for (unsigned r = 0; r < N; r += 2)
+			dP[r + N * c] += STATE_HISTORY_DT * dP[r + 1 + N * c];
+	}
+
+	/* (F dP) F': columns */
+	for (unsigned c = 0; c < N; c += 2) {
+		for (unsigned r = 0; r < N; r++)
+			dP[r + N * c] += STATE_HISTORY_DT * dP[r + N * (c + 1)];
+	}
+}
+
+void
+state_history_reset(struct state_history_s *history)
+{
+	history->newest = 0;
+	history->count = 0;
+}
+
+void
+state_history_push(struct state_history_s *history, uint64_t timestamp, const float u[2],
+		   const float x[N], const float P[N * N])
+{
+	history->newest = (history->newest + 1) % STATE_HISTORY_LENGTH;
+
+	if (history->count < STATE_HISTORY_LENGTH)
+		history->count++;
+
+	unsigned i = history->newest;
+	history->timestamp[i] = timestamp;
+	memcpy(history->u[i], u, sizeof(history->u[i]));
+	memcpy(history->x[i], x, sizeof(history->x[i]));
+	memcpy(history->P[i], P, sizeof(history->P[i]));
+}
+
+bool
+state_history_fuse(struct state_history_s *history, uint64_t timestamp, const float z[3],
+		   const float gps_covariance[3], float x[N], float P[N * N])
+{
+	/* the last step taken no later than the measurement; the one before it is needed too */
+	unsigned age = 0;
+
+	while ((age + 1 < history->count) && (history->timestamp[history_index(history, age)] > timestamp))
+		age++;
+
+	if ((age + 1 >= history->count) || (history->timestamp[history_index(history, age)] > timestamp))
+		return false;
+
+	unsigned k = history_index(history, age);
+	unsigned prev = history_index(history, age + 1);
+
+	/* redo step k with the measurement, and keep the difference it makes */
+	float x_fused[N], P_fused[N * N];
+	float dx[N], dP[N * N];
+
+	position_estimator(history->u[k], z, history->x[prev], history->P[prev], gps_covariance, 0, x_fused, P_fused);
+
+	for (unsigned i = 0; i < N; i++)
+		dx[i] = x_fused[i] - history->x[k][i];
+
+	for (unsigned i = 0; i < N * N; i++)
+		dP[i] = P_fused[i] - history->P[k][i];
+
+	/* apply it to step k and, carried forward, to every later one */
+	for (;;) {
+		for (unsigned i = 0; i < N; i++)
+			history->x[k][i] += dx[i];
+
+		for (unsigned i = 0; i < N * N; i++)
+			history->P[k][i] += dP[i];
+
+		if (age == 0)
+			break;
+
+		carry_forward(dx, dP);
+		age--;
+		k = history_index(history, age);
+	}
+
+	memcpy(x, history->x[k], sizeof(history->x[k]));
+	memcpy(P, history->P[k], sizeof(history->P[k]));
+	return true;
+}
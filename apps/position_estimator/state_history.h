@@ -0,0 +1,109 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2012 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file state_history.h
+ * Time-stamped state history for fusing delayed GPS fixes.
+ *
+ * GPS fixes arrive 100-200 ms after the position they describe. Instead of
+ * treating them as current, the estimator keeps a ring of its recent
+ * predictions and fuses each fix at the prediction nearest its measurement
+ * time. The model between steps is linear with known inputs, so the
+ * correction there carries forward to every later step exactly, through
+ * the transition matrix alone, without re-running the filter.
+ */
+
+#ifndef STATE_HISTORY_H_
+#define STATE_HISTORY_H_
+
+#include <sys/cdefs.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define STATE_HISTORY_STATES	6	/**< [px, vx, py, vy, pz, vz] */
+#define STATE_HISTORY_LENGTH	64	/**< steps kept, 256 ms at the model rate */
+#define STATE_HISTORY_DT	0.004f	/**< model step, fixed in position_estimator.m */
+
+/**
+ * The inputs and filter outputs of the last STATE_HISTORY_LENGTH steps.
+ */
+struct state_history_s {
+	uint64_t	timestamp[STATE_HISTORY_LENGTH];
+	float		u[STATE_HISTORY_LENGTH][2];
+	float		x[STATE_HISTORY_LENGTH][STATE_HISTORY_STATES];
+	float		P[STATE_HISTORY_LENGTH][STATE_HISTORY_STATES * STATE_HISTORY_STATES];
+	unsigned	newest;		/**< index of the last step pushed */
+	unsigned	count;		/**< number of valid steps */
+};
+
+__BEGIN_DECLS
+
+/**
+ * Forget all steps, e.g. when the estimate moves to a new map projection.
+ */
+__EXPORT extern void	state_history_reset(struct state_history_s *history);
+
+/**
+ * Record a prediction step, overwriting the oldest once full.
+ *
+ * @param timestamp	Time of the step, microseconds.
+ * @param u		The input the step was predicted with.
+ * @param x		The predicted state.
+ * @param P		The predicted covariance, column-major.
+ */
+__EXPORT extern void	state_history_push(struct state_history_s *history, uint64_t timestamp, const float u[2],
+					   const float x[STATE_HISTORY_STATES],
+					   const float P[STATE_HISTORY_STATES * STATE_HISTORY_STATES]);
+
+/**
+ * Fuse a position measurement at the step it was taken.
+ *
+ * Redoes that step with the measurement update, then carries the
+ * correction forward through every later step in the history.
+ *
+ * @param timestamp	Time the measurement was taken, microseconds.
+ * @param z		The measured position [px, py, pz].
+ * @param gps_covariance The measurement variances, as position_estimator().
+ * @param x		Returns the corrected newest state.
+ * @param P		Returns the corrected newest covariance.
+ * @return		True if fused; false if the measurement is older
+ *			than the history, in which case x and P are not
+ *			written.
+ */
+__EXPORT extern bool	state_history_fuse(struct state_history_s *history, uint64_t timestamp, const float z[3],
+					   const float gps_covariance[3], float x[STATE_HISTORY_STATES],
+					   float P[STATE_HISTORY_STATES * STATE_HISTORY_STATES]);
+
+__END_DECLS
+
+#endif /* STATE_HISTORY_H_ */
@@ -1,6 +1,6 @@
 
 /*
- * attitude_bm.c
+ * attitude_bm.cpp
  *
  *  Created on: 21.12.2010
  *      Author: Laurens Mackay, Tobias Naegeli
@@ -13,7 +13,7 @@
 
 #define TIME_STEP (1.0f / 500.0f)
 
-static kalman_t attitude_blackmagic_kal;
+static Kalman<12, 9> attitude_blackmagic_kal;
 
 void vect_norm(float_vect3 *vect)
 {
@@ -38,39 +38,29 @@ void vect_cross_product(const float_vect3 *a, const float_vect3 *b,
 
 void attitude_blackmagic_update_a(void)
 {
+	Kalman<12, 9>::StateMatrix &a = attitude_blackmagic_kal.a();
+
 	// for acc
 	// Idendity matrix already in A.
-	M(attitude_blackmagic_kal.a, 0, 1) = TIME_STEP * kalman_get_state(
-			&attitude_blackmagic_kal, 11);
-	M(attitude_blackmagic_kal.a, 0, 2) = -TIME_STEP * kalman_get_state(
-			&attitude_blackmagic_kal, 10);
+	a(0, 1) = TIME_STEP * attitude_blackmagic_kal.get_state(11);
+	a(0, 2) = -TIME_STEP * attitude_blackmagic_kal.get_state(10);
 
-	M(attitude_blackmagic_kal.a, 1, 0) = -TIME_STEP * kalman_get_state(
-			&attitude_blackmagic_kal, 11);
-	M(attitude_blackmagic_kal.a, 1, 2) = TIME_STEP * kalman_get_state(
-			&attitude_blackmagic_kal, 9);
+	a(1, 0) = -TIME_STEP * attitude_blackmagic_kal.get_state(11);
+	a(1, 2) = TIME_STEP * attitude_blackmagic_kal.get_state(9);
 
-	M(attitude_blackmagic_kal.a, 2, 0) = TIME_STEP * kalman_get_state(
-			&attitude_blackmagic_kal, 10);
-	M(attitude_blackmagic_kal.a, 2, 1) = -TIME_STEP * kalman_get_state(
-			&attitude_blackmagic_kal, 9);
+	a(2, 0) = TIME_STEP * attitude_blackmagic_kal.get_state(10);
+	a(2, 1) = -TIME_STEP * attitude_blackmagic_kal.get_state(9);
 
 	// for mag
 	// Idendity matrix already in A.
-	M(attitude_blackmagic_kal.a, 3, 4) = TIME_STEP * kalman_get_state(
-			&attitude_blackmagic_kal, 11);
-	M(attitude_blackmagic_kal.a, 3, 5) = -TIME_STEP * kalman_get_state(
-			&attitude_blackmagic_kal, 10);
+	a(3, 4) = TIME_STEP * attitude_blackmagic_kal.get_state(11);
+	a(3, 5) = -TIME_STEP * attitude_blackmagic_kal.get_state(10);
 
-	M(attitude_blackmagic_kal.a, 4, 3) = -TIME_STEP * kalman_get_state(
-			&attitude_blackmagic_kal, 11);
-	M(attitude_blackmagic_kal.a, 4, 5) = TIME_STEP * kalman_get_state(
-			&attitude_blackmagic_kal, 9);
+	a(4, 3) = -TIME_STEP * attitude_blackmagic_kal.get_state(11);
+	a(4, 5) = TIME_STEP * attitude_blackmagic_kal.get_state(9);
 
-	M(attitude_blackmagic_kal.a, 5, 3) = TIME_STEP * kalman_get_state(
-			&attitude_blackmagic_kal, 10);
-	M(attitude_blackmagic_kal.a, 5, 4) = -TIME_STEP * kalman_get_state(
-			&attitude_blackmagic_kal, 9);
+	a(5, 3) = TIME_STEP * attitude_blackmagic_kal.get_state(10);
+	a(5, 4) = -TIME_STEP * attitude_blackmagic_kal.get_state(9);
 
 }
 
@@ -79,7 +69,7 @@ void attitude_blackmagic_init(void)
 	//X Kalmanfilter
 	//initalize matrices
 
-	static m_elem kal_a[12 * 12] = {
+	static const float kal_a[12 * 12] = {
 		1.0f, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
 
 		0, 1.0f, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
@@ -105,7 +95,7 @@ void attitude_blackmagic_init(void)
 		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1.0f
 	};
 
-	static m_elem kal_c[9 * 12] = {
+	static const float kal_c[9 * 12] = {
 		1.0f, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
 
 		0, 1.0f, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
@@ -131,7 +121,7 @@ void attitude_blackmagic_init(void)
 #define FACTORstart 1
 
 
-//	static m_elem kal_gain[12 * 9] =
+//	static const float kal_gain[12 * 9] =
 //	{ 		0.004 , 0    ,   0    ,   0    ,   0    ,   0    ,   0   ,    0    ,   0,
 //			0   ,    0.004 , 0   ,    0   ,    0   ,    0   ,    0   ,    0   ,    0,
 //			0   ,    0    ,   0.004 , 0   ,    0   ,    0   ,    0   ,    0   ,    0,
@@ -146,7 +136,7 @@ void attitude_blackmagic_init(void)
 //			0   ,    0   ,    0   ,    0   ,    0   ,    0   ,    0    ,   0    ,   0.4
 //	};
 
-	static m_elem kal_gain[12 * 9] = {
+	static const float kal_gain[12 * 9] = {
 		0.0006f , 0    ,   0    ,   0    ,   0    ,   0    ,   0   ,    0    ,   0,
 		0   ,    0.0006f , 0   ,    0   ,    0   ,    0   ,    0   ,    0   ,    0,
 		0   ,    0    ,   0.0006f , 0   ,    0   ,    0   ,    0   ,    0   ,    0,
@@ -164,7 +154,7 @@ void attitude_blackmagic_init(void)
 
 #define K (10.0f*TIME_STEP)
 
-	static m_elem kal_gain_start[12 * 9] = {
+	static const float kal_gain_start[12 * 9] = {
 		K, 0, 0, 0, 0, 0, 0, 0, 0,
 
 		0, K, 0, 0, 0, 0, 0, 0, 0,
@@ -192,16 +182,11 @@ void attitude_blackmagic_init(void)
 
 
 
-	static m_elem kal_x_apriori[12 * 1] =
-		{  };
-
-
 	//---> initial states sind aposteriori!? ---> fehler
-	static m_elem kal_x_aposteriori[12 * 1] =
+	static const float kal_x_aposteriori[12 * 1] =
 	{ 0.0f, 0.0f, -1.0f, 0.6f, 0.0f, 0.8f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
 
-	kalman_init(&attitude_blackmagic_kal, 12, 9, kal_a, kal_c,
-		    kal_gain_start, kal_gain, kal_x_apriori, kal_x_aposteriori, 1000);
+	attitude_blackmagic_kal.init(kal_a, kal_c, kal_gain_start, kal_gain, kal_x_aposteriori, 1000);
 
 }
 
@@ -216,14 +201,15 @@ void attitude_blackmagic(const float_vect3 *accel, const float_vect3 *mag, const
 	//Calculate new linearized A matrix
 	attitude_blackmagic_update_a();
 
-	kalman_predict(&attitude_blackmagic_kal);
+	attitude_blackmagic_kal.predict();
 
 	//correction update
 
-	m_elem measurement[9] =
-		{ };
-	m_elem mask[9] =
-	{ 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f };
+	Kalman<12, 9>::MeasurementVector measurement;
+	Kalman<12, 9>::MeasurementVector mask;
+
+	for (unsigned i = 0; i < 9; i++)
+		mask(i) = 1.0f;
 
 	measurement[0] = accel->x;
 	measurement[1] = accel->y;
@@ -253,7 +239,7 @@ void attitude_blackmagic(const float_vect3 *accel, const float_vect3 *mag, const
 //	}else{
 //		j++;}
 
-	kalman_correct(&attitude_blackmagic_kal, measurement, mask);
+	attitude_blackmagic_kal.correct(measurement, mask);
 
 }
 void attitude_blackmagic_get_all(float_vect3 *euler, float_vect3 *rates, float_vect3 *x_n_b, float_vect3 *y_n_b, float_vect3 *z_n_b)
@@ -265,25 +251,25 @@ void attitude_blackmagic_get_all(float_vect3 *euler, float_vect3 *rates, float_v
 	float_vect3 kal_mag;
 //	float_vect3 kal_w0, kal_w;
 
-	kal_acc.x = kalman_get_state(&attitude_blackmagic_kal, 0);
-	kal_acc.y = kalman_get_state(&attitude_blackmagic_kal, 1);
-	kal_acc.z = kalman_get_state(&attitude_blackmagic_kal, 2);
+	kal_acc.x = attitude_blackmagic_kal.get_state(0);
+	kal_acc.y = attitude_blackmagic_kal.get_state(1);
+	kal_acc.z = attitude_blackmagic_kal.get_state(2);
 
-	kal_mag.x = kalman_get_state(&attitude_blackmagic_kal, 3);
-	kal_mag.y = kalman_get_state(&attitude_blackmagic_kal, 4);
-	kal_mag.z = kalman_get_state(&attitude_blackmagic_kal, 5);
+	kal_mag.x = attitude_blackmagic_kal.get_state(3);
+	kal_mag.y = attitude_blackmagic_kal.get_state(4);
+	kal_mag.z = attitude_blackmagic_kal.get_state(5);
 
-//	kal_w0.x = kalman_get_state(&attitude_blackmagic_kal, 6);
-//	kal_w0.y = kalman_get_state(&attitude_blackmagic_kal, 7);
-//	kal_w0.z = kalman_get_state(&attitude_blackmagic_kal, 8);
+//	kal_w0.x = attitude_blackmagic_kal.get_state(6);
+//	kal_w0.y = attitude_blackmagic_kal.get_state(7);
+//	kal_w0.z = attitude_blackmagic_kal.get_state(8);
 //
-//	kal_w.x = kalman_get_state(&attitude_blackmagic_kal, 9);
-//	kal_w.y = kalman_get_state(&attitude_blackmagic_kal, 10);
-//	kal_w.z = kalman_get_state(&attitude_blackmagic_kal, 11);
+//	kal_w.x = attitude_blackmagic_kal.get_state(9);
+//	kal_w.y = attitude_blackmagic_kal.get_state(10);
+//	kal_w.z = attitude_blackmagic_kal.get_state(11);
 
-	rates->x = kalman_get_state(&attitude_blackmagic_kal, 9);
-	rates->y = kalman_get_state(&attitude_blackmagic_kal, 10);
-	rates->z = kalman_get_state(&attitude_blackmagic_kal, 11);
+	rates->x = attitude_blackmagic_kal.get_state(9);
+	rates->y = attitude_blackmagic_kal.get_state(10);
+	rates->z = attitude_blackmagic_kal.get_state(11);
 
 
 
@@ -8,7 +8,10 @@
 #ifndef attitude_blackmagic_H_
 #define attitude_blackmagic_H_
 
-#include "matrix.h"
+#include <sys/cdefs.h>
+#include <systemlib/float_vect3.h>
+
+__BEGIN_DECLS
 
 void vect_norm(float_vect3 *vect);
 
@@ -21,4 +24,7 @@ void attitude_blackmagic_init(void);
 void attitude_blackmagic(const float_vect3 *accel, const float_vect3 *mag, const float_vect3 *gyro);
 
 void attitude_blackmagic_get_all(float_vect3 *euler, float_vect3 *rates, float_vect3 *x_n_b, float_vect3 *y_n_b, float_vect3 *z_n_b);
+
+__END_DECLS
+
 #endif /* attitude_blackmagic_H_ */
@@ -8,28 +8,93 @@
 #ifndef KALMAN_H_
 #define KALMAN_H_
 
-#include "matrix.h"
-
-#define KALMAN_MAX_STATES 12
-#define KALMAN_MAX_MEASUREMENTS 9
-typedef struct {
-	int states;
-	int measurements;
-	matrix_t a;
-	matrix_t c;
-	matrix_t gain_start;
-	matrix_t gain;
-	matrix_t x_apriori;
-	matrix_t x_aposteriori;
-	float gainfactor;
-	int gainfactorsteps;
-} kalman_t;
-
-void kalman_init(kalman_t *kalman, int states, int measurements, m_elem a[],
-		 m_elem c[], m_elem gain_start[], m_elem gain[], m_elem x_apriori[],
-		 m_elem x_aposteriori[], int gainfactorsteps);
-void kalman_predict(kalman_t *kalman);
-void kalman_correct(kalman_t *kalman, m_elem measurement_a[], m_elem mask_a[]);
-m_elem kalman_get_state(kalman_t *kalman, int state);
+#include <systemlib/matrix.h>
+
+/**
+ * Fixed-gain Kalman filter, blending from a start gain to the final gain
+ * over a number of steps.
+ *
+ * Has no constructor, so that it can be a static object in an app; call
+ * init() before use.
+ *
+ * @param STATES	Number of states.
+ * @param MEASUREMENTS	Number of measurements.
+ */
+template<unsigned STATES, unsigned MEASUREMENTS>
+class Kalman
+{
+public:
+	typedef math::Matrix<float, STATES, STATES>		StateMatrix;
+	typedef math::Matrix<float, MEASUREMENTS, STATES>	MeasurementMatrix;
+	typedef math::Matrix<float, STATES, MEASUREMENTS>	GainMatrix;
+	typedef math::Vector<float, STATES>			StateVector;
+	typedef math::Vector<float, MEASUREMENTS>		MeasurementVector;
+
+	/**
+	 * Set up the filter; all matrices are row-major.
+	 *
+	 * @param a		State transition, STATES x STATES.
+	 * @param c		Measurement matrix, MEASUREMENTS x STATES.
+	 * @param gain_start	Gain at the first step, STATES x MEASUREMENTS.
+	 * @param gain		Final gain, STATES x MEASUREMENTS.
+	 * @param x_aposteriori	Initial state.
+	 * @param gainfactorsteps Time constant, in steps, of the blend from
+	 *			the start gain to the final gain.
+	 */
+	void		init(const float a[], const float c[], const float gain_start[], const float gain[],
+			     const float x_aposteriori[], int gainfactorsteps) {
+		_a = StateMatrix(a);
+		_c = MeasurementMatrix(c);
+		_gain_start = GainMatrix(gain_start);
+		_gain = GainMatrix(gain);
+		_x_apriori.set_zero();
+		_x_aposteriori = StateVector(x_aposteriori);
+		_gainfactor = 0;
+		_gainfactorsteps = gainfactorsteps;
+	}
+
+	/**
+	 * x_apriori = A * x_aposteriori
+	 */
+	void		predict() {
+		_x_apriori = _a * _x_aposteriori;
+	}
+
+	/**
+	 * Correct the prediction with a measurement.
+	 *
+	 * @param measurement	The measurement.
+	 * @param mask		Per-measurement weight; 0 ignores a measurement.
+	 */
+	void		correct(const MeasurementVector &measurement, const MeasurementVector &mask) {
+		//x(:,i+1)=xapriori+(gainfactor*[M_50(:,1) M(:,2)]+(1-gainfactor)*M_start)*(z-C*xapriori);
+		MeasurementVector error = math::emult(measurement - _c * _x_apriori, mask);
+
+		_gainfactor = _gainfactor * (1.0f - 1.0f / _gainfactorsteps) + 1.0f * 1.0f / _gainfactorsteps;
+
+		/* blend the gains through the error rather than forming the blended gain */
+		_x_aposteriori = _x_apriori + _gain * (error * _gainfactor) + _gain_start * (error * (1.0f - _gainfactor));
+	}
+
+	/**
+	 * The state transition matrix, for updating the linearisation.
+	 */
+	StateMatrix	&a() { return _a; }
+
+	/**
+	 * One element of the corrected state.
+	 */
+	float		get_state(unsigned state) const { return _x_aposteriori(state); }
+
+private:
+	StateMatrix		_a;
+	MeasurementMatrix	_c;
+	GainMatrix		_gain_start;
+	GainMatrix		_gain;
+	StateVector		_x_apriori;
+	StateVector		_x_aposteriori;
+	float			_gainfactor;
+	int			_gainfactorsteps;
+};
 
 #endif /* KALMAN_H_ */
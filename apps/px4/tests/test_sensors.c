@@ -52,20 +52,20 @@
 
 #include <arch/board/board.h>
 
-#include <nuttx/spi.h>
+#include <drivers/drv_gyro.h>
+#include <drivers/drv_accel.h>
+#include <drivers/drv_mag.h>
+#include <drivers/drv_baro.h>
 
 #include "tests.h"
 
-#include <arch/board/drv_lis331.h>
-#include <arch/board/drv_bma180.h>
-#include <arch/board/drv_l3gd20.h>
-#include <arch/board/drv_hmc5883l.h>
-#include <arch/board/drv_mpu6000.h>
-
 /****************************************************************************
  * Pre-processor Definitions
  ****************************************************************************/
 
+#define MPU6000_ACCEL_DEVICE_PATH	"/dev/mpu6000_accel"
+#define MPU6000_GYRO_DEVICE_PATH	"/dev/mpu6000_gyro"
+
 /****************************************************************************
  * Private Types
  ****************************************************************************/
@@ -74,7 +74,6 @@
  * Private Function Prototypes
  ****************************************************************************/
 
-//static int	lis331(int argc, char *argv[]);
 static int l3gd20(int argc, char *argv[]);
 static int bma180(int argc, char *argv[]);
 static int hmc5883l(int argc, char *argv[]);
@@ -90,12 +89,11 @@ struct {
 	const char	*path;
 	int	(* test)(int argc, char *argv[]);
 } sensors[] = {
-	{"l3gd20",	"/dev/l3gd20",	l3gd20},
-	{"bma180",	"/dev/bma180",	bma180},
-	{"hmc5883l",	"/dev/hmc5883l",	hmc5883l},
-	{"ms5611",	"/dev/ms5611",	ms5611},
-	{"mpu6000",	"/dev/mpu6000",	mpu6000},
-//    {"lis331",	"/dev/lis331",	lis331},
+	{"l3gd20",	GYRO_DEVICE_PATH,	l3gd20},
+	{"bma180",	ACCEL_DEVICE_PATH,	bma180},
+	{"hmc5883l",	MAG_DEVICE_PATH,	hmc5883l},
+	{"ms5611",	BARO_DEVICE_PATH,	ms5611},
+	{"mpu6000",	MPU6000_ACCEL_DEVICE_PATH,	mpu6000},
 	{NULL, NULL, NULL}
 };
 
@@ -107,48 +105,6 @@ struct {
  * Private Functions
  ****************************************************************************/
 
-//static int
-//lis331(int argc, char *argv[])
-//{
-//	int		fd;
-//	int16_t	buf[3];
-//	int		ret;
-//
-//	fd = open("/dev/lis331", O_RDONLY);
-//	if (fd < 0) {
-//		printf("\tlis331: not present on PX4FMU v1.5 and later\n");
-//		return ERROR;
-//	}
-//
-//	if (ioctl(fd, LIS331_SETRATE, LIS331_RATE_50Hz) ||
-//	    ioctl(fd, LIS331_SETRANGE, LIS331_RANGE_4G)) {
-//
-//		printf("LIS331: ioctl fail\n");
-//		return ERROR;
-//	}
-//
-//	/* wait at least 100ms, sensor should have data after no more than 20ms */
-//	usleep(100000);
-//
-//	/* read data - expect samples */
-//	ret = read(fd, buf, sizeof(buf));
-//	if (ret != sizeof(buf)) {
-//		printf("LIS331: read1 fail (%d)\n", ret);
-//		return ERROR;
-//	}
-//
-//	/* read data - expect no samples (should not be ready again yet) */
-//	ret = read(fd, buf, sizeof(buf));
-//	if (ret != 0) {
-//		printf("LIS331: read2 fail (%d)\n", ret);
-//		return ERROR;
-//	}
-//
-//	/* XXX more tests here */
-//
-//	return 0;
-//}
-
 static int
 l3gd20(int argc, char *argv[])
 {
@@ -156,93 +112,54 @@ l3gd20(int argc, char *argv[])
 	fflush(stdout);
 
 	int		fd;
-	int16_t	buf[3] = {0, 0, 0};
+	struct gyro_report	buf[8];
 	int		ret;
 
-	fd = open("/dev/l3gd20", O_RDONLY | O_NONBLOCK);
+	fd = open(GYRO_DEVICE_PATH, O_RDONLY);
 
 	if (fd < 0) {
-		printf("L3GD20: open fail\n");
+		printf("\tL3GD20: open fail\n");
 		return ERROR;
 	}
 
-//	if (ioctl(fd, L3GD20_SETRATE, L3GD20_RATE_760HZ_LP_50HZ) ||
-//	    ioctl(fd, L3GD20_SETRANGE, L3GD20_RANGE_500DPS)) {
-//
-//		printf("L3GD20: ioctl fail\n");
-//		return ERROR;
-//	} else {
-//		printf("\tconfigured..\n");
-//	}
-//
-//	/* wait at least 100ms, sensor should have data after no more than 2ms */
-//	usleep(100000);
-
-
-
-	/* read data - expect samples */
-	ret = read(fd, buf, sizeof(buf));
-
-	if (ret != sizeof(buf)) {
-		printf("\tL3GD20: read1 fail (%d should have been %d)\n", ret, sizeof(buf));
-		//return ERROR;
-
-	} else {
-		printf("\tL3GD20 values #1: x:%d\ty:%d\tz:%d\n", buf[0], buf[1], buf[2]);
-	}
-
-	/* wait at least 2 ms, sensor should have data after no more than 1.5ms */
-	usleep(2000);
+	/* the driver starts out in manual-poll mode; a read measures */
+	ret = read(fd, &buf[0], sizeof(buf[0]));
 
-	/* read data - expect no samples (should not be ready again yet) */
-	ret = read(fd, buf, sizeof(buf));
-
-	if (ret != sizeof(buf)) {
-		printf("\tL3GD20: read2 fail (%d)\n", ret);
+	if (ret != sizeof(buf[0])) {
+		printf("\tL3GD20: read1 fail (%d)\n", ret);
 		close(fd);
 		return ERROR;
 
 	} else {
-		printf("\tL3GD20 values #2: x:%d\ty:%d\tz:%d\n", buf[0], buf[1], buf[2]);
-	}
-
-	/* empty sensor buffer */
-	ret = 0;
-
-	while (ret != sizeof(buf)) {
-		// Keep reading until successful
-		ret = read(fd, buf, sizeof(buf));
+		printf("\tL3GD20 values #1: x:%d\ty:%d\tz:%d\n", buf[0].x_raw, buf[0].y_raw, buf[0].z_raw);
 	}
 
-	/* test if FIFO is operational */
-	usleep(14800); // Expecting 10 measurements
+	/* measure automatically, unfiltered, so every sample drained from the FIFO is reported */
+	if (ioctl(fd, GYROIOCSLOWPASS, 0) ||
+	    ioctl(fd, GYROIOCSQUEUEDEPTH, 8) ||
+	    ioctl(fd, GYROIOCSPOLLRATE, 100)) {
 
-	ret = 0;
-	int count = 0;
-	bool dataready = true;
-
-	while (dataready) {
-		// Keep reading until successful
-		ret = read(fd, buf, sizeof(buf));
-
-		if (ret != sizeof(buf)) {
-			dataready = false;
-
-		} else {
-			count++;
-		}
+		printf("\tL3GD20: ioctl fail\n");
+		close(fd);
+		return ERROR;
 	}
 
-	printf("\tL3GD20: Drained FIFO with %d values (expected 8-12)\n", count);
+	/* at 760 Hz the first poll drains at least 7 samples, filling the queue */
+	usleep(15000);
 
-	/* read data - expect no samples (should not be ready again yet) */
 	ret = read(fd, buf, sizeof(buf));
 
-	if (ret != 0) {
-		printf("\tL3GD20: Note: read3 got data - there should not have been data ready\n", ret);
-//		return ERROR;
+	if (ret < (int)sizeof(buf[0])) {
+		printf("\tL3GD20: read2 fail (%d)\n", ret);
+		ioctl(fd, GYROIOCSPOLLRATE, GYRO_POLLRATE_MANUAL);
+		close(fd);
+		return ERROR;
 	}
 
+	printf("\tL3GD20: Drained FIFO with %d values (expected 8)\n", ret / (int)sizeof(buf[0]));
+	printf("\tL3GD20 values #2: x:%d\ty:%d\tz:%d\n", buf[0].x_raw, buf[0].y_raw, buf[0].z_raw);
+
+	ioctl(fd, GYROIOCSPOLLRATE, GYRO_POLLRATE_MANUAL);
 	close(fd);
 
 	/* Let user know everything is ok */
@@ -257,28 +174,18 @@ bma180(int argc, char *argv[])
 	fflush(stdout);
 
 	int		fd;
-	int16_t	buf[3] = {0, 0, 0};
+	struct accel_report	buf;
 	int		ret;
 
-	fd = open("/dev/bma180", O_RDONLY);
+	fd = open(ACCEL_DEVICE_PATH, O_RDONLY);
 
 	if (fd < 0) {
 		printf("\tBMA180: open fail\n");
 		return ERROR;
 	}
 
-//	if (ioctl(fd, LIS331_SETRATE, LIS331_RATE_50Hz) ||
-//	    ioctl(fd, LIS331_SETRANGE, LIS331_RANGE_4G)) {
-//
-//		printf("BMA180: ioctl fail\n");
-//		return ERROR;
-//	}
-//
-	/* wait at least 100ms, sensor should have data after no more than 20ms */
-	usleep(100000);
-
-	/* read data - expect samples */
-	ret = read(fd, buf, sizeof(buf));
+	/* the driver starts out in manual-poll mode; a read measures */
+	ret = read(fd, &buf, sizeof(buf));
 
 	if (ret != sizeof(buf)) {
 		printf("\tBMA180: read1 fail (%d)\n", ret);
@@ -286,13 +193,13 @@ bma180(int argc, char *argv[])
 		return ERROR;
 
 	} else {
-		printf("\tBMA180 values: x:%d\ty:%d\tz:%d\n", buf[0], buf[1], buf[2]);
+		printf("\tBMA180 values: x:%d\ty:%d\tz:%d\n", buf.x_raw, buf.y_raw, buf.z_raw);
 	}
 
-	/* wait at least 10ms, sensor should have data after no more than 2ms */
-	usleep(100000);
+	/* wait at least 10ms, sensor should have new data after no more than 2ms */
+	usleep(10000);
 
-	ret = read(fd, buf, sizeof(buf));
+	ret = read(fd, &buf, sizeof(buf));
 
 	if (ret != sizeof(buf)) {
 		printf("\tBMA180: read2 fail (%d)\n", ret);
@@ -300,21 +207,7 @@ bma180(int argc, char *argv[])
 		return ERROR;
 
 	} else {
-		printf("\tBMA180: x:%d\ty:%d\tz:%d\n", buf[0], buf[1], buf[2]);
-	}
-
-	/* empty sensor buffer */
-	ret = 0;
-
-	while (ret != sizeof(buf)) {
-		// Keep reading until successful
-		ret = read(fd, buf, sizeof(buf));
-	}
-
-	ret = read(fd, buf, sizeof(buf));
-
-	if (ret != 0) {
-		printf("\tBMA180: Note: read3 got data - there should not have been data ready\n", ret);
+		printf("\tBMA180: x:%d\ty:%d\tz:%d\n", buf.x_raw, buf.y_raw, buf.z_raw);
 	}
 
 	/* Let user know everything is ok */
@@ -331,44 +224,50 @@ mpu6000(int argc, char *argv[])
 	fflush(stdout);
 
 	int		fd;
-	int16_t	buf[5] = { -1, 0, -1, 0, -1, 0};
+	int		fd_gyro;
+	struct accel_report	a_buf;
+	struct gyro_report	g_buf;
 	int		ret;
 
-	fd = open("/dev/mpu6000", O_RDONLY);
+	fd = open(MPU6000_ACCEL_DEVICE_PATH, O_RDONLY);
 
 	if (fd < 0) {
 		printf("\tMPU-6000: open fail\n");
 		return ERROR;
 	}
 
-	// /* wait at least 100ms, sensor should have data after no more than 20ms */
-	// usleep(100000);
+	fd_gyro = open(MPU6000_GYRO_DEVICE_PATH, O_RDONLY);
 
-	// /* read data - expect samples */
-	// ret = read(fd, buf, sizeof(buf));
-
-	// if (ret != sizeof(buf)) {
-	// 	printf("\tMPU-6000: read1 fail (%d)\n", ret);
-	// 	return ERROR;
+	if (fd_gyro < 0) {
+		printf("\tMPU-6000: gyro open fail\n");
+		close(fd);
+		return ERROR;
+	}
 
-	// } else {
-	// 	printf("\tMPU-6000 values: acc: x:%d\ty:%d\tz:%d\tgyro: r:%d\tp:%d\ty:%d\n", buf[0], buf[1], buf[2], buf[3], buf[4], buf[5]);
-	// }
+	/* both nodes start out in manual-poll mode; each read measures */
+	ret = read(fd, &a_buf, sizeof(a_buf));
 
-	// /* wait at least 10ms, sensor should have data after no more than 2ms */
-	// usleep(100000);
+	if (ret != sizeof(a_buf)) {
+		printf("\tMPU-6000: accel read fail (%d)\n", ret);
+		close(fd_gyro);
+		close(fd);
+		return ERROR;
+	}
 
-	// ret = read(fd, buf, sizeof(buf));
+	ret = read(fd_gyro, &g_buf, sizeof(g_buf));
 
-	// if (ret != sizeof(buf)) {
-	// 	printf("\tMPU-6000: read2 fail (%d)\n", ret);
-	// 	return ERROR;
+	if (ret != sizeof(g_buf)) {
+		printf("\tMPU-6000: gyro read fail (%d)\n", ret);
+		close(fd_gyro);
+		close(fd);
+		return ERROR;
+	}
 
-	// } else {
-	// 	printf("\tMPU-6000 values: acc: x:%d\ty:%d\tz:%d\tgyro: r:%d\tp:%d\ty:%d\n", buf[0], buf[1], buf[2], buf[3], buf[4], buf[5]);
-	// }
+	printf("\tMPU-6000 values: acc: x:%d\ty:%d\tz:%d\tgyro: r:%d\tp:%d\ty:%d\n",
+	       a_buf.x_raw, a_buf.y_raw, a_buf.z_raw, g_buf.x_raw, g_buf.y_raw, g_buf.z_raw);
 
-	/* XXX more tests here */
+	close(fd_gyro);
+	close(fd);
 
 	/* Let user know everything is ok */
 	printf("\tOK: MPU-6000 passed all tests successfully\n");
@@ -383,10 +282,10 @@ ms5611(int argc, char *argv[])
 	fflush(stdout);
 
 	int		fd;
-	float	buf[3] = {0.0f, 0.0f, 0.0f};
+	struct baro_report	buf;
 	int		ret;
 
-	fd = open("/dev/ms5611", O_RDONLY);
+	fd = open(BARO_DEVICE_PATH, O_RDONLY);
 
 	if (fd < 0) {
 		printf("\tMS5611: open fail\n");
@@ -395,10 +294,10 @@ ms5611(int argc, char *argv[])
 
 	for (int i = 0; i < 5; i++) {
 		/* read data - expect samples */
-		ret = read(fd, buf, sizeof(buf));
+		ret = read(fd, &buf, sizeof(buf));
 
 		if (ret != sizeof(buf)) {
-			if ((uint8_t)ret == -EAGAIN || (uint8_t)ret == -EINPROGRESS || i < 3) {
+			if (errno == EAGAIN || errno == EINPROGRESS || i < 3) {
 				/* waiting for device to become ready, this is not an error */
 			} else {
 				printf("\tMS5611: read fail (%d)\n", ret);
@@ -409,11 +308,11 @@ ms5611(int argc, char *argv[])
 		} else {
 
 			/* hack for float printing */
-			int32_t pressure_int = buf[0];
-			int32_t altitude_int = buf[1];
-			int32_t temperature_int = buf[2];
+			int32_t pressure_int = buf.pressure;
+			int32_t altitude_int = buf.altitude;
+			int32_t temperature_int = buf.temperature;
 
-			printf("\tMS5611: pressure:%d.%03d mbar - altitude: %d.%02d meters - temp:%d.%02d deg celcius\n", pressure_int, (int)(buf[0] * 1000 - pressure_int * 1000), altitude_int, (int)(buf[1] * 100 - altitude_int * 100), temperature_int, (int)(buf[2] * 100 - temperature_int * 100));
+			printf("\tMS5611: pressure:%d.%03d mbar - altitude: %d.%02d meters - temp:%d.%02d deg celcius\n", pressure_int, (int)(buf.pressure * 1000 - pressure_int * 1000), altitude_int, (int)(buf.altitude * 100 - altitude_int * 100), temperature_int, (int)(buf.temperature * 100 - temperature_int * 100));
 		}
 
 		/* wait at least 10ms, sensor should have data after no more than 6.5ms */
@@ -435,10 +334,10 @@ hmc5883l(int argc, char *argv[])
 	fflush(stdout);
 
 	int		fd;
-	int16_t	buf[3] = {0, 0, 0};
+	struct mag_report	buf;
 	int		ret;
 
-	fd = open("/dev/hmc5883l", O_RDONLY);
+	fd = open(MAG_DEVICE_PATH, O_RDONLY);
 
 	if (fd < 0) {
 		printf("\tHMC5883L: open fail\n");
@@ -452,15 +351,15 @@ hmc5883l(int argc, char *argv[])
 		usleep(7000);
 
 		/* read data - expect samples */
-		ret = read(fd, buf, sizeof(buf));
+		ret = read(fd, &buf, sizeof(buf));
 
 		if (ret != sizeof(buf)) {
-			printf("\tHMC5883L: read1 fail (%d) values: x:%d\ty:%d\tz:%d\n", ret, buf[0], buf[1], buf[2]);
+			printf("\tHMC5883L: read1 fail (%d)\n", ret);
 			close(fd);
 			return ERROR;
 
 		} else {
-			printf("\tHMC5883L: x:%d\ty:%d\tz:%d\n", buf[0], buf[1], buf[2]);
+			printf("\tHMC5883L: x:%d\ty:%d\tz:%d\n", buf.x_raw, buf.y_raw, buf.z_raw);
 		}
 	}
 
@@ -0,0 +1,201 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2012 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file sensor_integrator.c
+ * Coning- and sculling-corrected integration of gyro and accelerometer
+ * samples.
+ */
+
+#include <string.h>
+
+#include "sensor_integrator.h"
+
+static inline void
+cross_acc(float r[3], float k, const float a[3], const float b[3])
+{
+	r[0] += k * (a[1] * b[2] - a[2] * b[1]);
+	r[1] += k * (a[2] * b[0] - a[0] * b[2]);
+	r[2] += k * (a[0] * b[1] - a[1] * b[0]);
+}
+
+static void
+restart_interval(struct sensor_integrator *integ)
+{
+	integ->start = integ->gyro_time;
+	integ->gyro_samples = 0;
+	integ->accel_samples = 0;
+
+	/*
+	 * The last accelerometer sample may predate the new interval; keep its
+	 * angle relative to the new start so that the rotation up to the next
+	 * one is not lost.
+	 */
+	for (unsigned i = 0; i < 3; i++)
+		integ->alpha_accel[i] -= integ->alpha[i];
+
+	memset(integ->alpha, 0, sizeof(integ->alpha));
+	memset(integ->beta, 0, sizeof(integ->beta));
+	memset(integ->vel, 0, sizeof(integ->vel));
+	memset(integ->scul, 0, sizeof(integ->scul));
+}
+
+void
+sensor_integrator_init(struct sensor_integrator *integ, uint32_t max_gap_us)
+{
+	memset(integ, 0, sizeof(*integ));
+	integ->max_gap_us = max_gap_us;
+}
+
+void
+sensor_integrator_gyro(struct sensor_integrator *integ, uint64_t timestamp, const float rate[3])
+{
+	uint64_t gap = timestamp - integ->gyro_time;
+
+	/* first sample, out of order or after an outage; restart the history */
+	if ((integ->gyro_time == 0) || (timestamp <= integ->gyro_time) || (gap > integ->max_gap_us)) {
+		integ->gyro_time = timestamp;
+		memcpy(integ->last_rate, rate, sizeof(integ->last_rate));
+		memset(integ->last_dalpha, 0, sizeof(integ->last_dalpha));
+
+		/* an empty interval just moves its start along */
+		if (integ->gyro_samples == 0)
+			integ->start = timestamp;
+
+		return;
+	}
+
+	float dt = gap * 1e-6f;
+	float dalpha[3];
+
+	for (unsigned i = 0; i < 3; i++)
+		dalpha[i] = 0.5f * (integ->last_rate[i] + rate[i]) * dt;
+
+	/* beta += 1/2 (alpha + 1/6 last_dalpha) x dalpha */
+	float a[3];
+
+	for (unsigned i = 0; i < 3; i++)
+		a[i] = integ->alpha[i] + integ->last_dalpha[i] * (1.0f / 6.0f);
+
+	cross_acc(integ->beta, 0.5f, a, dalpha);
+
+	for (unsigned i = 0; i < 3; i++) {
+		integ->alpha[i] += dalpha[i];
+		integ->last_dalpha[i] = dalpha[i];
+		integ->last_rate[i] = rate[i];
+	}
+
+	integ->gyro_time = timestamp;
+	integ->gyro_samples++;
+}
+
+void
+sensor_integrator_accel(struct sensor_integrator *integ, uint64_t timestamp, const float accel[3])
+{
+	uint64_t gap = timestamp - integ->accel_time;
+
+	if ((integ->accel_time == 0) || (timestamp <= integ->accel_time) || (gap > integ->max_gap_us)) {
+		integ->accel_time = timestamp;
+		memcpy(integ->last_accel, accel, sizeof(integ->last_accel));
+		memset(integ->last_dv, 0, sizeof(integ->last_dv));
+		memset(integ->last_dalpha_accel, 0, sizeof(integ->last_dalpha_accel));
+		memcpy(integ->alpha_accel, integ->alpha, sizeof(integ->alpha_accel));
+		return;
+	}
+
+	float dt = gap * 1e-6f;
+	float dv[3];
+	float dalpha[3];
+
+	/* velocity increment, and the rotation over the same step */
+	for (unsigned i = 0; i < 3; i++) {
+		dv[i] = 0.5f * (integ->last_accel[i] + accel[i]) * dt;
+		dalpha[i] = integ->alpha[i] - integ->alpha_accel[i];
+	}
+
+	/*
+	 * scul += 1/2 ((alpha + 1/6 last_dalpha) x dv + (vel + 1/6 last_dv) x dalpha)
+	 *
+	 * with alpha and last_dalpha taken at the accelerometer sample times.
+	 */
+	float a[3];
+	float v[3];
+
+	for (unsigned i = 0; i < 3; i++) {
+		a[i] = integ->alpha_accel[i] + integ->last_dalpha_accel[i] * (1.0f / 6.0f);
+		v[i] = integ->vel[i] + integ->last_dv[i] * (1.0f / 6.0f);
+	}
+
+	cross_acc(integ->scul, 0.5f, a, dv);
+	cross_acc(integ->scul, 0.5f, v, dalpha);
+
+	for (unsigned i = 0; i < 3; i++) {
+		integ->vel[i] += dv[i];
+		integ->last_dv[i] = dv[i];
+		integ->alpha_accel[i] = integ->alpha[i];
+		integ->last_dalpha_accel[i] = dalpha[i];
+		integ->last_accel[i] = accel[i];
+	}
+
+	integ->accel_time = timestamp;
+	integ->accel_samples++;
+}
+
+uint32_t
+sensor_integrator_elapsed(const struct sensor_integrator *integ)
+{
+	return integ->gyro_time - integ->start;
+}
+
+bool
+sensor_integrator_get(struct sensor_integrator *integ, struct sensor_delta_s *delta)
+{
+	if (integ->gyro_samples == 0)
+		return false;
+
+	delta->timestamp = integ->gyro_time;
+	delta->dt_us = integ->gyro_time - integ->start;
+	delta->gyro_samples = integ->gyro_samples;
+	delta->accel_samples = integ->accel_samples;
+
+	for (unsigned i = 0; i < 3; i++) {
+		delta->delta_angle_rad[i] = integ->alpha[i] + integ->beta[i];
+		delta->delta_velocity_m_s[i] = integ->vel[i] + integ->scul[i];
+	}
+
+	/* rotation correction, 1/2 alpha x vel */
+	cross_acc(delta->delta_velocity_m_s, 0.5f, integ->alpha_accel, integ->vel);
+
+	restart_interval(integ);
+	return true;
+}
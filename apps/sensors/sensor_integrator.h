@@ -0,0 +1,136 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2012 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file sensor_integrator.h
+ * Coning- and sculling-corrected integration of gyro and accelerometer
+ * samples into angle and velocity increments.
+ *
+ * Uses the recursive two-sample algorithms from Savage, "Strapdown
+ * Analytics", section 7. Every sample contributes a trapezoidal increment;
+ * the coning term accounts for the non-commutativity of the rotations
+ * within the interval, and the rotation and sculling terms for the body
+ * turning while it accelerates.
+ *
+ * Gyro and accelerometer samples need not be synchronous, but each must be
+ * fed in timestamp order, and should be interleaved in timestamp order.
+ */
+
+#ifndef _SENSORS_SENSOR_INTEGRATOR_H
+#define _SENSORS_SENSOR_INTEGRATOR_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <uORB/topics/sensor_delta.h>
+
+/**
+ * Integrator state; treat as opaque.
+ */
+struct sensor_integrator {
+	uint64_t	start;			/**< start of the current interval */
+	uint64_t	gyro_time;		/**< timestamp of the last gyro sample */
+	uint64_t	accel_time;		/**< timestamp of the last accelerometer sample */
+	uint32_t	max_gap_us;		/**< longest sample gap that is integrated across */
+
+	unsigned	gyro_samples;
+	unsigned	accel_samples;
+
+	float		last_rate[3];		/**< last gyro sample, rad/s */
+	float		last_accel[3];		/**< last accelerometer sample, m/s^2 */
+
+	float		alpha[3];		/**< sum of the angle increments */
+	float		beta[3];		/**< coning correction */
+	float		last_dalpha[3];		/**< previous gyro angle increment */
+
+	float		alpha_accel[3];		/**< alpha at the last accelerometer sample */
+	float		last_dalpha_accel[3];	/**< angle increment over the previous accelerometer step */
+	float		vel[3];			/**< sum of the velocity increments */
+	float		scul[3];		/**< sculling correction */
+	float		last_dv[3];		/**< previous velocity increment */
+};
+
+__BEGIN_DECLS
+
+/**
+ * Initialise an integrator.
+ *
+ * @param integ		The integrator.
+ * @param max_gap_us	Samples further apart than this are not integrated
+ *			across; the next sample restarts the sensor's history
+ *			instead. Covers dropped reports and driver restarts.
+ */
+__EXPORT extern void	sensor_integrator_init(struct sensor_integrator *integ, uint32_t max_gap_us);
+
+/**
+ * Add a gyro sample.
+ *
+ * @param integ		The integrator.
+ * @param timestamp	Time the sample was taken.
+ * @param rate		Angular rate in rad/s.
+ */
+__EXPORT extern void	sensor_integrator_gyro(struct sensor_integrator *integ, uint64_t timestamp, const float rate[3]);
+
+/**
+ * Add an accelerometer sample.
+ *
+ * @param integ		The integrator.
+ * @param timestamp	Time the sample was taken.
+ * @param accel		Specific force in m/s^2.
+ */
+__EXPORT extern void	sensor_integrator_accel(struct sensor_integrator *integ, uint64_t timestamp, const float accel[3]);
+
+/**
+ * Return the length of the interval integrated so far.
+ *
+ * @param integ		The integrator.
+ * @return		Microseconds from the start of the interval to the
+ *			last gyro sample.
+ */
+__EXPORT extern uint32_t sensor_integrator_elapsed(const struct sensor_integrator *integ);
+
+/**
+ * Fetch the increments for the current interval and start a new one.
+ *
+ * The new interval starts at the last gyro sample.
+ *
+ * @param integ		The integrator.
+ * @param delta		Returns the increments.
+ * @return		true if any gyro samples were integrated, false
+ *			(leaving delta untouched) otherwise.
+ */
+__EXPORT extern bool	sensor_integrator_get(struct sensor_integrator *integ, struct sensor_delta_s *delta);
+
+__END_DECLS
+
+#endif /* _SENSORS_SENSOR_INTEGRATOR_H */
@@ -41,8 +41,8 @@
 
 #include <nuttx/config.h>
 
-#include <pthread.h>
 #include <fcntl.h>
+#include <poll.h>
 #include <sys/prctl.h>
 #include <nuttx/analog/adc.h>
 #include <unistd.h>
@@ -53,34 +53,67 @@
 #include <float.h>
 
 #include <arch/board/up_hrt.h>
-#include <arch/board/drv_lis331.h>
-#include <arch/board/drv_bma180.h>
-#include <arch/board/drv_l3gd20.h>
-#include <arch/board/drv_hmc5883l.h>
 #include <arch/board/up_adc.h>
 
+#include <drivers/drv_gyro.h>
+#include <drivers/drv_accel.h>
+#include <drivers/drv_mag.h>
+#include <drivers/drv_baro.h>
+
 #include <systemlib/systemlib.h>
+#include <systemlib/perf_counter.h>
 #include <uORB/uORB.h>
 #include <uORB/topics/sensor_combined.h>
 #include <uORB/topics/rc_channels.h>
 #include <uORB/topics/vehicle_status.h>
+#include <uORB/topics/parameter_update.h>
+#include <uORB/topics/sensor_delta.h>
 
 #include "sensors.h"
+#include "sensor_integrator.h"
 
 #define errno *get_errno_ptr()
 
-#define SENSOR_INTERVAL_MICROSEC 2000
+/*
+ * Driver polling rates. The loop runs on each gyro report; the other
+ * sensors are merged in at whatever rate their drivers publish.
+ *
+ * The L3GD20 drains its FIFO at each poll, so its report rate follows
+ * from its sample rate and filter rather than from GYRO_RATE_HZ; the
+ * loop asks the driver for it with GYROIOCGETRATE.
+ */
+#define GYRO_RATE_HZ		500
+#define GYRO_SAMPLERATE_HZ	760
+#define ACC_RATE_HZ		500
+#define MAGN_RATE_HZ		75
+#define BARO_RATE_HZ		100
+
+/*
+ * Cutoff of the drivers' anti-aliasing and decimation filters. The BMA180
+ * filters at its 500 Hz poll rate and reports every sample; the L3GD20
+ * filters at 760 Hz and reports every second sample, at 380 Hz.
+ */
+#define GYRO_LOWPASS_HZ		100
+#define ACC_LOWPASS_HZ		100
+
+#define GYRO_TIMEOUT_SAMPLES	10	/* missed gyro reports before the gyro is unhealthy */
 
-#define GYRO_HEALTH_COUNTER_LIMIT_ERROR 20   /* 40 ms downtime at 500 Hz update rate   */
-#define ACC_HEALTH_COUNTER_LIMIT_ERROR  20   /* 40 ms downtime at 500 Hz update rate   */
-#define MAGN_HEALTH_COUNTER_LIMIT_ERROR 100  /* 1000 ms downtime at 100 Hz update rate  */
-#define BARO_HEALTH_COUNTER_LIMIT_ERROR 50   /* 500 ms downtime at 100 Hz update rate  */
+/*
+ * Every queued gyro and accel report is integrated into sensor_delta,
+ * published at this interval. Up to REPORT_BATCH reports are read from
+ * each driver at each gyro wakeup; the driver rings are deeper, and
+ * anything left over is read at the next wakeup.
+ */
+#define DELTA_INTERVAL_US	10000	/* 100 Hz */
+#define DELTA_MAX_GAP_US	20000	/* don't integrate across a sensor outage */
+#define REPORT_BATCH		8
+
+#define ACC_HEALTH_TIMEOUT_US	40000	/* 40 ms downtime at 500 Hz update rate   */
+#define MAGN_HEALTH_TIMEOUT_US	1000000	/* 1000 ms downtime at 75 Hz update rate  */
+#define BARO_HEALTH_TIMEOUT_US	500000	/* 500 ms downtime at 100 Hz update rate  */
 #define ADC_HEALTH_COUNTER_LIMIT_ERROR  10   /* 100 ms downtime at 100 Hz update rate  */
 
 #define GYRO_HEALTH_COUNTER_LIMIT_OK 5
-#define ACC_HEALTH_COUNTER_LIMIT_OK  5
-#define MAGN_HEALTH_COUNTER_LIMIT_OK 5
-#define BARO_HEALTH_COUNTER_LIMIT_OK 5
 #define ADC_HEALTH_COUNTER_LIMIT_OK  5
 
 #define ADC_BATTERY_VOLATGE_CHANNEL  10
@@ -98,20 +131,22 @@
 
 #define PPM_MID (PPM_MIN+PPM_MAX)/2
 
-static pthread_cond_t sensors_read_ready;
-static pthread_mutex_t sensors_read_ready_mutex;
-
-static int sensors_timer_loop_counter = 0;
-
-/* File descriptors for all sensors */
+/*
+ * Driver file descriptors; held open so that the drivers keep measuring
+ * and publishing.
+ */
 static int	fd_gyro = -1;
+static unsigned	gyro_rate_hz;		/**< gyro report rate, as reported by the driver */
 static int	fd_accelerometer = -1;
 static int	fd_magnetometer = -1;
-static int  fd_barometer = -1;
-static int  fd_adc = -1;
+static int	fd_barometer = -1;
+static int	fd_adc = -1;
 
-/* Private functions declared static */
-static void sensors_timer_loop(void *arg);
+/* Subscriptions to the driver report topics */
+static int	gyro_sub = -1;
+static int	accel_sub = -1;
+static int	mag_sub = -1;
+static int	baro_sub = -1;
 
 #ifdef CONFIG_HRT_PPM
 extern uint16_t ppm_buffer[];
@@ -123,14 +158,46 @@ static int sensor_pub;
 
 /**
  * Sensor readout and publishing.
- * 
- * This function reads all onboard sensors and publishes the sensor_combined topic.
+ *
+ * This function collects the reports published by the sensor drivers and
+ * publishes the sensor_combined topic, once for each gyro report.
  *
  * @see sensor_combined_s
  * @ingroup apps
  */
 __EXPORT int sensors_main(int argc, char *argv[]);
 
+/**
+ * Open a sensor driver and set its polling rate.
+ *
+ * @param path		The device to open.
+ * @param pollrate_ioctl The driver's *IOCSPOLLRATE ioctl.
+ * @param rate_hz	The polling rate, or zero to leave the driver
+ *			polling at its own rate.
+ * @return		The file descriptor, or -1 with errno set.
+ */
+static int sensors_open(const char *path, int pollrate_ioctl, unsigned rate_hz)
+{
+	int fd = open(path, O_RDONLY);
+
+	if (fd < 0) {
+		fprintf(stderr, "[sensors]   %s open fail (err #%d): %s\n", path, (int)*get_errno_ptr(), strerror((int)*get_errno_ptr()));
+		fflush(stderr);
+		return -1;
+	}
+
+	if ((rate_hz > 0) &&
+	    (ioctl(fd, pollrate_ioctl, rate_hz) != OK)) {
+		fprintf(stderr, "[sensors]   %s poll rate fail (err #%d): %s\n", path, (int)*get_errno_ptr(), strerror((int)*get_errno_ptr()));
+		fflush(stderr);
+		close(fd);
+		return -1;
+	}
+
+	printf("[sensors]   %s open ok\n", path);
+	return fd;
+}
+
 /**
  * Initialize all sensor drivers.
  *
@@ -140,24 +207,23 @@ static int sensors_init(void)
 {
 	printf("[sensors] Sensor configuration..\n");
 
-	/* open magnetometer */
-	fd_magnetometer = open("/dev/hmc5883l", O_RDONLY);
+	/* open magnetometer, 0.88 Ga range as the calibration expects */
+	fd_magnetometer = sensors_open(MAG_DEVICE_PATH, MAGIOCSPOLLRATE, 0);
 
-	if (fd_magnetometer < 0) {
-		fprintf(stderr, "[sensors]   HMC5883L open fail (err #%d): %s\n", (int)*get_errno_ptr(), strerror((int)*get_errno_ptr()));
+	if ((fd_magnetometer < 0) ||
+	    (ioctl(fd_magnetometer, MAGIOCSRANGE, 0) != OK) ||
+	    (ioctl(fd_magnetometer, MAGIOCSPOLLRATE, MAGN_RATE_HZ) != OK)) {
+		fprintf(stderr, "[sensors]   HMC5883L configuration fail\n");
 		fflush(stderr);
 		/* this sensor is critical, exit on failed init */
 		errno = ENOSYS;
 		return ERROR;
-
-	} else {
-		printf("[sensors]   HMC5883L open ok\n");
 	}
 
-	/* open barometer */
-	fd_barometer = open("/dev/ms5611", O_RDONLY);
+	/* open barometer; its I2C driver only ever polls */
+	fd_barometer = open(BARO_DEVICE_PATH, O_RDONLY);
 
-	if (fd_barometer < 0) {
+	if ((fd_barometer < 0) || (ioctl(fd_barometer, BAROIOCSPOLLRATE, BARO_RATE_HZ) != OK)) {
 		fprintf(stderr, "[sensors]   MS5611 open fail (err #%d): %s\n", (int)*get_errno_ptr(), strerror((int)*get_errno_ptr()));
 		fflush(stderr);
 
@@ -166,31 +232,32 @@ static int sensors_init(void)
 	}
 
 	/* open gyro */
-	fd_gyro = open("/dev/l3gd20", O_RDONLY);
-
-	if (fd_gyro < 0) {
-		fprintf(stderr, "[sensors]   L3GD20 open fail (err #%d): %s\n", (int)*get_errno_ptr(), strerror((int)*get_errno_ptr()));
+	fd_gyro = sensors_open(GYRO_DEVICE_PATH, GYROIOCSPOLLRATE, GYRO_RATE_HZ);
+
+	if ((fd_gyro < 0) ||
+	    (ioctl(fd_gyro, GYROIOCSSAMPLERATE, GYRO_SAMPLERATE_HZ) != OK) ||
+	    (ioctl(fd_gyro, GYROIOCSRANGE, 500) != OK) ||
+	    (ioctl(fd_gyro, GYROIOCSLOWPASS, GYRO_LOWPASS_HZ) != OK) ||
+	    (ioctl(fd_gyro, GYROIOCGETRATE, (unsigned long)&gyro_rate_hz) != OK) ||
+	    (gyro_rate_hz == 0)) {
+		fprintf(stderr, "[sensors]   L3GD20 configuration fail\n");
 		fflush(stderr);
 		/* this sensor is critical, exit on failed init */
 		errno = ENOSYS;
 		return ERROR;
-
-	} else {
-		printf("[sensors]   L3GD20 open ok\n");
 	}
 
 	/* open accelerometer */
-	fd_accelerometer = open("/dev/bma180", O_RDONLY);
+	fd_accelerometer = sensors_open(ACCEL_DEVICE_PATH, ACCELIOCSPOLLRATE, ACC_RATE_HZ);
 
-	if (fd_accelerometer < 0) {
-		fprintf(stderr, "[sensors]   BMA180: open fail (err #%d): %s\n", (int)*get_errno_ptr(), strerror((int)*get_errno_ptr()));
+	if ((fd_accelerometer < 0) ||
+	    (ioctl(fd_accelerometer, ACCELIORANGE, 4) != OK) ||
+	    (ioctl(fd_accelerometer, ACCELIOCSLOWPASS, ACC_LOWPASS_HZ) != OK)) {
+		fprintf(stderr, "[sensors]   BMA180 configuration fail\n");
 		fflush(stderr);
 		/* this sensor is critical, exit on failed init */
 		errno = ENOSYS;
 		return ERROR;
-
-	} else {
-		printf("[sensors]   BMA180 open ok\n");
 	}
 
 	/* open adc */
@@ -207,38 +274,160 @@ static int sensors_init(void)
 		printf("[sensors]   ADC open ok\n");
 	}
 
-	/* configure gyro */
-	if (ioctl(fd_gyro, L3GD20_SETRATE, L3GD20_RATE_760HZ_LP_30HZ) || ioctl(fd_gyro, L3GD20_SETRANGE, L3GD20_RANGE_500DPS)) {
-		fprintf(stderr, "[sensors]   L3GD20 configuration (ioctl) fail (err #%d): %s\n", (int)*get_errno_ptr(), strerror((int)*get_errno_ptr()));
+	/* subscribe to the driver reports */
+	gyro_sub = orb_subscribe(ORB_ID(sensor_gyro));
+	accel_sub = orb_subscribe(ORB_ID(sensor_accel));
+	mag_sub = orb_subscribe(ORB_ID(sensor_mag));
+	baro_sub = orb_subscribe(ORB_ID(sensor_baro));
+
+	if ((gyro_sub < 0) || (accel_sub < 0) || (mag_sub < 0) || (baro_sub < 0)) {
+		fprintf(stderr, "[sensors]   sensor topic subscription fail\n");
 		fflush(stderr);
-		/* this sensor is critical, exit on failed init */
 		errno = ENOSYS;
 		return ERROR;
-
-	} else {
-		printf("[sensors]   L3GD20 configuration ok\n");
 	}
 
-	/* XXX Add IOCTL configuration of remaining sensors */
-
 	printf("[sensors] All sensors configured\n");
 	return OK;
 }
 
 /**
- * Callback function called by high resolution timer.
+ * Rotate a gyro report into the board frame and scale it.
+ *
+ * @param report	The driver report.
+ * @param offset	Calibrated offsets, in board frame raw units.
+ * @param raw		Returns the board frame raw values.
+ * @param rad_s		Returns the board frame rates in rad/s.
+ */
+static void sensors_gyro_board(const struct gyro_report *report, const int16_t offset[3], int16_t raw[3], float rad_s[3])
+{
+	raw[0] = ((report->y_raw == -32768) ? -32767 : report->y_raw); // x of the board is y of the sensor
+	/* assign negated value, except for -SHORT_MAX, as it would wrap there */
+	raw[1] = ((report->x_raw == -32768) ? 32767 : -report->x_raw); // y on the board is -x of the sensor
+	raw[2] = ((report->z_raw == -32768) ? -32767 : report->z_raw); // z of the board is -z of the sensor
+
+	/* scale measurements */
+	// XXX request scaling from driver instead of hardcoding it
+	/* scaling calculated as: raw * (1/(32768*(500/180*PI))) */
+	rad_s[0] = (raw[0] - offset[0]) * 0.000266316109f;
+	rad_s[1] = (raw[1] - offset[1]) * 0.000266316109f;
+	rad_s[2] = (raw[2] - offset[2]) * 0.000266316109f;
+}
+
+/**
+ * Rotate the accelerometer driver's SI values into the board frame.
  *
- * This function signals a pthread condition and wakes up the
- * sensor main loop.
+ * @param report	The driver report.
+ * @param m_s2		Returns the board frame specific force in m/s^2.
  */
-static void sensors_timer_loop(void *arg)
+static void sensors_accel_board(const struct accel_report *report, float m_s2[3])
 {
-	/* Inform the read thread that it is now time to read */
-	sensors_timer_loop_counter++;
-	/* Do not use global data broadcast because of
-	 * use of printf() in call - would be fatal here
-	 */
-	pthread_cond_broadcast(&sensors_read_ready);
+	m_s2[0] = -report->y;	// x of the board is -y of the sensor
+	m_s2[1] = report->x;	// y on the board is x of the sensor
+	m_s2[2] = report->z;	// z of the board is z of the sensor
+}
+
+/**
+ * Integrate every gyro and accel report the drivers have queued.
+ *
+ * The reports are fed to the integrator in timestamp order.
+ *
+ * @param integ		The integrator.
+ * @param gyro_offset	Calibrated gyro offsets.
+ * @param gyro_report	Returns the newest gyro report, if there was one.
+ */
+static void sensors_integrate(struct sensor_integrator *integ, const int16_t gyro_offset[3], struct gyro_report *gyro_report)
+{
+	struct gyro_report	gyro[REPORT_BATCH];
+	struct accel_report	accel[REPORT_BATCH];
+	ssize_t			ret;
+	unsigned		ngyro = 0;
+	unsigned		naccel = 0;
+
+	ret = read(fd_gyro, gyro, sizeof(gyro));
+
+	if (ret > 0)
+		ngyro = ret / sizeof(gyro[0]);
+
+	ret = read(fd_accelerometer, accel, sizeof(accel));
+
+	if (ret > 0)
+		naccel = ret / sizeof(accel[0]);
+
+	for (unsigned g = 0, a = 0; (g < ngyro) || (a < naccel);) {
+		int16_t raw[3];
+		float value[3];
+
+		if ((a >= naccel) || ((g < ngyro) && (gyro[g].timestamp <= accel[a].timestamp))) {
+			sensors_gyro_board(&gyro[g], gyro_offset, raw, value);
+			sensor_integrator_gyro(integ, gyro[g].timestamp, value);
+			g++;
+
+		} else {
+			sensors_accel_board(&accel[a], value);
+			sensor_integrator_accel(integ, accel[a].timestamp, value);
+			a++;
+		}
+	}
+
+	if (ngyro > 0)
+		*gyro_report = gyro[ngyro - 1];
+}
+
+/**
+ * Recompute the values derived from the parameters.
+ *
+ * Called at startup and then only when parameter_update is published.
+ */
+static void sensors_parameters_update(struct rc_channels_s *rc, int16_t gyro_offset[3], int16_t mag_offset[3])
+{
+	/* Update RC scalings and function mappings */
+	rc->chan[0].scaling_factor = (10000 / ((global_data_parameter_storage->pm.param_values[PARAM_RC1_MAX] - global_data_parameter_storage->pm.param_values[PARAM_RC1_MIN]) / 2)
+				     * global_data_parameter_storage->pm.param_values[PARAM_RC1_REV]);
+	rc->chan[0].mid = (uint16_t)global_data_parameter_storage->pm.param_values[PARAM_RC1_TRIM];
+
+	rc->chan[1].scaling_factor = (10000 / ((global_data_parameter_storage->pm.param_values[PARAM_RC2_MAX] - global_data_parameter_storage->pm.param_values[PARAM_RC2_MIN]) / 2)
+				     * global_data_parameter_storage->pm.param_values[PARAM_RC2_REV]);
+	rc->chan[1].mid = (uint16_t)global_data_parameter_storage->pm.param_values[PARAM_RC2_TRIM];
+
+	rc->chan[2].scaling_factor = (10000 / ((global_data_parameter_storage->pm.param_values[PARAM_RC3_MAX] - global_data_parameter_storage->pm.param_values[PARAM_RC3_MIN]) / 2)
+				     * global_data_parameter_storage->pm.param_values[PARAM_RC3_REV]);
+	rc->chan[2].mid = (uint16_t)global_data_parameter_storage->pm.param_values[PARAM_RC3_TRIM];
+
+	rc->chan[3].scaling_factor = (10000 / ((global_data_parameter_storage->pm.param_values[PARAM_RC4_MAX] - global_data_parameter_storage->pm.param_values[PARAM_RC4_MIN]) / 2)
+				     * global_data_parameter_storage->pm.param_values[PARAM_RC4_REV]);
+	rc->chan[3].mid = (uint16_t)global_data_parameter_storage->pm.param_values[PARAM_RC4_TRIM];
+
+	rc->chan[4].scaling_factor = (10000 / ((global_data_parameter_storage->pm.param_values[PARAM_RC5_MAX] - global_data_parameter_storage->pm.param_values[PARAM_RC5_MIN]) / 2)
+				     * global_data_parameter_storage->pm.param_values[PARAM_RC5_REV]);
+	rc->chan[4].mid = (uint16_t)global_data_parameter_storage->pm.param_values[PARAM_RC5_TRIM];
+
+	rc->function[0] = global_data_parameter_storage->pm.param_values[PARAM_THROTTLE_CHAN] - 1;
+	rc->function[1] = global_data_parameter_storage->pm.param_values[PARAM_ROLL_CHAN] - 1;
+	rc->function[2] = global_data_parameter_storage->pm.param_values[PARAM_PITCH_CHAN] - 1;
+	rc->function[3] = global_data_parameter_storage->pm.param_values[PARAM_YAW_CHAN] - 1;
+	rc->function[4] = global_data_parameter_storage->pm.param_values[PARAM_OVERRIDE_CHAN] - 1;
+
+	gyro_offset[0] = global_data_parameter_storage->pm.param_values[PARAM_SENSOR_GYRO_XOFFSET];
+	gyro_offset[1] = global_data_parameter_storage->pm.param_values[PARAM_SENSOR_GYRO_YOFFSET];
+	gyro_offset[2] = global_data_parameter_storage->pm.param_values[PARAM_SENSOR_GYRO_ZOFFSET];
+
+	mag_offset[0] = global_data_parameter_storage->pm.param_values[PARAM_SENSOR_MAG_XOFFSET];
+	mag_offset[1] = global_data_parameter_storage->pm.param_values[PARAM_SENSOR_MAG_YOFFSET];
+	mag_offset[2] = global_data_parameter_storage->pm.param_values[PARAM_SENSOR_MAG_ZOFFSET];
+}
+
+static void sensors_close(void)
+{
+	close(gyro_sub);
+	close(accel_sub);
+	close(mag_sub);
+	close(baro_sub);
+	close(fd_gyro);
+	close(fd_accelerometer);
+	close(fd_magnetometer);
+	close(fd_barometer);
+	close(fd_adc);
 }
 
 int sensors_main(int argc, char *argv[])
@@ -252,11 +441,7 @@ int sensors_main(int argc, char *argv[])
 	if (sensors_init() != OK) {
 		fprintf(stderr, "[sensors] ERROR: Failed to initialize all sensors\n");
 		/* Clean up */
-		close(fd_gyro);
-		close(fd_accelerometer);
-		close(fd_magnetometer);
-		close(fd_barometer);
-		close(fd_adc);
+		sensors_close();
 
 		fprintf(stderr, "[sensors] rebooting system.\n");
 		fflush(stderr);
@@ -281,43 +466,31 @@ int sensors_main(int argc, char *argv[])
 	bool hil_enabled = false;		/**< HIL is disabled by default	*/
 	bool publishing = false;		/**< the app is not publishing by default, only if HIL is disabled on first run */
 
-	int magcounter = 0;
-	int barocounter = 0;
 	int adccounter = 0;
 
-	unsigned int mag_fail_count = 0;
-	unsigned int mag_success_count = 0;
-
-	unsigned int baro_fail_count = 0;
-	unsigned int baro_success_count = 0;
-
 	unsigned int gyro_fail_count = 0;
 	unsigned int gyro_success_count = 0;
 
-	unsigned int acc_fail_count = 0;
-	unsigned int acc_success_count = 0;
-
 	unsigned int adc_fail_count = 0;
 	unsigned int adc_success_count = 0;
 
-	ssize_t	ret_gyro;
-	ssize_t	ret_accelerometer;
-	ssize_t	ret_magnetometer;
-	ssize_t	ret_barometer;
 	ssize_t	ret_adc;
 	int 	nsamples_adc;
 
-	int16_t buf_gyro[3];
-	int16_t buf_accelerometer[3];
-	int16_t buf_magnetometer[7];
-	float	buf_barometer[3];
+	struct gyro_report	gyro_report;
+	struct accel_report	accel_report;
+	struct mag_report	mag_report;
+	struct baro_report	baro_report;
+
+	memset(&gyro_report, 0, sizeof(gyro_report));
+	memset(&accel_report, 0, sizeof(accel_report));
+	memset(&mag_report, 0, sizeof(mag_report));
+	memset(&baro_report, 0, sizeof(baro_report));
 
 	int16_t	mag_offset[3] = {0, 0, 0};
 	int16_t acc_offset[3] = {0, 0, 0};
 	int16_t	gyro_offset[3] = {0, 0, 0};
 
-	bool mag_calibration_enabled = false;
-
 	#pragma pack(push,1)
 	struct adc_msg4_s {
 		uint8_t      am_channel1;	/**< The 8-bit ADC Channel 1 */
@@ -345,28 +518,17 @@ int sensors_main(int argc, char *argv[])
 #ifdef CONFIG_HRT_PPM
 	int ppmcounter = 0;
 #endif
-	/* initialize to 100 to execute immediately */
-	int paramcounter = 100;
 	int excessive_readout_time_counter = 0;
-	int read_loop_counter = 0;
-
-	/* Empty sensor buffers, avoid junk values */
-	/* Read first two values of each sensor into void */
-	(void)read(fd_gyro, buf_gyro, sizeof(buf_gyro));
-	(void)read(fd_accelerometer, buf_accelerometer, sizeof(buf_accelerometer));
-	(void)read(fd_magnetometer, buf_magnetometer, sizeof(buf_magnetometer));
-
-	if (fd_barometer > 0)(void)read(fd_barometer, buf_barometer, sizeof(buf_barometer));
 
 	struct sensor_combined_s raw = {
 		.timestamp = hrt_absolute_time(),
-		.gyro_raw = {buf_gyro[0], buf_gyro[1], buf_gyro[2]},
+		.gyro_raw = {0, 0, 0},
 		.gyro_raw_counter = 0,
 		.gyro_rad_s = {0, 0, 0},
-		.accelerometer_raw = {buf_accelerometer[0], buf_accelerometer[1], buf_accelerometer[2]},
+		.accelerometer_raw = {0, 0, 0},
 		.accelerometer_raw_counter = 0,
 		.accelerometer_m_s2 = {0, 0, 0},
-		.magnetometer_raw = {buf_magnetometer[0], buf_magnetometer[1], buf_magnetometer[2]},
+		.magnetometer_raw = {0, 0, 0},
 		.magnetometer_raw_counter = 0,
 		.baro_pres_mbar = 0,
 		.baro_alt_meter = 0,
@@ -378,10 +540,6 @@ int sensors_main(int argc, char *argv[])
 		.battery_voltage_valid = false,
 	};
 
-	/* condition to wait for */
-	pthread_mutex_init(&sensors_read_ready_mutex, NULL);
-	pthread_cond_init(&sensors_read_ready, NULL);
-
 	/* advertise the topic and make the initial publication */
 	sensor_pub = orb_advertise(ORB_ID(sensor_combined), &raw);
 	publishing = true;
@@ -396,479 +554,346 @@ int sensors_main(int argc, char *argv[])
 	memset(&vstatus, 0, sizeof(vstatus));
 	int vstatus_sub = orb_subscribe(ORB_ID(vehicle_status));
 
+	/* subscribe to parameter changes and pick up the current values */
+	int param_sub = orb_subscribe(ORB_ID(parameter_update));
+	sensors_parameters_update(&rc, gyro_offset, mag_offset);
 
-	printf("[sensors] rate: %u Hz\n", (unsigned int)(1000000 / SENSOR_INTERVAL_MICROSEC));
-
-	struct hrt_call sensors_hrt_call;
-	/* Enable high resolution timer callback to unblock main thread, run after 2 ms */
-	hrt_call_every(&sensors_hrt_call, 2000, SENSOR_INTERVAL_MICROSEC, &sensors_timer_loop, NULL);
-
-	while (1) {
-		pthread_mutex_lock(&sensors_read_ready_mutex);
-
-		struct timespec time_to_wait = {0, 0};
-		/* Wait 2 seconds until timeout */
-		time_to_wait.tv_nsec = 0;
-		time_to_wait.tv_sec = time(NULL) + 2;
-
-		if (pthread_cond_timedwait(&sensors_read_ready, &sensors_read_ready_mutex, &time_to_wait) == OK) {
-			pthread_mutex_unlock(&sensors_read_ready_mutex);
-
-			bool gyro_updated = false;
-			bool acc_updated = false;
-			bool magn_updated = false;
-			bool baro_updated = false;
-			bool adc_updated = false;
-
-			/* store the time closest to all measurements */
-			uint64_t current_time = hrt_absolute_time();
-			raw.timestamp = current_time;
-
-			if (paramcounter == 100) {
-				// XXX paramcounter is not a good name, rename / restructure
-				// XXX make counter ticks dependent on update rate of sensor main loop
-
-				/* Check HIL state */
-				orb_copy(ORB_ID(vehicle_status), vstatus_sub, &vstatus);
-
-				/* switching from non-HIL to HIL mode */
-				//printf("[sensors] Vehicle mode: %i \t AND: %i, HIL: %i\n", vstatus.mode, vstatus.mode & VEHICLE_MODE_FLAG_HIL_ENABLED, hil_enabled);
-				if ((vstatus.mode & VEHICLE_MODE_FLAG_HIL_ENABLED) && !hil_enabled) {
-					hil_enabled = true;
-					publishing = false;
-					int ret = close(sensor_pub);
-					printf("[sensors] Closing sensor pub: %i \n", ret);
-
-					/* switching from HIL to non-HIL mode */
-
-				} else if (!publishing && !hil_enabled) {
-					/* advertise the topic and make the initial publication */
-					sensor_pub = orb_advertise(ORB_ID(sensor_combined), &raw);
-					hil_enabled = false;
-					publishing = true;
-				}
-
+	/* integrated increments, advertised with the first interval */
+	struct sensor_integrator integ;
+	struct sensor_delta_s delta;
+	int delta_pub = -1;
+	sensor_integrator_init(&integ, DELTA_MAX_GAP_US);
 
-				/* Update RC scalings and function mappings */
-				rc.chan[0].scaling_factor = (10000 / ((global_data_parameter_storage->pm.param_values[PARAM_RC1_MAX] - global_data_parameter_storage->pm.param_values[PARAM_RC1_MIN]) / 2)
-							     * global_data_parameter_storage->pm.param_values[PARAM_RC1_REV]);
-				rc.chan[0].mid = (uint16_t)global_data_parameter_storage->pm.param_values[PARAM_RC1_TRIM];
+	/* time from the gyro sample to sensor_combined being published */
+	perf_counter_t latency_perf = perf_alloc(PC_LEVEL, "sensors latency (us)");
 
-				rc.chan[1].scaling_factor = (10000 / ((global_data_parameter_storage->pm.param_values[PARAM_RC2_MAX] - global_data_parameter_storage->pm.param_values[PARAM_RC2_MIN]) / 2)
-							     * global_data_parameter_storage->pm.param_values[PARAM_RC2_REV]);
-				rc.chan[1].mid = (uint16_t)global_data_parameter_storage->pm.param_values[PARAM_RC2_TRIM];
+	/* wake on each gyro report */
+	struct pollfd fds = { .fd = gyro_sub, .events = POLLIN };
 
-				rc.chan[2].scaling_factor = (10000 / ((global_data_parameter_storage->pm.param_values[PARAM_RC3_MAX] - global_data_parameter_storage->pm.param_values[PARAM_RC3_MIN]) / 2)
-							     * global_data_parameter_storage->pm.param_values[PARAM_RC3_REV]);
-				rc.chan[2].mid = (uint16_t)global_data_parameter_storage->pm.param_values[PARAM_RC3_TRIM];
+	/* give up on the gyro after this many report intervals, rounded up */
+	int gyro_timeout_ms = (GYRO_TIMEOUT_SAMPLES * 1000 + gyro_rate_hz - 1) / gyro_rate_hz;
 
-				rc.chan[3].scaling_factor = (10000 / ((global_data_parameter_storage->pm.param_values[PARAM_RC4_MAX] - global_data_parameter_storage->pm.param_values[PARAM_RC4_MIN]) / 2)
-							     * global_data_parameter_storage->pm.param_values[PARAM_RC4_REV]);
-				rc.chan[3].mid = (uint16_t)global_data_parameter_storage->pm.param_values[PARAM_RC4_TRIM];
+	printf("[sensors] rate: %u Hz\n", gyro_rate_hz);
 
-				rc.chan[4].scaling_factor = (10000 / ((global_data_parameter_storage->pm.param_values[PARAM_RC5_MAX] - global_data_parameter_storage->pm.param_values[PARAM_RC5_MIN]) / 2)
-							     * global_data_parameter_storage->pm.param_values[PARAM_RC5_REV]);
-				rc.chan[4].mid = (uint16_t)global_data_parameter_storage->pm.param_values[PARAM_RC5_TRIM];
+	while (1) {
 
-				rc.function[0] = global_data_parameter_storage->pm.param_values[PARAM_THROTTLE_CHAN] - 1;
-				rc.function[1] = global_data_parameter_storage->pm.param_values[PARAM_ROLL_CHAN] - 1;
-				rc.function[2] = global_data_parameter_storage->pm.param_values[PARAM_PITCH_CHAN] - 1;
-				rc.function[3] = global_data_parameter_storage->pm.param_values[PARAM_YAW_CHAN] - 1;
-				rc.function[4] = global_data_parameter_storage->pm.param_values[PARAM_OVERRIDE_CHAN] - 1;
+		int pret = poll(&fds, 1, gyro_timeout_ms);
 
-				gyro_offset[0] = global_data_parameter_storage->pm.param_values[PARAM_SENSOR_GYRO_XOFFSET];
-				gyro_offset[1] = global_data_parameter_storage->pm.param_values[PARAM_SENSOR_GYRO_YOFFSET];
-				gyro_offset[2] = global_data_parameter_storage->pm.param_values[PARAM_SENSOR_GYRO_ZOFFSET];
+		/* GYROSCOPE */
+		if (pret <= 0) {
+			gyro_fail_count++;
 
-				mag_offset[0] = global_data_parameter_storage->pm.param_values[PARAM_SENSOR_MAG_XOFFSET];
-				mag_offset[1] = global_data_parameter_storage->pm.param_values[PARAM_SENSOR_MAG_YOFFSET];
-				mag_offset[2] = global_data_parameter_storage->pm.param_values[PARAM_SENSOR_MAG_ZOFFSET];
+			if ((((gyro_fail_count % 20) == 0) || (gyro_fail_count > 20 && gyro_fail_count < 100))) {
+				fprintf(stderr, "[sensors] L3GD20 ERROR: %s\n", (pret < 0) ? strerror((int)*get_errno_ptr()) : "no data");
+			}
 
-				paramcounter = 0;
+			if (gyro_healthy) {
+				/* the timeout is already several missed samples */
+				gyro_healthy = false;
+				gyro_success_count = 0;
 			}
 
-			paramcounter++;
+			continue;
+		}
 
-			/* try reading gyro */
-			uint64_t start_gyro = hrt_absolute_time();
-			ret_gyro = read(fd_gyro, buf_gyro, sizeof(buf_gyro));
-			int gyrotime = hrt_absolute_time() - start_gyro;
+		orb_copy(ORB_ID(sensor_gyro), gyro_sub, &gyro_report);
 
-			if (gyrotime > 500) printf("GYRO (pure read): %d us\n", gyrotime);
+		/* integrate everything queued since the last wakeup */
+		sensors_integrate(&integ, gyro_offset, &gyro_report);
 
-			/* GYROSCOPE */
-			if (ret_gyro != sizeof(buf_gyro)) {
-				gyro_fail_count++;
+		gyro_success_count++;
 
-				if ((((gyro_fail_count % 20) == 0) || (gyro_fail_count > 20 && gyro_fail_count < 100)) && (int)*get_errno_ptr() != EAGAIN) {
-					fprintf(stderr, "[sensors] L3GD20 ERROR #%d: %s\n", (int)*get_errno_ptr(), strerror((int)*get_errno_ptr()));
-				}
+		if (!gyro_healthy && gyro_success_count >= GYRO_HEALTH_COUNTER_LIMIT_OK) {
+			gyro_healthy = true;
+			gyro_fail_count = 0;
+		}
 
-				if (gyro_healthy && gyro_fail_count >= GYRO_HEALTH_COUNTER_LIMIT_ERROR) {
-					// global_data_send_subsystem_info(&gyro_present_enabled);
-					gyro_healthy = false;
-					gyro_success_count = 0;
-				}
+		/* store the time of the sample that triggered this update */
+		raw.timestamp = gyro_report.timestamp;
 
-			} else {
-				gyro_success_count++;
+		bool acc_updated = false;
+		bool magn_updated = false;
+		bool baro_updated = false;
+		bool adc_updated = false;
 
-				if (!gyro_healthy && gyro_success_count >= GYRO_HEALTH_COUNTER_LIMIT_OK) {
-					// global_data_send_subsystem_info(&gyro_present_enabled_healthy);
-					gyro_healthy = true;
-					gyro_fail_count = 0;
+		/* Check HIL state */
+		bool vstatus_updated;
+		orb_check(vstatus_sub, &vstatus_updated);
 
-				}
+		if (vstatus_updated) {
+			orb_copy(ORB_ID(vehicle_status), vstatus_sub, &vstatus);
 
-				gyro_updated = true;
-			}
+			/* switching from non-HIL to HIL mode */
+			//printf("[sensors] Vehicle mode: %i \t AND: %i, HIL: %i\n", vstatus.mode, vstatus.mode & VEHICLE_MODE_FLAG_HIL_ENABLED, hil_enabled);
+			if ((vstatus.mode & VEHICLE_MODE_FLAG_HIL_ENABLED) && !hil_enabled) {
+				hil_enabled = true;
+				publishing = false;
+				int ret = close(sensor_pub);
+				printf("[sensors] Closing sensor pub: %i \n", ret);
 
-			gyrotime = hrt_absolute_time() - start_gyro;
+				/* switching from HIL to non-HIL mode */
 
-			if (gyrotime > 500) printf("GYRO (complete): %d us\n", gyrotime);
+			} else if (!publishing && !hil_enabled) {
+				/* advertise the topic and make the initial publication */
+				sensor_pub = orb_advertise(ORB_ID(sensor_combined), &raw);
+				hil_enabled = false;
+				publishing = true;
+			}
+		}
 
-			/* try reading acc */
-			uint64_t start_acc = hrt_absolute_time();
-			ret_accelerometer = read(fd_accelerometer, buf_accelerometer, sizeof(buf_accelerometer));
+		/* recompute derived values only when a parameter has changed */
+		bool param_updated;
+		orb_check(param_sub, &param_updated);
 
-			/* ACCELEROMETER */
-			if (ret_accelerometer != sizeof(buf_accelerometer)) {
-				acc_fail_count++;
+		if (param_updated) {
+			struct parameter_update_s update;
+			orb_copy(ORB_ID(parameter_update), param_sub, &update);
+			sensors_parameters_update(&rc, gyro_offset, mag_offset);
+		}
 
-				if (acc_fail_count & 0b1000 || (acc_fail_count > 20 && acc_fail_count < 100)) {
-					fprintf(stderr, "[sensors] BMA180 ERROR #%d: %s\n", (int)*get_errno_ptr(), strerror((int)*get_errno_ptr()));
-				}
+		/*
+		 * Merge the latest of the other sensors; none of this waits on a
+		 * bus, so the slower sensors cannot delay the gyro.
+		 */
+		uint64_t now = hrt_absolute_time();
 
-				if (acc_healthy && acc_fail_count >= ACC_HEALTH_COUNTER_LIMIT_ERROR) {
-					// global_data_send_subsystem_info(&acc_present_enabled);
-					gyro_healthy = false;
-					acc_success_count = 0;
-				}
+		/* ACCELEROMETER */
+		orb_check(accel_sub, &acc_updated);
 
-			} else {
-				acc_success_count++;
+		if (acc_updated)
+			orb_copy(ORB_ID(sensor_accel), accel_sub, &accel_report);
 
-				if (!acc_healthy && acc_success_count >= ACC_HEALTH_COUNTER_LIMIT_OK) {
+		if (acc_healthy != ((now - accel_report.timestamp) < ACC_HEALTH_TIMEOUT_US)) {
+			acc_healthy = !acc_healthy;
 
-					// global_data_send_subsystem_info(&acc_present_enabled_healthy);
-					acc_healthy = true;
-					acc_fail_count = 0;
+			if (!acc_healthy)
+				fprintf(stderr, "[sensors] BMA180 ERROR: no data\n");
+		}
 
-				}
+		/* MAGNETOMETER */
+		orb_check(mag_sub, &magn_updated);
 
-				acc_updated = true;
-			}
+		if (magn_updated)
+			orb_copy(ORB_ID(sensor_mag), mag_sub, &mag_report);
 
-			int acctime = hrt_absolute_time() - start_acc;
-
-			if (acctime > 500) printf("ACC: %d us\n", acctime);
-
-			/* MAGNETOMETER */
-			if (magcounter == 4) { /* 120 Hz */
-				uint64_t start_mag = hrt_absolute_time();
-				/* start calibration mode if requested */
-				if (!mag_calibration_enabled && vstatus.preflight_mag_calibration) {
-					ioctl(fd_magnetometer, HMC5883L_CALIBRATION_ON, 0);
-					printf("[sensors] enabling mag calibration mode\n");
-					mag_calibration_enabled = true;
-				} else if (mag_calibration_enabled && !vstatus.preflight_mag_calibration) {
-					ioctl(fd_magnetometer, HMC5883L_CALIBRATION_OFF, 0);
-					printf("[sensors] disabling mag calibration mode\n");
-					mag_calibration_enabled = false;
-				}
+		if (magn_healthy != ((now - mag_report.timestamp) < MAGN_HEALTH_TIMEOUT_US)) {
+			magn_healthy = !magn_healthy;
 
-				ret_magnetometer = read(fd_magnetometer, buf_magnetometer, sizeof(buf_magnetometer));
-				int errcode_mag = (int) * get_errno_ptr();
-				int magtime = hrt_absolute_time() - start_mag;
+			if (!magn_healthy)
+				fprintf(stderr, "[sensors] HMC5883L ERROR: no data\n");
+		}
 
-				if (magtime > 2000) {
-					printf("MAG (pure read): %d us\n", magtime);
-				}
+		/* BAROMETER */
+		orb_check(baro_sub, &baro_updated);
 
-				if (ret_magnetometer != sizeof(buf_magnetometer)) {
-					mag_fail_count++;
+		if (baro_updated)
+			orb_copy(ORB_ID(sensor_baro), baro_sub, &baro_report);
 
-					if (mag_fail_count & 0b1000 || (mag_fail_count > 20 && mag_fail_count < 100)) {
-						fprintf(stderr, "[sensors] HMC5883L ERROR #%d: %s\n", (int)*get_errno_ptr(), strerror((int)*get_errno_ptr()));
-					}
+		if ((fd_barometer >= 0) && (baro_healthy != ((now - baro_report.timestamp) < BARO_HEALTH_TIMEOUT_US))) {
+			baro_healthy = !baro_healthy;
 
-					if (magn_healthy && mag_fail_count >= MAGN_HEALTH_COUNTER_LIMIT_ERROR) {
-						// global_data_send_subsystem_info(&magn_present_enabled);
-						magn_healthy = false;
-						mag_success_count = 0;
-					}
+			if (!baro_healthy)
+				fprintf(stderr, "[sensors] MS5611 ERROR: no data\n");
+		}
 
-				} else {
-					mag_success_count++;
+		/* ADC */
+		if (adccounter == 5) {
+			ret_adc = read(fd_adc, &buf_adc, adc_readsize);
+			nsamples_adc = ret_adc / sizeof(struct adc_msg_s);
 
-					if (!magn_healthy && mag_success_count >= MAGN_HEALTH_COUNTER_LIMIT_OK) {
-						// global_data_send_subsystem_info(&magn_present_enabled_healthy);
-						magn_healthy = true;
-						mag_fail_count = 0;
-					}
+			if (ret_adc  < 0 || nsamples_adc * sizeof(struct adc_msg_s) != ret_adc) {
+				adc_fail_count++;
 
-					magn_updated = true;
+				if ((adc_fail_count & 0b1000 || adc_fail_count < 10) && (int)*get_errno_ptr() != EAGAIN) {
+					fprintf(stderr, "[sensors] ADC ERROR #%d: %s\n", (int)*get_errno_ptr(), strerror((int)*get_errno_ptr()));
 				}
 
-				magtime = hrt_absolute_time() - start_mag;
-
-				if (magtime > 2000) {
-					printf("MAG (overall time): %d us\n", magtime);
-					fprintf(stderr, "[sensors] TIMEOUT HMC5883L ERROR #%d: %s\n", errcode_mag, strerror(errcode_mag));
+				if (adc_healthy && adc_fail_count >= ADC_HEALTH_COUNTER_LIMIT_ERROR) {
+					adc_healthy = false;
+					adc_success_count = 0;
 				}
 
-				magcounter = 0;
-			}
-
-			magcounter++;
-
-			/* BAROMETER */
-			if (barocounter == 5 && (fd_barometer > 0)) { /* 100 Hz */
-				uint64_t start_baro = hrt_absolute_time();
-				*get_errno_ptr() = 0;
-				ret_barometer = read(fd_barometer, buf_barometer, sizeof(buf_barometer));
-
-				if (ret_barometer != sizeof(buf_barometer)) {
-					baro_fail_count++;
-
-					if ((baro_fail_count & 0b1000 || (baro_fail_count > 20 && baro_fail_count < 100)) && (int)*get_errno_ptr() != EAGAIN) {
-						fprintf(stderr, "[sensors] MS5611 ERROR #%d: %s\n", (int)*get_errno_ptr(), strerror((int)*get_errno_ptr()));
-					}
-
-					if (baro_healthy && baro_fail_count >= BARO_HEALTH_COUNTER_LIMIT_ERROR) {
-						/* switched from healthy to unhealthy */
-						baro_healthy = false;
-						baro_success_count = 0;
-						// global_data_send_subsystem_info(&baro_present_enabled);
-					}
-
-				} else {
-					baro_success_count++;
-
-					if (!baro_healthy && baro_success_count >= MAGN_HEALTH_COUNTER_LIMIT_OK) {
-						/* switched from unhealthy to healthy */
-						baro_healthy = true;
-						baro_fail_count = 0;
-						// global_data_send_subsystem_info(&baro_present_enabled_healthy);
-					}
+			} else {
+				adc_success_count++;
 
-					baro_updated = true;
+				if (!adc_healthy && adc_success_count >= ADC_HEALTH_COUNTER_LIMIT_OK) {
+					adc_healthy = true;
+					adc_fail_count = 0;
 				}
 
-				barocounter = 0;
-				int barotime = hrt_absolute_time() - start_baro;
-
-				if (barotime > 2000) printf("BARO: %d us\n", barotime);
+				adc_updated = true;
 			}
 
-			barocounter++;
-
-			/* ADC */
-			if (adccounter == 5) {
-				ret_adc = read(fd_adc, &buf_adc, adc_readsize);
-				nsamples_adc = ret_adc / sizeof(struct adc_msg_s);
-
-				if (ret_adc  < 0 || nsamples_adc * sizeof(struct adc_msg_s) != ret_adc) {
-					adc_fail_count++;
+			adccounter = 0;
 
-					if ((adc_fail_count & 0b1000 || adc_fail_count < 10) && (int)*get_errno_ptr() != EAGAIN) {
-						fprintf(stderr, "[sensors] ADC ERROR #%d: %s\n", (int)*get_errno_ptr(), strerror((int)*get_errno_ptr()));
-					}
+		}
 
-					if (adc_healthy && adc_fail_count >= ADC_HEALTH_COUNTER_LIMIT_ERROR) {
-						adc_healthy = false;
-						adc_success_count = 0;
-					}
+		adccounter++;
 
-				} else {
-					adc_success_count++;
 
-					if (!adc_healthy && adc_success_count >= ADC_HEALTH_COUNTER_LIMIT_OK) {
-						adc_healthy = true;
-						adc_fail_count = 0;
-					}
 
-					adc_updated = true;
-				}
+#ifdef CONFIG_HRT_PPM
+		bool ppm_updated = false;
 
-				adccounter = 0;
+		/* PPM */
+		if (ppmcounter == 5) {
 
+			/* Read out values from HRT */
+			for (int i = 0; i < ppm_decoded_channels; i++) {
+				rc.chan[i].raw = ppm_buffer[i];
+				/* Set the range to +-, then scale up */
+				rc.chan[i].scale = (ppm_buffer[i] - rc.chan[i].mid) * rc.chan[i].scaling_factor;
 			}
 
-			adccounter++;
+			rc.chan_count = ppm_decoded_channels;
 
+			rc.timestamp = hrt_absolute_time();
+			/* publish a few lines of code later if set to true */
+			ppm_updated = true;
 
 
-#ifdef CONFIG_HRT_PPM
-			bool ppm_updated = false;
-
-			/* PPM */
-			if (ppmcounter == 5) {
-
-				/* Read out values from HRT */
-				for (int i = 0; i < ppm_decoded_channels; i++) {
-					rc.chan[i].raw = ppm_buffer[i];
-					/* Set the range to +-, then scale up */
-					rc.chan[i].scale = (ppm_buffer[i] - rc.chan[i].mid) * rc.chan[i].scaling_factor;
-				}
+			//TODO: XXX check the mode switch channel and eventually send a request to the commander (see implementation in commander and mavlink)
+			ppmcounter = 0;
+		}
 
-				rc.chan_count = ppm_decoded_channels;
+		ppmcounter++;
+#endif
 
-				rc.timestamp = hrt_absolute_time();
-				/* publish a few lines of code later if set to true */
-				ppm_updated = true;
+		/* Copy values of gyro, acc, magnetometer & barometer */
 
+		/* GYROSCOPE */
+		{
+			/* copy sensor readings to global data and transform coordinates into px4fmu board frame */
+			sensors_gyro_board(&gyro_report, gyro_offset, raw.gyro_raw, raw.gyro_rad_s);
 
-				//TODO: XXX check the mode switch channel and eventually send a request to the commander (see implementation in commander and mavlink)
-				ppmcounter = 0;
-			}
-
-			ppmcounter++;
-#endif
+			raw.gyro_raw_counter++;
+		}
 
-			/* Copy values of gyro, acc, magnetometer & barometer */
+		/* ACCELEROMETER */
+		if (acc_updated) {
+			/* copy sensor readings to global data and transform coordinates into px4fmu board frame */
 
-			/* GYROSCOPE */
-			if (gyro_updated) {
-				/* copy sensor readings to global data and transform coordinates into px4fmu board frame */
+			/* assign negated value, except for -SHORT_MAX, as it would wrap there */
+			raw.accelerometer_raw[0] = (accel_report.y_raw == -32768) ? 32767 : -accel_report.y_raw; // x of the board is -y of the sensor
+			raw.accelerometer_raw[1] = (accel_report.x_raw == -32768) ? -32767 : accel_report.x_raw;  // y on the board is x of the sensor
+			raw.accelerometer_raw[2] = (accel_report.z_raw == -32768) ? -32767 : accel_report.z_raw; // z of the board is z of the sensor
 
-				raw.gyro_raw[0] = ((buf_gyro[1] == -32768) ? -32767 : buf_gyro[1]); // x of the board is y of the sensor
-				/* assign negated value, except for -SHORT_MAX, as it would wrap there */
-				raw.gyro_raw[1] = ((buf_gyro[0] == -32768) ? 32767 : -buf_gyro[0]); // y on the board is -x of the sensor
-				raw.gyro_raw[2] = ((buf_gyro[2] == -32768) ? -32767 : buf_gyro[2]); // z of the board is -z of the sensor
+			// XXX read range from sensor
+			float range_g = 4.0f;
+			/* scale from 14 bit to m/s2 */
+			raw.accelerometer_m_s2[0] = (((raw.accelerometer_raw[0] - acc_offset[0]) * range_g) / 8192.0f) / 9.81f;
+			raw.accelerometer_m_s2[1] = (((raw.accelerometer_raw[1] - acc_offset[1]) * range_g) / 8192.0f) / 9.81f;
+			raw.accelerometer_m_s2[2] = (((raw.accelerometer_raw[2] - acc_offset[2]) * range_g) / 8192.0f) / 9.81f;
 
-				/* scale measurements */
-				// XXX request scaling from driver instead of hardcoding it
-				/* scaling calculated as: raw * (1/(32768*(500/180*PI))) */
-				raw.gyro_rad_s[0] = (raw.gyro_raw[0] - gyro_offset[0]) * 0.000266316109f;
-				raw.gyro_rad_s[1] = (raw.gyro_raw[1] - gyro_offset[1]) * 0.000266316109f;
-				raw.gyro_rad_s[2] = (raw.gyro_raw[2] - gyro_offset[2]) * 0.000266316109f;
+			raw.accelerometer_raw_counter++;
+		}
 
-				raw.gyro_raw_counter++;
-			}
+		/* MAGNETOMETER */
+		if (magn_updated) {
+			/* copy sensor readings to global data and transform coordinates into px4fmu board frame */
 
-			/* ACCELEROMETER */
-			if (acc_updated) {
-				/* copy sensor readings to global data and transform coordinates into px4fmu board frame */
+			/* assign negated value, except for -SHORT_MAX, as it would wrap there */
+			raw.magnetometer_raw[0] = (mag_report.y_raw == -32768) ? 32767 : -mag_report.y_raw; // x of the board is -y of the sensor
+			raw.magnetometer_raw[1] = (mag_report.x_raw == -32768) ? -32767 : mag_report.x_raw; // y on the board is x of the sensor
+			raw.magnetometer_raw[2] = (mag_report.z_raw == -32768) ? -32767 : mag_report.z_raw; // z of the board is z of the sensor
 
-				/* assign negated value, except for -SHORT_MAX, as it would wrap there */
-				raw.accelerometer_raw[0] = (buf_accelerometer[1] == -32768) ? 32767 : -buf_accelerometer[1]; // x of the board is -y of the sensor
-				raw.accelerometer_raw[1] = (buf_accelerometer[0] == -32768) ? -32767 : buf_accelerometer[0];  // y on the board is x of the sensor
-				raw.accelerometer_raw[2] = (buf_accelerometer[2] == -32768) ? -32767 : buf_accelerometer[2]; // z of the board is z of the sensor
+			/* 0.88 Ga range, 12 bit resolution, set in sensors_init() */
+			raw.magnetometer_ga[0] = ((raw.magnetometer_raw[0] - mag_offset[0]) / 4096.0f) * 0.88f;
+			raw.magnetometer_ga[1] = ((raw.magnetometer_raw[1] - mag_offset[1]) / 4096.0f) * 0.88f;
+			raw.magnetometer_ga[2] = ((raw.magnetometer_raw[2] - mag_offset[2]) / 4096.0f) * 0.88f;
 
-				// XXX read range from sensor
-				float range_g = 4.0f;
-				/* scale from 14 bit to m/s2 */
-				raw.accelerometer_m_s2[0] = (((raw.accelerometer_raw[0] - acc_offset[0]) * range_g) / 8192.0f) / 9.81f;
-				raw.accelerometer_m_s2[1] = (((raw.accelerometer_raw[1] - acc_offset[1]) * range_g) / 8192.0f) / 9.81f;
-				raw.accelerometer_m_s2[2] = (((raw.accelerometer_raw[2] - acc_offset[2]) * range_g) / 8192.0f) / 9.81f;
+			/* the driver only runs in normal mode */
+			raw.magnetometer_mode = MAGNETOMETER_MODE_NORMAL;
 
-				raw.accelerometer_raw_counter++;
-			}
+			raw.magnetometer_raw_counter++;
+		}
 
-			/* MAGNETOMETER */
-			if (magn_updated) {
-				/* copy sensor readings to global data and transform coordinates into px4fmu board frame */
+		/* BAROMETER */
+		if (baro_updated) {
+			/* copy sensor readings to global data and transform coordinates into px4fmu board frame */
 
-				/* assign negated value, except for -SHORT_MAX, as it would wrap there */
-				raw.magnetometer_raw[0] = (buf_magnetometer[1] == -32768) ? 32767 : -buf_magnetometer[1]; // x of the board is -y of the sensor
-				raw.magnetometer_raw[1] = (buf_magnetometer[0] == -32768) ? -32767 : buf_magnetometer[0]; // y on the board is x of the sensor
-				raw.magnetometer_raw[2] = (buf_magnetometer[2] == -32768) ? -32767 : buf_magnetometer[2]; // z of the board is z of the sensor
+			raw.baro_pres_mbar = baro_report.pressure; // Pressure in mbar
+			raw.baro_alt_meter = baro_report.altitude; // Altitude in meters
+			raw.baro_temp_celcius = baro_report.temperature; // Temperature in degrees celcius
 
-				// XXX Read out mag range via I2C on init, assuming 0.88 Ga and 12 bit res here
-				raw.magnetometer_ga[0] = ((raw.magnetometer_raw[0] - mag_offset[0]) / 4096.0f) * 0.88f;
-				raw.magnetometer_ga[1] = ((raw.magnetometer_raw[1] - mag_offset[1]) / 4096.0f) * 0.88f;
-				raw.magnetometer_ga[2] = ((raw.magnetometer_raw[2] - mag_offset[2]) / 4096.0f) * 0.88f;
+			raw.baro_raw_counter++;
+		}
 
-				/* store mode */
-				raw.magnetometer_mode = buf_magnetometer[3];
+		/* ADC */
+		if (adc_updated) {
+			/* copy sensor readings to global data*/
 
-				raw.magnetometer_raw_counter++;
-			}
+			if (ADC_BATTERY_VOLATGE_CHANNEL == buf_adc.am_channel1) {
+				/* Voltage in volts */
+				raw.battery_voltage_v = (BAT_VOL_LOWPASS_1 * (raw.battery_voltage_v + BAT_VOL_LOWPASS_2 * (uint16_t)(buf_adc.am_data1 * battery_voltage_conversion)));
 
-			/* BAROMETER */
-			if (baro_updated) {
-				/* copy sensor readings to global data and transform coordinates into px4fmu board frame */
+				if ((buf_adc.am_data1 * battery_voltage_conversion) < VOLTAGE_BATTERY_IGNORE_THRESHOLD_VOLTS) {
+					raw.battery_voltage_valid = false;
+					raw.battery_voltage_v = 0.f;
 
-				raw.baro_pres_mbar = buf_barometer[0]; // Pressure in mbar
-				raw.baro_alt_meter = buf_barometer[1]; // Altitude in meters
-				raw.baro_temp_celcius = buf_barometer[2]; // Temperature in degrees celcius
+				} else {
+					raw.battery_voltage_valid = true;
+				}
 
-				raw.baro_raw_counter++;
+				raw.battery_voltage_counter++;
 			}
+		}
 
-			/* ADC */
-			if (adc_updated) {
-				/* copy sensor readings to global data*/
-
-				if (ADC_BATTERY_VOLATGE_CHANNEL == buf_adc.am_channel1) {
-					/* Voltage in volts */
-					raw.battery_voltage_v = (BAT_VOL_LOWPASS_1 * (raw.battery_voltage_v + BAT_VOL_LOWPASS_2 * (uint16_t)(buf_adc.am_data1 * battery_voltage_conversion)));
-
-					if ((buf_adc.am_data1 * battery_voltage_conversion) < VOLTAGE_BATTERY_IGNORE_THRESHOLD_VOLTS) {
-						raw.battery_voltage_valid = false;
-						raw.battery_voltage_v = 0.f;
+		/* Inform other processes that new data is available to copy */
+		if (publishing) {
+			orb_publish(ORB_ID(sensor_combined), sensor_pub, &raw);
+		}
 
-					} else {
-						raw.battery_voltage_valid = true;
-					}
+		/* close the integration interval once it is long enough */
+		if ((sensor_integrator_elapsed(&integ) >= DELTA_INTERVAL_US) &&
+		    sensor_integrator_get(&integ, &delta) &&
+		    publishing) {
+			if (delta_pub < 0) {
+				delta_pub = orb_advertise(ORB_ID(sensor_delta), &delta);
 
-					raw.battery_voltage_counter++;
-				}
+			} else {
+				orb_publish(ORB_ID(sensor_delta), delta_pub, &delta);
 			}
+		}
 
-			uint64_t total_time = hrt_absolute_time() - current_time;
-
-			/* Inform other processes that new data is available to copy */
-			if ((gyro_updated || acc_updated || magn_updated || baro_updated) && publishing) {
-				/* Values changed, publish */
-				orb_publish(ORB_ID(sensor_combined), sensor_pub, &raw);
-			}
+		uint64_t total_time = hrt_absolute_time() - gyro_report.timestamp;
+		perf_set(latency_perf, total_time);
 
 #ifdef CONFIG_HRT_PPM
 
-			if (ppm_updated) {
-				orb_publish(ORB_ID(rc_channels), rc_pub, &rc);
-			}
+		if (ppm_updated) {
+			orb_publish(ORB_ID(rc_channels), rc_pub, &rc);
+		}
 
 #endif
 
-			if (total_time > 2600) {
-				excessive_readout_time_counter++;
-			}
-
-			if (total_time > 2600 && excessive_readout_time_counter > 100 && excessive_readout_time_counter % 100 == 0) {
-				fprintf(stderr, "[sensors] slow update (>2600 us): %d us (#%d)\n", (int)total_time, excessive_readout_time_counter);
+		if (total_time > 2600) {
+			excessive_readout_time_counter++;
+		}
 
-			} else if (total_time > 6000) {
-				if (excessive_readout_time_counter < 100 || excessive_readout_time_counter % 100 == 0) fprintf(stderr, "[sensors] WARNING: Slow update (>6000 us): %d us (#%d)\n", (int)total_time, excessive_readout_time_counter);
-			}
+		if (total_time > 2600 && excessive_readout_time_counter > 100 && excessive_readout_time_counter % 100 == 0) {
+			fprintf(stderr, "[sensors] slow update (>2600 us): %d us (#%d)\n", (int)total_time, excessive_readout_time_counter);
 
+		} else if (total_time > 6000) {
+			if (excessive_readout_time_counter < 100 || excessive_readout_time_counter % 100 == 0) fprintf(stderr, "[sensors] WARNING: Slow update (>6000 us): %d us (#%d)\n", (int)total_time, excessive_readout_time_counter);
+		}
 
-			read_loop_counter++;
 #ifdef CONFIG_SENSORS_DEBUG_ENABLED
 
-			if (read_loop_counter % 1000 == 0) printf("[sensors] read loop counter: %d\n", read_loop_counter);
-
-			fflush(stdout);
+		if (raw.gyro_raw_counter % 1000 == 0) printf("[sensors] read loop counter: %d\n", raw.gyro_raw_counter);
 
-			if (sensors_timer_loop_counter % 1000 == 0) printf("[sensors] timer/trigger loop counter: %d\n", sensors_timer_loop_counter);
+		fflush(stdout);
 
 #endif
-		}
 	}
 
 	/* Never really getting here */
 	printf("[sensors] sensor readout stopped\n");
 
-	close(fd_gyro);
-	close(fd_accelerometer);
-	close(fd_magnetometer);
-	close(fd_barometer);
-	close(fd_adc);
+	perf_free(latency_perf);
+	sensors_close();
 
 	printf("[sensors] exiting.\n");
 
 	return ret;
 }
-
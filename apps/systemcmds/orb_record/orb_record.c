@@ -0,0 +1,379 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2012 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file orb_record.c
+ *
+ * Record uORB topics to a binary stream for later replay with orb_replay.
+ *
+ * Each update of the recorded topics is written with the time it was
+ * published, in the format described in uORB/orb_log.h. Topics that are
+ * not known yet when recording starts are picked up as soon as something
+ * advertises or subscribes to them.
+ */
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sched.h>
+
+#include <arch/board/up_hrt.h>
+
+#include <uORB/uORB.h>
+#include <uORB/orb_log.h>
+
+__EXPORT int orb_record_main(int argc, char *argv[]);
+
+/** topics recorded when none are given on the command line; the estimator and controller inputs */
+static const char *default_topics[] = {
+	"sensor_combined",
+	"vehicle_gps_position",
+	"vehicle_status",
+	"rc_channels",
+	"vehicle_attitude",
+	"vehicle_local_position",
+	"vehicle_global_position",
+	"vehicle_attitude_setpoint",
+	"actuator_controls_0",
+	"actuator_armed",
+};
+
+#define BUFFER_BYTES	2048		/**< stream buffer; flushed when the next record does not fit */
+#define RESCAN_INTERVAL	1000000		/**< microseconds between attempts to find missing topics */
+
+struct record_topic {
+	const char			*name;
+	const struct orb_metadata	*meta;	/**< NULL until the topic is known */
+	orb_sub_t			sub;
+	unsigned			updates;
+	bool				ignored;	/**< the topic cannot be recorded */
+};
+
+static struct record_topic topics[ORB_LOG_MAX_TOPICS];
+static unsigned	topic_count;
+static bool	topics_allocated;		/**< true if the topic names were copied from the command line */
+static char	*filename;
+
+static volatile bool thread_should_exit;
+static volatile bool thread_running;
+static int	record_task;
+
+static unsigned	bytes_written;
+static unsigned	write_errors;
+
+static uint8_t	buffer[BUFFER_BYTES];
+static unsigned	buffer_fill;
+
+static int	record_thread_main(int argc, char *argv[]);
+static int	usage(const char *reason);
+
+/**
+ * Write out the stream buffer.
+ */
+static void
+flush(int fd)
+{
+	if (buffer_fill == 0)
+		return;
+
+	if (write(fd, buffer, buffer_fill) == (ssize_t)buffer_fill) {
+		bytes_written += buffer_fill;
+
+	} else {
+		write_errors++;
+	}
+
+	buffer_fill = 0;
+}
+
+/**
+ * Reserve space for a record in the stream buffer and fill in its header.
+ *
+ * @return		Pointer to where the payload goes.
+ */
+static uint8_t *
+record_begin(int fd, uint8_t type, uint8_t id, uint16_t length)
+{
+	struct orb_log_record rec;
+
+	if ((buffer_fill + ORB_LOG_RECORD_LEN + length) > sizeof(buffer))
+		flush(fd);
+
+	rec.type = type;
+	rec.id = id;
+	rec.length = length;
+
+	uint8_t *p = &buffer[buffer_fill];
+	memcpy(p, &rec.type, sizeof(rec.type));
+	memcpy(p + 1, &rec.id, sizeof(rec.id));
+	memcpy(p + 2, &rec.length, sizeof(rec.length));
+
+	buffer_fill += ORB_LOG_RECORD_LEN + length;
+
+	return p + ORB_LOG_RECORD_LEN;
+}
+
+/**
+ * Try to find the topics that are not known yet, and start recording them.
+ */
+static void
+scan_topics(int fd, orb_waitset_t ws, unsigned *bit_to_topic)
+{
+	for (unsigned i = 0; i < topic_count; i++) {
+		struct record_topic *t = &topics[i];
+
+		if ((t->meta != NULL) || t->ignored)
+			continue;
+
+		const struct orb_metadata *meta = orb_lookup(t->name);
+
+		if (meta == NULL)
+			continue;
+
+		/* a record must fit in the stream buffer */
+		if ((ORB_LOG_RECORD_LEN + ORB_LOG_DATA_LEN + meta->o_size) > sizeof(buffer)) {
+			fprintf(stderr, "[orb_record] %s is too large to record\n", t->name);
+			t->ignored = true;
+			continue;
+		}
+
+		t->sub = orb_subscribe_direct(meta);
+
+		if (t->sub == NULL)
+			continue;
+
+		int bit = orb_waitset_add_direct(ws, t->sub);
+
+		if (bit < 0) {
+			orb_unsubscribe_direct(t->sub);
+			t->sub = NULL;
+			continue;
+		}
+
+		bit_to_topic[bit] = i;
+		t->meta = meta;
+
+		/* introduce the topic */
+		size_t namelen = strlen(meta->o_name);
+		struct orb_log_format fmt = { meta->o_size };
+		uint8_t *p = record_begin(fd, ORB_LOG_FORMAT, i, ORB_LOG_FORMAT_LEN + namelen);
+
+		memcpy(p, &fmt.size, sizeof(fmt.size));
+		memcpy(p + ORB_LOG_FORMAT_LEN, meta->o_name, namelen);
+	}
+}
+
+static int
+record_thread_main(int argc, char *argv[])
+{
+	unsigned bit_to_topic[ORB_WAITSET_MAX];
+	struct orb_log_header hdr;
+	hrt_abstime last_scan = 0;
+	orb_waitset_t ws = NULL;
+	int fd;
+
+	thread_running = true;
+	bytes_written = 0;
+	write_errors = 0;
+	buffer_fill = 0;
+
+	fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+
+	if (fd < 0) {
+		fprintf(stderr, "[orb_record] can't open %s: %d\n", filename, errno);
+		goto out;
+	}
+
+	ws = orb_waitset_create();
+
+	if (ws == NULL) {
+		fprintf(stderr, "[orb_record] out of memory\n");
+		goto out;
+	}
+
+	memcpy(hdr.magic, ORB_LOG_MAGIC, ORB_LOG_MAGIC_LEN);
+	hdr.version = ORB_LOG_VERSION;
+	hdr.reserved = 0;
+	memcpy(buffer, &hdr, sizeof(hdr));
+	buffer_fill = sizeof(hdr);
+
+	while (!thread_should_exit) {
+		uint32_t ready;
+
+		if ((hrt_absolute_time() - last_scan) > RESCAN_INTERVAL) {
+			scan_topics(fd, ws, bit_to_topic);
+			last_scan = hrt_absolute_time();
+		}
+
+		if (orb_waitset_wait(ws, 100, &ready) <= 0)
+			continue;
+
+		for (unsigned bit = 0; ready != 0; bit++, ready >>= 1) {
+			if (!(ready & 1))
+				continue;
+
+			struct record_topic *t = &topics[bit_to_topic[bit]];
+			struct orb_log_data data;
+			uint8_t *p = record_begin(fd, ORB_LOG_DATA, bit_to_topic[bit], ORB_LOG_DATA_LEN + t->meta->o_size);
+
+			/* the oldest unread update, and when it was published */
+			orb_copy_stamped_direct(t->meta, t->sub, p + ORB_LOG_DATA_LEN, &data.timestamp);
+			memcpy(p, &data.timestamp, sizeof(data.timestamp));
+			t->updates++;
+		}
+	}
+
+	flush(fd);
+
+out:
+	if (ws != NULL)
+		orb_waitset_destroy(ws);
+
+	for (unsigned i = 0; i < topic_count; i++) {
+		if (topics[i].sub != NULL)
+			orb_unsubscribe_direct(topics[i].sub);
+
+		topics[i].sub = NULL;
+	}
+
+	if (fd >= 0)
+		close(fd);
+
+	thread_running = false;
+
+	return 0;
+}
+
+static int
+usage(const char *reason)
+{
+	if (reason)
+		fprintf(stderr, "%s\n", reason);
+
+	fprintf(stderr, "usage: orb_record {start <file> [<topic> ...]|stop|status}\n");
+	return 1;
+}
+
+int
+orb_record_main(int argc, char *argv[])
+{
+	if (argc < 2)
+		return usage("missing command");
+
+	if (!strcmp(argv[1], "start")) {
+
+		if (thread_running) {
+			printf("[orb_record] already running\n");
+			return 0;
+		}
+
+		if (argc < 3)
+			return usage("missing file name");
+
+		/* the task outlives argv */
+		free(filename);
+		filename = strdup(argv[2]);
+
+		/* names from a previous command line were copied */
+		if (topics_allocated) {
+			for (unsigned i = 0; i < topic_count; i++)
+				free((void *)topics[i].name);
+
+			topics_allocated = false;
+		}
+
+		topic_count = 0;
+
+		if (argc > 3) {
+			topics_allocated = true;
+
+			for (int i = 3; (i < argc) && (topic_count < ORB_LOG_MAX_TOPICS); i++)
+				topics[topic_count++].name = strdup(argv[i]);
+
+		} else {
+			for (unsigned i = 0; i < sizeof(default_topics) / sizeof(default_topics[0]); i++)
+				topics[topic_count++].name = default_topics[i];
+		}
+
+		for (unsigned i = 0; i < topic_count; i++) {
+			topics[i].meta = NULL;
+			topics[i].sub = NULL;
+			topics[i].updates = 0;
+			topics[i].ignored = false;
+		}
+
+		thread_should_exit = false;
+		thread_running = true;
+		record_task = task_create("orb_record", SCHED_PRIORITY_DEFAULT - 1, 2048, record_thread_main, NULL);
+
+		if (record_task < 0) {
+			thread_running = false;
+			fprintf(stderr, "[orb_record] task start failed: %d\n", errno);
+			return 1;
+		}
+
+		return 0;
+	}
+
+	if (!strcmp(argv[1], "stop")) {
+		thread_should_exit = true;
+
+		while (thread_running)
+			usleep(10000);
+
+		printf("[orb_record] %u bytes written to %s, %u write errors\n", bytes_written, filename, write_errors);
+		return 0;
+	}
+
+	if (!strcmp(argv[1], "status")) {
+		printf("[orb_record] %s, %u bytes written, %u write errors\n",
+		       thread_running ? "running" : "stopped", bytes_written, write_errors);
+
+		for (unsigned i = 0; i < topic_count; i++) {
+			printf("  %-32s %s %u updates\n", topics[i].name,
+			       (topics[i].meta != NULL) ? "recording" : "waiting  ", topics[i].updates);
+		}
+
+		return 0;
+	}
+
+	return usage("unrecognised command");
+}
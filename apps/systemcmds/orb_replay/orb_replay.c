@@ -0,0 +1,373 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2012 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file orb_replay.c
+ *
+ * Republish uORB topics recorded with orb_record.
+ *
+ * Updates are published with the timing they were recorded with, or as
+ * fast as possible. The replayed topics must not have any other publisher,
+ * so the apps that normally produce them should not be running; topics
+ * that nothing in the system knows about are skipped.
+ */
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sched.h>
+
+#include <arch/board/up_hrt.h>
+
+#include <drivers/drv_orb_dev.h>
+
+#include <uORB/uORB.h>
+#include <uORB/orb_log.h>
+
+__EXPORT int orb_replay_main(int argc, char *argv[]);
+
+#define BUFFER_BYTES	2048		/**< largest record that can be replayed */
+
+struct replay_topic {
+	char				name[ORB_MAXNAME];
+	uint16_t			size;	/**< recorded topic size, zero if no format record seen */
+	const struct orb_metadata	*meta;	/**< NULL until the topic is known */
+	int				pub;	/**< publication handle, or -1 */
+	unsigned			updates;
+	bool				ignored; /**< the topic cannot be replayed */
+};
+
+static struct replay_topic topics[ORB_LOG_MAX_TOPICS];
+static char	*filename;
+static bool	fast;
+
+static volatile bool thread_should_exit;
+static volatile bool thread_running;
+static int	replay_task;
+
+static unsigned	records;
+static unsigned	skipped;
+
+static uint8_t	buffer[BUFFER_BYTES];
+
+static int	replay_thread_main(int argc, char *argv[]);
+static int	usage(const char *reason);
+
+/**
+ * Read exactly len bytes.
+ *
+ * @return		True on success, false at the end of the stream or on error.
+ */
+static bool
+read_all(int fd, void *buf, size_t len)
+{
+	uint8_t *p = (uint8_t *)buf;
+
+	while (len > 0) {
+		ssize_t ret = read(fd, p, len);
+
+		if (ret <= 0)
+			return false;
+
+		p += ret;
+		len -= ret;
+	}
+
+	return true;
+}
+
+/**
+ * Handle a format record.
+ */
+static void
+replay_format(uint8_t id, const uint8_t *payload, uint16_t length)
+{
+	struct replay_topic *t = &topics[id];
+	struct orb_log_format fmt;
+	unsigned namelen = length - ORB_LOG_FORMAT_LEN;
+
+	memcpy(&fmt.size, payload, sizeof(fmt.size));
+
+	if (namelen >= sizeof(t->name))
+		namelen = sizeof(t->name) - 1;
+
+	memcpy(t->name, payload + ORB_LOG_FORMAT_LEN, namelen);
+	t->name[namelen] = '\0';
+	t->size = fmt.size;
+}
+
+/**
+ * Handle a data record.
+ */
+static void
+replay_data(uint8_t id, const uint8_t *payload, uint16_t length)
+{
+	struct replay_topic *t = &topics[id];
+
+	if (t->ignored || (t->size == 0) || (length != (ORB_LOG_DATA_LEN + t->size))) {
+		skipped++;
+		return;
+	}
+
+	/* something may have subscribed since the last update */
+	if (t->meta == NULL) {
+		t->meta = orb_lookup(t->name);
+
+		if (t->meta == NULL) {
+			skipped++;
+			return;
+		}
+
+		if (t->meta->o_size != t->size) {
+			fprintf(stderr, "[orb_replay] %s: recorded size %u does not match %u, skipping\n",
+				t->name, t->size, (unsigned)t->meta->o_size);
+			t->ignored = true;
+			skipped++;
+			return;
+		}
+	}
+
+	const uint8_t *data = payload + ORB_LOG_DATA_LEN;
+
+	if (t->pub < 0) {
+		t->pub = orb_advertise(t->meta, data);
+
+		if (t->pub < 0) {
+			fprintf(stderr, "[orb_replay] %s: can't advertise (%d), is the publisher running?\n",
+				t->name, errno);
+			t->ignored = true;
+			skipped++;
+			return;
+		}
+
+	} else {
+		orb_publish(t->meta, t->pub, data);
+	}
+
+	t->updates++;
+}
+
+static int
+replay_thread_main(int argc, char *argv[])
+{
+	struct orb_log_header hdr;
+	hrt_abstime first_timestamp = 0;
+	hrt_abstime start = 0;
+	int fd;
+
+	records = 0;
+	skipped = 0;
+
+	for (unsigned i = 0; i < ORB_LOG_MAX_TOPICS; i++) {
+		topics[i].name[0] = '\0';
+		topics[i].size = 0;
+		topics[i].meta = NULL;
+		topics[i].pub = -1;
+		topics[i].updates = 0;
+		topics[i].ignored = false;
+	}
+
+	fd = open(filename, O_RDONLY);
+
+	if (fd < 0) {
+		fprintf(stderr, "[orb_replay] can't open %s: %d\n", filename, errno);
+		goto out;
+	}
+
+	if (!read_all(fd, &hdr, sizeof(hdr)) ||
+	    memcmp(hdr.magic, ORB_LOG_MAGIC, ORB_LOG_MAGIC_LEN) ||
+	    (hdr.version != ORB_LOG_VERSION)) {
+		fprintf(stderr, "[orb_replay] %s is not a version %u topic recording\n", filename, ORB_LOG_VERSION);
+		goto out;
+	}
+
+	while (!thread_should_exit) {
+		uint8_t raw[ORB_LOG_RECORD_LEN];
+		struct orb_log_record rec;
+
+		if (!read_all(fd, raw, sizeof(raw)))
+			break;
+
+		memcpy(&rec.type, raw, sizeof(rec.type));
+		memcpy(&rec.id, raw + 1, sizeof(rec.id));
+		memcpy(&rec.length, raw + 2, sizeof(rec.length));
+
+		if ((rec.length > sizeof(buffer)) || (rec.id >= ORB_LOG_MAX_TOPICS)) {
+			fprintf(stderr, "[orb_replay] bad record, stopping\n");
+			break;
+		}
+
+		if (!read_all(fd, buffer, rec.length))
+			break;
+
+		records++;
+
+		switch (rec.type) {
+		case ORB_LOG_FORMAT:
+			if (rec.length > ORB_LOG_FORMAT_LEN)
+				replay_format(rec.id, buffer, rec.length);
+
+			break;
+
+		case ORB_LOG_DATA:
+			if (rec.length < ORB_LOG_DATA_LEN)
+				break;
+
+			if (!fast) {
+				struct orb_log_data data;
+
+				memcpy(&data.timestamp, buffer, sizeof(data.timestamp));
+
+				/* keep the recorded spacing between updates */
+				if (start == 0) {
+					start = hrt_absolute_time();
+					first_timestamp = data.timestamp;
+
+				} else if (data.timestamp > first_timestamp) {
+					hrt_abstime due = start + (data.timestamp - first_timestamp);
+					hrt_abstime now = hrt_absolute_time();
+
+					if (due > now)
+						usleep(due - now);
+				}
+			}
+
+			replay_data(rec.id, buffer, rec.length);
+			break;
+
+		default:
+			/* unknown record types are skipped */
+			break;
+		}
+	}
+
+out:
+	for (unsigned i = 0; i < ORB_LOG_MAX_TOPICS; i++) {
+		if (topics[i].pub >= 0)
+			close(topics[i].pub);
+
+		topics[i].pub = -1;
+	}
+
+	if (fd >= 0)
+		close(fd);
+
+	printf("[orb_replay] done, %u records, %u updates skipped\n", records, skipped);
+	thread_running = false;
+
+	return 0;
+}
+
+static int
+usage(const char *reason)
+{
+	if (reason)
+		fprintf(stderr, "%s\n", reason);
+
+	fprintf(stderr, "usage: orb_replay {start [-f] <file>|stop|status}\n");
+	fprintf(stderr, "    -f    replay as fast as possible rather than with the recorded timing\n");
+	return 1;
+}
+
+int
+orb_replay_main(int argc, char *argv[])
+{
+	if (argc < 2)
+		return usage("missing command");
+
+	if (!strcmp(argv[1], "start")) {
+		int arg = 2;
+
+		if (thread_running) {
+			printf("[orb_replay] already running\n");
+			return 0;
+		}
+
+		fast = false;
+
+		if ((arg < argc) && !strcmp(argv[arg], "-f")) {
+			fast = true;
+			arg++;
+		}
+
+		if (arg >= argc)
+			return usage("missing file name");
+
+		/* the task outlives argv */
+		free(filename);
+		filename = strdup(argv[arg]);
+
+		thread_should_exit = false;
+		thread_running = true;
+		replay_task = task_create("orb_replay", SCHED_PRIORITY_DEFAULT, 2048, replay_thread_main, NULL);
+
+		if (replay_task < 0) {
+			thread_running = false;
+			fprintf(stderr, "[orb_replay] task start failed: %d\n", errno);
+			return 1;
+		}
+
+		return 0;
+	}
+
+	if (!strcmp(argv[1], "stop")) {
+		thread_should_exit = true;
+
+		while (thread_running)
+			usleep(10000);
+
+		return 0;
+	}
+
+	if (!strcmp(argv[1], "status")) {
+		printf("[orb_replay] %s, %u records, %u updates skipped\n",
+		       thread_running ? "running" : "stopped", records, skipped);
+
+		for (unsigned i = 0; i < ORB_LOG_MAX_TOPICS; i++) {
+			if (topics[i].name[0] != '\0')
+				printf("  %-32s %u updates\n", topics[i].name, topics[i].updates);
+		}
+
+		return 0;
+	}
+
+	return usage("unrecognised command");
+}
@@ -0,0 +1,459 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2012 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file Fixed-size matrix and vector templates.
+ *
+ * Dimensions are template parameters, so a mismatch is a compile error
+ * rather than something to check at runtime, every loop has a constant
+ * trip count the compiler can unroll, and storage is a plain array with
+ * no pointer or size to carry around.
+ *
+ * Arithmetic builds expression objects rather than matrices; nothing is
+ * computed until an expression is assigned, and then each element of the
+ * result is computed once, straight into the destination. So
+ *
+ *	X = A * B + C * D;
+ *
+ * needs no temporary for either product or for the sum. A product whose
+ * factor is itself an expression (other than the transpose of a matrix)
+ * evaluates that factor into a temporary first, since the product reads
+ * each element of it many times.
+ *
+ * As expressions refer to their matrices rather than copying them, a
+ * product or transpose must not be assigned to a matrix it reads from;
+ * use a temporary. Element-wise expressions (sums, differences, scaling)
+ * may be assigned in place.
+ *
+ * Matrices are row-major. Default construction leaves the elements
+ * uninitialised, as for a C array, so a matrix is as cheap to declare as
+ * one and may be placed in static storage without a constructor.
+ */
+
+#ifndef _SYSTEMLIB_MATRIX_H
+#define _SYSTEMLIB_MATRIX_H
+
+#include <math.h>
+
+namespace math
+{
+
+template<typename T, unsigned M, unsigned N> class Matrix;
+template<typename A, typename T, unsigned M, unsigned N> class Transpose;
+
+/**
+ * Base of everything that can be indexed as an M x N matrix.
+ *
+ * @param E		The expression type (the class deriving from this).
+ * @param T		Element type.
+ * @param M		Rows.
+ * @param N		Columns.
+ */
+template<typename E, typename T, unsigned M, unsigned N>
+class Expr
+{
+public:
+	typedef T		value_type;
+	static const unsigned	rows = M;
+	static const unsigned	cols = N;
+
+	/**
+	 * Element (i, j) of the expression.
+	 */
+	T		operator()(unsigned i, unsigned j) const { return self()(i, j); }
+
+	/**
+	 * The expression as its own type.
+	 */
+	const E		&self() const { return static_cast<const E &>(*this); }
+
+	/**
+	 * The transpose of the expression.
+	 */
+	Transpose<E, T, N, M> transpose() const { return Transpose<E, T, N, M>(self()); }
+};
+
+/**
+ * How an expression holds an operand.
+ *
+ * Expression objects are small and are copied; matrices are referred to.
+ */
+template<typename E>
+struct Operand {
+	typedef const E type;
+};
+
+template<typename T, unsigned M, unsigned N>
+struct Operand<Matrix<T, M, N> > {
+	typedef const Matrix<T, M, N> &type;
+};
+
+/**
+ * How a product holds a factor.
+ *
+ * A product reads each element of its factors many times, so anything more
+ * than a matrix or its transpose is evaluated into a temporary once.
+ */
+template<typename E, typename T, unsigned M, unsigned N>
+struct Factor {
+	typedef const Matrix<T, M, N> type;
+};
+
+template<typename T, unsigned M, unsigned N>
+struct Factor<Matrix<T, M, N>, T, M, N> {
+	typedef const Matrix<T, M, N> &type;
+};
+
+template<typename T, unsigned M, unsigned N>
+struct Factor<Transpose<Matrix<T, N, M>, T, M, N>, T, M, N> {
+	typedef const Transpose<Matrix<T, N, M>, T, M, N> type;
+};
+
+/**
+ * A matrix with M rows and N columns of T.
+ */
+template<typename T, unsigned M, unsigned N>
+class Matrix : public Expr<Matrix<T, M, N>, T, M, N>
+{
+public:
+	/**
+	 * Construct with the elements uninitialised.
+	 */
+	Matrix() = default;
+
+	/**
+	 * Construct from M * N elements in row-major order.
+	 */
+	explicit Matrix(const T *data) {
+		for (unsigned i = 0; i < M; i++)
+			for (unsigned j = 0; j < N; j++)
+				_data[i][j] = data[i * N + j];
+	}
+
+	/**
+	 * Construct by evaluating an expression.
+	 */
+	template<typename E>
+	Matrix(const Expr<E, T, M, N> &e) { *this = e; }
+
+	/**
+	 * Evaluate an expression into the matrix.
+	 *
+	 * The expression must not contain a product or transpose that reads
+	 * this matrix.
+	 */
+	template<typename E>
+	Matrix &operator=(const Expr<E, T, M, N> &e) {
+		const E &x = e.self();
+
+		for (unsigned i = 0; i < M; i++)
+			for (unsigned j = 0; j < N; j++)
+				_data[i][j] = x(i, j);
+
+		return *this;
+	}
+
+	template<typename E>
+	Matrix &operator+=(const Expr<E, T, M, N> &e) {
+		const E &x = e.self();
+
+		for (unsigned i = 0; i < M; i++)
+			for (unsigned j = 0; j < N; j++)
+				_data[i][j] += x(i, j);
+
+		return *this;
+	}
+
+	template<typename E>
+	Matrix &operator-=(const Expr<E, T, M, N> &e) {
+		const E &x = e.self();
+
+		for (unsigned i = 0; i < M; i++)
+			for (unsigned j = 0; j < N; j++)
+				_data[i][j] -= x(i, j);
+
+		return *this;
+	}
+
+	Matrix &operator*=(T s) {
+		for (unsigned i = 0; i < M; i++)
+			for (unsigned j = 0; j < N; j++)
+				_data[i][j] *= s;
+
+		return *this;
+	}
+
+	T		&operator()(unsigned i, unsigned j) { return _data[i][j]; }
+	T		operator()(unsigned i, unsigned j) const { return _data[i][j]; }
+
+	/**
+	 * The elements in row-major order.
+	 */
+	T		*data() { return &_data[0][0]; }
+	const T		*data() const { return &_data[0][0]; }
+
+	/**
+	 * Set every element to zero.
+	 */
+	void		set_zero() {
+		for (unsigned i = 0; i < M; i++)
+			for (unsigned j = 0; j < N; j++)
+				_data[i][j] = T(0);
+	}
+
+	/**
+	 * Set to the identity, or its leading part if not square.
+	 */
+	void		set_identity() {
+		for (unsigned i = 0; i < M; i++)
+			for (unsigned j = 0; j < N; j++)
+				_data[i][j] = (i == j) ? T(1) : T(0);
+	}
+
+private:
+	T		_data[M][N];
+};
+
+/**
+ * A column vector of N elements of T.
+ */
+template<typename T, unsigned N>
+class Vector : public Matrix<T, N, 1>
+{
+public:
+	Vector() = default;
+
+	explicit Vector(const T *data) : Matrix<T, N, 1>(data) {}
+
+	template<typename E>
+	Vector(const Expr<E, T, N, 1> &e) : Matrix<T, N, 1>(e) {}
+
+	template<typename E>
+	Vector &operator=(const Expr<E, T, N, 1> &e) {
+		Matrix<T, N, 1>::operator=(e);
+		return *this;
+	}
+
+	using Matrix<T, N, 1>::operator();
+
+	T		&operator()(unsigned i) { return (*this)(i, 0); }
+	T		operator()(unsigned i) const { return (*this)(i, 0); }
+	T		&operator[](unsigned i) { return (*this)(i, 0); }
+	T		operator[](unsigned i) const { return (*this)(i, 0); }
+};
+
+/** a + b */
+template<typename A, typename B, typename T, unsigned M, unsigned N>
+class Sum : public Expr<Sum<A, B, T, M, N>, T, M, N>
+{
+public:
+	Sum(const A &a, const B &b) : _a(a), _b(b) {}
+	T operator()(unsigned i, unsigned j) const { return _a(i, j) + _b(i, j); }
+private:
+	typename Operand<A>::type _a;
+	typename Operand<B>::type _b;
+};
+
+/** a - b */
+template<typename A, typename B, typename T, unsigned M, unsigned N>
+class Difference : public Expr<Difference<A, B, T, M, N>, T, M, N>
+{
+public:
+	Difference(const A &a, const B &b) : _a(a), _b(b) {}
+	T operator()(unsigned i, unsigned j) const { return _a(i, j) - _b(i, j); }
+private:
+	typename Operand<A>::type _a;
+	typename Operand<B>::type _b;
+};
+
+/** a .* b */
+template<typename A, typename B, typename T, unsigned M, unsigned N>
+class ElementProduct : public Expr<ElementProduct<A, B, T, M, N>, T, M, N>
+{
+public:
+	ElementProduct(const A &a, const B &b) : _a(a), _b(b) {}
+	T operator()(unsigned i, unsigned j) const { return _a(i, j) * _b(i, j); }
+private:
+	typename Operand<A>::type _a;
+	typename Operand<B>::type _b;
+};
+
+/** a * s, for scalar s */
+template<typename A, typename T, unsigned M, unsigned N>
+class Scaled : public Expr<Scaled<A, T, M, N>, T, M, N>
+{
+public:
+	Scaled(const A &a, T s) : _a(a), _s(s) {}
+	T operator()(unsigned i, unsigned j) const { return _a(i, j) * _s; }
+private:
+	typename Operand<A>::type _a;
+	const T _s;
+};
+
+/** a', where a is N x M */
+template<typename A, typename T, unsigned M, unsigned N>
+class Transpose : public Expr<Transpose<A, T, M, N>, T, M, N>
+{
+public:
+	explicit Transpose(const A &a) : _a(a) {}
+	T operator()(unsigned i, unsigned j) const { return _a(j, i); }
+private:
+	typename Operand<A>::type _a;
+};
+
+/** a * b, where a is M x K and b is K x N */
+template<typename A, typename B, typename T, unsigned M, unsigned K, unsigned N>
+class Product : public Expr<Product<A, B, T, M, K, N>, T, M, N>
+{
+public:
+	Product(const A &a, const B &b) : _a(a), _b(b) {}
+
+	T operator()(unsigned i, unsigned j) const {
+		T sum = _a(i, 0) * _b(0, j);
+
+		for (unsigned k = 1; k < K; k++)
+			sum += _a(i, k) * _b(k, j);
+
+		return sum;
+	}
+
+private:
+	typename Factor<A, T, M, K>::type _a;
+	typename Factor<B, T, K, N>::type _b;
+};
+
+/** keeps a scalar argument out of template argument deduction */
+template<typename T>
+struct Scalar {
+	typedef T type;
+};
+
+template<typename A, typename B, typename T, unsigned M, unsigned N>
+inline Sum<A, B, T, M, N>
+operator+(const Expr<A, T, M, N> &a, const Expr<B, T, M, N> &b)
+{
+	return Sum<A, B, T, M, N>(a.self(), b.self());
+}
+
+template<typename A, typename B, typename T, unsigned M, unsigned N>
+inline Difference<A, B, T, M, N>
+operator-(const Expr<A, T, M, N> &a, const Expr<B, T, M, N> &b)
+{
+	return Difference<A, B, T, M, N>(a.self(), b.self());
+}
+
+template<typename A, typename T, unsigned M, unsigned N>
+inline Scaled<A, T, M, N>
+operator*(const Expr<A, T, M, N> &a, typename Scalar<T>::type s)
+{
+	return Scaled<A, T, M, N>(a.self(), s);
+}
+
+template<typename A, typename T, unsigned M, unsigned N>
+inline Scaled<A, T, M, N>
+operator*(typename Scalar<T>::type s, const Expr<A, T, M, N> &a)
+{
+	return Scaled<A, T, M, N>(a.self(), s);
+}
+
+template<typename A, typename T, unsigned M, unsigned N>
+inline Scaled<A, T, M, N>
+operator-(const Expr<A, T, M, N> &a)
+{
+	return Scaled<A, T, M, N>(a.self(), T(-1));
+}
+
+template<typename A, typename B, typename T, unsigned M, unsigned K, unsigned N>
+inline Product<A, B, T, M, K, N>
+operator*(const Expr<A, T, M, K> &a, const Expr<B, T, K, N> &b)
+{
+	return Product<A, B, T, M, K, N>(a.self(), b.self());
+}
+
+/**
+ * Element-wise product.
+ */
+template<typename A, typename B, typename T, unsigned M, unsigned N>
+inline ElementProduct<A, B, T, M, N>
+emult(const Expr<A, T, M, N> &a, const Expr<B, T, M, N> &b)
+{
+	return ElementProduct<A, B, T, M, N>(a.self(), b.self());
+}
+
+/**
+ * Dot product of two vectors.
+ */
+template<typename A, typename B, typename T, unsigned N>
+inline T
+dot(const Expr<A, T, N, 1> &a, const Expr<B, T, N, 1> &b)
+{
+	const A &x = a.self();
+	const B &y = b.self();
+	T sum = x(0, 0) * y(0, 0);
+
+	for (unsigned i = 1; i < N; i++)
+		sum += x(i, 0) * y(i, 0);
+
+	return sum;
+}
+
+/**
+ * Euclidean length of a vector.
+ */
+template<typename A, unsigned N>
+inline float
+norm(const Expr<A, float, N, 1> &a)
+{
+	return sqrtf(dot(a, a));
+}
+
+/**
+ * Cross product of two 3-vectors.
+ */
+template<typename A, typename B, typename T>
+inline Vector<T, 3>
+cross(const Expr<A, T, 3, 1> &a, const Expr<B, T, 3, 1> &b)
+{
+	const A &x = a.self();
+	const B &y = b.self();
+	Vector<T, 3> r;
+
+	r(0) = x(1, 0) * y(2, 0) - x(2, 0) * y(1, 0);
+	r(1) = x(2, 0) * y(0, 0) - x(0, 0) * y(2, 0);
+	r(2) = x(0, 0) * y(1, 0) - x(1, 0) * y(0, 0);
+	return r;
+}
+
+} // namespace math
+
+#endif /* _SYSTEMLIB_MATRIX_H */
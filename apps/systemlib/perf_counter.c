@@ -73,6 +73,17 @@ struct perf_ctr_elapsed {
 	uint64_t		time_most;
 };
 
+/**
+ * PC_LEVEL counter.
+ */
+struct perf_ctr_level {
+	struct perf_ctr_header	hdr;
+	uint64_t		event_count;
+	uint64_t		level;
+	uint64_t		level_total;
+	uint64_t		level_most;
+};
+
 /**
  * List of all known counters.
  */
@@ -93,6 +104,10 @@ perf_alloc(enum perf_counter_type type, const char *name)
 		ctr = (perf_counter_t)calloc(sizeof(struct perf_ctr_elapsed), 1);
 		break;
 
+	case PC_LEVEL:
+		ctr = (perf_counter_t)calloc(sizeof(struct perf_ctr_level), 1);
+		break;
+
 	default:
 		break;
 	}
@@ -174,6 +189,30 @@ perf_end(perf_counter_t handle)
 	}
 }
 
+void
+perf_set(perf_counter_t handle, uint64_t level)
+{
+	if (handle == NULL)
+		return;
+
+	switch (handle->type) {
+	case PC_LEVEL: {
+			struct perf_ctr_level *pcl = (struct perf_ctr_level *)handle;
+
+			pcl->event_count++;
+			pcl->level = level;
+			pcl->level_total += level;
+
+			if (pcl->level_most < level)
+				pcl->level_most = level;
+		}
+		break;
+
+	default:
+		break;
+	}
+}
+
 void
 perf_print_counter(perf_counter_t handle)
 {
@@ -194,6 +233,19 @@ perf_print_counter(perf_counter_t handle)
 		       ((struct perf_ctr_elapsed *)handle)->time_total,
 		       ((struct perf_ctr_elapsed *)handle)->time_least,
 		       ((struct perf_ctr_elapsed *)handle)->time_most);
+		break;
+
+	case PC_LEVEL: {
+			struct perf_ctr_level *pcl = (struct perf_ctr_level *)handle;
+
+			printf("%s: %llu samples, level %llu, mean %llu max %llu\n",
+			       handle->name,
+			       pcl->event_count,
+			       pcl->level,
+			       (pcl->event_count > 0) ? (pcl->level_total / pcl->event_count) : 0,
+			       pcl->level_most);
+		}
+		break;
 
 	default:
 		break;
@@ -39,12 +39,15 @@
 #ifndef _SYSTEMLIB_PERF_COUNTER_H
 #define _SYSTEMLIB_PERF_COUNTER_H value
 
+#include <stdint.h>
+
 /**
  * Counter types.
  */
 enum perf_counter_type {
 	PC_COUNT,		/**< count the number of times an event occurs */
-	PC_ELAPSED		/**< measure the time elapsed performing an event */
+	PC_ELAPSED,		/**< measure the time elapsed performing an event */
+	PC_LEVEL		/**< track the level of a quantity, e.g. a queue depth */
 };
 
 struct perf_ctr_header;
@@ -96,6 +99,15 @@ __EXPORT extern void		perf_begin(perf_counter_t handle);
  */
 __EXPORT extern void		perf_end(perf_counter_t handle);
 
+/**
+ * Record the current level of a quantity.
+ *
+ * This call applies to counters that track a level; PC_LEVEL etc.
+ *
+ * @param handle		The handle returned from perf_alloc.
+ * @param level			The current level.
+ */
+__EXPORT extern void		perf_set(perf_counter_t handle, uint64_t level);
 
 /**
  * Print one performance counter.
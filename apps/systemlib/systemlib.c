@@ -46,8 +46,13 @@
 #include <signal.h>
 #include <sys/stat.h>
 #include <unistd.h>
+#include <arch/irq.h>
 #include <arch/board/drv_eeprom.h>
+#include <arch/board/up_hrt.h>
+#include <drivers/drv_accel.h>
+#include <uORB/uORB.h>
 #include <uORB/parameter_storage.h>
+#include <uORB/topics/parameter_update.h>
 #include <float.h>
 #include <string.h>
 
@@ -227,6 +232,7 @@ int get_params_from_eeprom(struct global_data_parameter_storage_t *params)
 									if (read_res != sizeof(params->pm.param_values[i])) return ERROR;
 								}
 
+								params_changed(params);
 								ret = OK;
 
 							} else {
@@ -250,6 +256,28 @@ int get_params_from_eeprom(struct global_data_parameter_storage_t *params)
 	return ret;
 }
 
+void params_changed(struct global_data_parameter_storage_t *params)
+{
+	struct parameter_update_s update;
+	irqstate_t flags;
+
+	/* writers may be in different tasks */
+	flags = irqsave();
+	update.generation = ++params->generation;
+	irqrestore(flags);
+
+	update.timestamp = hrt_absolute_time();
+
+	/*
+	 * Advertising publishes the update; the handle belongs to the calling
+	 * task, so it is not kept.
+	 */
+	int pub = orb_advertise(ORB_ID(parameter_update), &update);
+
+	if (pub >= 0)
+		close(pub);
+}
+
 #define PX4_BOARD_ID_FMU (5)
 
 int fmu_get_board_info(struct fmu_board_info_s *info)
@@ -267,7 +295,8 @@ int fmu_get_board_info(struct fmu_board_info_s *info)
 		info->board_version = 17;
 
 	} else {
-		statres = stat("/dev/bma180", &sb);
+		/* the bma180 driver only creates the accel node if it finds the part */
+		statres = stat(ACCEL_DEVICE_PATH, &sb);
 
 		if (statres == OK) {
 			/* BMA180 indicates a v1.5-v1.6 board */
@@ -56,6 +56,16 @@ __EXPORT int store_params_in_eeprom(struct global_data_parameter_storage_t *para
 
 __EXPORT int get_params_from_eeprom(struct global_data_parameter_storage_t *params);
 
+/**
+ * Announce that one or more parameter values have changed.
+ *
+ * Must be called by anything that writes to params->pm.param_values, once
+ * the new values are in place. Increments params->generation and
+ * publishes the parameter_update topic, so that users of the parameters
+ * can recompute derived values on change rather than on every cycle.
+ */
+__EXPORT void params_changed(struct global_data_parameter_storage_t *params);
+
 enum MULT_PORTS {
 	MULT_0_US2_RXTX = 0,
 	MULT_1_US2_FLOW,
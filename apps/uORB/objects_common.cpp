@@ -66,6 +66,9 @@ ORB_DEFINE(vehicle_attitude, struct vehicle_attitude_s);
 #include "topics/sensor_combined.h"
 ORB_DEFINE(sensor_combined, struct sensor_combined_s);
 
+#include "topics/sensor_delta.h"
+ORB_DEFINE(sensor_delta, struct sensor_delta_s);
+
 #include "topics/vehicle_gps_position.h"
 ORB_DEFINE(vehicle_gps_position, struct vehicle_gps_position_s);
 
@@ -102,6 +105,9 @@ ORB_DEFINE(vehicle_global_position_setpoint, struct vehicle_global_position_setp
 #include "topics/vehicle_attitude_setpoint.h"
 ORB_DEFINE(vehicle_attitude_setpoint, struct vehicle_attitude_s);
 
+#include "topics/parameter_update.h"
+ORB_DEFINE(parameter_update, struct parameter_update_s);
+
 #include "topics/actuator_controls.h"
 ORB_DEFINE(actuator_controls_0, struct actuator_controls_s);
 ORB_DEFINE(actuator_controls_1, struct actuator_controls_s);
@@ -0,0 +1,106 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2012 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file Binary stream format written by orb_record and read by orb_replay.
+ *
+ * A stream is a file header followed by records. Each record starts with
+ * a record header giving its type and the length of the payload that
+ * follows, so that readers can skip record types they do not know.
+ *
+ * A topic is introduced by a format record before its first data record,
+ * which binds a one-byte topic ID to the topic name and size. Data records
+ * carry the time the update was published and a copy of the topic.
+ *
+ * All fields are in native byte order, and records are packed without
+ * padding; readers and writers copy fields in and out with memcpy.
+ */
+
+#ifndef _UORB_ORB_LOG_H
+#define _UORB_ORB_LOG_H
+
+#include <stdint.h>
+
+/** file header magic */
+#define ORB_LOG_MAGIC		"ORBLOG"
+#define ORB_LOG_MAGIC_LEN	6
+
+/** stream format version */
+#define ORB_LOG_VERSION		1
+
+/** maximum number of topics in a stream */
+#define ORB_LOG_MAX_TOPICS	32
+
+/** record types */
+#define ORB_LOG_FORMAT		1	/**< payload is ORB_LOG_FORMAT_LEN bytes plus the topic name */
+#define ORB_LOG_DATA		2	/**< payload is ORB_LOG_DATA_LEN bytes plus the topic data */
+
+/**
+ * File header.
+ */
+struct orb_log_header {
+	char		magic[ORB_LOG_MAGIC_LEN];
+	uint8_t		version;
+	uint8_t		reserved;
+};
+
+/**
+ * Record header.
+ */
+struct orb_log_record {
+	uint8_t		type;		/**< ORB_LOG_FORMAT or ORB_LOG_DATA */
+	uint8_t		id;		/**< topic ID */
+	uint16_t	length;		/**< length of the payload that follows */
+};
+
+#define ORB_LOG_RECORD_LEN	4
+
+/**
+ * Format record payload; followed by the topic name, without a terminating NUL.
+ */
+struct orb_log_format {
+	uint16_t	size;		/**< topic size */
+};
+
+#define ORB_LOG_FORMAT_LEN	2
+
+/**
+ * Data record payload; followed by the topic data.
+ */
+struct orb_log_data {
+	uint64_t	timestamp;	/**< time the update was published */
+};
+
+#define ORB_LOG_DATA_LEN	8
+
+#endif /* _UORB_ORB_LOG_H */
@@ -5,7 +5,7 @@
 
 /* Global symbols / flags */
 
-struct global_data_parameter_storage_t global_data_parameter_storage_d =  { /*.counter = 0, .timestamp = 0,*/ .pm = {.size = PARAM_MAX_COUNT,
+struct global_data_parameter_storage_t global_data_parameter_storage_d =  { /*.counter = 0, .timestamp = 0,*/ .generation = 1, .pm = {.size = PARAM_MAX_COUNT,
 			.param_values[PARAM_SYSTEM_ID] = 12,
 			.param_names[PARAM_SYSTEM_ID] = "SYS_ID",
 			.param_needs_write[PARAM_SYSTEM_ID] = false,
@@ -139,6 +139,12 @@ struct global_data_parameter_storage_t {
 	/* Parameters (set by a param_set mavlink message */
 	struct px4_parameter_storage_t pm;
 
+	/*
+	 * Incremented by params_changed() each time values in pm have been
+	 * changed. Starts at 1, so that a reader can use zero for "never read".
+	 */
+	uint32_t generation;
+
 	//*****END: Add your variables here *****
 
 };
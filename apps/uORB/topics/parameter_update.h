@@ -1,5 +1,6 @@
-/*
- *   Copyright (C) 2012 Lorenz Meier. All rights reserved.
+/****************************************************************************
+ *
+ *   Copyright (C) 2012 PX4 Development Team. All rights reserved.
  *
  * Redistribution and use in source and binary forms, with or without
  * modification, are permitted provided that the following conditions
@@ -11,7 +12,7 @@
  *    notice, this list of conditions and the following disclaimer in
  *    the documentation and/or other materials provided with the
  *    distribution.
- * 3. Neither the name of the author or the names of contributors may be
+ * 3. Neither the name PX4 nor the names of its contributors may be
  *    used to endorse or promote products derived from this software
  *    without specific prior written permission.
  *
@@ -27,50 +28,40 @@
  * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
  * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
  * POSSIBILITY OF SUCH DAMAGE.
- */
+ *
+ ****************************************************************************/
 
-/*
- * Driver for the Meas Spec MS5611 barometric pressure sensor
+/**
+ * @file parameter_update.h
+ * Notification that one or more parameters have changed.
  */
 
-#include <sys/ioctl.h>
+#ifndef TOPIC_PARAMETER_UPDATE_H_
+#define TOPIC_PARAMETER_UPDATE_H_
 
-#define _MS5611BASE	0x6A00
-#define MS5611C(_x)	_IOC(_MS5611BASE, _x)
+#include <stdint.h>
+#include "../uORB.h"
 
-/* 
- * Sets the sensor internal sampling rate, and if a buffer
- * has been configured, the rate at which entries will be
- * added to the buffer.
+/**
+ * @addtogroup topics
+ * @{
  */
-#define MS5611_SETRATE		MS5611C(1)
-
-/* set rate (configuration A register */
-#define MS5611_RATE_0_75HZ		(0 << 2) /* 0.75 Hz */
 
-/*
- * Sets the sensor internal range.
+/**
+ * Published by params_changed() whenever a value in the global parameter
+ * storage is changed. Subscribers should re-read the parameters they use
+ * and recompute anything derived from them.
  */
-#define MS5611_SETRANGE		MS5611C(2)
-
-#define MS5611_RANGE_0_88GA			(0 << 5)
+struct parameter_update_s {
+	uint64_t timestamp;		/**< time of the change, in microseconds since system start */
+	uint32_t generation;		/**< global_data_parameter_storage->generation after the change */
+};
 
-/*
- * Sets the address of a shared MS5611_buffer
- * structure that is maintained by the driver.
- *
- * If zero is passed as the address, disables
- * the buffer updating.
+/**
+ * @}
  */
-#define MS5611_SETBUFFER	MS5611C(3)
 
-struct ms5611_buffer {
-	uint32_t	size;		/* number of entries in the samples[] array */
-	uint32_t	next;		/* the next entry that will be populated */
-	struct {
-		uint32_t	pressure;
-		uint16_t temperature;
-	} samples[];
-};
+/* register this as object request broker structure */
+ORB_DECLARE(parameter_update);
 
-extern int	ms5611_attach(struct i2c_dev_s *i2c);
+#endif
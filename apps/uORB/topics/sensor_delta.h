@@ -0,0 +1,76 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2012 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file sensor_delta.h
+ * Integrated gyro and accelerometer increments.
+ */
+
+#ifndef TOPIC_SENSOR_DELTA_H_
+#define TOPIC_SENSOR_DELTA_H_
+
+#include <stdint.h>
+#include "../uORB.h"
+
+/**
+ * @addtogroup topics
+ * @{
+ */
+
+/**
+ * Angle and velocity increments over one integration interval.
+ *
+ * The sensors app integrates every gyro and accelerometer report the
+ * drivers queue, so a consumer running slower than the IMU sees all the
+ * motion in the interval rather than a single sample of it. The increments
+ * are in the px4fmu board frame and include the coning, rotation and
+ * sculling corrections; they can be applied directly as the attitude and
+ * velocity change over the interval.
+ */
+struct sensor_delta_s {
+	uint64_t timestamp;		/**< time of the last gyro sample in the interval */
+	uint32_t dt_us;			/**< length of the integration interval in microseconds */
+	uint16_t gyro_samples;		/**< number of gyro reports integrated */
+	uint16_t accel_samples;		/**< number of accelerometer reports integrated */
+	float delta_angle_rad[3];	/**< coning-corrected rotation vector over the interval */
+	float delta_velocity_m_s[3];	/**< rotation- and sculling-corrected velocity change, in the frame at the start of the interval */
+};
+
+/**
+ * @}
+ */
+
+/* register this as object request broker structure */
+ORB_DECLARE(sensor_delta);
+
+#endif
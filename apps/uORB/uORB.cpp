@@ -50,6 +50,9 @@
 #include <stdio.h>
 #include <math.h>
 #include <unistd.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <time.h>
 
 #include <nuttx/arch.h>
 #include <nuttx/wqueue.h>
@@ -80,14 +83,27 @@ enum Flavor {
 	PARAM
 };
 
+/**
+ * Build the path of a topic node.
+ *
+ * Instance 0 is /obj/<name> so that single-instance users need not know
+ * about instances; further instances are /obj/<name><instance>.
+ */
 int
-node_mkpath(char *buf, Flavor f, const struct orb_metadata *meta)
+node_mkpath(char *buf, Flavor f, const struct orb_metadata *meta, unsigned instance = 0)
 {
 	unsigned len;
 
-	len = snprintf(buf, orb_maxpath, "/%s/%s",
-		       (f == PUBSUB) ? "obj" : "param",
-		       meta->o_name);
+	if (instance == 0) {
+		len = snprintf(buf, orb_maxpath, "/%s/%s",
+			       (f == PUBSUB) ? "obj" : "param",
+			       meta->o_name);
+
+	} else {
+		len = snprintf(buf, orb_maxpath, "/%s/%s%u",
+			       (f == PUBSUB) ? "obj" : "param",
+			       meta->o_name, instance);
+	}
 
 	if (len >= orb_maxpath)
 		return -ENAMETOOLONG;
@@ -97,39 +113,137 @@ node_mkpath(char *buf, Flavor f, const struct orb_metadata *meta)
 
 }
 
+namespace
+{
+
+/**
+ * Argument to ORBIOCSETWAITSET.
+ */
+struct waitset_attach {
+	struct orb_waitset	*ws;
+	unsigned		bit;
+};
+
+void	waitset_signal(struct orb_waitset *ws, unsigned bit);
+
+}
+
 /**
  * Per-object device instance.
  */
 class ORBDevNode : public device::CDev
 {
 public:
-	ORBDevNode(const struct orb_metadata *meta, const char *name, const char *path);
+	ORBDevNode(const struct orb_metadata *meta, unsigned instance, const char *name, const char *path);
 	~ORBDevNode();
 
+	struct SubscriberData {
+		unsigned	generation;	/**< last generation the subscriber has seen */
+		unsigned	update_interval; /**< if nonzero minimum interval between updates */
+		hrt_abstime	update_due;	/**< if update_interval is nonzero, time the next update can be reported */
+		void		*poll_priv;	/**< saved copy of fds->f_priv while poll is active */
+		bool		update_reported; /**< true if we have reported the update via poll/check */
+		unsigned	overruns;	/**< updates discarded because the queue wrapped before they were read */
+		unsigned	rate_limited;	/**< updates skipped because of update_interval */
+		hrt_abstime	max_latency;	/**< longest time from publication to the copy that collected it */
+		pid_t		pid;		/**< task that made the subscription */
+		SubscriberData	*next;		/**< next subscriber to the same node */
+		struct orb_waitset *waitset;	/**< wait set the subscription is a member of, or nullptr */
+		unsigned	waitset_bit;	/**< the subscription's bit in the wait set */
+		SubscriberData	*waitset_next;	/**< next subscriber to the same node in a wait set */
+	};
+
 	virtual int		open(struct file *filp);
 	virtual int		close(struct file *filp);
 	virtual ssize_t		read(struct file *filp, char *buffer, size_t buflen);
 	virtual ssize_t		write(struct file *filp, const char *buffer, size_t buflen);
 	virtual int		ioctl(struct file *filp, int cmd, unsigned long arg);
 
+	/**
+	 * Set up the state for a new subscriber.
+	 *
+	 * Used by open() and by direct subscriptions that do not have a file.
+	 *
+	 * @param sd		The subscriber state to initialise.
+	 */
+	void			subscriber_init(SubscriberData *sd);
+
+	/**
+	 * Tear down the state of a subscriber that is going away.
+	 *
+	 * @param sd		The subscriber state to release.
+	 */
+	void			subscriber_fini(SubscriberData *sd);
+
+	/**
+	 * Copy the next update for a subscriber.
+	 *
+	 * @param sd		The subscriber for whom to copy.
+	 * @param buffer	Buffer of _meta->o_size bytes, or nullptr to mark
+	 *			the update as seen without copying it.
+	 * @param time		If not nullptr, returns the time at which the
+	 *			copied update was published.
+	 * @return		The number of bytes copied, or zero if the object
+	 *			has not been published yet.
+	 */
+	ssize_t			copy(SubscriberData *sd, char *buffer, hrt_abstime *time = nullptr);
+
+	/**
+	 * Make a subscriber a member of a wait set.
+	 *
+	 * @param sd		The subscriber.
+	 * @param ws		The wait set, or nullptr to remove the subscriber
+	 *			from the wait set it is in.
+	 * @param bit		The subscriber's bit in the wait set.
+	 */
+	void			waitset_attach(SubscriberData *sd, struct orb_waitset *ws, unsigned bit);
+
+	/**
+	 * Check whether a topic appears updated to a subscriber.
+	 *
+	 * @param sd		The subscriber for whom to check.
+	 * @return		True if the topic should appear updated to the subscriber
+	 */
+	bool			appears_updated(SubscriberData *sd);
+
+	const struct orb_metadata *meta() { return _meta; }
+	unsigned		instance() { return _instance; }
+	const char		*path() { return _path; }
+	hrt_abstime		last_update() { return _last_update; }
+
+	/**
+	 * Print the topic statistics and those of each subscriber.
+	 *
+	 * @param now		The current time.
+	 */
+	void			print_stats(hrt_abstime now);
+
 protected:
 	virtual pollevent_t	poll_state(struct file *filp);
+	virtual void		poll_notify(pollevent_t events);
 	virtual void		poll_notify_one(struct pollfd *fds, pollevent_t events);
 
 private:
-	struct SubscriberData {
-		unsigned	generation;	/**< last generation the subscriber has seen */
-		unsigned	update_interval; /**< if nonzero minimum interval between updates */
-		struct hrt_call	update_call;	/**< deferred wakeup call if update_period is nonzero */
-		void		*poll_priv;	/**< saved copy of fds->f_priv while poll is active */
-		bool		update_reported; /**< true if we have reported the update via poll/check */
-	};
+	friend class ORBDevMaster;
 
 	const struct orb_metadata *_meta;	/**< object metadata information */
-	uint8_t			*_data;		/**< allocated object buffer */
+	unsigned		_instance;	/**< instance of the topic this node carries */
+	const char		*_path;		/**< path of the device node */
+	ORBDevNode		*_hash_next;	/**< next node in the same topic registry bucket */
+	uint8_t			*_data;		/**< allocated object buffer, _queue_size + 1 slots of slot_size() bytes */
+	uint8_t			*_retired_data;	/**< previous object buffer, kept while it may still be in use */
+	volatile unsigned	_copies;	/**< copies in progress from a buffer snapshot */
+	unsigned		_queue_size;	/**< number of updates buffered for subscribers */
+	unsigned		_queue_fill;	/**< number of buffered updates that are valid */
 	hrt_abstime		_last_update;	/**< time the object was last updated */
 	volatile unsigned 	_generation;	/**< object generation count */
+	volatile unsigned	_write_generation; /**< number of writes started, at most _generation + 1 */
+	uint8_t			*_loan;		/**< slot handed out by publish_begin, or nullptr */
 	pid_t			_publisher;	/**< if nonzero, current publisher */
+	unsigned		_publish_interval; /**< smoothed interval between updates in microseconds */
+	SubscriberData		*_subscribers;	/**< all subscribers, for statistics */
+	SubscriberData		*_waiters;	/**< subscribers that are members of a wait set */
+	struct hrt_call		_update_call;	/**< deferred wakeup shared by all rate-limited subscribers */
 
 	SubscriberData		*filp_to_sd(struct file *filp) {
 		SubscriberData *sd = (SubscriberData *)(filp->f_priv);
@@ -137,7 +251,80 @@ private:
 	}
 
 	/**
-	 * Perform a deferred update for a rate-limited subscriber.
+	 * Return a pointer to the buffer slot holding a given generation.
+	 *
+	 * Generation N is the update that advanced _generation from N to N + 1.
+	 * The buffer has one slot more than the queue holds, so the slot being
+	 * written never holds an update a subscriber may be copying.
+	 */
+	uint8_t			*slot(uint8_t *data, unsigned queue_size, unsigned generation) {
+		return data + (generation % (queue_size + 1)) * slot_size();
+	}
+
+	/**
+	 * Return the size of a buffer slot; the update, padded to eight bytes,
+	 * followed by the time it was published.
+	 */
+	size_t			slot_size() {
+		return ((_meta->o_size + 7) & ~7) + sizeof(hrt_abstime);
+	}
+
+	/**
+	 * Return a pointer to the publication time stored in a buffer slot.
+	 */
+	hrt_abstime		*slot_time(uint8_t *slot) {
+		return (hrt_abstime *)(slot + ((_meta->o_size + 7) & ~7));
+	}
+
+	/**
+	 * Change the number of updates buffered for subscribers.
+	 *
+	 * Updates that are still buffered and fit in the new queue are retained.
+	 * Must be called from thread context.
+	 *
+	 * The old buffer is freed at once if no copy or loan can be using it,
+	 * otherwise it is retired until a later resize finds it idle. Only one
+	 * buffer is ever retired; a resize that would need a second fails.
+	 *
+	 * @param queue_size	The new number of slots, at least 1.
+	 * @return		OK on success, -EBUSY if the buffers are still in
+	 *			use by a copy or a loan, -errno otherwise.
+	 */
+	int			update_queue_size(unsigned queue_size);
+
+	/**
+	 * Hand the publisher the slot the next update goes into.
+	 *
+	 * Subscribers cannot see the slot until publish_commit is called, so it
+	 * can be filled in place with interrupts enabled. Its contents are stale
+	 * and must be overwritten completely.
+	 *
+	 * @return		The slot, or nullptr if the object is not allocated
+	 *			or a slot is already on loan.
+	 */
+	uint8_t			*publish_begin();
+
+	/**
+	 * Publish the update placed in the slot returned by publish_begin.
+	 *
+	 * @return		OK on success, -EINVAL if there is no slot on loan.
+	 */
+	int			publish_commit();
+
+	/**
+	 * Make sure a deferred update happens no later than one bucket after a
+	 * rate-limited subscriber's interval expires.
+	 *
+	 * Deadlines are rounded up to a bucket boundary so that the wakeups of
+	 * subscribers with similar intervals share one callout. Must be called
+	 * with interrupts disabled.
+	 *
+	 * @param due		Time at which the subscriber's interval expires.
+	 */
+	void			schedule_deferred(hrt_abstime due);
+
+	/**
+	 * Perform a deferred update for rate-limited subscribers.
 	 */
 	void			update_deferred();
 
@@ -147,32 +334,80 @@ private:
 	 * void *arg		ORBDevNode pointer for which the deferred update is performed.
 	 */
 	static void		update_deferred_trampoline(void *arg);
+};
 
-	/**
-	 * Check whether a topic appears updated to a subscriber.
-	 *
-	 * @param sd		The subscriber for whom to check.
-	 * @return		True if the topic should appear updated to the subscriber
-	 */
-	bool			appears_updated(SubscriberData *sd);
+/**
+ * A set of subscriptions that a thread waits on together.
+ *
+ * Members are held by node and subscriber state rather than by file
+ * handle, and a subscription that is closed clears its member slot, so
+ * the set never refers to a handle that has been closed and reused.
+ */
+struct orb_waitset {
+	sem_t			sem;		/**< posted when ready goes from zero to nonzero */
+	volatile uint32_t	ready;		/**< members that have updated since the last wait */
+	unsigned		count;		/**< number of member slots used */
+	struct {
+		ORBDevNode	*node;		/**< node of the subscribed topic */
+		ORBDevNode::SubscriberData *sd;	/**< subscriber state, or nullptr once unsubscribed */
+	} members[ORB_WAITSET_MAX];
 };
 
-ORBDevNode::ORBDevNode(const struct orb_metadata *meta, const char *name, const char *path) :
+namespace
+{
+
+/**
+ * Flag a wait set member as ready and wake the waiter.
+ *
+ * Must be called with interrupts disabled.
+ */
+void
+waitset_signal(struct orb_waitset *ws, unsigned bit)
+{
+	/* only the transition from nothing ready needs a wakeup */
+	if (ws->ready == 0)
+		sem_post(&ws->sem);
+
+	ws->ready |= (1 << bit);
+}
+
+}
+
+ORBDevNode::ORBDevNode(const struct orb_metadata *meta, unsigned instance, const char *name, const char *path) :
 	CDev(name, path),
 	_meta(meta),
+	_instance(instance),
+	_path(path),
+	_hash_next(nullptr),
 	_data(nullptr),
+	_retired_data(nullptr),
+	_copies(0),
+	_queue_size(1),
+	_queue_fill(0),
 	_last_update(0),
 	_generation(0),
-	_publisher(0)
+	_write_generation(0),
+	_loan(nullptr),
+	_publisher(0),
+	_publish_interval(0),
+	_subscribers(nullptr),
+	_waiters(nullptr)
 {
 	// enable debug() calls
 	_debug_enabled = true;
+
+	memset(&_update_call, 0, sizeof(_update_call));
 }
 
 ORBDevNode::~ORBDevNode()
 {
+	hrt_cancel(&_update_call);
+
 	if (_data != nullptr)
 		delete[] _data;
+
+	if (_retired_data != nullptr)
+		delete[] _retired_data;
 }
 
 int
@@ -217,17 +452,16 @@ ORBDevNode::open(struct file *filp)
 		if (nullptr == sd)
 			return -ENOMEM;
 
-		memset(sd, 0, sizeof(*sd));
-
-		/* default to no pending update */
-		sd->generation = _generation;
+		subscriber_init(sd);
 
 		filp->f_priv = (void *)sd;
 
 		ret = CDev::open(filp);
 
-		if (ret != OK)
-			free(sd);
+		if (ret != OK) {
+			subscriber_fini(sd);
+			delete sd;
+		}
 
 		return ret;
 	}
@@ -239,25 +473,63 @@ ORBDevNode::open(struct file *filp)
 int
 ORBDevNode::close(struct file *filp)
 {
-	/* is this the publisher closing? */
-	if (getpid() == _publisher) {
+	/*
+	 * Is this the publisher closing? Go by how the file was opened; the
+	 * publishing task may hold subscriptions to the same topic.
+	 */
+	if (filp->f_oflags == O_WRONLY) {
 		_publisher = 0;
 
+		/* abandon any update that was never committed */
+		_loan = nullptr;
+
 	} else {
 		SubscriberData *sd = filp_to_sd(filp);
 
-		if (sd != nullptr)
+		if (sd != nullptr) {
+			subscriber_fini(sd);
 			delete sd;
+		}
 	}
 
 	return CDev::close(filp);
 }
 
+void
+ORBDevNode::subscriber_init(SubscriberData *sd)
+{
+	memset(sd, 0, sizeof(*sd));
+
+	/* default to no pending update */
+	sd->generation = _generation;
+	sd->pid = getpid();
+
+	lock();
+	sd->next = _subscribers;
+	_subscribers = sd;
+	unlock();
+}
+
+void
+ORBDevNode::subscriber_fini(SubscriberData *sd)
+{
+	waitset_attach(sd, nullptr, 0);
+
+	lock();
+
+	for (SubscriberData **sdp = &_subscribers; *sdp != nullptr; sdp = &(*sdp)->next) {
+		if (*sdp == sd) {
+			*sdp = sd->next;
+			break;
+		}
+	}
+
+	unlock();
+}
+
 ssize_t
 ORBDevNode::read(struct file *filp, char *buffer, size_t buflen)
 {
-	SubscriberData *sd = (SubscriberData *)filp_to_sd(filp);
-
 	/* if the object has not been written yet, return zero */
 	if (_data == nullptr)
 		return 0;
@@ -266,25 +538,107 @@ ORBDevNode::read(struct file *filp, char *buffer, size_t buflen)
 	if (buflen != _meta->o_size)
 		return -EIO;
 
+	return copy(filp_to_sd(filp), buffer);
+}
+
+ssize_t
+ORBDevNode::copy(SubscriberData *sd, char *buffer, hrt_abstime *time)
+{
+	/* if the object has not been written yet, return zero */
+	if (_data == nullptr)
+		return 0;
+
 	/*
-	 * Perform an atomic copy & state update
+	 * Copy the update optimistically with interrupts enabled, and only
+	 * lock out interrupts to pick the update and to commit the state
+	 * change. If a writer lapped the ring while we were copying, the
+	 * slot may have been overwritten and we go round again.
 	 */
-	irqstate_t flags = irqsave();
+	for (;;) {
+		irqstate_t flags = irqsave();
 
-	/* if the caller doesn't want the data, don't give it to them */
-	if (nullptr != buffer)
-		memcpy(buffer, _data, _meta->o_size);
+		/*
+		 * If the subscriber has fallen further behind than the queue can
+		 * hold, skip the updates that have been overwritten and count them.
+		 * A rate-limited subscriber skips updates by design.
+		 */
+		if ((_generation - sd->generation) > _queue_fill) {
+			unsigned skipped = (_generation - sd->generation) - _queue_fill;
 
-	/* track the last generation that the file has seen */
-	sd->generation = _generation;
+			if (sd->update_interval != 0) {
+				sd->rate_limited += skipped;
 
-	/*
-	 * Clear the flag that indicates that an update has been reported, as
-	 * we have just collected it.
-	 */
-	sd->update_reported = false;
+			} else {
+				sd->overruns += skipped;
+			}
 
-	irqrestore(flags);
+			sd->generation = _generation - _queue_fill;
+		}
+
+		/*
+		 * Hand out the oldest unread update; if there is none, repeat the
+		 * most recent one.
+		 */
+		unsigned generation = (sd->generation == _generation) ? (_generation - 1) : sd->generation;
+		uint8_t *data = _data;
+		unsigned queue_size = _queue_size;
+
+		/* hold off the freeing of this buffer by a resize until we are done */
+		_copies++;
+
+		irqrestore(flags);
+
+		/* if the caller doesn't want the data, don't give it to them */
+		if (nullptr != buffer)
+			memcpy(buffer, slot(data, queue_size, generation), _meta->o_size);
+
+		/* the time is checked along with the data, so the two always match */
+		hrt_abstime published = *slot_time(slot(data, queue_size, generation));
+
+		hrt_abstime now = hrt_absolute_time();
+
+		flags = irqsave();
+
+		_copies--;
+
+		/*
+		 * The slot is reused by generation + queue_size + 1; if that write has
+		 * not started, and the buffer was not resized, the copy is intact.
+		 */
+		if ((data == _data) && ((_write_generation - generation) <= (queue_size + 1))) {
+
+			/*
+			 * If this collected the newest update, note how long it was
+			 * waiting; we only know when the newest update was published.
+			 */
+			if ((sd->generation == generation) &&
+			    (generation + 1 == _generation) &&
+			    (now > _last_update) &&
+			    ((now - _last_update) > sd->max_latency))
+				sd->max_latency = now - _last_update;
+
+			/* track the last generation that the file has seen */
+			sd->generation = generation + 1;
+
+			if (time != nullptr)
+				*time = published;
+
+			/*
+			 * Clear the flag that indicates that an update has been reported, as
+			 * we have just collected it.
+			 */
+			sd->update_reported = false;
+
+			/* a wait set has to hear about updates still queued behind this one */
+			if ((sd->waitset != nullptr) && (sd->update_interval == 0) && (sd->generation != _generation))
+				waitset_signal(sd->waitset, sd->waitset_bit);
+
+			irqrestore(flags);
+			break;
+		}
+
+		irqrestore(flags);
+	}
 
 	return _meta->o_size;
 }
@@ -292,6 +646,10 @@ ORBDevNode::read(struct file *filp, char *buffer, size_t buflen)
 ssize_t
 ORBDevNode::write(struct file *filp, const char *buffer, size_t buflen)
 {
+	/* If write size does not match, that is an error */
+	if (_meta->o_size != buflen)
+		return -EIO;
+
 	/*
 	 * Writes are legal from interrupt context as long as the
 	 * object has already been initialised from thread context.
@@ -306,7 +664,7 @@ ORBDevNode::write(struct file *filp, const char *buffer, size_t buflen)
 
 			/* re-check size */
 			if (nullptr == _data)
-				_data = new uint8_t[_meta->o_size];
+				_data = new uint8_t[(_queue_size + 1) * slot_size()];
 
 			unlock();
 		}
@@ -316,23 +674,91 @@ ORBDevNode::write(struct file *filp, const char *buffer, size_t buflen)
 			return -ENOMEM;
 	}
 
-	/* If write size does not match, that is an error */
-	if (_meta->o_size != buflen)
-		return -EIO;
+	/*
+	 * Copy into the free slot with interrupts enabled; subscribers never
+	 * read it until the generation count says it is there.
+	 */
+	uint8_t *data = publish_begin();
+
+	if (data == nullptr)
+		return -EBUSY;
+
+	memcpy(data, buffer, _meta->o_size);
+	publish_commit();
 
-	/* Perform an atomic copy. */
+	return _meta->o_size;
+}
+
+uint8_t *
+ORBDevNode::publish_begin()
+{
+	uint8_t *data = nullptr;
+
+	/*
+	 * There is only one publisher, so the only things we can race are a
+	 * loan that is still outstanding and a resize of the queue.
+	 */
 	irqstate_t flags = irqsave();
-	memcpy(_data, buffer, _meta->o_size);
+
+	if ((_data != nullptr) && (_loan == nullptr)) {
+		data = _loan = slot(_data, _queue_size, _generation);
+		_write_generation = _generation + 1;
+	}
+
 	irqrestore(flags);
 
+	return data;
+}
+
+int
+ORBDevNode::publish_commit()
+{
+	irqstate_t flags = irqsave();
+
+	if (_loan == nullptr) {
+		irqrestore(flags);
+		return -EINVAL;
+	}
+
+	/*
+	 * If the queue was resized while the slot was on loan, the update was
+	 * written to the retired buffer; move it across.
+	 */
+	uint8_t *data = slot(_data, _queue_size, _generation);
+
+	if (data != _loan)
+		memcpy(data, _loan, _meta->o_size);
+
+	_loan = nullptr;
+
+	if (_queue_fill < _queue_size)
+		_queue_fill++;
+
 	/* update the timestamp and generation count */
-	_last_update = hrt_absolute_time();
+	hrt_abstime now = hrt_absolute_time();
+
+	if (_generation > 0) {
+		/* clamp so that a long pause cannot overflow the filter */
+		unsigned interval = ((now - _last_update) < 10000000) ? (now - _last_update) : 10000000;
+
+		if (_publish_interval == 0) {
+			_publish_interval = interval;
+
+		} else {
+			_publish_interval = (_publish_interval * 7 + interval) / 8;
+		}
+	}
+
+	*slot_time(data) = now;
+	_last_update = now;
 	_generation++;
 
+	irqrestore(flags);
+
 	/* notify any poll waiters */
 	poll_notify(POLLIN);
 
-	return _meta->o_size;
+	return OK;
 }
 
 int
@@ -353,30 +779,199 @@ ORBDevNode::ioctl(struct file *filp, int cmd, unsigned long arg)
 		sd->update_interval = arg;
 		return OK;
 
+	case ORBIOCSETQUEUESIZE:
+		return update_queue_size(arg);
+
+	case ORBIOCGETOVERRUNS:
+		if (sd == nullptr)
+			return -EBADF;
+
+		*(unsigned *)arg = sd->overruns;
+		return OK;
+
+	case ORBIOCPUBLISHBEGIN:
+		if (filp->f_oflags != O_WRONLY)
+			return -EBADF;
+
+		*(void **)arg = publish_begin();
+		return (*(void **)arg != nullptr) ? OK : -EBUSY;
+
+	case ORBIOCPUBLISHCOMMIT:
+		if (filp->f_oflags != O_WRONLY)
+			return -EBADF;
+
+		return publish_commit();
+
+	case ORBIOCSETWAITSET:
+		if (sd == nullptr)
+			return -EBADF;
+
+		if (arg == 0) {
+			waitset_attach(sd, nullptr, 0);
+
+		} else {
+			struct waitset_attach *wa = (struct waitset_attach *)arg;
+			waitset_attach(sd, wa->ws, wa->bit);
+		}
+
+		return OK;
+
 	default:
 		/* give it to the superclass */
 		return CDev::ioctl(filp, cmd, arg);
 	}
 }
 
-pollevent_t
-ORBDevNode::poll_state(struct file *filp)
+int
+ORBDevNode::update_queue_size(unsigned queue_size)
 {
-	SubscriberData *sd = filp_to_sd(filp);
+	/* lower bound is mandatory, upper bound is a sanity check */
+	if ((queue_size < 1) || (queue_size > ORB_MAX_QUEUE_SIZE))
+		return -EINVAL;
 
-	/*
-	 * If the topic appears updated to the subscriber, say so.
-	 */
-	if (appears_updated(sd))
-		return POLLIN;
+	lock();
 
-	return 0;
-}
+	/* nothing has been published yet, the buffer will be allocated on first write */
+	if (_data == nullptr) {
+		_queue_size = queue_size;
+		unlock();
+		return OK;
+	}
+
+	if (queue_size == _queue_size) {
+		unlock();
+		return OK;
+	}
+
+	uint8_t *buf = new uint8_t[(queue_size + 1) * slot_size()];
+
+	if (buf == nullptr) {
+		unlock();
+		return -ENOMEM;
+	}
+
+	/*
+	 * Move the newest updates across, each to the slot its generation maps
+	 * to in the new queue, and swap the buffers.
+	 */
+	irqstate_t flags = irqsave();
+
+	unsigned fill = (_queue_fill < queue_size) ? _queue_fill : queue_size;
+
+	for (unsigned generation = _generation - fill; generation != _generation; generation++)
+		memcpy(slot(buf, queue_size, generation), slot(_data, _queue_size, generation), slot_size());
+
+	/*
+	 * A reader may still be copying from the old buffer, or the publisher
+	 * filling a slot in it; both notice the swap, but the memory must stay
+	 * valid until then. Every copy and loan holds the buffer it started
+	 * with, so with none in progress nothing can reference an old buffer.
+	 */
+	uint8_t *free_data = nullptr;
+	uint8_t *free_retired = nullptr;
+
+	if ((_copies == 0) && (_loan == nullptr)) {
+		free_data = _data;
+		free_retired = _retired_data;
+		_retired_data = nullptr;
+
+	} else if (_retired_data == nullptr) {
+		_retired_data = _data;
+
+	} else {
+		/* the buffer retired last time may still be in use, and so may this one */
+		irqrestore(flags);
+		unlock();
+		delete[] buf;
+		return -EBUSY;
+	}
+
+	_data = buf;
+	_queue_size = queue_size;
+	_queue_fill = fill;
+
+	irqrestore(flags);
+
+	if (free_data != nullptr)
+		delete[] free_data;
+
+	if (free_retired != nullptr)
+		delete[] free_retired;
+
+	unlock();
+
+	return OK;
+}
+
+void
+ORBDevNode::waitset_attach(SubscriberData *sd, struct orb_waitset *ws, unsigned bit)
+{
+	irqstate_t flags = irqsave();
+
+	if (sd->waitset != nullptr) {
+		for (SubscriberData **sdp = &_waiters; *sdp != nullptr; sdp = &(*sdp)->waitset_next) {
+			if (*sdp == sd) {
+				*sdp = sd->waitset_next;
+				break;
+			}
+		}
+
+		/* the wait set must not reach this subscriber again */
+		sd->waitset->members[sd->waitset_bit].sd = nullptr;
+	}
+
+	sd->waitset = ws;
+	sd->waitset_bit = bit;
+
+	if (ws != nullptr) {
+		ws->members[bit].node = this;
+		ws->members[bit].sd = sd;
+
+		sd->waitset_next = _waiters;
+		_waiters = sd;
+
+		/* an update that is already pending counts */
+		if (appears_updated(sd))
+			waitset_signal(ws, bit);
+	}
+
+	irqrestore(flags);
+}
+
+pollevent_t
+ORBDevNode::poll_state(struct file *filp)
+{
+	SubscriberData *sd = filp_to_sd(filp);
+
+	/*
+	 * If the topic appears updated to the subscriber, say so.
+	 */
+	if (appears_updated(sd))
+		return POLLIN;
+
+	return 0;
+}
+
+void
+ORBDevNode::poll_notify(pollevent_t events)
+{
+	CDev::poll_notify(events);
+
+	/* wake wait sets for which the topic now looks updated */
+	irqstate_t flags = irqsave();
+
+	for (SubscriberData *sd = _waiters; sd != nullptr; sd = sd->waitset_next) {
+		if (appears_updated(sd))
+			waitset_signal(sd->waitset, sd->waitset_bit);
+	}
+
+	irqrestore(flags);
+}
 
 void
 ORBDevNode::poll_notify_one(struct pollfd *fds, pollevent_t events)
 {
-	SubscriberData *sd = filp_to_sd((struct file *)fds->priv);
+	SubscriberData *sd = filp_to_sd(poll_file(fds));
 
 	/*
 	 * If the topic looks updated to the subscriber, go ahead and notify them.
@@ -422,24 +1017,26 @@ ORBDevNode::appears_updated(SubscriberData *sd)
 		}
 
 		/*
-		 * If the interval timer is still running, the topic should not
+		 * If the interval is still running, the topic should not
 		 * appear updated, even though at this point we know that it has.
 		 * We have previously been through here, so the subscriber
 		 * must have collected the update we reported, otherwise
 		 * update_reported would still be true.
+		 *
+		 * Arrange to come back and notify when the interval expires.
 		 */
-		if (!hrt_called(&sd->update_call))
+		hrt_abstime now = hrt_absolute_time();
+
+		if (now < sd->update_due) {
+			schedule_deferred(sd->update_due);
 			break;
+		}
 
 		/*
 		 * Make sure that we don't consider the topic to be updated again
-		 * until the interval has passed once more by restarting the interval
-		 * timer and thereby re-scheduling a poll notification at that time.
+		 * until the interval has passed once more.
 		 */
-		hrt_call_after(&sd->update_call,
-			       sd->update_interval,
-			       &ORBDevNode::update_deferred_trampoline,
-			       (void *)this);
+		sd->update_due = now + sd->update_interval;
 
 		/*
 		 * Remember that we have told the subscriber that there is data.
@@ -456,12 +1053,25 @@ ORBDevNode::appears_updated(SubscriberData *sd)
 	return ret;
 }
 
+void
+ORBDevNode::schedule_deferred(hrt_abstime due)
+{
+	static const hrt_abstime bucket = 1000;	/**< microseconds */
+
+	due = ((due + bucket - 1) / bucket) * bucket;
+
+	/* one callout serves every subscriber due at or after it */
+	if (hrt_called(&_update_call) || (_update_call.deadline > due))
+		hrt_call_at(&_update_call, due, &ORBDevNode::update_deferred_trampoline, (void *)this);
+}
+
 void
 ORBDevNode::update_deferred()
 {
 	/*
 	 * Instigate a poll notification; any subscribers whose intervals have
-	 * expired will be woken.
+	 * expired will be woken, and those still waiting will schedule the
+	 * next deferred update.
 	 */
 	poll_notify(POLLIN);
 }
@@ -474,6 +1084,34 @@ ORBDevNode::update_deferred_trampoline(void *arg)
 	node->update_deferred();
 }
 
+void
+ORBDevNode::print_stats(hrt_abstime now)
+{
+	/*
+	 * The smoothed interval does not move once the publisher stops, so
+	 * let the time since the last update take over when it is longer.
+	 */
+	unsigned interval = _publish_interval;
+
+	if ((_generation > 1) && ((now - _last_update) > interval))
+		interval = ((now - _last_update) < 10000000) ? (now - _last_update) : 10000000;
+
+	unsigned rate = (interval > 0) ? (10000000 / interval) : 0;
+
+	printf("\033[K%-24s %5u %5u %10u %5u.%u\n",
+	       strrchr(_path, '/') + 1, (unsigned)_meta->o_size, _queue_size, _generation, rate / 10, rate % 10);
+
+	lock();
+
+	for (SubscriberData *sd = _subscribers; sd != nullptr; sd = sd->next) {
+		printf("\033[K    pid %-5d lag %-5u lost %-8u limited %-8u max latency %u us\n",
+		       (int)sd->pid, _generation - sd->generation, sd->overruns, sd->rate_limited,
+		       (unsigned)sd->max_latency);
+	}
+
+	unlock();
+}
+
 /**
  * Master control device for ObjDev.
  *
@@ -487,8 +1125,61 @@ public:
 	~ORBDevMaster();
 
 	virtual int		ioctl(struct file *filp, int cmd, unsigned long arg);
+
+	/**
+	 * Find the node for an instance of a topic.
+	 *
+	 * May be called from any context.
+	 *
+	 * @param meta		The topic metadata.
+	 * @param instance	The topic instance.
+	 * @return		The node, or nullptr if the instance has not been
+	 *			advertised or subscribed yet.
+	 */
+	ORBDevNode		*node_find(const struct orb_metadata *meta, unsigned instance);
+
+	/**
+	 * Find the node for a topic by name.
+	 *
+	 * @param name		The topic name.
+	 * @return		A node for the topic, or nullptr if no topic of
+	 *			that name has been advertised or subscribed yet.
+	 */
+	ORBDevNode		*node_find_name(const char *name);
+
+	/**
+	 * Create the node for an instance of a topic.
+	 *
+	 * @param meta		The topic metadata.
+	 * @param instance	The topic instance, less than ORB_MULTI_MAX_INSTANCES.
+	 * @param node		If not nullptr, returns the node on success or
+	 *			if it already existed.
+	 * @return		OK on success, -EEXIST if the node already
+	 *			existed, -errno otherwise.
+	 */
+	int			node_create(const struct orb_metadata *meta, unsigned instance, ORBDevNode **node);
+
+	/**
+	 * Print the statistics of every topic.
+	 */
+	void			print_stats();
+
 private:
+	static const unsigned	_buckets = 32;
+
 	Flavor			_flavor;
+
+	/**
+	 * Topic registry, hashed on the metadata pointer and instance.
+	 *
+	 * Nodes are only ever added, at the head of a chain, so a lookup
+	 * sees either the old or the new chain.
+	 */
+	ORBDevNode		* volatile _nodes[_buckets];
+
+	unsigned		bucket(const struct orb_metadata *meta, unsigned instance) {
+		return ((uintptr_t)meta / sizeof(struct orb_metadata) + instance) % _buckets;
+	}
 };
 
 ORBDevMaster::ORBDevMaster(Flavor f) :
@@ -499,6 +1190,8 @@ ORBDevMaster::ORBDevMaster(Flavor f) :
 	// enable debug() calls
 	_debug_enabled = true;
 
+	for (unsigned i = 0; i < _buckets; i++)
+		_nodes[i] = nullptr;
 }
 
 ORBDevMaster::~ORBDevMaster()
@@ -508,53 +1201,129 @@ ORBDevMaster::~ORBDevMaster()
 int
 ORBDevMaster::ioctl(struct file *filp, int cmd, unsigned long arg)
 {
+	switch (cmd) {
+	case ORBIOCADVERTISE:
+		return node_create((const struct orb_metadata *)arg, 0, nullptr);
+
+	default:
+		/* give it to the superclass */
+		return CDev::ioctl(filp, cmd, arg);
+	}
+}
+
+ORBDevNode *
+ORBDevMaster::node_find(const struct orb_metadata *meta, unsigned instance)
+{
+	ORBDevNode *node = _nodes[bucket(meta, instance)];
+
+	while ((node != nullptr) && ((node->_meta != meta) || (node->_instance != instance)))
+		node = node->_hash_next;
+
+	return node;
+}
+
+void
+ORBDevMaster::print_stats()
+{
+	hrt_abstime now = hrt_absolute_time();
+
+	printf("\033[K%-24s %5s %5s %10s %7s\n", "TOPIC", "SIZE", "QUEUE", "UPDATES", "RATE Hz");
+
+	for (unsigned b = 0; b < _buckets; b++) {
+		for (ORBDevNode *node = _nodes[b]; node != nullptr; node = node->_hash_next)
+			node->print_stats(now);
+	}
+}
+
+ORBDevNode *
+ORBDevMaster::node_find_name(const char *name)
+{
+	for (unsigned b = 0; b < _buckets; b++) {
+		for (ORBDevNode *node = _nodes[b]; node != nullptr; node = node->_hash_next) {
+			if (!strcmp(node->_meta->o_name, name))
+				return node;
+		}
+	}
+
+	return nullptr;
+}
+
+int
+ORBDevMaster::node_create(const struct orb_metadata *meta, unsigned instance, ORBDevNode **pnode)
+{
+	char nodepath[orb_maxpath];
+	char *path;
+	ORBDevNode *node;
 	int ret;
 
-	switch (cmd) {
-	case ORBIOCADVERTISE: {
-			const struct orb_metadata *meta = (const struct orb_metadata *)arg;
-			const char *objname;
-			char nodepath[orb_maxpath];
-			ORBDevNode *node;
+	if (instance >= ORB_MULTI_MAX_INSTANCES)
+		return -EINVAL;
 
-			/* construct a path to the node - this also checks the node name */
-			ret = node_mkpath(nodepath, _flavor, meta);
+	/* serialise creators so that only one of them makes the node */
+	lock();
 
-			if (ret != OK)
-				return ret;
+	node = node_find(meta, instance);
 
-			/* driver wants a permanent copy of the node name, so make one here */
-			objname = strdup(meta->o_name);
+	if (node != nullptr) {
+		ret = -EEXIST;
+		goto out;
+	}
 
-			if (objname == nullptr)
-				return -ENOMEM;
+	/* construct a path to the node - this also checks the node name */
+	ret = node_mkpath(nodepath, _flavor, meta, instance);
 
-			/* construct the new node */
-			node = new ORBDevNode(meta, objname, nodepath);
+	if (ret != OK)
+		goto out;
 
-			/* initialise the node - this may fail if e.g. a node with this name already exists */
-			if (node != nullptr)
-				ret = node->init();
+	/*
+	 * The driver wants permanent copies of the node name and path; the name
+	 * is the last component of the path, so one copy serves for both.
+	 */
+	path = strdup(nodepath);
 
-			/* if we didn't get a device, that's bad */
-			if (node == nullptr)
-				return -ENOMEM;
+	if (path == nullptr) {
+		ret = -ENOMEM;
+		goto out;
+	}
 
-			/* if init failed, discard the node and its name */
-			if (ret != OK) {
-				delete node;
-				free((void *)objname);
-			}
+	/* construct the new node */
+	node = new ORBDevNode(meta, instance, strrchr(path, '/') + 1, path);
 
-			return ret;
-		}
+	/* if we didn't get a device, that's bad */
+	if (node == nullptr) {
+		free(path);
+		ret = -ENOMEM;
+		goto out;
+	}
 
-	default:
-		/* give it to the superclass */
-		return CDev::ioctl(filp, cmd, arg);
+	/* initialise the node - this may fail if e.g. a node with this name already exists */
+	ret = node->init();
+
+	/* if init failed, discard the node and its path */
+	if (ret != OK) {
+		delete node;
+		free(path);
+		node = nullptr;
+		goto out;
 	}
-}
 
+	/* make it visible to lookups, which may run in interrupt context */
+	{
+		irqstate_t flags = irqsave();
+		unsigned b = bucket(meta, instance);
+		node->_hash_next = _nodes[b];
+		_nodes[b] = node;
+		irqrestore(flags);
+	}
+
+out:
+	unlock();
+
+	if ((pnode != nullptr) && (node != nullptr))
+		*pnode = node;
+
+	return ret;
+}
 
 /**
  * Local functions in support of the shell command.
@@ -570,6 +1339,15 @@ struct orb_test {
 };
 
 ORB_DEFINE(orb_test, struct orb_test);
+ORB_DEFINE(orb_test_queue, struct orb_test);
+ORB_DEFINE(orb_test_multi, struct orb_test);
+
+struct orb_test_large {
+	unsigned val;
+	unsigned fill[63];
+};
+
+ORB_DEFINE(orb_test_large, struct orb_test_large);
 
 int
 test_fail(const char *fmt, ...)
@@ -601,6 +1379,151 @@ test_note(const char *fmt, ...)
 
 ORB_DECLARE(sensor_combined);
 
+static const unsigned	stress_readers = 3;
+static const hrt_abstime stress_duration = 2000000;	/**< microseconds */
+
+volatile bool		stress_done;
+volatile unsigned	stress_torn;
+volatile unsigned	stress_reordered;
+
+/**
+ * Copy the large test topic as fast as possible, checking that every copy
+ * is a single, complete update and that updates never go backwards.
+ *
+ * @param arg		Pointer to an unsigned that receives the copy count.
+ */
+void *
+stress_reader(void *arg)
+{
+	struct orb_test_large t;
+	unsigned last = 0;
+	unsigned copies = 0;
+	int sfd = orb_subscribe(ORB_ID(orb_test_large));
+
+	if (sfd < 0) {
+		stress_torn++;
+		return nullptr;
+	}
+
+	while (!stress_done) {
+		if (OK != orb_copy(ORB_ID(orb_test_large), sfd, &t))
+			continue;
+
+		for (unsigned i = 0; i < (sizeof(t.fill) / sizeof(t.fill[0])); i++) {
+			if (t.fill[i] != t.val) {
+				stress_torn++;
+				break;
+			}
+		}
+
+		if (t.val < last)
+			stress_reordered++;
+
+		last = t.val;
+		copies++;
+	}
+
+	orb_unsubscribe(sfd);
+	*(unsigned *)arg = copies;
+
+	return nullptr;
+}
+
+/**
+ * Publish a large topic continuously while several threads copy it, and
+ * fail if any of them saw a torn or out-of-order update.
+ */
+int
+test_stress()
+{
+	struct orb_test_large t;
+	pthread_t readers[stress_readers];
+	unsigned copies[stress_readers];
+	int pfd;
+
+	memset(&t, 0, sizeof(t));
+	pfd = orb_advertise(ORB_ID(orb_test_large), &t);
+
+	if (pfd < 0)
+		return test_fail("advertise(large) failed: %d", errno);
+
+	stress_done = false;
+	stress_torn = 0;
+	stress_reordered = 0;
+
+	pthread_attr_t attr;
+	pthread_attr_init(&attr);
+	pthread_attr_setstacksize(&attr, 2048);
+
+	for (unsigned i = 0; i < stress_readers; i++) {
+		copies[i] = 0;
+
+		if (0 != pthread_create(&readers[i], &attr, stress_reader, &copies[i])) {
+			stress_done = true;
+
+			while (i-- > 0)
+				pthread_join(readers[i], nullptr);
+
+			close(pfd);
+			return test_fail("stress reader create failed");
+		}
+	}
+
+	hrt_abstime end = hrt_absolute_time() + stress_duration;
+	unsigned updates = 0;
+
+	/* alternate between copying and in-place publication */
+	while (hrt_absolute_time() < end) {
+		struct orb_test_large *p = &t;
+
+		t.val++;
+
+		if (t.val & 1) {
+			p = (struct orb_test_large *)orb_publish_begin(ORB_ID(orb_test_large), pfd);
+
+			if (p == nullptr)
+				break;
+
+			p->val = t.val;
+		}
+
+		for (unsigned i = 0; i < (sizeof(p->fill) / sizeof(p->fill[0])); i++)
+			p->fill[i] = t.val;
+
+		if (p != &t) {
+			if (OK != orb_publish_commit(ORB_ID(orb_test_large), pfd))
+				break;
+
+		} else if (OK != orb_publish(ORB_ID(orb_test_large), pfd, &t)) {
+			break;
+		}
+
+		updates++;
+	}
+
+	stress_done = true;
+
+	for (unsigned i = 0; i < stress_readers; i++) {
+		pthread_join(readers[i], nullptr);
+		test_note("stress reader %u: %u copies", i, copies[i]);
+	}
+
+	close(pfd);
+
+	test_note("stress: %u updates published", updates);
+
+	if (updates == 0)
+		return test_fail("stress: publish failed");
+
+	if (stress_torn != 0)
+		return test_fail("stress: %u torn reads", stress_torn);
+
+	if (stress_reordered != 0)
+		return test_fail("stress: %u reads went backwards", stress_reordered);
+
+	return OK;
+}
+
 int
 test()
 {
@@ -653,9 +1576,351 @@ test()
 	if (u.val != t.val)
 		return test_fail("copy(2) mismatch: %d expected %d", u.val, t.val);
 
+	/* direct subscription to the same node */
+	orb_sub_t sub = orb_subscribe_direct(ORB_ID(orb_test));
+
+	if (sub == nullptr)
+		return test_fail("subscribe_direct failed: %d", errno);
+
+	if (OK != orb_check_direct(sub, &updated))
+		return test_fail("check_direct(1) failed");
+
+	if (updated)
+		return test_fail("spurious direct updated flag");
+
+	t.val = 3;
+
+	if (OK != orb_publish(ORB_ID(orb_test), pfd, &t))
+		return test_fail("publish failed");
+
+	if (OK != orb_check_direct(sub, &updated))
+		return test_fail("check_direct(2) failed");
+
+	if (!updated)
+		return test_fail("missing direct updated flag");
+
+	if (OK != orb_copy_direct(ORB_ID(orb_test), sub, &u))
+		return test_fail("copy_direct failed: %d", errno);
+
+	if (u.val != t.val)
+		return test_fail("copy_direct mismatch: %d expected %d", u.val, t.val);
+
+	if (OK == orb_copy_direct(ORB_ID(orb_test_queue), sub, &u))
+		return test_fail("copy_direct with the wrong topic succeeded");
+
+	/* wait set over the file and the direct subscription */
+	orb_waitset_t ws = orb_waitset_create();
+	uint32_t ready;
+
+	if (ws == nullptr)
+		return test_fail("waitset_create failed: %d", errno);
+
+	if ((orb_waitset_add(ws, sfd) != 0) || (orb_waitset_add_direct(ws, sub) != 1))
+		return test_fail("waitset_add failed: %d", errno);
+
+	/* the file subscription has not collected the last update yet */
+	if ((orb_waitset_wait(ws, 0, &ready) != 1) || (ready != 1))
+		return test_fail("waitset: pending update not reported");
+
+	orb_copy(ORB_ID(orb_test), sfd, &u);
+
+	if ((orb_waitset_wait(ws, 10, &ready) != 0) || (ready != 0))
+		return test_fail("waitset: spurious wakeup, ready %x", ready);
+
+	t.val = 4;
+
+	if (OK != orb_publish(ORB_ID(orb_test), pfd, &t))
+		return test_fail("publish failed");
+
+	if ((orb_waitset_wait(ws, 100, &ready) != 2) || (ready != 3))
+		return test_fail("waitset: update not reported, ready %x", ready);
+
+	orb_copy(ORB_ID(orb_test), sfd, &u);
+	orb_copy_direct(ORB_ID(orb_test), sub, &u);
+
+	/*
+	 * A member that is unsubscribed leaves the set; destroying the set
+	 * must not touch whatever subscription reuses its file handle.
+	 */
+	orb_unsubscribe(sfd);
+	sfd = orb_subscribe(ORB_ID(orb_test));
+
+	if (sfd < 0)
+		return test_fail("resubscribe failed: %d", errno);
+
+	orb_copy(ORB_ID(orb_test), sfd, &u);
+
+	orb_waitset_t ws2 = orb_waitset_create();
+
+	if ((ws2 == nullptr) || (orb_waitset_add(ws2, sfd) != 0))
+		return test_fail("second waitset failed: %d", errno);
+
+	orb_waitset_destroy(ws);
+
+	t.val = 5;
+
+	if (OK != orb_publish(ORB_ID(orb_test), pfd, &t))
+		return test_fail("publish failed");
+
+	if ((orb_waitset_wait(ws2, 100, &ready) != 1) || (ready != 1))
+		return test_fail("waitset: destroying another set detached a reused handle, ready %x", ready);
+
+	orb_copy(ORB_ID(orb_test), sfd, &u);
+	orb_copy_direct(ORB_ID(orb_test), sub, &u);
+	orb_waitset_destroy(ws2);
+
+	orb_unsubscribe_direct(sub);
+
+	orb_unsubscribe(sfd);
+	close(pfd);
+
+	/* queued topic: every update is seen in order until the queue overruns */
+	const unsigned queue_size = 4;
+	unsigned overruns;
+
+	t.val = 0;
+	pfd = orb_advertise_queue(ORB_ID(orb_test_queue), &t, queue_size);
+
+	if (pfd < 0)
+		return test_fail("advertise_queue failed: %d", errno);
+
+	sfd = orb_subscribe(ORB_ID(orb_test_queue));
+
+	if (sfd < 0)
+		return test_fail("subscribe(queue) failed: %d", errno);
+
+	for (t.val = 1; t.val < (int)queue_size; t.val++) {
+		if (OK != orb_publish(ORB_ID(orb_test_queue), pfd, &t))
+			return test_fail("publish(queue) failed");
+	}
+
+	for (int i = 1; i < (int)queue_size; i++) {
+		if (OK != orb_check(sfd, &updated) || !updated)
+			return test_fail("queue: missing updated flag at %d", i);
+
+		if (OK != orb_copy(ORB_ID(orb_test_queue), sfd, &u))
+			return test_fail("copy(queue) failed: %d", errno);
+
+		if (u.val != i)
+			return test_fail("queue: out of order %d expected %d", u.val, i);
+	}
+
+	if (OK != orb_check(sfd, &updated) || updated)
+		return test_fail("queue: spurious updated flag after drain");
+
+	/* each queued update is copied with its own publication time */
+	orb_sub_t qsub = orb_subscribe_direct(ORB_ID(orb_test_queue));
+	hrt_abstime before[3], after[3];
+
+	if (qsub == nullptr)
+		return test_fail("subscribe_direct(queue) failed: %d", errno);
+
+	for (t.val = 0; t.val < 3; t.val++) {
+		before[t.val] = hrt_absolute_time();
+
+		if (OK != orb_publish(ORB_ID(orb_test_queue), pfd, &t))
+			return test_fail("publish(queue) failed");
+
+		after[t.val] = hrt_absolute_time();
+		usleep(1000);
+	}
+
+	for (int i = 0; i < 3; i++) {
+		uint64_t published;
+
+		if (OK != orb_copy_stamped_direct(ORB_ID(orb_test_queue), qsub, &u, &published))
+			return test_fail("copy_stamped_direct failed: %d", errno);
+
+		if (u.val != i)
+			return test_fail("copy_stamped_direct: out of order %d expected %d", u.val, i);
+
+		if ((published < before[i]) || (published > after[i]))
+			return test_fail("copy_stamped_direct: update %d stamped outside its publication", i);
+	}
+
+	orb_unsubscribe_direct(qsub);
+
+	/* the file subscription has the same three queued */
+	for (int i = 0; i < 3; i++)
+		orb_copy(ORB_ID(orb_test_queue), sfd, &u);
+
+	/* publish two more than fit and expect the oldest two to be dropped */
+	for (t.val = 10; t.val < 10 + (int)queue_size + 2; t.val++) {
+		if (OK != orb_publish(ORB_ID(orb_test_queue), pfd, &t))
+			return test_fail("publish(queue) failed");
+	}
+
+	if (OK != orb_copy(ORB_ID(orb_test_queue), sfd, &u))
+		return test_fail("copy(queue) failed: %d", errno);
+
+	if (u.val != 12)
+		return test_fail("queue: overrun kept %d expected 12", u.val);
+
+	if (OK != ioctl(sfd, ORBIOCGETOVERRUNS, (unsigned long)(uintptr_t)&overruns))
+		return test_fail("queue: overrun fetch failed");
+
+	if (overruns != 2)
+		return test_fail("queue: %u overruns expected 2", overruns);
+
+	/* the publisher's handle has no subscriber state to report */
+	if ((OK == ioctl(pfd, ORBIOCGETOVERRUNS, (unsigned long)(uintptr_t)&overruns)) || (errno != EBADF))
+		return test_fail("queue: overrun fetch on the publisher not refused: %d", errno);
+
+	/* in-place publication */
+	struct orb_test *slot = (struct orb_test *)orb_publish_begin(ORB_ID(orb_test_queue), pfd);
+
+	if (slot == nullptr)
+		return test_fail("publish_begin failed: %d", errno);
+
+	slot->val = 42;
+
+	if (OK == orb_publish(ORB_ID(orb_test_queue), pfd, &t))
+		return test_fail("publish succeeded during publish_begin");
+
+	/* a resize during the loan retires the buffer it is in; a second cannot free it */
+	if (OK != orb_set_queue_size(sfd, queue_size + 1))
+		return test_fail("resize during loan failed: %d", errno);
+
+	if ((OK == orb_set_queue_size(sfd, queue_size + 2)) || (errno != EBUSY))
+		return test_fail("second resize during loan not refused: %d", errno);
+
+	if (OK != orb_publish_commit(ORB_ID(orb_test_queue), pfd))
+		return test_fail("publish_commit failed: %d", errno);
+
+	if (OK == orb_publish_commit(ORB_ID(orb_test_queue), pfd))
+		return test_fail("second publish_commit succeeded");
+
+	/* with the loan returned, nothing holds the old buffers */
+	if (OK != orb_set_queue_size(sfd, queue_size))
+		return test_fail("resize after loan failed: %d", errno);
+
+	/* drain the overrun queue, the in-place update must come out last */
+	do {
+		if (OK != orb_copy(ORB_ID(orb_test_queue), sfd, &u))
+			return test_fail("copy(queue) failed: %d", errno);
+
+		orb_check(sfd, &updated);
+	} while (updated);
+
+	if (u.val != 42)
+		return test_fail("in-place publish mismatch: %d expected 42", u.val);
+
 	orb_unsubscribe(sfd);
 	close(pfd);
 
+	/* rate-limited subscribers, woken by the shared deferred update */
+	t.val = 0;
+	pfd = orb_advertise(ORB_ID(orb_test), &t);
+
+	if (pfd < 0)
+		return test_fail("advertise(interval) failed: %d", errno);
+
+	struct pollfd fds[2];
+	const unsigned intervals[2] = { 50, 80 };
+
+	for (unsigned i = 0; i < 2; i++) {
+		fds[i].fd = orb_subscribe(ORB_ID(orb_test));
+		fds[i].events = POLLIN;
+
+		if ((fds[i].fd < 0) || (OK != orb_set_interval(fds[i].fd, intervals[i])))
+			return test_fail("subscribe(interval) failed: %d", errno);
+	}
+
+	/* the first update is reported straight away and starts the interval */
+	hrt_abstime start = hrt_absolute_time();
+	t.val = 1;
+	orb_publish(ORB_ID(orb_test), pfd, &t);
+
+	for (unsigned i = 0; i < 2; i++) {
+		if (OK != orb_check(fds[i].fd, &updated) || !updated)
+			return test_fail("interval: first update not reported");
+
+		orb_copy(ORB_ID(orb_test), fds[i].fd, &u);
+	}
+
+	t.val = 2;
+	orb_publish(ORB_ID(orb_test), pfd, &t);
+
+	for (unsigned i = 0; i < 2; i++) {
+		if (OK != orb_check(fds[i].fd, &updated) || updated)
+			return test_fail("interval: update reported within the interval");
+	}
+
+	for (unsigned i = 0; i < 2; i++) {
+		fds[i].revents = 0;
+
+		if (poll(&fds[i], 1, 500) != 1)
+			return test_fail("interval: no wakeup for %ums interval", intervals[i]);
+
+		hrt_abstime elapsed = hrt_absolute_time() - start;
+
+		/* intervals run from the last report; allow a bucket and some scheduling slop */
+		if ((elapsed < (intervals[i] - 10) * 1000) || (elapsed > (intervals[i] + 30) * 1000))
+			return test_fail("interval: %ums wakeup after %uus", intervals[i], (unsigned)elapsed);
+
+		orb_copy(ORB_ID(orb_test), fds[i].fd, &u);
+
+		if (u.val != 2)
+			return test_fail("interval: copied %d expected 2", u.val);
+	}
+
+	orb_unsubscribe(fds[0].fd);
+	orb_unsubscribe(fds[1].fd);
+	close(pfd);
+
+	/* multi-instance topic: each publisher gets its own instance */
+	int instance[ORB_MULTI_MAX_INSTANCES];
+	int mfd[ORB_MULTI_MAX_INSTANCES];
+
+	if (orb_instance_count(ORB_ID(orb_test_multi)) != 0)
+		return test_fail("multi: instances before advertising");
+
+	/* an early subscriber to instance 1 sees the second publisher */
+	sfd = orb_subscribe_multi(ORB_ID(orb_test_multi), 1);
+
+	if (sfd < 0)
+		return test_fail("subscribe_multi failed: %d", errno);
+
+	for (unsigned i = 0; i < ORB_MULTI_MAX_INSTANCES; i++) {
+		t.val = 100 + i;
+		mfd[i] = orb_advertise_multi(ORB_ID(orb_test_multi), &t, &instance[i]);
+
+		if (mfd[i] < 0)
+			return test_fail("advertise_multi(%u) failed: %d", i, errno);
+
+		if (instance[i] != (int)i)
+			return test_fail("advertise_multi(%u) got instance %d", i, instance[i]);
+	}
+
+	if ((orb_advertise_multi(ORB_ID(orb_test_multi), &t, nullptr) >= 0) || (errno != EBUSY))
+		return test_fail("advertise_multi beyond the last instance did not fail with EBUSY");
+
+	if (orb_instance_count(ORB_ID(orb_test_multi)) != ORB_MULTI_MAX_INSTANCES)
+		return test_fail("multi: instance count %d", orb_instance_count(ORB_ID(orb_test_multi)));
+
+	if (OK != orb_copy(ORB_ID(orb_test_multi), sfd, &u) || (u.val != 101))
+		return test_fail("multi: instance 1 copied %d expected 101", u.val);
+
+	orb_unsubscribe(sfd);
+
+	/* instance 0 is the plain topic */
+	sfd = orb_subscribe(ORB_ID(orb_test_multi));
+
+	if (OK != orb_copy(ORB_ID(orb_test_multi), sfd, &u) || (u.val != 100))
+		return test_fail("multi: instance 0 copied %d expected 100", u.val);
+
+	orb_unsubscribe(sfd);
+
+	/* a freed instance is handed to the next publisher */
+	close(mfd[2]);
+	mfd[2] = orb_advertise_multi(ORB_ID(orb_test_multi), &t, &instance[2]);
+
+	if ((mfd[2] < 0) || (instance[2] != 2))
+		return test_fail("multi: re-advertise got instance %d", instance[2]);
+
+	for (unsigned i = 0; i < ORB_MULTI_MAX_INSTANCES; i++)
+		close(mfd[i]);
+
 #if 0
 	/* this is a hacky test that exploits the sensors app to test rate-limiting */
 
@@ -696,16 +1961,63 @@ test()
 	end = hrt_absolute_time();
 	test_note("100Hz, 100 updates in %llu", end - start);
 
-	orb_unsubscribe(sfd);
-#endif
+	orb_unsubscribe(sfd);
+#endif
+
+	if (OK != test_stress())
+		return ERROR;
+
+	return test_note("PASS");
+}
+
+int
+info()
+{
+	if (g_dev == nullptr) {
+		fprintf(stderr, "[uorb] not running\n");
+		return -ENXIO;
+	}
+
+	g_dev->print_stats();
 
-	return test_note("PASS");
+	return OK;
 }
 
 int
-info()
+top()
 {
-	return OK;
+	if (g_dev == nullptr) {
+		fprintf(stderr, "[uorb] not running\n");
+		return -ENXIO;
+	}
+
+	/* open console directly to grab CTRL-C */
+	int console = open("/dev/console", O_NONBLOCK | O_RDONLY | O_NOCTTY);
+
+	if (console < 0) {
+		int ret = errno;
+		fprintf(stderr, "[uorb] can't open console: %d\n", ret);
+		return -ret;
+	}
+
+	for (;;) {
+		printf("\033[H"); /* cursor home */
+		g_dev->print_stats();
+		printf("\033[K[ Hit Ctrl-C to quit. ]\n\033[J");
+		fflush(stdout);
+
+		/* sleep a second, checking for user input every 200 ms */
+		for (unsigned k = 0; k < 5; k++) {
+			char c;
+
+			if ((read(console, &c, 1) == 1) && ((c == 0x03) || (c == 'q'))) {
+				close(console);
+				return OK;
+			}
+
+			usleep(200000);
+		}
+	}
 }
 
 
@@ -762,7 +2074,13 @@ uorb_main(int argc, char *argv[])
 	if (!strcmp(argv[1], "info"))
 		return info();
 
-	fprintf(stderr, "unrecognised command, try 'start', 'test' or 'info'\n");
+	/*
+	 * Show driver information until interrupted.
+	 */
+	if (!strcmp(argv[1], "top"))
+		return top();
+
+	fprintf(stderr, "unrecognised command, try 'start', 'test', 'info' or 'top'\n");
 	return -EINVAL;
 }
 
@@ -772,18 +2090,6 @@ uorb_main(int argc, char *argv[])
 namespace
 {
 
-void debug(const char *fmt, ...)
-{
-	va_list ap;
-
-	va_start(ap, fmt);
-	vfprintf(stderr, fmt, ap);
-	va_end(ap);
-	fprintf(stderr, "\n");
-	fflush(stderr);
-	usleep(100000);
-}
-
 /**
  * Advertise a node; don't consider it an error if the node has
  * already been advertised.
@@ -823,9 +2129,14 @@ out:
  *
  * Handles creation of the object and the initial publication for
  * advertisers.
+ *
+ * If instance is nullptr, instance 0 of the topic is opened. Otherwise a
+ * subscriber opens the instance it points to, and an advertiser claims the
+ * lowest-numbered instance that has no publisher and returns it there.
  */
 int
-node_open(Flavor f, const struct orb_metadata *meta, const void *data, bool advertiser)
+node_open(Flavor f, const struct orb_metadata *meta, const void *data, bool advertiser,
+	  unsigned queue_size = 1, int *instance = nullptr)
 {
 	char path[orb_maxpath];
 	int fd, ret;
@@ -847,30 +2158,85 @@ node_open(Flavor f, const struct orb_metadata *meta, const void *data, bool adve
 		return ERROR;
 	}
 
-	/*
-	 * Generate the path to the node and try to open it.
-	 */
-	ret = node_mkpath(path, f, meta);
+	if ((f == PUBSUB) && (g_dev != nullptr)) {
+		unsigned first = 0;
+		unsigned last = 0;
 
-	if (ret != OK) {
-		errno = -ret;
+		if (instance != nullptr) {
+			if (advertiser) {
+				last = ORB_MULTI_MAX_INSTANCES - 1;
+
+			} else {
+				first = last = *instance;
+			}
+		}
+
+		fd = -1;
+
+		for (unsigned i = first; (i <= last) && (fd < 0); i++) {
+			ORBDevNode *node;
+
+			/*
+			 * Find the node in the topic registry, creating it if this is the
+			 * first reference, and open it by the path it was registered with.
+			 * Opening for write fails if the instance already has a publisher.
+			 *
+			 * The open still resolves the path through the VFS inode tree, so
+			 * this costs a path lookup like before; the registry only saves
+			 * building the path and probing for the node. Subscribers that
+			 * need to avoid the VFS entirely use orb_subscribe_direct().
+			 */
+			ret = g_dev->node_create(meta, i, &node);
+
+			if ((ret != OK) && (ret != -EEXIST)) {
+				errno = -ret;
+				return ERROR;
+			}
+
+			fd = open(node->path(), (advertiser) ? O_WRONLY : O_RDONLY);
+
+			if ((fd >= 0) && (instance != nullptr))
+				*instance = i;
+		}
+
+		if ((fd < 0) && advertiser && (instance != nullptr)) {
+			errno = EBUSY;
+			return ERROR;
+		}
+
+	} else if (instance != nullptr) {
+		/* instances are only known to the topic registry */
+		errno = ENODEV;
 		return ERROR;
-	}
 
-	/* open the path as either the advertiser or the subscriber */
-	fd = open(path, (advertiser) ? O_WRONLY : O_RDONLY);
+	} else {
+		/*
+		 * Generate the path to the node and try to open it.
+		 */
+		ret = node_mkpath(path, f, meta);
 
-	/* we may need to advertise the node... */
-	if (fd < 0) {
+		if (ret != OK) {
+			errno = -ret;
+			return ERROR;
+		}
 
-		/* try to create the node */
-		ret = node_advertise(meta);
+		/* open the path as either the advertiser or the subscriber */
+		fd = open(path, (advertiser) ? O_WRONLY : O_RDONLY);
 
-		/* on success, try the open again */
-		if (ret == OK)
-			fd = open(path, (advertiser) ? O_WRONLY : O_RDONLY);
+		/* we may need to advertise the node... */
+		if (fd < 0) {
+
+			/* try to create the node */
+			ret = node_advertise(meta);
+
+			/* on success, try the open again */
+			if (ret == OK)
+				fd = open(path, (advertiser) ? O_WRONLY : O_RDONLY);
+		}
 	}
 
+	ret = OK;
+
 	if (fd < 0) {
 		errno = EIO;
 		return ERROR;
@@ -878,7 +2244,12 @@ node_open(Flavor f, const struct orb_metadata *meta, const void *data, bool adve
 
 	/* the advertiser must perform an initial publish to initialise the object */
 	if (advertiser) {
-		ret = orb_publish(meta, fd, data);
+		/* size the queue before the first update lands in it */
+		if (queue_size != 1)
+			ret = ioctl(fd, ORBIOCSETQUEUESIZE, queue_size);
+
+		if (ret == OK)
+			ret = orb_publish(meta, fd, data);
 
 		if (ret != OK) {
 			/* save errno across the close */
@@ -901,12 +2272,60 @@ orb_advertise(const struct orb_metadata *meta, const void *data)
 	return node_open(PUBSUB, meta, data, true);
 }
 
+int
+orb_advertise_queue(const struct orb_metadata *meta, const void *data, unsigned queue_size)
+{
+	return node_open(PUBSUB, meta, data, true, queue_size);
+}
+
+int
+orb_advertise_multi(const struct orb_metadata *meta, const void *data, int *instance)
+{
+	int dummy;
+
+	return node_open(PUBSUB, meta, data, true, 1, (instance != nullptr) ? instance : &dummy);
+}
+
 int
 orb_subscribe(const struct orb_metadata *meta)
 {
 	return node_open(PUBSUB, meta, nullptr, false);
 }
 
+int
+orb_subscribe_multi(const struct orb_metadata *meta, unsigned instance)
+{
+	int i = instance;
+
+	return node_open(PUBSUB, meta, nullptr, false, 1, &i);
+}
+
+int
+orb_instance_count(const struct orb_metadata *meta)
+{
+	int count = 0;
+
+	if (nullptr == meta) {
+		errno = ENOENT;
+		return ERROR;
+	}
+
+	if (g_dev == nullptr) {
+		errno = ENODEV;
+		return ERROR;
+	}
+
+	for (unsigned i = 0; i < ORB_MULTI_MAX_INSTANCES; i++) {
+		ORBDevNode *node = g_dev->node_find(meta, i);
+
+		/* instances are claimed lowest first, but may since have lost their publisher */
+		if ((node != nullptr) && (node->last_update() != 0))
+			count = i + 1;
+	}
+
+	return count;
+}
+
 int
 orb_unsubscribe(int handle)
 {
@@ -931,6 +2350,23 @@ orb_publish(const struct orb_metadata *meta, int handle, const void *data)
 	return OK;
 }
 
+void *
+orb_publish_begin(const struct orb_metadata *meta, int handle)
+{
+	void *data;
+
+	if (OK != ioctl(handle, ORBIOCPUBLISHBEGIN, (unsigned long)(uintptr_t)&data))
+		return nullptr;
+
+	return data;
+}
+
+int
+orb_publish_commit(const struct orb_metadata *meta, int handle)
+{
+	return ioctl(handle, ORBIOCPUBLISHCOMMIT, 0);
+}
+
 int
 orb_copy(const struct orb_metadata *meta, int handle, void *buffer)
 {
@@ -967,3 +2403,265 @@ orb_set_interval(int handle, unsigned interval)
 	return ioctl(handle, ORBIOCSETINTERVAL, interval * 1000);
 }
 
+int
+orb_set_queue_size(int handle, unsigned queue_size)
+{
+	return ioctl(handle, ORBIOCSETQUEUESIZE, queue_size);
+}
+
+const struct orb_metadata *
+orb_lookup(const char *name)
+{
+	ORBDevNode *node = nullptr;
+
+	if (g_dev != nullptr)
+		node = g_dev->node_find_name(name);
+
+	if (node == nullptr) {
+		errno = ENOENT;
+		return nullptr;
+	}
+
+	return node->meta();
+}
+
+/**
+ * State of a direct subscription.
+ */
+struct orb_subscription {
+	ORBDevNode			*node;
+	ORBDevNode::SubscriberData	sd;
+};
+
+orb_sub_t
+orb_subscribe_direct(const struct orb_metadata *meta)
+{
+	ORBDevNode *node;
+	int ret;
+
+	if (nullptr == meta) {
+		errno = ENOENT;
+		return nullptr;
+	}
+
+	/* direct subscriptions need the broker to be in this address space */
+	if (g_dev == nullptr) {
+		errno = ENODEV;
+		return nullptr;
+	}
+
+	ret = g_dev->node_create(meta, 0, &node);
+
+	if ((ret != OK) && (ret != -EEXIST)) {
+		errno = -ret;
+		return nullptr;
+	}
+
+	orb_sub_t sub = new orb_subscription;
+
+	if (sub == nullptr) {
+		errno = ENOMEM;
+		return nullptr;
+	}
+
+	sub->node = node;
+	node->subscriber_init(&sub->sd);
+
+	return sub;
+}
+
+int
+orb_unsubscribe_direct(orb_sub_t sub)
+{
+	if (sub == nullptr) {
+		errno = EINVAL;
+		return ERROR;
+	}
+
+	sub->node->subscriber_fini(&sub->sd);
+	delete sub;
+
+	return OK;
+}
+
+int
+orb_copy_direct(const struct orb_metadata *meta, orb_sub_t sub, void *buffer)
+{
+	if (meta != sub->node->meta()) {
+		errno = EINVAL;
+		return ERROR;
+	}
+
+	if (sub->node->copy(&sub->sd, (char *)buffer) != (ssize_t)meta->o_size) {
+		errno = EIO;
+		return ERROR;
+	}
+
+	return OK;
+}
+
+int
+orb_copy_stamped_direct(const struct orb_metadata *meta, orb_sub_t sub, void *buffer, uint64_t *time)
+{
+	if (meta != sub->node->meta()) {
+		errno = EINVAL;
+		return ERROR;
+	}
+
+	if (sub->node->copy(&sub->sd, (char *)buffer, time) != (ssize_t)meta->o_size) {
+		errno = EIO;
+		return ERROR;
+	}
+
+	return OK;
+}
+
+int
+orb_check_direct(orb_sub_t sub, bool *updated)
+{
+	*updated = sub->node->appears_updated(&sub->sd);
+	return OK;
+}
+
+int
+orb_stat_direct(orb_sub_t sub, uint64_t *time)
+{
+	*time = sub->node->last_update();
+	return OK;
+}
+
+orb_waitset_t
+orb_waitset_create(void)
+{
+	orb_waitset_t ws = new orb_waitset;
+
+	if (ws == nullptr) {
+		errno = ENOMEM;
+		return nullptr;
+	}
+
+	sem_init(&ws->sem, 0, 0);
+	ws->ready = 0;
+	ws->count = 0;
+
+	return ws;
+}
+
+namespace
+{
+
+/**
+ * Common implementation for orb_waitset_add and orb_waitset_add_direct.
+ */
+int
+waitset_add(orb_waitset_t ws, int handle, orb_sub_t sub)
+{
+	if (ws->count >= ORB_WAITSET_MAX) {
+		errno = ENOSPC;
+		return ERROR;
+	}
+
+	unsigned bit = ws->count;
+
+	if (sub != nullptr) {
+		sub->node->waitset_attach(&sub->sd, ws, bit);
+
+	} else {
+		struct waitset_attach wa = { ws, bit };
+
+		if (OK != ioctl(handle, ORBIOCSETWAITSET, (unsigned long)(uintptr_t)&wa))
+			return ERROR;
+	}
+
+	ws->count++;
+
+	return bit;
+}
+
+} // namespace
+
+int
+orb_waitset_add(orb_waitset_t ws, int handle)
+{
+	return waitset_add(ws, handle, nullptr);
+}
+
+int
+orb_waitset_add_direct(orb_waitset_t ws, orb_sub_t sub)
+{
+	return waitset_add(ws, -1, sub);
+}
+
+int
+orb_waitset_wait(orb_waitset_t ws, int timeout, uint32_t *ready)
+{
+	struct timespec deadline;
+
+	if (timeout >= 0) {
+		clock_gettime(CLOCK_REALTIME, &deadline);
+		deadline.tv_sec += timeout / 1000;
+		deadline.tv_nsec += (timeout % 1000) * 1000000;
+
+		if (deadline.tv_nsec >= 1000000000) {
+			deadline.tv_sec++;
+			deadline.tv_nsec -= 1000000000;
+		}
+	}
+
+	for (;;) {
+		/*
+		 * The semaphore is posted once each time the ready set becomes
+		 * non-empty, so this returns straight away if it already is.
+		 */
+		int ret = (timeout >= 0) ? sem_timedwait(&ws->sem, &deadline) : sem_wait(&ws->sem);
+
+		irqstate_t flags = irqsave();
+		uint32_t r = ws->ready;
+		ws->ready = 0;
+		irqrestore(flags);
+
+		if (r != 0) {
+			unsigned count = 0;
+
+			for (uint32_t m = r; m != 0; m &= m - 1)
+				count++;
+
+			*ready = r;
+			return count;
+		}
+
+		if (ret != OK) {
+			if (errno == EINTR)
+				continue;
+
+			if (errno == ETIMEDOUT) {
+				*ready = 0;
+				return 0;
+			}
+
+			return ERROR;
+		}
+
+		/* a stale wakeup; wait again */
+	}
+}
+
+int
+orb_waitset_destroy(orb_waitset_t ws)
+{
+	/* members that have been unsubscribed already cleared their slots */
+	for (unsigned i = 0; i < ws->count; i++) {
+		irqstate_t flags = irqsave();
+		ORBDevNode *node = ws->members[i].node;
+		ORBDevNode::SubscriberData *sd = ws->members[i].sd;
+		irqrestore(flags);
+
+		if (sd != nullptr)
+			node->waitset_attach(sd, nullptr, 0);
+	}
+
+	sem_destroy(&ws->sem);
+	delete ws;
+
+	return OK;
+}
@@ -124,6 +124,51 @@ __BEGIN_DECLS
  */
 extern int	orb_advertise(const struct orb_metadata *meta, const void *data) __EXPORT;
 
+/**
+ * Advertise as the publisher of a queued topic.
+ *
+ * As orb_advertise, but the topic keeps the last queue_size updates
+ * rather than only the most recent one. Each subscriber reads them in
+ * order via orb_copy; a subscriber that falls more than queue_size
+ * updates behind loses the oldest ones.
+ *
+ * @param meta		The uORB metadata (usually from the ORB_ID() macro)
+ *			for the topic.
+ * @param data		A pointer to the initial data to be published.
+ * @param queue_size	The number of updates to queue, between 1 and
+ *			ORB_MAX_QUEUE_SIZE.
+ * @return		ERROR on error, otherwise returns a handle
+ *			that can be used to publish to the topic.
+ */
+extern int	orb_advertise_queue(const struct orb_metadata *meta, const void *data, unsigned queue_size) __EXPORT;
+
+/**
+ * Maximum number of instances of a topic.
+ */
+#define ORB_MULTI_MAX_INSTANCES	4
+
+/**
+ * Advertise as the publisher of one instance of a topic.
+ *
+ * Where several publishers produce the same kind of data, e.g. redundant
+ * sensors, each advertises its own instance of the topic rather than a
+ * topic of its own. The publisher is given the lowest-numbered instance
+ * that has no publisher; instance 0 is the one orb_advertise and
+ * orb_subscribe use, so the first publisher is also visible to
+ * subscribers that know nothing of instances.
+ *
+ * Instance 0 is the node /obj/<name>, further instances are /obj/<name><n>.
+ *
+ * @param meta		The uORB metadata (usually from the ORB_ID() macro)
+ *			for the topic.
+ * @param data		A pointer to the initial data to be published.
+ * @param instance	If not NULL, returns the instance claimed.
+ * @return		ERROR on error, otherwise returns a handle
+ *			that can be used to publish to the topic. errno is
+ *			EBUSY if every instance already has a publisher.
+ */
+extern int	orb_advertise_multi(const struct orb_metadata *meta, const void *data, int *instance) __EXPORT;
+
 /**
  * Publish new data to a topic.
  *
@@ -139,6 +184,38 @@ extern int	orb_advertise(const struct orb_metadata *meta, const void *data) __EX
  */
 extern int	orb_publish(const struct orb_metadata *meta, int handle, const void *data) __EXPORT;
 
+/**
+ * Begin publishing an update in place.
+ *
+ * Returns a pointer to the topic buffer that the next update will be
+ * published from, so that the publisher can build the update there rather
+ * than in a structure of its own that orb_publish then copies. Subscribers
+ * do not see the update until orb_publish_commit is called.
+ *
+ * The buffer does not hold the previous update; every field must be
+ * written before committing. Only one update may be in progress at a
+ * time, and orb_publish fails while one is.
+ *
+ * @param meta		The uORB metadata (usually from the ORB_ID() macro)
+ *			for the topic.
+ * @param handle	The handle returned from orb_advertise.
+ * @return		A pointer to meta->o_size bytes to fill, or NULL on
+ *			error with errno set accordingly.
+ */
+extern void	*orb_publish_begin(const struct orb_metadata *meta, int handle) __EXPORT;
+
+/**
+ * Publish the update started with orb_publish_begin.
+ *
+ * Subscribers are notified exactly as for orb_publish.
+ *
+ * @param meta		The uORB metadata (usually from the ORB_ID() macro)
+ *			for the topic.
+ * @param handle	The handle returned from orb_advertise.
+ * @return		OK on success, ERROR otherwise with errno set accordingly.
+ */
+extern int	orb_publish_commit(const struct orb_metadata *meta, int handle) __EXPORT;
+
 /**
  * Subscribe to a topic.
  *
@@ -167,6 +244,32 @@ extern int	orb_publish(const struct orb_metadata *meta, int handle, const void *
  */
 extern int	orb_subscribe(const struct orb_metadata *meta) __EXPORT;
 
+/**
+ * Subscribe to one instance of a topic.
+ *
+ * As orb_subscribe, which is equivalent to subscribing to instance 0.
+ * The subscription succeeds whether or not the instance has been
+ * advertised yet; see orb_instance_count.
+ *
+ * @param meta		The uORB metadata (usually from the ORB_ID() macro)
+ *			for the topic.
+ * @param instance	The instance, less than ORB_MULTI_MAX_INSTANCES.
+ * @return		ERROR on error, otherwise returns a handle
+ *			that can be used to read and update the topic.
+ */
+extern int	orb_subscribe_multi(const struct orb_metadata *meta, unsigned instance) __EXPORT;
+
+/**
+ * Count the instances of a topic that have been published.
+ *
+ * @param meta		The uORB metadata (usually from the ORB_ID() macro)
+ *			for the topic.
+ * @return		One more than the highest instance that has been
+ *			published, zero if none has, or ERROR with errno set
+ *			accordingly.
+ */
+extern int	orb_instance_count(const struct orb_metadata *meta) __EXPORT;
+
 /**
  * Unsubscribe from a topic.
  *
@@ -183,6 +286,11 @@ extern int	orb_unsubscribe(int handle) __EXPORT;
  * or check return indicating that an updaet is available, this call
  * must be used to update the subscription.
  *
+ * For queued topics each call returns the oldest update the subscriber
+ * has not yet seen, and the topic continues to appear updated until the
+ * queue has been drained. Once there is nothing left to read, the most
+ * recent update is returned again.
+ *
  * @param meta		The uORB metadata (usually from the ORB_ID() macro)
  *			for the topic.
  * @param handle	A handle returned from orb_subscribe.
@@ -243,6 +351,205 @@ extern int	orb_stat(int handle, uint64_t *time) __EXPORT;
  */
 extern int	orb_set_interval(int handle, unsigned interval) __EXPORT;
 
+/**
+ * Set the number of updates a topic queues for its subscribers.
+ *
+ * May be called by the publisher or by any subscriber, e.g. by a logger
+ * that must see every update of a fast topic. Updates already queued are
+ * kept as far as they fit.
+ *
+ * @param handle	A handle returned from orb_advertise or orb_subscribe.
+ * @param queue_size	The number of updates to queue, between 1 and
+ *			ORB_MAX_QUEUE_SIZE.
+ * @return		OK on success, ERROR otherwise with errno set accordingly.
+ *			EBUSY means the topic's previous buffer is still in
+ *			use by a copy or an in-place publication; retry later.
+ */
+extern int	orb_set_queue_size(int handle, unsigned queue_size) __EXPORT;
+
+/**
+ * Find the metadata for a topic by name.
+ *
+ * This is intended for tools that are given topic names at runtime, such
+ * as loggers; code that knows the topic at compile time should use ORB_ID().
+ * Only topics that something in the system has advertised or subscribed
+ * to can be found.
+ *
+ * @param name		The topic name.
+ * @return		The uORB metadata for the topic, or NULL with errno
+ *			set to ENOENT if it is not known.
+ */
+extern const struct orb_metadata *orb_lookup(const char *name) __EXPORT;
+
+/**
+ * Handle for a direct subscription.
+ */
+typedef struct orb_subscription *orb_sub_t;
+
+/**
+ * Subscribe to a topic without going through the VFS.
+ *
+ * The topic is found in the broker's registry by its metadata, and the
+ * returned handle is used with orb_copy_direct, orb_check_direct and
+ * orb_stat_direct, which call into the broker directly rather than via
+ * read() and ioctl(). This makes it suitable for code that checks and
+ * copies many topics at a high rate.
+ *
+ * A direct handle is not a file descriptor and cannot be passed to poll();
+ * use orb_subscribe for topics that the caller needs to wait on. The
+ * topic is still visible in /obj to shell tools.
+ *
+ * @param meta		The uORB metadata (usually from the ORB_ID() macro)
+ *			for the topic.
+ * @return		NULL on error with errno set accordingly, otherwise a
+ *			handle for the subscription.
+ */
+extern orb_sub_t orb_subscribe_direct(const struct orb_metadata *meta) __EXPORT;
+
+/**
+ * Unsubscribe a direct subscription.
+ *
+ * @param sub		A handle returned from orb_subscribe_direct.
+ * @return		OK on success, ERROR otherwise with errno set accordingly.
+ */
+extern int	orb_unsubscribe_direct(orb_sub_t sub) __EXPORT;
+
+/**
+ * Fetch data from a topic via a direct subscription.
+ *
+ * As orb_copy.
+ *
+ * @param meta		The uORB metadata (usually from the ORB_ID() macro)
+ *			for the topic.
+ * @param sub		A handle returned from orb_subscribe_direct.
+ * @param buffer	Pointer to the buffer receiving the data, or NULL
+ *			if the caller wants to clear the updated flag without
+ *			using the data.
+ * @return		OK on success, ERROR otherwise with errno set accordingly.
+ */
+extern int	orb_copy_direct(const struct orb_metadata *meta, orb_sub_t sub, void *buffer) __EXPORT;
+
+/**
+ * Fetch data from a topic via a direct subscription, along with the time
+ * it was published.
+ *
+ * As orb_copy_direct. The time is that of the update copied, which on a
+ * queued topic may be older than the time orb_stat_direct returns.
+ *
+ * @param meta		The uORB metadata (usually from the ORB_ID() macro)
+ *			for the topic.
+ * @param sub		A handle returned from orb_subscribe_direct.
+ * @param buffer	Pointer to the buffer receiving the data, or NULL
+ *			if the caller only wants the time.
+ * @param time		Returns the absolute time that the copied update was
+ *			published. Time is measured in microseconds.
+ * @return		OK on success, ERROR otherwise with errno set accordingly.
+ */
+extern int	orb_copy_stamped_direct(const struct orb_metadata *meta, orb_sub_t sub, void *buffer, uint64_t *time) __EXPORT;
+
+/**
+ * Check whether a topic has been published to since the last orb_copy_direct.
+ *
+ * As orb_check.
+ *
+ * @param sub		A handle returned from orb_subscribe_direct.
+ * @param updated	Set to true if the topic has been updated since the
+ *			last time it was copied using this handle.
+ * @return		OK if the check was successful, ERROR otherwise with
+ *			errno set accordingly.
+ */
+extern int	orb_check_direct(orb_sub_t sub, bool *updated) __EXPORT;
+
+/**
+ * Return the last time that the topic was updated.
+ *
+ * As orb_stat.
+ *
+ * @param sub		A handle returned from orb_subscribe_direct.
+ * @param time		Returns the absolute time that the topic was updated, or zero if it has
+ *			never been updated. Time is measured in microseconds.
+ * @return		OK on success, ERROR otherwise with errno set accordingly.
+ */
+extern int	orb_stat_direct(orb_sub_t sub, uint64_t *time) __EXPORT;
+
+/**
+ * Maximum number of subscriptions in a wait set.
+ */
+#define ORB_WAITSET_MAX		32
+
+/**
+ * Handle for a wait set.
+ */
+typedef struct orb_waitset *orb_waitset_t;
+
+/**
+ * Create a wait set.
+ *
+ * A wait set lets a thread block until any of a number of subscriptions
+ * is updated. The subscriptions are registered with the topics once,
+ * when they are added, rather than on every call as with poll().
+ *
+ * A wait set belongs to the thread that waits on it.
+ *
+ * @return		NULL on error with errno set accordingly, otherwise a
+ *			handle for the wait set.
+ */
+extern orb_waitset_t orb_waitset_create(void) __EXPORT;
+
+/**
+ * Add a subscription to a wait set.
+ *
+ * A subscription can be a member of only one wait set. Unsubscribing
+ * removes it from the wait set; its bit is not reused.
+ *
+ * @param ws		A handle returned from orb_waitset_create.
+ * @param handle	A handle returned from orb_subscribe.
+ * @return		The bit that represents the subscription in the
+ *			ready mask returned by orb_waitset_wait, or ERROR
+ *			with errno set accordingly.
+ */
+extern int	orb_waitset_add(orb_waitset_t ws, int handle) __EXPORT;
+
+/**
+ * Add a direct subscription to a wait set.
+ *
+ * As orb_waitset_add.
+ *
+ * @param ws		A handle returned from orb_waitset_create.
+ * @param sub		A handle returned from orb_subscribe_direct.
+ * @return		The bit that represents the subscription in the
+ *			ready mask returned by orb_waitset_wait, or ERROR
+ *			with errno set accordingly.
+ */
+extern int	orb_waitset_add_direct(orb_waitset_t ws, orb_sub_t sub) __EXPORT;
+
+/**
+ * Wait until one or more subscriptions in a wait set are updated.
+ *
+ * A subscription is reported once for each time it is seen to be updated;
+ * the caller is expected to copy each topic reported in the ready mask.
+ * Updates to queued topics that are still waiting after a copy are
+ * reported again. Rate-limited subscriptions are reported no more often
+ * than their interval allows, as for poll().
+ *
+ * @param ws		A handle returned from orb_waitset_create.
+ * @param timeout	Maximum time to wait in milliseconds, or -1 to wait
+ *			indefinitely.
+ * @param ready		Returns the mask of subscriptions that have been
+ *			updated, by the bits returned when they were added.
+ * @return		The number of subscriptions that have been updated,
+ *			zero on timeout, or ERROR with errno set accordingly.
+ */
+extern int	orb_waitset_wait(orb_waitset_t ws, int timeout, uint32_t *ready) __EXPORT;
+
+/**
+ * Remove all subscriptions from a wait set and free it.
+ *
+ * @param ws		A handle returned from orb_waitset_create.
+ * @return		OK on success, ERROR otherwise with errno set accordingly.
+ */
+extern int	orb_waitset_destroy(orb_waitset_t ws) __EXPORT;
+
 __END_DECLS
 
 #endif /* _UORB_UORB_H */
@@ -61,11 +61,6 @@
 #include <arch/board/drv_tone_alarm.h>
 #include <arch/board/up_adc.h>
 #include <arch/board/board.h>
-#include <arch/board/drv_bma180.h>
-#include <arch/board/drv_l3gd20.h>
-#include <arch/board/drv_hmc5883l.h>
-#include <arch/board/drv_mpu6000.h>
-#include <arch/board/drv_ms5611.h>
 #include <arch/board/drv_eeprom.h>
 #include <arch/board/drv_led.h>
 
@@ -209,45 +204,10 @@ int nsh_archinitialize(void)
 
   message("[boot] Successfully initialized SPI port 1\r\n");
 
-  /* initialize SPI peripherals redundantly */
-  int gyro_attempts = 0;
-  int gyro_fail = 0;
-
-  while (gyro_attempts < 5)
-  {
-	  gyro_fail = l3gd20_attach(spi1, PX4_SPIDEV_GYRO);
-	  gyro_attempts++;
-	  if (gyro_fail == 0) break;
-	  up_udelay(1000);
-  }
-
-  if (gyro_fail) message("[boot] FAILED to attach L3GD20 gyro\r\n");
-
-  int acc_attempts = 0;
-  int acc_fail = 0;
-
-  while (acc_attempts < 5)
-  {
-	  acc_fail = bma180_attach(spi1, PX4_SPIDEV_ACCEL);
-	  acc_attempts++;
-	  if (acc_fail == 0) break;
-	  up_udelay(1000);
-  }
-
-  if (acc_fail) message("[boot] FAILED to attach BMA180 accelerometer\r\n");
-
-  int mpu_attempts = 0;
-  int mpu_fail = 0;
-
-  while (mpu_attempts < 1)
-  {
-	  mpu_fail = mpu6000_attach(spi1, PX4_SPIDEV_MPU);
-	  mpu_attempts++;
-	  if (mpu_fail == 0) break;
-	  up_udelay(200);
-  }
-
-  if (mpu_fail) message("[boot] FAILED to attach MPU 6000 gyro/acc\r\n");
+  /*
+   * The sensors on SPI1 and I2C2 are attached by their drivers in
+   * apps/drivers, started from rc.sensors.
+   */
 
   /* initialize I2C2 bus */
 
@@ -272,31 +232,6 @@ int nsh_archinitialize(void)
   /* set I2C3 speed */
   I2C_SETFREQUENCY(i2c3, 400000);
 
-  int mag_attempts = 0;
-  int mag_fail = 0;
-
-  while (mag_attempts < 5)
-  {
-	  mag_fail = hmc5883l_attach(i2c2);
-	  mag_attempts++;
-	  if (mag_fail == 0) break;
-	  up_udelay(1000);
-  }
-
-  if (mag_fail) message("[boot] FAILED to attach HMC5883L magnetometer\r\n");
-
-  int baro_attempts = 0;
-  int baro_fail = 0;
-  while (baro_attempts < 5)
-  {
-	  baro_fail = ms5611_attach(i2c2);
-	  baro_attempts++;
-	  if (baro_fail == 0) break;
-	  up_udelay(1000);
-  }
-
-  if (baro_fail) message("[boot] FAILED to attach MS5611 baro at addr #1 or #2 (0x76 or 0x77)\r\n");
-
   /* try to attach, don't fail if device is not responding */
   (void)eeprom_attach(i2c3, FMU_BASEBOARD_EEPROM_ADDRESS,
 		  FMU_BASEBOARD_EEPROM_TOTAL_SIZE_BYTES,
@@ -317,11 +252,9 @@ int nsh_archinitialize(void)
 	  up_udelay(1000);
   }
 
-  if (eeprom_fail) message("[boot] FAILED to attach FMU EEPROM\r\n");
-
-  /* Report back sensor status */
-  if (acc_fail || gyro_fail || mag_fail || baro_fail || eeprom_fail)
+  if (eeprom_fail)
   {
+	  message("[boot] FAILED to attach FMU EEPROM\r\n");
 	  up_ledon(LED_AMBER);
   }
 
@@ -0,0 +1,101 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2012 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file Cost of the driver decimation filter on the host.
+ *
+ * Absolute numbers reflect the host, not the target; the benchmark is meant
+ * for comparing filter changes and configurations.
+ */
+
+#include <nuttx/config.h>
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include <drivers/device/decimator.h>
+
+#include "test_util.h"
+
+namespace
+{
+
+const unsigned	samples = 10000000;
+
+void
+bench(unsigned sample_hz, unsigned cutoff_hz)
+{
+	device::Decimator d;
+	int16_t in[3] = { 0, 0, 0 };
+	int16_t out[3];
+	volatile int32_t sink = 0;
+	unsigned outputs = 0;
+
+	d.configure(sample_hz, cutoff_hz);
+
+	uint64_t start = now_ns();
+
+	for (unsigned n = 0; n < samples; n++) {
+		/* something that isn't constant */
+		in[0] = n;
+		in[1] = n >> 3;
+		in[2] = -n;
+
+		if (d.put(in, out)) {
+			sink += out[0] + out[1] + out[2];
+			outputs++;
+		}
+	}
+
+	uint64_t elapsed = now_ns() - start;
+
+	printf("%4u Hz, cutoff %3u Hz: %2u taps, decimation %u: %6.1f ns/sample, %6.1f ns/output\n",
+	       sample_hz, cutoff_hz, d.taps(), d.factor(),
+	       (double)elapsed / samples, (double)elapsed / outputs);
+}
+
+} // namespace
+
+int
+main(int argc, char *argv[])
+{
+	bench(760, 0);
+	bench(760, 30);
+	bench(760, 50);
+	bench(760, 100);
+	bench(760, 200);
+	bench(500, 30);
+	bench(1000, 100);
+
+	return 0;
+}
@@ -0,0 +1,170 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2012 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file Checks the driver decimation filter on synthetic vibration.
+ */
+
+#include <nuttx/config.h>
+
+#include <stdio.h>
+#include <stdint.h>
+#include <math.h>
+
+#include <drivers/device/decimator.h>
+
+#include "test_util.h"
+
+namespace
+{
+
+const unsigned	sample_hz = 760;	/**< L3GD20 data rate */
+const unsigned	cutoff_hz = 30;
+
+/**
+ * Filter a slow motion with vibration on top, and return the largest
+ * difference between the output and the slow motion alone, delayed by
+ * the filter.
+ */
+double
+residual(device::Decimator &d, double motion_hz, double motion_amp, double vib_hz, double vib_amp)
+{
+	double worst = 0;
+	double delay = (d.taps() - 1) / 2.0;
+	unsigned outputs = 0;
+
+	for (unsigned n = 0; n < 10 * sample_hz; n++) {
+		double t = (double)n / sample_hz;
+		double v = motion_amp * sin(2 * M_PI * motion_hz * t) + vib_amp * sin(2 * M_PI * vib_hz * t);
+		int16_t in[3] = { (int16_t)lrint(v), (int16_t)lrint(-v), 0 };
+		int16_t out[3];
+
+		if (!d.put(in, out))
+			continue;
+
+		/* let the history fill with real samples first */
+		if (n < 2 * d.taps())
+			continue;
+
+		double expect = motion_amp * sin(2 * M_PI * motion_hz * (n - delay) / sample_hz);
+
+		worst = fmax(worst, fabs(out[0] - expect));
+
+		if ((out[1] != -out[0]) && (out[1] != -out[0] + 1) && (out[1] != -out[0] - 1))
+			return 1e9;
+
+		outputs++;
+	}
+
+	/* a second at the output rate */
+	if (outputs < (10 * sample_hz - 2 * d.taps()) / d.factor() - 1)
+		return 1e9;
+
+	return worst;
+}
+
+} // namespace
+
+int
+main(int argc, char *argv[])
+{
+	device::Decimator d;
+	int16_t in[3], out[3];
+
+	/* pass-through when disabled */
+	if ((d.configure(sample_hz, 0) != OK) || (d.taps() != 1) || (d.factor() != 1))
+		return fail("disabled filter has %u taps, factor %u", d.taps(), d.factor());
+
+	in[0] = 1234; in[1] = -32768; in[2] = 32767;
+
+	if (!d.put(in, out) || (out[0] != 1234) || (out[1] != -32768) || (out[2] != 32767))
+		return fail("disabled filter changed the sample");
+
+	if (d.configure(0, cutoff_hz) == OK)
+		return fail("configured for a zero sample rate");
+
+	if ((d.configure(sample_hz, cutoff_hz) != OK) || (d.taps() < 3) || (d.factor() < 2))
+		return fail("%u taps, factor %u", d.taps(), d.factor());
+
+	printf("%u Hz at %u Hz: %u taps, decimation %u, output %u Hz\n",
+	       cutoff_hz, sample_hz, d.taps(), d.factor(), sample_hz / d.factor());
+
+	/* DC is passed exactly, including full scale */
+	const int16_t levels[] = { 0, 1, -1, 1000, -20000, 32767, -32768 };
+
+	for (unsigned l = 0; l < sizeof(levels) / sizeof(levels[0]); l++) {
+		d.reset();
+		in[0] = in[1] = in[2] = levels[l];
+
+		for (unsigned n = 0; n < 4 * d.taps(); n++) {
+			if (d.put(in, out) && ((out[0] != levels[l]) || (out[2] != levels[l])))
+				return fail("level %d came out as %d", levels[l], out[0]);
+		}
+	}
+
+	/* full-scale alternation must saturate, not wrap */
+	d.reset();
+
+	for (unsigned n = 0; n < 4 * d.taps(); n++) {
+		in[0] = in[1] = in[2] = (n & 1) ? 32767 : -32768;
+
+		if (d.put(in, out) && (n > d.taps()) && (abs(out[0]) > 1000))
+			return fail("Nyquist input came out as %d", out[0]);
+	}
+
+	/* the motion is kept */
+	d.configure(sample_hz, cutoff_hz);
+	double r = residual(d, 5, 10000, 0, 0);
+
+	if (r > 200)
+		return fail("5 Hz motion error %g", r);
+
+	printf("5 Hz motion: %.0f LSB error of 10000\n", r);
+
+	/* vibration anywhere above the stopband is removed, including what would alias */
+	const double vibration[] = { 90, 120, 200, 290, 300, 370 };
+
+	for (unsigned v = 0; v < sizeof(vibration) / sizeof(vibration[0]); v++) {
+		d.configure(sample_hz, cutoff_hz);
+		r = residual(d, 2, 2000, vibration[v], 20000);
+
+		printf("%3.0f Hz vibration: %.0f LSB residual of 20000\n", vibration[v], r);
+
+		/* 40 dB */
+		if (r > 200)
+			return fail("%g Hz vibration leaves %g", vibration[v], r);
+	}
+
+	printf("PASS\n");
+	return 0;
+}
@@ -0,0 +1,164 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2012 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file Cost of one attitude EKF step on the host, hand-written against
+ * MATLAB-generated, and of the split propagation and correction per gyro
+ * sample.
+ *
+ * Absolute numbers reflect the host, not the target; the benchmark is meant
+ * for comparing the implementations.
+ */
+
+#include <nuttx/config.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#include <attitude_estimator_ekf/attitude_ekf.h>
+
+extern "C" {
+#include <attitude_estimator_ekf/codegen/attitudeKalmanfilter_initialize.h>
+#include <attitude_estimator_ekf/codegen/attitudeKalmanfilter.h>
+}
+
+#include "test_util.h"
+
+namespace
+{
+
+const unsigned	steps = 200000;
+const float	knownConst[7] = { 1e-2f, 1e-2f, 1e-6f, 1e-1f, 1.0f, 1.0f, 1e-2f };
+
+typedef void (*filter_t)(float dt, const float z_k[9], const float x_aposteriori_k[12],
+			 const float P_aposteriori_k[144], const float knownConst[7],
+			 float Rot_matrix[9], float x_aposteriori[12], float P_aposteriori[144]);
+
+/** attitude_ekf() with its result dropped, to match */
+void
+block_sparse(float dt, const float z_k[9], const float x_aposteriori_k[12],
+	     const float P_aposteriori_k[144], const float knownConst[7],
+	     float Rot_matrix[9], float x_aposteriori[12], float P_aposteriori[144])
+{
+	attitude_ekf(dt, z_k, x_aposteriori_k, P_aposteriori_k, knownConst, Rot_matrix, x_aposteriori, P_aposteriori);
+}
+
+double
+bench(const char *name, filter_t filter)
+{
+	float x[12] = { 0.2f, 0, 0.4f, 0, 0, -9.81f, 0, 0, 0, 0, 0, 0 };
+	float P[144];
+	float rot[9];
+	float z[9] = { 0.2f, 0, 0.4f, 0, 0, -9.81f, 0.01f, -0.02f, 0 };
+
+	memset(P, 0, sizeof(P));
+
+	for (unsigned i = 0; i < 12; i++)
+		P[i + 12 * i] = 100.0f;
+
+	uint64_t start = now_ns();
+
+	for (unsigned step = 0; step < steps; step++) {
+		/* keep the filter moving so the work can't be hoisted */
+		z[6] = 0.01f * (step & 7);
+		filter(0.005f, z, x, P, knownConst, rot, x, P);
+	}
+
+	double ns = (double)(now_ns() - start) / steps;
+
+	printf("%-24s %8.1f ns/step\n", name, ns);
+	return ns;
+}
+
+/**
+ * Propagation on every sample and correction on every ratio'th, as with a
+ * slower accelerometer and magnetometer; zero ratio never corrects.
+ */
+double
+bench_split(const char *name, unsigned ratio)
+{
+	float x[12] = { 0.2f, 0, 0.4f, 0, 0, -9.81f, 0, 0, 0, 0, 0, 0 };
+	float P[144];
+	float rot[9];
+	float z[9] = { 0.2f, 0, 0.4f, 0, 0, -9.81f, 0.01f, -0.02f, 0 };
+	float correct_dt = 0;
+	unsigned correct_steps = 0;
+
+	memset(P, 0, sizeof(P));
+
+	for (unsigned i = 0; i < 12; i++)
+		P[i + 12 * i] = 100.0f;
+
+	uint64_t start = now_ns();
+
+	for (unsigned step = 0; step < steps; step++) {
+		z[6] = 0.01f * (step & 7);
+		attitude_ekf_propagate(0.005f, &z[6], x, rot);
+		correct_dt += 0.005f;
+		correct_steps++;
+
+		if ((ratio != 0) && ((step % ratio) == ratio - 1)) {
+			attitude_ekf_correct(correct_dt, correct_steps, z, knownConst, x, P, rot);
+			correct_dt = 0;
+			correct_steps = 0;
+		}
+	}
+
+	double ns = (double)(now_ns() - start) / steps;
+
+	printf("%-24s %8.1f ns/sample\n", name, ns);
+	return ns;
+}
+
+} // namespace
+
+int
+main(int argc, char *argv[])
+{
+	attitudeKalmanfilter_initialize();
+
+	double generated = bench("attitudeKalmanfilter", attitudeKalmanfilter);
+	double blocks = bench("attitude_ekf", block_sparse);
+
+	printf("speedup: %.1fx\n", generated / blocks);
+
+	bench_split("propagate only", 0);
+	double every = bench_split("correct every sample", 1);
+	double half = bench_split("correct every 2nd", 2);
+	double quarter = bench_split("correct every 4th", 4);
+
+	printf("per-sample cost against attitude_ekf: %.2f, %.2f, %.2f\n",
+	       every / blocks, half / blocks, quarter / blocks);
+	return 0;
+}
@@ -0,0 +1,232 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2012 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file Checks the hand-written attitude EKF against the MATLAB-generated one.
+ */
+
+#include <nuttx/config.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+
+#include <attitude_estimator_ekf/attitude_ekf.h>
+
+extern "C" {
+#include <attitude_estimator_ekf/codegen/attitudeKalmanfilter_initialize.h>
+#include <attitude_estimator_ekf/codegen/attitudeKalmanfilter.h>
+}
+
+#include "test_util.h"
+
+namespace
+{
+
+const unsigned	steps = 5000;
+const float	knownConst[7] = { 1e-2f, 1e-2f, 1e-6f, 1e-1f, 1.0f, 1.0f, 1e-2f };
+
+/** a slowly tumbling vehicle in a fixed field, with sensor noise */
+void
+measurement(unsigned step, float dt, float z[9])
+{
+	float t = step * dt;
+	float roll = 0.5f * sinf(0.7f * t);
+	float pitch = 0.3f * sinf(1.1f * t);
+
+	/* gravity and field in the body frame, to first order */
+	z[0] = 0.2f + 0.4f * pitch + 0.02f * noise();
+	z[1] = -0.2f * roll + 0.02f * noise();
+	z[2] = 0.4f + 0.02f * noise();
+	z[3] = 9.81f * pitch + 0.3f * noise();
+	z[4] = -9.81f * roll + 0.3f * noise();
+	z[5] = -9.81f + 0.3f * noise();
+	z[6] = 0.35f * cosf(0.7f * t) + 0.01f + 0.005f * noise();
+	z[7] = 0.33f * cosf(1.1f * t) - 0.02f + 0.005f * noise();
+	z[8] = 0.005f * noise();
+}
+
+} // namespace
+
+int
+main(int argc, char *argv[])
+{
+	attitudeKalmanfilter_initialize();
+
+	/* one step from the same, arbitrary, symmetric positive definite state */
+	float x[12], P[144], z[9];
+	float rot_ref[9], x_ref[12], P_ref[144];
+	float rot[9], x_new[12], P_new[144];
+
+	for (unsigned i = 0; i < 12; i++)
+		x[i] = 2.0f * noise();
+
+	for (unsigned j = 0; j < 12; j++) {
+		for (unsigned i = 0; i <= j; i++) {
+			P[i + 12 * j] = P[j + 12 * i] = (i == j) ? (5.0f + noise()) : (0.3f * noise());
+		}
+	}
+
+	measurement(0, 0.005f, z);
+
+	attitudeKalmanfilter(0.005f, z, x, P, knownConst, rot_ref, x_ref, P_ref);
+	attitude_ekf(0.005f, z, x, P, knownConst, rot, x_new, P_new);
+
+	if ((difference(x_ref, x_new, 12) > 1e-5) ||
+	    (difference(P_ref, P_new, 144) > 1e-5) ||
+	    (difference(rot_ref, rot, 9) > 1e-5))
+		return fail("single step: state %g, covariance %g", difference(x_ref, x_new, 12), difference(P_ref, P_new, 144));
+
+	/* the outputs may overwrite the inputs, as the estimator does */
+	attitude_ekf(0.005f, z, x, P, knownConst, rot, x, P);
+
+	if ((difference(x_ref, x, 12) > 1e-5) || (difference(P_ref, P, 144) > 1e-5))
+		return fail("in-place step: state %g, covariance %g", difference(x_ref, x, 12), difference(P_ref, P, 144));
+
+	/* the two filters side by side over a flight, starting as the estimator does */
+	float x_a[12] = { 0.2f, 0, 0.4f, 0, 0, -9.81f, 0, 0, 0, 0, 0, 0 };
+	float P_a[144];
+	float x_b[12], P_b[144];
+
+	memset(P_a, 0, sizeof(P_a));
+
+	for (unsigned i = 0; i < 12; i++)
+		P_a[i + 12 * i] = 100.0f;
+
+	memcpy(x_b, x_a, sizeof(x_b));
+	memcpy(P_b, P_a, sizeof(P_b));
+
+	double worst_x = 0, worst_P = 0, worst_rot = 0;
+
+	for (unsigned step = 0; step < steps; step++) {
+		float dt = 0.004f + 0.002f * (step % 3);
+
+		measurement(step, dt, z);
+
+		attitudeKalmanfilter(dt, z, x_a, P_a, knownConst, rot_ref, x_a, P_a);
+		attitude_ekf(dt, z, x_b, P_b, knownConst, rot, x_b, P_b);
+
+		worst_x = fmax(worst_x, difference(x_a, x_b, 12));
+		worst_P = fmax(worst_P, difference(P_a, P_b, 144));
+		worst_rot = fmax(worst_rot, difference(rot_ref, rot, 9));
+
+		if (!(worst_x < 1e-4) || !(worst_P < 1e-4) || !(worst_rot < 1e-4))
+			return fail("step %u: outputs differ by %g", step, fmax(worst_x, fmax(worst_P, worst_rot)));
+	}
+
+	printf("%u steps: relative difference state %.2g, covariance %.2g, rotation %.2g\n",
+	       steps, worst_x, worst_P, worst_rot);
+
+	/*
+	 * Propagation on every gyro sample and correction on every fourth, as
+	 * the estimator runs with a slower accelerometer and magnetometer. The
+	 * reference is the single-rate filter given fresh measurements on
+	 * every sample; the split filter should track it at least as well as
+	 * the single-rate filter does when fed the same, held, measurements.
+	 */
+	float x_full[12] = { 0.2f, 0, 0.4f, 0, 0, -9.81f, 0, 0, 0, 0, 0, 0 };
+	float P_full[144], rot_full[9];
+	float x_held[12], P_held[144], rot_held[9];
+	float x_split[12], P_split[144], rot_split[9];
+	float z_held[9];
+	float correct_dt = 0;
+	unsigned correct_steps = 0;
+	double err_held = 0, err_split = 0;
+	unsigned compared = 0;
+
+	memset(P_full, 0, sizeof(P_full));
+
+	for (unsigned i = 0; i < 12; i++)
+		P_full[i + 12 * i] = 100.0f;
+
+	memcpy(x_held, x_full, sizeof(x_held));
+	memcpy(P_held, P_full, sizeof(P_held));
+	memcpy(x_split, x_full, sizeof(x_split));
+	memcpy(P_split, P_full, sizeof(P_split));
+
+	for (unsigned step = 0; step < steps; step++) {
+		float dt = 0.004f + 0.002f * (step % 3);
+
+		measurement(step, dt, z);
+
+		/* accelerometer and magnetometer only refresh every fourth sample */
+		if ((step % 4) == 0)
+			memcpy(z_held, z, 6 * sizeof(float));
+
+		memcpy(&z_held[6], &z[6], 3 * sizeof(float));
+
+		attitude_ekf(dt, z, x_full, P_full, knownConst, rot_full, x_full, P_full);
+		attitude_ekf(dt, z_held, x_held, P_held, knownConst, rot_held, x_held, P_held);
+
+		attitude_ekf_propagate(dt, &z_held[6], x_split, rot_split);
+		correct_dt += dt;
+		correct_steps++;
+
+		if ((step % 4) == 3) {
+			if (!attitude_ekf_correct(correct_dt, correct_steps, z_held, knownConst, x_split, P_split, rot_split))
+				return fail("step %u: correction failed", step);
+
+			correct_dt = 0;
+			correct_steps = 0;
+		}
+
+		for (unsigned i = 0; i < 9; i++) {
+			if (!isfinite(rot_split[i]))
+				return fail("step %u: attitude not finite", step);
+		}
+
+		/* compare once the filters have converged */
+		if (step < steps / 4)
+			continue;
+
+		for (unsigned i = 0; i < 9; i++) {
+			err_held += (rot_held[i] - rot_full[i]) * (rot_held[i] - rot_full[i]);
+			err_split += (rot_split[i] - rot_full[i]) * (rot_split[i] - rot_full[i]);
+		}
+
+		compared++;
+	}
+
+	err_held = sqrt(err_held / compared);
+	err_split = sqrt(err_split / compared);
+
+	printf("%u steps at quarter-rate correction: rms attitude error single-rate %.2g, split %.2g\n",
+	       steps, err_held, err_split);
+
+	if (!(err_split < 1.1 * err_held))
+		return fail("split filter attitude error %g, single-rate %g", err_split, err_held);
+
+	printf("PASS\n");
+	return 0;
+}
@@ -0,0 +1,66 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2012 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file Interrupt masking for the POSIX host build.
+ *
+ * There are no interrupts on the host; "interrupt context" is the HRT
+ * callout thread. Masking interrupts takes a single process-wide recursive
+ * lock that the callout thread also holds while it runs callouts, which
+ * gives the same mutual exclusion as irqsave() does on the target.
+ */
+
+#ifndef _POSIX_ARCH_IRQ_H
+#define _POSIX_ARCH_IRQ_H
+
+#include <nuttx/config.h>
+
+#include <stdbool.h>
+
+typedef int irqstate_t;
+
+__BEGIN_DECLS
+
+extern irqstate_t	irqsave(void);
+extern void		irqrestore(irqstate_t flags);
+
+extern bool		up_interrupt_context(void);
+extern void		up_enable_irq(int irq);
+extern void		up_disable_irq(int irq);
+
+typedef int		(*xcpt_t)(int irq, void *context);
+extern int		irq_attach(int irq, xcpt_t isr);
+
+__END_DECLS
+
+#endif /* _POSIX_ARCH_IRQ_H */
@@ -0,0 +1,83 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2012 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file Stand-in for the NuttX character driver interface in the POSIX host build.
+ *
+ * Drivers registered here are reachable through open(), close(), read(),
+ * write(), ioctl() and poll(), which the host build redirects into the
+ * stand-in VFS (see posix_vfs.cpp).
+ */
+
+#ifndef _POSIX_NUTTX_FS_FS_H
+#define _POSIX_NUTTX_FS_FS_H
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <stdbool.h>
+#include <semaphore.h>
+#include <poll.h>
+
+struct file;
+
+struct file_operations {
+	int	(*open)(struct file *filp);
+	int	(*close)(struct file *filp);
+	ssize_t	(*read)(struct file *filp, char *buffer, size_t buflen);
+	ssize_t	(*write)(struct file *filp, const char *buffer, size_t buflen);
+	off_t	(*seek)(struct file *filp, off_t offset, int whence);
+	int	(*ioctl)(struct file *filp, int cmd, unsigned long arg);
+	int	(*poll)(struct file *filp, struct pollfd *fds, bool setup);
+};
+
+struct inode {
+	const struct file_operations *i_ops;	/**< driver operations */
+	void		*i_private;		/**< per inode driver private data */
+};
+
+struct file {
+	int		f_oflags;	/**< open mode flags */
+	off_t		f_pos;		/**< file position */
+	struct inode	*f_inode;	/**< driver interface */
+	void		*f_priv;	/**< per file driver private data */
+};
+
+__BEGIN_DECLS
+
+extern int	register_driver(const char *path, const struct file_operations *fops, mode_t mode, void *priv);
+extern int	unregister_driver(const char *path);
+
+__END_DECLS
+
+#endif /* _POSIX_NUTTX_FS_FS_H */
@@ -0,0 +1,106 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2012 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file NuttX-flavoured poll() for the POSIX host build.
+ *
+ * Drivers see the NuttX pollfd, which carries the semaphore that is posted
+ * to wake the poller and a private pointer for the driver's use.
+ */
+
+#ifndef _POSIX_POLL_H
+#define _POSIX_POLL_H
+
+#include <nuttx/config.h>
+
+#include <stdint.h>
+#include <pthread.h>
+
+#define POLLIN       (0x01)  /* NuttX does not make priority distinctions */
+#define POLLRDNORM   (0x01)
+#define POLLRDBAND   (0x01)
+#define POLLPRI      (0x01)
+
+#define POLLOUT      (0x02)  /* NuttX does not make priority distinctions */
+#define POLLWRNORM   (0x02)
+#define POLLWRBAND   (0x02)
+
+#define POLLERR      (0x04)
+#define POLLHUP      (0x08)
+#define POLLNVAL     (0x10)
+
+typedef unsigned int nfds_t;
+typedef uint8_t pollevent_t;
+
+/**
+ * Wakeup semaphore for a poll() call.
+ *
+ * Drivers inspect semcount to avoid posting a waiter twice, as they do on
+ * NuttX, so this cannot be a host sem_t.
+ */
+struct poll_sem {
+	pthread_mutex_t	mutex;
+	pthread_cond_t	cond;
+	volatile int	semcount;
+};
+
+struct pollfd {
+	int		fd;		/**< the descriptor being polled */
+	struct poll_sem	*sem;		/**< posted to wake the poller */
+	pollevent_t	events;		/**< the input event flags */
+	pollevent_t	revents;	/**< the output event flags */
+	void		*priv;		/**< for use by drivers */
+};
+
+__BEGIN_DECLS
+
+extern int	poll(struct pollfd *fds, nfds_t nfds, int timeout);
+
+__END_DECLS
+
+#ifdef __cplusplus
+/**
+ * Post a poll wakeup; overloads the host sem_post for drivers.
+ */
+static inline int
+sem_post(struct poll_sem *sem)
+{
+	pthread_mutex_lock(&sem->mutex);
+	sem->semcount++;
+	pthread_cond_broadcast(&sem->cond);
+	pthread_mutex_unlock(&sem->mutex);
+	return 0;
+}
+#endif
+
+#endif /* _POSIX_POLL_H */
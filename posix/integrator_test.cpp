@@ -0,0 +1,288 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2012 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file Checks the sensors app's delta-angle and delta-velocity integrator
+ * against a finely integrated reference on coning and sculling motion.
+ */
+
+#include <nuttx/config.h>
+
+#include <stdio.h>
+#include <stdint.h>
+#include <math.h>
+
+#include <sensors/sensor_integrator.h>
+
+#include "test_util.h"
+
+namespace
+{
+
+const unsigned	sample_us = 1000;		/**< 1 kHz IMU */
+const unsigned	interval_us = 10000;		/**< 100 Hz consumer */
+const unsigned	intervals = 50;
+
+/** angular rate and specific force at time t */
+typedef void (*motion_t)(double t, double w[3], double a[3]);
+
+void
+coning(double t, double w[3], double a[3])
+{
+	const double A = 1.0, W = 2 * M_PI * 10;
+
+	w[0] = A * cos(W * t);
+	w[1] = A * sin(W * t);
+	w[2] = 0;
+	a[0] = a[1] = 0;
+	a[2] = -9.81;
+}
+
+void
+sculling(double t, double w[3], double a[3])
+{
+	const double A = 1.0, B = 5.0, W = 2 * M_PI * 10;
+
+	w[0] = A * cos(W * t);
+	w[1] = w[2] = 0;
+	a[0] = 0;
+	a[1] = B * cos(W * t);
+	a[2] = -9.81;
+}
+
+/** q = q * (rotation by w over h), q as w, x, y, z */
+void
+rotate(double q[4], const double w[3], double h)
+{
+	double n = sqrt(w[0] * w[0] + w[1] * w[1] + w[2] * w[2]);
+	double s = (n > 0) ? sin(0.5 * n * h) / n : 0.5 * h;
+	double c = cos(0.5 * n * h);
+	double d[4] = { c, s * w[0], s * w[1], s * w[2] };
+	double r[4] = {
+		q[0] * d[0] - q[1] * d[1] - q[2] * d[2] - q[3] * d[3],
+		q[0] * d[1] + q[1] * d[0] + q[2] * d[3] - q[3] * d[2],
+		q[0] * d[2] - q[1] * d[3] + q[2] * d[0] + q[3] * d[1],
+		q[0] * d[3] + q[1] * d[2] - q[2] * d[1] + q[3] * d[0],
+	};
+
+	for (unsigned i = 0; i < 4; i++)
+		q[i] = r[i];
+}
+
+/** v = R(q) a */
+void
+body_to_start(const double q[4], const double a[3], double v[3])
+{
+	double w = q[0], x = q[1], y = q[2], z = q[3];
+
+	v[0] = (1 - 2 * (y * y + z * z)) * a[0] + 2 * (x * y - w * z) * a[1] + 2 * (x * z + w * y) * a[2];
+	v[1] = 2 * (x * y + w * z) * a[0] + (1 - 2 * (x * x + z * z)) * a[1] + 2 * (y * z - w * x) * a[2];
+	v[2] = 2 * (x * z - w * y) * a[0] + 2 * (y * z + w * x) * a[1] + (1 - 2 * (x * x + y * y)) * a[2];
+}
+
+double
+distance(const double a[3], const float b[3])
+{
+	double d[3] = { a[0] - b[0], a[1] - b[1], a[2] - b[2] };
+	return sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+}
+
+/**
+ * Run a motion through the integrator and through a 1 us reference
+ * integration, and return the worst per-interval errors of the corrected
+ * increments and of the plain sums of the samples.
+ */
+int
+run(const char *name, motion_t motion, double &angle_err, double &vel_err, double &angle_naive, double &vel_naive)
+{
+	struct sensor_integrator integ;
+	sensor_integrator_init(&integ, 3 * sample_us);
+
+	double q[4] = { 1, 0, 0, 0 };
+	double vel[3] = { 0, 0, 0 };
+	float sum_angle[3] = { 0, 0, 0 };
+	float sum_vel[3] = { 0, 0, 0 };
+	float last_w[3], last_a[3];
+
+	angle_err = vel_err = angle_naive = vel_naive = 0;
+
+	/* timestamps start at 1 us, as zero means 'no sample yet' */
+	for (unsigned t_us = 0; t_us <= intervals * interval_us; t_us++) {
+		double t = t_us * 1e-6;
+		double w[3], a[3];
+
+		if ((t_us % sample_us) == 0) {
+			motion(t, w, a);
+
+			float wf[3] = { (float)w[0], (float)w[1], (float)w[2] };
+			float af[3] = { (float)a[0], (float)a[1], (float)a[2] };
+
+			sensor_integrator_gyro(&integ, t_us + 1, wf);
+			sensor_integrator_accel(&integ, t_us + 1, af);
+
+			if (t_us > 0) {
+				for (unsigned i = 0; i < 3; i++) {
+					sum_angle[i] += 0.5f * (last_w[i] + wf[i]) * (sample_us * 1e-6f);
+					sum_vel[i] += 0.5f * (last_a[i] + af[i]) * (sample_us * 1e-6f);
+				}
+			}
+
+			for (unsigned i = 0; i < 3; i++) {
+				last_w[i] = wf[i];
+				last_a[i] = af[i];
+			}
+		}
+
+		if ((t_us > 0) && ((t_us % interval_us) == 0)) {
+			struct sensor_delta_s delta;
+
+			if (!sensor_integrator_get(&integ, &delta))
+				return fail("no increments at %u us", t_us);
+
+			if ((delta.dt_us != interval_us) || (delta.gyro_samples != interval_us / sample_us))
+				return fail("interval of %u us, %d samples", delta.dt_us, delta.gyro_samples);
+
+			/* reference rotation vector from the quaternion */
+			double n = sqrt(q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+			double k = (n > 0) ? 2 * atan2(n, q[0]) / n : 2;
+			double angle[3] = { k * q[1], k * q[2], k * q[3] };
+
+			angle_err = fmax(angle_err, distance(angle, delta.delta_angle_rad));
+			vel_err = fmax(vel_err, distance(vel, delta.delta_velocity_m_s));
+			angle_naive = fmax(angle_naive, distance(angle, sum_angle));
+			vel_naive = fmax(vel_naive, distance(vel, sum_vel));
+
+			/* restart the reference at the new interval */
+			q[0] = 1;
+			q[1] = q[2] = q[3] = 0;
+
+			for (unsigned i = 0; i < 3; i++) {
+				vel[i] = 0;
+				sum_angle[i] = 0;
+				sum_vel[i] = 0;
+			}
+		}
+
+		/*
+		 * Reference, midpoint rule over 1 us. The sensors only report
+		 * samples, so the motion between them is taken to be the linear
+		 * interpolation the trapezoidal increments assume; that leaves
+		 * only the errors of the coning and sculling algorithms.
+		 */
+		double tm = t + 0.5e-6;
+		double t0 = floor(tm / (sample_us * 1e-6)) * (sample_us * 1e-6);
+		double f = (tm - t0) / (sample_us * 1e-6);
+		double w1[3], a1[3];
+
+		motion(t0, w, a);
+		motion(t0 + sample_us * 1e-6, w1, a1);
+
+		for (unsigned i = 0; i < 3; i++) {
+			w[i] += f * (w1[i] - w[i]);
+			a[i] += f * (a1[i] - a[i]);
+		}
+
+		double half[4] = { q[0], q[1], q[2], q[3] };
+		double v[3];
+		rotate(half, w, 0.5e-6);
+		body_to_start(half, a, v);
+
+		for (unsigned i = 0; i < 3; i++)
+			vel[i] += v[i] * 1e-6;
+
+		rotate(q, w, 1e-6);
+	}
+
+	printf("%s: angle error %.3g rad (uncorrected %.3g), velocity error %.3g m/s (uncorrected %.3g)\n",
+	       name, angle_err, angle_naive, vel_err, vel_naive);
+	return 0;
+}
+
+} // namespace
+
+int
+main(int argc, char *argv[])
+{
+	double angle_err, vel_err, angle_naive, vel_naive;
+
+	/* coning; the rate vector turns, so summing it is wrong */
+	if (run("coning", coning, angle_err, vel_err, angle_naive, vel_naive))
+		return 1;
+
+	if (angle_err > 0.1 * angle_naive)
+		return fail("coning correction %g vs %g uncorrected", angle_err, angle_naive);
+
+	/* sculling; rotation about x while accelerating along y */
+	if (run("sculling", sculling, angle_err, vel_err, angle_naive, vel_naive))
+		return 1;
+
+	if (vel_err > 0.1 * vel_naive)
+		return fail("sculling correction %g vs %g uncorrected", vel_err, vel_naive);
+
+	/* asynchronous sensors; a steady turn with steady acceleration */
+	struct sensor_integrator integ;
+	sensor_integrator_init(&integ, 3 * sample_us);
+
+	const float rate[3] = { 0, 0, 0.5f };
+	const float accel[3] = { 1.0f, 0, 0 };
+	double angle = 0, speed = 0;
+	unsigned accel_samples = 0;
+
+	for (unsigned t_us = 1; t_us <= intervals * interval_us + 1; t_us += 100) {
+		if ((t_us % 1300) == 1)
+			sensor_integrator_gyro(&integ, t_us, rate);
+
+		if ((t_us % 2000) == 701)
+			sensor_integrator_accel(&integ, t_us, accel);
+
+		struct sensor_delta_s delta;
+		bool last = (t_us > intervals * interval_us);
+
+		if (((sensor_integrator_elapsed(&integ) >= interval_us) || last) && sensor_integrator_get(&integ, &delta)) {
+			angle += delta.delta_angle_rad[2];
+			speed += sqrt(delta.delta_velocity_m_s[0] * delta.delta_velocity_m_s[0] +
+				      delta.delta_velocity_m_s[1] * delta.delta_velocity_m_s[1]);
+			accel_samples += delta.accel_samples;
+		}
+	}
+
+	/* everything up to the last gyro and accelerometer samples is accounted for */
+	if (fabs(angle - 0.5 * 1.3e-3 * ((intervals * interval_us - 1) / 1300)) > 1e-4)
+		return fail("asynchronous angle %g", angle);
+
+	if (fabs(speed - 1.0 * 2e-3 * (accel_samples)) > 1e-3)
+		return fail("asynchronous speed %g for %u samples", speed, accel_samples);
+
+	printf("PASS\n");
+	return 0;
+}
@@ -0,0 +1,133 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2012 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file Cost of the attitude EKF gain solve on the host, LDL' against the
+ * MATLAB-generated LU.
+ *
+ * Times are converted to cycles at the nominal rate of the timestamp counter
+ * where one is available; they reflect the host, not the target, and are
+ * meant for comparing the solvers.
+ */
+
+#include <nuttx/config.h>
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <attitude_estimator_ekf/ldlt.h>
+
+extern "C" {
+#include <attitude_estimator_ekf/codegen/attitudeKalmanfilter_initialize.h>
+#include <attitude_estimator_ekf/codegen/mrdivide.h>
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+# include <x86intrin.h>
+# define HAVE_TSC
+#endif
+
+#include "test_util.h"
+
+namespace
+{
+
+const unsigned	N = LDLT_N;
+const unsigned	M = LDLT_M;
+const unsigned	calls = 500000;
+
+float	A[M * N], B[N * N], y[M * N];
+
+uint64_t
+now_cycles()
+{
+#ifdef HAVE_TSC
+	return __rdtsc();
+#else
+	return 0;
+#endif
+}
+
+void
+lu(void)
+{
+	mrdivide(A, B, y);
+}
+
+void
+ldlt(void)
+{
+	ldlt_mrdivide(A, B, y);
+}
+
+double
+bench(const char *name, void (*solve)(void))
+{
+	uint64_t start = now_ns();
+	uint64_t start_cycles = now_cycles();
+
+	for (unsigned i = 0; i < calls; i++) {
+		/* perturb the system so the work can't be hoisted */
+		B[0] = 10.0f + 1e-3f * (i & 7);
+		solve();
+	}
+
+	double ns = (double)(now_ns() - start) / calls;
+	double cycles = (double)(now_cycles() - start_cycles) / calls;
+
+	printf("%-16s %8.1f ns %8.0f cycles/solve\n", name, ns, cycles);
+	return ns;
+}
+
+} // namespace
+
+int
+main(int argc, char *argv[])
+{
+	attitudeKalmanfilter_initialize();
+
+	/* a diagonally dominant S, and an arbitrary right-hand side */
+	for (unsigned j = 0; j < N; j++)
+		for (unsigned i = 0; i < N; i++)
+			B[i + N * j] = (i == j) ? 10.0f : 1.0f / (1 + i + j);
+
+	for (unsigned i = 0; i < M * N; i++)
+		A[i] = (float)(i % 7) - 3.0f;
+
+	double generated = bench("mrdivide", lu);
+	double symmetric = bench("ldlt_mrdivide", ldlt);
+
+	printf("speedup: %.1fx\n", generated / symmetric);
+	return 0;
+}
@@ -0,0 +1,217 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2012 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file Checks the attitude EKF's symmetric solver.
+ */
+
+#include <nuttx/config.h>
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#include <attitude_estimator_ekf/ldlt.h>
+#include <attitude_estimator_ekf/attitude_ekf.h>
+
+extern "C" {
+#include <attitude_estimator_ekf/codegen/attitudeKalmanfilter_initialize.h>
+#include <attitude_estimator_ekf/codegen/mrdivide.h>
+}
+
+#include "test_util.h"
+
+namespace
+{
+
+const unsigned	N = LDLT_N;
+const unsigned	M = LDLT_M;
+const unsigned	trials = 1000;
+
+/** B = G * G' + diag(shift), symmetric positive definite for shift > 0 */
+void
+make_spd(float B[N * N], float shift)
+{
+	float G[N * N];
+
+	for (unsigned i = 0; i < N * N; i++)
+		G[i] = noise();
+
+	for (unsigned j = 0; j < N; j++) {
+		for (unsigned i = 0; i < N; i++) {
+			double sum = (i == j) ? shift : 0.0;
+
+			for (unsigned k = 0; k < N; k++)
+				sum += (double)G[i + N * k] * G[j + N * k];
+
+			B[i + N * j] = sum;
+		}
+	}
+}
+
+/** largest element of |y * B - A| relative to the largest of |A| */
+double
+residual(const float A[M * N], const float B[N * N], const float y[M * N])
+{
+	double diff = 0, scale = 0;
+
+	for (unsigned r = 0; r < M; r++) {
+		for (unsigned c = 0; c < N; c++) {
+			double sum = 0;
+
+			for (unsigned k = 0; k < N; k++)
+				sum += (double)y[r + M * k] * B[k + N * c];
+
+			diff = fmax(diff, fabs(sum - A[r + M * c]));
+			scale = fmax(scale, fabs((double)A[r + M * c]));
+		}
+	}
+
+	return diff / scale;
+}
+
+} // namespace
+
+int
+main(int argc, char *argv[])
+{
+	attitudeKalmanfilter_initialize();
+
+	float A[M * N], B[N * N], y[M * N], y_ref[M * N];
+	double worst = 0, worst_ref = 0;
+
+	/* well and moderately conditioned systems, against the LU solver */
+	for (unsigned trial = 0; trial < trials; trial++) {
+		make_spd(B, (trial & 1) ? 1.0f : 1e-3f);
+
+		for (unsigned i = 0; i < M * N; i++)
+			A[i] = noise();
+
+		if (!ldlt_mrdivide(A, B, y))
+			return fail("trial %u: positive definite matrix rejected", trial);
+
+		mrdivide(A, B, y_ref);
+
+		worst = fmax(worst, residual(A, B, y));
+		worst_ref = fmax(worst_ref, residual(A, B, y_ref));
+	}
+
+	printf("residual: ldlt %.2g, lu %.2g\n", worst, worst_ref);
+
+	if (worst > 1e-3)
+		return fail("residual %g", worst);
+
+	if (worst > 10 * worst_ref)
+		return fail("residual %g, much worse than LU (%g)", worst, worst_ref);
+
+	/* only the lower triangle is read */
+	make_spd(B, 1.0f);
+	ldlt_mrdivide(A, B, y_ref);
+
+	for (unsigned j = 1; j < N; j++)
+		for (unsigned i = 0; i < j; i++)
+			B[i + N * j] = NAN;
+
+	if (!ldlt_mrdivide(A, B, y) || memcmp(y, y_ref, sizeof(y)))
+		return fail("upper triangle was read");
+
+	/* the result may overwrite the right-hand side */
+	memcpy(y, A, sizeof(y));
+
+	if (!ldlt_mrdivide(y, B, y) || memcmp(y, y_ref, sizeof(y)))
+		return fail("in-place solve differs");
+
+	/* loss of positive definiteness is reported, and y left alone */
+	const char *cases[] = { "indefinite", "singular", "negative diagonal", "NaN" };
+
+	for (unsigned c = 0; c < 4; c++) {
+		make_spd(B, 1.0f);
+
+		switch (c) {
+		case 0:
+			B[4 + N * 4] = -B[4 + N * 4];
+			B[8 + N * 8] = 0.1f;
+			B[8 + N * 0] = 3.0f;
+			break;
+
+		case 1:
+			/* rank one */
+			for (unsigned j = 0; j < N; j++)
+				for (unsigned i = 0; i < N; i++)
+					B[i + N * j] = (float)(i + 1) * (j + 1);
+
+			break;
+
+		case 2:
+			B[0] = -1.0f;
+			break;
+
+		case 3:
+			B[5 + N * 3] = NAN;
+			break;
+		}
+
+		memset(y, 0, sizeof(y));
+
+		if (ldlt_mrdivide(A, B, y))
+			return fail("matrix not rejected (case %u)", c);
+
+		for (unsigned i = 0; i < M * N; i++)
+			if (y[i] != 0.0f)
+				return fail("result written for a rejected matrix (case %u)", c);
+
+		printf("%s: rejected\n", cases[c]);
+	}
+
+	/* and the filter falls back to the prediction instead of producing NaNs */
+	const float bad_noise[7] = { 1e-2f, 1e-2f, 1e-6f, 1e-1f, -1e6f, 1.0f, 1e-2f };
+	float x[12] = { 0.2f, 0, 0.4f, 0, 0, -9.81f, 0, 0, 0, 0, 0, 0 };
+	float P[144], rot[9];
+	float z[9] = { 0.2f, 0, 0.4f, 0, 0, -9.81f, 0, 0, 0 };
+
+	memset(P, 0, sizeof(P));
+
+	for (unsigned i = 0; i < 12; i++)
+		P[i + 12 * i] = 100.0f;
+
+	if (attitude_ekf(0.005f, z, x, P, bad_noise, rot, x, P))
+		return fail("filter update applied with indefinite S");
+
+	for (unsigned i = 0; i < 144; i++)
+		if (!isfinite(P[i]) || ((i < 12) && !isfinite(x[i])) || ((i < 9) && !isfinite(rot[i])))
+			return fail("filter produced a non-finite value at %u", i);
+
+	printf("PASS\n");
+	return 0;
+}
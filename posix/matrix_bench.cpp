@@ -0,0 +1,359 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2012 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file Cost of the fixed-size matrix library on the host, against the
+ * runtime-sized matrix_t code it replaced.
+ *
+ * Absolute numbers reflect the host, not the target; the benchmark is meant
+ * for comparing the implementations.
+ */
+
+#include <nuttx/config.h>
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#include <systemlib/matrix.h>
+#include <px4/attitude_estimator_bm/kalman.h>
+#include <fixedwing_control/rotation.h>
+
+#include "test_util.h"
+
+namespace
+{
+
+/*
+ * The matrix_t routines from the old attitude_estimator_bm/matrix.h, and
+ * the Kalman correction step built from them in the old kalman.c.
+ */
+namespace legacy
+{
+
+typedef struct {
+	int rows;
+	int cols;
+	float *a;
+} matrix_t;
+
+#define M(m,i,j) m.a[m.cols*i+j]
+
+matrix_t matrix_create(const int rows, const int cols, float *a)
+{
+	matrix_t ret;
+	ret.rows = rows;
+	ret.cols = cols;
+	ret.a = a;
+	return ret;
+}
+
+void matrix_add(const matrix_t a, const matrix_t b, matrix_t c)
+{
+	if (a.rows != c.rows || a.cols != c.cols || b.rows != c.rows || b.cols != c.cols)
+		return;
+
+	for (int i = 0; i < c.rows; i++)
+		for (int j = 0; j < c.cols; j++)
+			M(c, i, j) = M(a, i, j) + M(b, i, j);
+}
+
+void matrix_sub(const matrix_t a, const matrix_t b, matrix_t c)
+{
+	if (a.rows != c.rows || a.cols != c.cols || b.rows != c.rows || b.cols != c.cols)
+		return;
+
+	for (int i = 0; i < c.rows; i++)
+		for (int j = 0; j < c.cols; j++)
+			M(c, i, j) = M(a, i, j) - M(b, i, j);
+}
+
+void matrix_mult(const matrix_t a, const matrix_t b, matrix_t c)
+{
+	if (a.rows != c.rows || b.cols != c.cols || a.cols != b.rows)
+		return;
+
+	for (int i = 0; i < a.rows; i++) {
+		for (int j = 0; j < b.cols; j++) {
+			M(c, i, j) = 0;
+
+			for (int k = 0; k < a.cols; k++)
+				M(c, i, j) += M(a, i, k) * M(b, k, j);
+		}
+	}
+}
+
+void matrix_mult_scalar(const float f, const matrix_t a, matrix_t c)
+{
+	if (a.rows != c.rows || a.cols != c.cols)
+		return;
+
+	for (int i = 0; i < c.rows; i++)
+		for (int j = 0; j < c.cols; j++)
+			M(c, i, j) = f * M(a, i, j);
+}
+
+void matrix_mult_element(const matrix_t a, const matrix_t b, matrix_t c)
+{
+	if (a.rows != c.rows || a.cols != c.cols || b.rows != c.rows || b.cols != c.cols)
+		return;
+
+	for (int i = 0; i < c.rows; i++)
+		for (int j = 0; j < c.cols; j++)
+			M(c, i, j) = M(a, i, j) * M(b, i, j);
+}
+
+void kalman_correct(matrix_t c, matrix_t gain_start, matrix_t gain, matrix_t x_apriori, matrix_t x_aposteriori,
+		    float gainfactor, float measurement_a[], float mask_a[])
+{
+	matrix_t measurement = matrix_create(9, 1, measurement_a);
+	matrix_t mask = matrix_create(9, 1, mask_a);
+
+	float gain_start_part_a[12 * 9] = { };
+	matrix_t gain_start_part = matrix_create(12, 9, gain_start_part_a);
+	float gain_part_a[12 * 9] = { };
+	matrix_t gain_part = matrix_create(12, 9, gain_part_a);
+	float gain_sum_a[12 * 9] = { };
+	matrix_t gain_sum = matrix_create(12, 9, gain_sum_a);
+	float error_a[9] = { };
+	matrix_t error = matrix_create(9, 1, error_a);
+	float measurement_estimate_a[9] = { };
+	matrix_t measurement_estimate = matrix_create(9, 1, measurement_estimate_a);
+	float x_update_a[12] = { };
+	matrix_t x_update = matrix_create(12, 1, x_update_a);
+
+	matrix_mult(c, x_apriori, measurement_estimate);
+	matrix_sub(measurement, measurement_estimate, error);
+	matrix_mult_element(error, mask, error);
+	matrix_mult_scalar(gainfactor, gain, gain_part);
+	matrix_mult_scalar(1.0f - gainfactor, gain_start, gain_start_part);
+	matrix_add(gain_start_part, gain_part, gain_sum);
+	matrix_mult(gain_sum, error, x_update);
+	matrix_add(x_apriori, x_update, x_aposteriori);
+}
+
+} // namespace legacy
+
+const unsigned	iterations = 200000;
+
+/** keeps results alive */
+volatile float	sink;
+
+float	a_data[12 * 12], c_data[9 * 12], g_data[12 * 9], g0_data[12 * 9];
+float	x_data[12], xp_data[12], z_data[9], mask_data[9];
+float	b_data[4][9];
+
+void
+report(const char *name, uint64_t legacy_ns, uint64_t template_ns)
+{
+	double l = (double)legacy_ns / iterations;
+	double t = (double)template_ns / iterations;
+
+	printf("%-24s %8.1f ns %8.1f ns %6.1fx\n", name, l, t, l / t);
+}
+
+void
+bench_predict()
+{
+	using namespace legacy;
+	matrix_t a = matrix_create(12, 12, a_data);
+	matrix_t x = matrix_create(12, 1, x_data);
+	matrix_t xp = matrix_create(12, 1, xp_data);
+
+	uint64_t start = now_ns();
+
+	for (unsigned i = 0; i < iterations; i++) {
+		x_data[0] = (float)(i & 7);
+		matrix_mult(a, x, xp);
+		sink = xp_data[11];
+	}
+
+	uint64_t legacy_ns = now_ns() - start;
+
+	math::Matrix<float, 12, 12> A(a_data);
+	math::Vector<float, 12> X(x_data), XP;
+
+	start = now_ns();
+
+	for (unsigned i = 0; i < iterations; i++) {
+		X(0) = (float)(i & 7);
+		XP = A * X;
+		sink = XP(11);
+	}
+
+	report("predict 12x12 * 12", legacy_ns, now_ns() - start);
+}
+
+void
+bench_correct()
+{
+	using namespace legacy;
+	matrix_t c = matrix_create(9, 12, c_data);
+	matrix_t g0 = matrix_create(12, 9, g0_data);
+	matrix_t g = matrix_create(12, 9, g_data);
+	matrix_t xp = matrix_create(12, 1, xp_data);
+	matrix_t x = matrix_create(12, 1, x_data);
+
+	uint64_t start = now_ns();
+
+	for (unsigned i = 0; i < iterations; i++) {
+		z_data[0] = (float)(i & 7);
+		kalman_correct(c, g0, g, xp, x, 0.5f, z_data, mask_data);
+		sink = x_data[11];
+	}
+
+	uint64_t legacy_ns = now_ns() - start;
+
+	Kalman<12, 9> kalman;
+	kalman.init(a_data, c_data, g0_data, g_data, x_data, 1000);
+	Kalman<12, 9>::MeasurementVector z(z_data), mask(mask_data);
+
+	start = now_ns();
+
+	for (unsigned i = 0; i < iterations; i++) {
+		z(0) = (float)(i & 7);
+		kalman.correct(z, mask);
+		sink = kalman.get_state(11);
+	}
+
+	report("kalman correct 12x9", legacy_ns, now_ns() - start);
+}
+
+void
+bench_blocks()
+{
+	using namespace legacy;
+	float ab_data[9], cd_data[9], r_data[9];
+	matrix_t a = matrix_create(3, 3, b_data[0]);
+	matrix_t b = matrix_create(3, 3, b_data[1]);
+	matrix_t c = matrix_create(3, 3, b_data[2]);
+	matrix_t d = matrix_create(3, 3, b_data[3]);
+	matrix_t ab = matrix_create(3, 3, ab_data);
+	matrix_t cd = matrix_create(3, 3, cd_data);
+	matrix_t r = matrix_create(3, 3, r_data);
+
+	uint64_t start = now_ns();
+
+	for (unsigned i = 0; i < iterations; i++) {
+		b_data[0][0] = (float)(i & 7);
+		matrix_mult(a, b, ab);
+		matrix_mult(c, d, cd);
+		matrix_add(ab, cd, r);
+		sink = r_data[8];
+	}
+
+	uint64_t legacy_ns = now_ns() - start;
+
+	math::Matrix<float, 3, 3> A(b_data[0]), B(b_data[1]), C(b_data[2]), D(b_data[3]), R;
+
+	start = now_ns();
+
+	for (unsigned i = 0; i < iterations; i++) {
+		A(0, 0) = (float)(i & 7);
+		R = A * B + C * D;
+		sink = R(2, 2);
+	}
+
+	report("3x3 A * B + C * D", legacy_ns, now_ns() - start);
+}
+
+void
+bench_rotation()
+{
+	float in[3] = { 0.3f, -0.2f, 0.9f };
+	float out[3];
+
+	uint64_t start = now_ns();
+
+	for (unsigned i = 0; i < iterations; i++) {
+		float roll = 0.001f * (i & 1023), pitch = 0.002f * (i & 511), yaw = 0.003f * (i & 255);
+
+		/* the expressions fixedwing_control used to evaluate */
+		out[0] = cosf(yaw) * cosf(pitch) * in[0] +
+			 (cosf(yaw) * sinf(pitch) * sinf(roll) + sinf(yaw) * cosf(roll)) * in[1]
+			 + (-cosf(yaw) * sinf(pitch) * cosf(roll)  + sinf(yaw) * sinf(roll)) * in[2];
+		out[1] = -sinf(yaw) * cosf(pitch) * in[0] +
+			 (-sinf(yaw) * sinf(pitch) * sinf(roll) + cosf(yaw) * cosf(roll)) * in[1]
+			 + (sinf(yaw) * sinf(pitch) * cosf(roll) + cosf(yaw) * sinf(roll)) * in[2];
+		out[2] = sinf(pitch) * in[0] - cosf(pitch) * sinf(roll) * in[1] + cosf(pitch) * cosf(roll) * in[2];
+		sink = out[0] + out[1] + out[2];
+	}
+
+	uint64_t legacy_ns = now_ns() - start;
+
+	start = now_ns();
+
+	for (unsigned i = 0; i < iterations; i++) {
+		float roll = 0.001f * (i & 1023), pitch = 0.002f * (i & 511), yaw = 0.003f * (i & 255);
+
+		rotation_to_body(roll, pitch, yaw, in, out);
+		sink = out[0] + out[1] + out[2];
+	}
+
+	report("fixed wing rotation", legacy_ns, now_ns() - start);
+}
+
+} // namespace
+
+int
+main(int argc, char *argv[])
+{
+	for (unsigned i = 0; i < 12 * 12; i++)
+		a_data[i] = (i % 13) ? 0.001f * (i % 5) : 1.0f;
+
+	for (unsigned i = 0; i < 12 * 9; i++) {
+		c_data[i] = (i % 13) ? 0.0f : 1.0f;
+		g_data[i] = 0.01f * (i % 7);
+		g0_data[i] = 0.02f * (i % 3);
+	}
+
+	for (unsigned i = 0; i < 12; i++)
+		x_data[i] = xp_data[i] = 0.1f * i;
+
+	for (unsigned i = 0; i < 9; i++) {
+		z_data[i] = 0.2f * i;
+		mask_data[i] = 1.0f;
+	}
+
+	for (unsigned b = 0; b < 4; b++)
+		for (unsigned i = 0; i < 9; i++)
+			b_data[b][i] = 0.1f * (b + i);
+
+	printf("%-24s %11s %11s %7s\n", "", "matrix_t", "Matrix<>", "");
+	bench_predict();
+	bench_correct();
+	bench_blocks();
+	bench_rotation();
+	return 0;
+}
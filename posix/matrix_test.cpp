@@ -0,0 +1,313 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2012 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file Checks the fixed-size matrix library and its users.
+ */
+
+#include <nuttx/config.h>
+
+#include <stdio.h>
+#include <stdint.h>
+#include <math.h>
+
+#include <systemlib/matrix.h>
+#include <px4/attitude_estimator_bm/kalman.h>
+#include <fixedwing_control/rotation.h>
+
+using namespace math;
+
+#include "test_util.h"
+
+namespace
+{
+
+template<unsigned M, unsigned N>
+void
+randomise(Matrix<float, M, N> &m)
+{
+	for (unsigned i = 0; i < M; i++)
+		for (unsigned j = 0; j < N; j++)
+			m(i, j) = noise();
+}
+
+/** reference product, in double */
+template<unsigned M, unsigned K, unsigned N>
+void
+multiply(const Matrix<float, M, K> &a, const Matrix<float, K, N> &b, double r[M][N])
+{
+	for (unsigned i = 0; i < M; i++) {
+		for (unsigned j = 0; j < N; j++) {
+			r[i][j] = 0;
+
+			for (unsigned k = 0; k < K; k++)
+				r[i][j] += (double)a(i, k) * b(k, j);
+		}
+	}
+}
+
+/** largest difference between a matrix and a reference */
+template<unsigned M, unsigned N>
+double
+difference(const Matrix<float, M, N> &m, const double r[M][N])
+{
+	double diff = 0;
+
+	for (unsigned i = 0; i < M; i++)
+		for (unsigned j = 0; j < N; j++)
+			diff = fmax(diff, fabs(m(i, j) - r[i][j]));
+
+	return diff;
+}
+
+const double	tolerance = 1e-5;
+
+} // namespace
+
+int
+main(int argc, char *argv[])
+{
+	Matrix<float, 4, 3> A, C;
+	Matrix<float, 3, 5> B, D;
+	Matrix<float, 5, 2> E;
+	Matrix<float, 4, 5> X;
+	double r[4][5], r2[4][5];
+
+	randomise(A);
+	randomise(B);
+	randomise(C);
+	randomise(D);
+	randomise(E);
+
+	/* product */
+	X = A * B;
+	multiply(A, B, r);
+
+	if (difference(X, r) > tolerance)
+		return fail("product: error %g", difference(X, r));
+
+	/* fused sum of products */
+	X = A * B + C * D;
+	multiply(C, D, r2);
+
+	for (unsigned i = 0; i < 4; i++)
+		for (unsigned j = 0; j < 5; j++)
+			r[i][j] += r2[i][j];
+
+	if (difference(X, r) > tolerance)
+		return fail("sum of products: error %g", difference(X, r));
+
+	/* difference, scaling and negation, evaluated in place */
+	Matrix<float, 4, 5> Y = X;
+	X = 2.0f * X - X * 0.5f + -X;
+
+	for (unsigned i = 0; i < 4; i++)
+		for (unsigned j = 0; j < 5; j++)
+			r[i][j] = 0.5 * Y(i, j);
+
+	if (difference(X, r) > tolerance)
+		return fail("scaling: error %g", difference(X, r));
+
+	X += Y;
+	X -= Y * 0.5f;
+	X *= 2.0f;
+
+	for (unsigned i = 0; i < 4; i++)
+		for (unsigned j = 0; j < 5; j++)
+			r[i][j] = 2.0 * Y(i, j);
+
+	if (difference(X, r) > tolerance)
+		return fail("compound assignment: error %g", difference(X, r));
+
+	/* transposes, and products of expressions */
+	Matrix<float, 3, 4> At = A.transpose();
+
+	for (unsigned i = 0; i < 4; i++)
+		for (unsigned j = 0; j < 3; j++)
+			if (At(j, i) != A(i, j))
+				return fail("transpose");
+
+	Matrix<float, 4, 2> Z = (A * B) * E;
+	Matrix<float, 4, 5> AB = A * B;
+	double r3[4][2];
+
+	multiply(AB, E, r3);
+
+	if (difference(Z, r3) > tolerance)
+		return fail("product of a product: error %g", difference(Z, r3));
+
+	Z = (A + C) * (B - D) * E + At.transpose() * (B * E);
+	Matrix<float, 4, 3> AC = A + C;
+	Matrix<float, 3, 5> BD = B - D;
+	Matrix<float, 4, 5> ACBD = AC * BD;
+	Matrix<float, 3, 2> BE = B * E;
+	double r4[4][2];
+
+	multiply(ACBD, E, r3);
+	multiply(A, BE, r4);
+
+	for (unsigned i = 0; i < 4; i++)
+		for (unsigned j = 0; j < 2; j++)
+			r3[i][j] += r4[i][j];
+
+	if (difference(Z, r3) > tolerance)
+		return fail("products of expressions: error %g", difference(Z, r3));
+
+	Matrix<float, 3, 3> I;
+	I.set_identity();
+	Matrix<float, 4, 3> AI = A * I;
+
+	for (unsigned i = 0; i < 4; i++)
+		for (unsigned j = 0; j < 3; j++)
+			if (AI(i, j) != A(i, j))
+				return fail("identity");
+
+	/* vectors */
+	const float u_data[3] = { 1.0f, 2.0f, 3.0f };
+	const float v_data[3] = { -2.0f, 0.5f, 4.0f };
+	Vector<float, 3> u(u_data), v(v_data);
+	Vector<float, 3> w = cross(u, v);
+
+	if (w(0) != 6.5f || w(1) != -10.0f || w[2] != 4.5f)
+		return fail("cross product");
+
+	if (dot(u, v) != 11.0f || fabs(norm(u) - sqrt(14.0)) > tolerance || dot(w, u) != 0.0f)
+		return fail("dot product or norm");
+
+	w = emult(u, v) + u;
+
+	if (w(0) != -1.0f || w(1) != 3.0f || w(2) != 15.0f)
+		return fail("element-wise product");
+
+	/* the blackmagic filter against the equations it implements */
+	const unsigned S = 12, Mz = 9;
+	float a[S * S], c[Mz * S], g0[S * Mz], g[S * Mz], x0[S];
+
+	for (unsigned i = 0; i < S * S; i++)
+		a[i] = ((i % (S + 1)) == 0 ? 0.95f : 0.0f) + 0.01f * noise();
+
+	/* small gains, so the filter is stable and rounding does not grow */
+	for (unsigned i = 0; i < Mz * S; i++) {
+		c[i] = 0.3f * noise();
+		g0[i] = 0.05f * noise();
+		g[i] = 0.05f * noise();
+	}
+
+	for (unsigned i = 0; i < S; i++)
+		x0[i] = noise();
+
+	Kalman<S, Mz> kalman;
+	kalman.init(a, c, g0, g, x0, 10);
+
+	double x[S], gainfactor = 0;
+
+	for (unsigned i = 0; i < S; i++)
+		x[i] = x0[i];
+
+	for (unsigned step = 0; step < 50; step++) {
+		Kalman<S, Mz>::MeasurementVector z, mask;
+
+		for (unsigned i = 0; i < Mz; i++) {
+			z(i) = noise();
+			mask(i) = (i == step % Mz) ? 0.0f : 1.0f;
+		}
+
+		kalman.predict();
+		kalman.correct(z, mask);
+
+		double xp[S], e[Mz];
+
+		for (unsigned i = 0; i < S; i++) {
+			xp[i] = 0;
+
+			for (unsigned k = 0; k < S; k++)
+				xp[i] += a[i * S + k] * x[k];
+		}
+
+		for (unsigned i = 0; i < Mz; i++) {
+			e[i] = z(i);
+
+			for (unsigned k = 0; k < S; k++)
+				e[i] -= c[i * S + k] * xp[k];
+
+			e[i] *= mask(i);
+		}
+
+		gainfactor = gainfactor * (1.0 - 1.0 / 10) + 1.0 / 10;
+
+		for (unsigned i = 0; i < S; i++) {
+			x[i] = xp[i];
+
+			for (unsigned k = 0; k < Mz; k++)
+				x[i] += (gainfactor * g[i * Mz + k] + (1.0 - gainfactor) * g0[i * Mz + k]) * e[k];
+		}
+
+		for (unsigned i = 0; i < S; i++)
+			if (fabs(kalman.get_state(i) - x[i]) > tolerance * fmax(1.0, fabs(x[i])))
+				return fail("kalman step %u: state differs by %g", step, fabs(kalman.get_state(i) - x[i]));
+	}
+
+	/* the fixed wing rotations against the expressions they replaced */
+	for (unsigned trial = 0; trial < 100; trial++) {
+		float roll = 3.0f * noise(), pitch = 1.5f * noise(), yaw = 3.0f * noise();
+		float in[3] = { noise(), noise(), noise() };
+		float out[3], ref[3];
+
+		ref[0] = cosf(yaw) * cosf(pitch) * in[0] +
+			 (cosf(yaw) * sinf(pitch) * sinf(roll) + sinf(yaw) * cosf(roll)) * in[1]
+			 + (-cosf(yaw) * sinf(pitch) * cosf(roll)  + sinf(yaw) * sinf(roll)) * in[2];
+		ref[1] = -sinf(yaw) * cosf(pitch) * in[0] +
+			 (-sinf(yaw) * sinf(pitch) * sinf(roll) + cosf(yaw) * cosf(roll)) * in[1]
+			 + (sinf(yaw) * sinf(pitch) * cosf(roll) + cosf(yaw) * sinf(roll)) * in[2];
+		ref[2] = sinf(pitch) * in[0] - cosf(pitch) * sinf(roll) * in[1] + cosf(pitch) * cosf(roll) * in[2];
+
+		rotation_to_body(roll, pitch, yaw, in, out);
+
+		for (unsigned i = 0; i < 3; i++)
+			if (fabs(out[i] - ref[i]) > tolerance)
+				return fail("rotation to body: error %g", fabs(out[i] - ref[i]));
+
+		ref[0] = in[0] - sinf(pitch) * in[2];
+		ref[1] = cosf(roll) * in[1] + sinf(roll) * cosf(pitch) * in[2];
+		ref[2] = -sinf(roll) * in[1] + cosf(roll) * cosf(pitch) * in[2];
+
+		rotation_body_rates(roll, pitch, in, out);
+
+		for (unsigned i = 0; i < 3; i++)
+			if (fabs(out[i] - ref[i]) > tolerance)
+				return fail("body rates: error %g", fabs(out[i] - ref[i]));
+	}
+
+	printf("PASS\n");
+	return 0;
+}
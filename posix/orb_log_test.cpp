@@ -0,0 +1,199 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2012 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file Records a topic with orb_record and plays it back with orb_replay.
+ */
+
+#include <nuttx/config.h>
+
+#include <stdio.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+
+#include <arch/board/up_hrt.h>
+
+#include <uORB/uORB.h>
+
+#include "test_util.h"
+
+extern "C" int uorb_main(int argc, char *argv[]);
+extern "C" int orb_record_main(int argc, char *argv[]);
+extern "C" int orb_replay_main(int argc, char *argv[]);
+
+struct orb_log_test {
+	unsigned	seq;
+	hrt_abstime	sent;
+};
+
+ORB_DEFINE(orb_log_test, struct orb_log_test);
+
+namespace
+{
+
+const char	*log_file = "/tmp/orb_log_test.bin";
+const unsigned	updates = 200;
+const unsigned	spacing = 2000;		/**< us between recorded updates */
+
+int
+command(int (*entry)(int, char **), const char *a0, const char *a1, const char *a2 = nullptr, const char *a3 = nullptr)
+{
+	const char *argv[] = { a0, a1, a2, a3, nullptr };
+	int argc = 2 + (a2 != nullptr) + (a3 != nullptr);
+
+	return entry(argc, (char **)argv);
+}
+
+/**
+ * Replay the recording and check that the updates come back in order.
+ *
+ * @return		Time from the first to the last replayed update, or
+ *			zero on failure.
+ */
+hrt_abstime
+replay(bool fast)
+{
+	int sub = orb_subscribe(ORB_ID(orb_log_test));
+	struct orb_log_test t;
+	hrt_abstime first = 0, last = 0;
+
+	if (sub < 0) {
+		fail("subscribe");
+		return 0;
+	}
+
+	if ((fast && command(orb_replay_main, "orb_replay", "start", "-f", log_file)) ||
+	    (!fast && command(orb_replay_main, "orb_replay", "start", log_file))) {
+		fail("orb_replay start");
+		close(sub);
+		return 0;
+	}
+
+	unsigned next = 0;
+	unsigned received = 0;
+
+	while (next < updates) {
+		struct pollfd fds = { .fd = sub, .events = POLLIN, .revents = 0 };
+
+		if (poll(&fds, 1, 1000) != 1) {
+			fprintf(stderr, "FAIL: timed out waiting for update %u\n", next);
+			break;
+		}
+
+		orb_copy(ORB_ID(orb_log_test), sub, &t);
+		last = hrt_absolute_time();
+
+		if (received++ == 0)
+			first = last;
+
+		/* a slow reader may miss updates, but never sees them out of order */
+		if (t.seq < next) {
+			fprintf(stderr, "FAIL: update %u arrived after %u\n", t.seq, next - 1);
+			break;
+		}
+
+		next = t.seq + 1;
+	}
+
+	if (next == updates)
+		printf("%s replay: %u of %u updates seen\n", fast ? "fast" : "timed", received, updates);
+
+	command(orb_replay_main, "orb_replay", "stop");
+	close(sub);
+
+	return (next == updates) ? (last - first + 1) : 0;
+}
+
+} // namespace
+
+int
+main(int argc, char *argv[])
+{
+	struct orb_log_test t = { 0, 0 };
+
+	if (OK != command(uorb_main, "uorb", "start"))
+		return 1;
+
+	int pub = orb_advertise(ORB_ID(orb_log_test), &t);
+
+	if (pub < 0)
+		return fail("advertise");
+
+	if (command(orb_record_main, "orb_record", "start", log_file, "orb_log_test"))
+		return fail("orb_record start");
+
+	/* the recorder picks the topic up on its first scan */
+	usleep(100000);
+
+	for (unsigned i = 0; i < updates; i++) {
+		t.seq = i;
+		t.sent = hrt_absolute_time();
+		orb_publish(ORB_ID(orb_log_test), pub, &t);
+		usleep(spacing);
+	}
+
+	usleep(100000);
+	command(orb_record_main, "orb_record", "stop");
+
+	/* the replay publishes in place of the original publisher */
+	close(pub);
+
+	hrt_abstime recorded = (updates - 1) * spacing;
+	hrt_abstime timed = replay(false);
+
+	if (timed == 0)
+		return 1;
+
+	printf("timed replay: %u updates over %uus (recorded over at least %uus)\n",
+	       updates, (unsigned)timed, (unsigned)recorded);
+
+	/* sleeps only ever overshoot, so allow some slack above and a little below */
+	if ((timed < recorded * 9 / 10) || (timed > recorded * 2))
+		return fail("timed replay did not keep the recorded spacing");
+
+	hrt_abstime fast = replay(true);
+
+	if (fast == 0)
+		return 1;
+
+	printf("fast replay: %uus\n", (unsigned)fast);
+
+	if (fast >= timed)
+		return fail("fast replay was not faster");
+
+	unlink(log_file);
+	printf("PASS\n");
+
+	return 0;
+}
@@ -0,0 +1,244 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2012 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file HRT emulation for the POSIX host build.
+ *
+ * Callouts are kept on a list sorted by deadline and run by a dedicated
+ * thread, which marks itself as being in interrupt context and holds the
+ * interrupt lock while they run.
+ */
+
+#include <nuttx/config.h>
+#include <arch/irq.h>
+#include <arch/board/up_hrt.h>
+
+#include <pthread.h>
+#include <time.h>
+#include <errno.h>
+
+extern __thread bool posix_in_interrupt;
+
+namespace
+{
+
+struct hrt_call	*callout_queue;		/**< pending callouts, sorted by deadline */
+pthread_mutex_t	callout_mutex = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t	callout_cond;		/**< signalled when the head of the queue changes */
+pthread_t	callout_thread;
+bool		callout_thread_started;
+
+void
+hrt_call_enter(struct hrt_call *entry)
+{
+	struct hrt_call **pp = &callout_queue;
+
+	while ((*pp != nullptr) && ((*pp)->deadline <= entry->deadline))
+		pp = &(*pp)->link;
+
+	entry->link = *pp;
+	*pp = entry;
+
+	/* wake the callout thread if the next deadline changed */
+	if (callout_queue == entry)
+		pthread_cond_signal(&callout_cond);
+}
+
+void
+hrt_call_remove(struct hrt_call *entry)
+{
+	for (struct hrt_call **pp = &callout_queue; *pp != nullptr; pp = &(*pp)->link) {
+		if (*pp == entry) {
+			*pp = entry->link;
+			break;
+		}
+	}
+}
+
+void *
+hrt_callout_thread(void *arg)
+{
+	posix_in_interrupt = true;
+
+	for (;;) {
+		irqstate_t flags = irqsave();
+		hrt_abstime now = hrt_absolute_time();
+		struct hrt_call *call;
+
+		while (((call = callout_queue) != nullptr) && (call->deadline <= now)) {
+			callout_queue = call->link;
+
+			/* save the intended deadline for periodic calls */
+			hrt_abstime deadline = call->deadline;
+
+			/* zero the deadline, as the call has occurred */
+			call->deadline = 0;
+
+			if (call->callout)
+				call->callout(call->arg);
+
+			/* if the callout has a non-zero period, it has to be re-entered */
+			if (call->period != 0) {
+				call->deadline = deadline + call->period;
+				hrt_call_enter(call);
+			}
+		}
+
+		/*
+		 * Sleep until the next deadline, or until an earlier one is entered.
+		 * Take the queue mutex before letting other threads in, so that a
+		 * callout entered meanwhile cannot signal before we wait.
+		 */
+		struct timespec ts;
+		hrt_abstime wake = (callout_queue != nullptr) ? callout_queue->deadline : (now + 100000);
+
+		pthread_mutex_lock(&callout_mutex);
+		irqrestore(flags);
+
+		/* the condition uses CLOCK_MONOTONIC, the same clock as hrt_absolute_time */
+		abstime_to_ts(&ts, wake);
+		pthread_cond_timedwait(&callout_cond, &callout_mutex, &ts);
+
+		pthread_mutex_unlock(&callout_mutex);
+	}
+
+	return nullptr;
+}
+
+void
+hrt_call_internal(struct hrt_call *entry, hrt_abstime deadline, hrt_abstime interval, hrt_callout callout, void *arg)
+{
+	irqstate_t flags = irqsave();
+	pthread_mutex_lock(&callout_mutex);
+
+	if (!callout_thread_started)
+		hrt_init();
+
+	/* if the entry is currently queued, remove it */
+	if (entry->deadline != 0)
+		hrt_call_remove(entry);
+
+	entry->deadline = deadline;
+	entry->period = interval;
+	entry->callout = callout;
+	entry->arg = arg;
+
+	hrt_call_enter(entry);
+
+	pthread_mutex_unlock(&callout_mutex);
+	irqrestore(flags);
+}
+
+} // namespace
+
+hrt_abstime
+hrt_absolute_time(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts_to_abstime(&ts);
+}
+
+hrt_abstime
+ts_to_abstime(struct timespec *ts)
+{
+	return ((hrt_abstime)ts->tv_sec * 1000000) + (ts->tv_nsec / 1000);
+}
+
+void
+abstime_to_ts(struct timespec *ts, hrt_abstime abstime)
+{
+	ts->tv_sec = abstime / 1000000;
+	ts->tv_nsec = (abstime % 1000000) * 1000;
+}
+
+void
+hrt_call_after(struct hrt_call *entry, hrt_abstime delay, hrt_callout callout, void *arg)
+{
+	hrt_call_internal(entry, hrt_absolute_time() + delay, 0, callout, arg);
+}
+
+void
+hrt_call_at(struct hrt_call *entry, hrt_abstime calltime, hrt_callout callout, void *arg)
+{
+	hrt_call_internal(entry, calltime, 0, callout, arg);
+}
+
+void
+hrt_call_every(struct hrt_call *entry, hrt_abstime delay, hrt_abstime interval, hrt_callout callout, void *arg)
+{
+	hrt_call_internal(entry, hrt_absolute_time() + delay, interval, callout, arg);
+}
+
+bool
+hrt_called(struct hrt_call *entry)
+{
+	return (entry->deadline == 0);
+}
+
+void
+hrt_cancel(struct hrt_call *entry)
+{
+	irqstate_t flags = irqsave();
+
+	hrt_call_remove(entry);
+	entry->deadline = 0;
+
+	/* if this is a periodic call being removed by the callout, prevent it from
+	 * being re-entered when the callout returns.
+	 */
+	entry->period = 0;
+
+	irqrestore(flags);
+}
+
+void
+hrt_init(void)
+{
+	irqstate_t flags = irqsave();
+
+	if (!callout_thread_started) {
+		pthread_condattr_t attr;
+
+		pthread_condattr_init(&attr);
+		pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+		pthread_cond_init(&callout_cond, &attr);
+		pthread_condattr_destroy(&attr);
+
+		pthread_create(&callout_thread, nullptr, hrt_callout_thread, nullptr);
+		callout_thread_started = true;
+	}
+
+	irqrestore(flags);
+}
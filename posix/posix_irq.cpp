@@ -0,0 +1,101 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2012 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file Interrupt emulation for the POSIX host build.
+ */
+
+#include <nuttx/config.h>
+#include <arch/irq.h>
+
+#include <pthread.h>
+
+namespace
+{
+
+pthread_mutex_t	irq_lock;
+pthread_once_t	irq_once = PTHREAD_ONCE_INIT;
+
+void
+irq_lock_init()
+{
+	pthread_mutexattr_t attr;
+
+	/* irqsave() nests, e.g. poll_notify() inside a callout */
+	pthread_mutexattr_init(&attr);
+	pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+	pthread_mutex_init(&irq_lock, &attr);
+	pthread_mutexattr_destroy(&attr);
+}
+
+} // namespace
+
+/** set while the current thread is running HRT callouts */
+__thread bool posix_in_interrupt;
+
+irqstate_t
+irqsave(void)
+{
+	pthread_once(&irq_once, irq_lock_init);
+	pthread_mutex_lock(&irq_lock);
+	return 0;
+}
+
+void
+irqrestore(irqstate_t flags)
+{
+	pthread_mutex_unlock(&irq_lock);
+}
+
+bool
+up_interrupt_context(void)
+{
+	return posix_in_interrupt;
+}
+
+void
+up_enable_irq(int irq)
+{
+}
+
+void
+up_disable_irq(int irq)
+{
+}
+
+int
+irq_attach(int irq, xcpt_t isr)
+{
+	/* there are no device interrupts on the host */
+	return -1;
+}
@@ -0,0 +1,121 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2012 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file Task emulation for the POSIX host build.
+ */
+
+#include <nuttx/config.h>
+
+#include <sched.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+namespace
+{
+
+struct task_start {
+	main_t		entry;
+	const char	**argv;
+	const char	*name;
+	pid_t		pid;
+	pthread_mutex_t	lock;
+	pthread_cond_t	started;
+};
+
+void *
+task_trampoline(void *arg)
+{
+	struct task_start *ts = (struct task_start *)arg;
+	main_t entry = ts->entry;
+	const char *argv[2] = { ts->name, nullptr };
+	const char **args = (ts->argv != nullptr) ? ts->argv : argv;
+	int argc = 0;
+
+	while (args[argc] != nullptr)
+		argc++;
+
+	/* tell the creator who we are; ts is gone once it wakes */
+	pthread_mutex_lock(&ts->lock);
+	ts->pid = syscall(SYS_gettid);
+	pthread_cond_signal(&ts->started);
+	pthread_mutex_unlock(&ts->lock);
+
+	entry(argc, (char **)args);
+
+	return nullptr;
+}
+
+} // namespace
+
+int
+task_create(const char *name, int priority, int stack_size, main_t entry, const char *argv[])
+{
+	struct task_start ts;
+	pthread_attr_t attr;
+	pthread_t thread;
+
+	ts.entry = entry;
+	ts.argv = argv;
+	ts.name = name;
+	ts.pid = 0;
+	pthread_mutex_init(&ts.lock, nullptr);
+	pthread_cond_init(&ts.started, nullptr);
+
+	pthread_attr_init(&attr);
+	pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+
+	pthread_mutex_lock(&ts.lock);
+
+	int ret = pthread_create(&thread, &attr, task_trampoline, &ts);
+
+	if (ret == 0) {
+		while (ts.pid == 0)
+			pthread_cond_wait(&ts.started, &ts.lock);
+	}
+
+	pthread_mutex_unlock(&ts.lock);
+	pthread_attr_destroy(&attr);
+	pthread_cond_destroy(&ts.started);
+	pthread_mutex_destroy(&ts.lock);
+
+	if (ret != 0) {
+		errno = ret;
+		return -1;
+	}
+
+	return ts.pid;
+}
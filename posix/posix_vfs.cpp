@@ -0,0 +1,357 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2012 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file Stand-in VFS for the POSIX host build.
+ *
+ * Character drivers registered with register_driver() live in a private
+ * namespace. The host build links with --wrap for open, close, read,
+ * write, ioctl and poll, so calls made by the code under test land here;
+ * descriptors that belong to the host (stdio, real files) are passed
+ * through to the C library.
+ *
+ * Every thread is its own "task" as far as getpid() is concerned, which
+ * is what uORB's single-publisher check expects.
+ */
+
+#include <nuttx/config.h>
+#include <nuttx/fs/fs.h>
+
+#include <sys/syscall.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+
+extern "C" {
+	int	__real_open(const char *path, int oflags, ...);
+	int	__real_close(int fd);
+	ssize_t	__real_read(int fd, void *buffer, size_t buflen);
+	ssize_t	__real_write(int fd, const void *buffer, size_t buflen);
+
+	int	__wrap_open(const char *path, int oflags, ...);
+	int	__wrap_close(int fd);
+	ssize_t	__wrap_read(int fd, void *buffer, size_t buflen);
+	ssize_t	__wrap_write(int fd, const void *buffer, size_t buflen);
+	int	__wrap_ioctl(int fd, int cmd, unsigned long arg);
+	int	__wrap_poll(struct pollfd *fds, nfds_t nfds, int timeout);
+	pid_t	__wrap_getpid(void);
+}
+
+namespace
+{
+
+static const unsigned	max_drivers = 128;
+static const unsigned	max_files = CONFIG_NFILE_DESCRIPTORS;
+
+/** descriptors at or above this are ours, below it they belong to the host */
+static const int	fd_base = 1000;
+
+struct driver {
+	char		*path;
+	struct inode	inode;
+};
+
+driver		drivers[max_drivers];
+struct file	files[max_files];
+bool		files_used[max_files];
+pthread_mutex_t	vfs_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+struct file *
+fd_to_file(int fd)
+{
+	if ((fd < fd_base) || (fd >= (int)(fd_base + max_files)) || !files_used[fd - fd_base])
+		return nullptr;
+
+	return &files[fd - fd_base];
+}
+
+/**
+ * Convert a driver return into the libc convention.
+ */
+int
+driver_ret(int ret)
+{
+	if (ret < 0) {
+		errno = -ret;
+		return -1;
+	}
+
+	return ret;
+}
+
+} // namespace
+
+int
+register_driver(const char *path, const struct file_operations *fops, mode_t mode, void *priv)
+{
+	int ret = -ENOMEM;
+
+	pthread_mutex_lock(&vfs_mutex);
+
+	for (unsigned i = 0; i < max_drivers; i++) {
+		if ((drivers[i].path != nullptr) && !strcmp(drivers[i].path, path)) {
+			ret = -EEXIST;
+			break;
+		}
+	}
+
+	for (unsigned i = 0; (ret == -ENOMEM) && (i < max_drivers); i++) {
+		if (drivers[i].path == nullptr) {
+			drivers[i].path = strdup(path);
+			drivers[i].inode.i_ops = fops;
+			drivers[i].inode.i_private = priv;
+			ret = OK;
+		}
+	}
+
+	pthread_mutex_unlock(&vfs_mutex);
+
+	return ret;
+}
+
+int
+unregister_driver(const char *path)
+{
+	int ret = -ENOENT;
+
+	pthread_mutex_lock(&vfs_mutex);
+
+	for (unsigned i = 0; i < max_drivers; i++) {
+		if ((drivers[i].path != nullptr) && !strcmp(drivers[i].path, path)) {
+			free(drivers[i].path);
+			drivers[i].path = nullptr;
+			ret = OK;
+			break;
+		}
+	}
+
+	pthread_mutex_unlock(&vfs_mutex);
+
+	return ret;
+}
+
+int
+__wrap_open(const char *path, int oflags, ...)
+{
+	struct file *filp = nullptr;
+	bool found = false;
+	int fd = -1;
+
+	pthread_mutex_lock(&vfs_mutex);
+
+	for (unsigned i = 0; i < max_drivers; i++) {
+		if ((drivers[i].path == nullptr) || strcmp(drivers[i].path, path))
+			continue;
+
+		found = true;
+
+		for (unsigned f = 0; f < max_files; f++) {
+			if (!files_used[f]) {
+				files_used[f] = true;
+				filp = &files[f];
+				memset(filp, 0, sizeof(*filp));
+				filp->f_oflags = oflags;
+				filp->f_inode = &drivers[i].inode;
+				fd = fd_base + f;
+				break;
+			}
+		}
+
+		break;
+	}
+
+	pthread_mutex_unlock(&vfs_mutex);
+
+	/* not one of ours, hand it to the host */
+	if (!found) {
+		va_list ap;
+		va_start(ap, oflags);
+		mode_t mode = va_arg(ap, int);
+		va_end(ap);
+
+		return __real_open(path, oflags, mode);
+	}
+
+	if (fd < 0) {
+		errno = EMFILE;
+		return -1;
+	}
+
+	int ret = OK;
+
+	if (filp->f_inode->i_ops->open != nullptr)
+		ret = filp->f_inode->i_ops->open(filp);
+
+	if (ret < 0) {
+		files_used[fd - fd_base] = false;
+		return driver_ret(ret);
+	}
+
+	return fd;
+}
+
+int
+__wrap_close(int fd)
+{
+	struct file *filp = fd_to_file(fd);
+
+	if (filp == nullptr)
+		return __real_close(fd);
+
+	int ret = OK;
+
+	if (filp->f_inode->i_ops->close != nullptr)
+		ret = filp->f_inode->i_ops->close(filp);
+
+	files_used[fd - fd_base] = false;
+
+	return driver_ret(ret);
+}
+
+ssize_t
+__wrap_read(int fd, void *buffer, size_t buflen)
+{
+	struct file *filp = fd_to_file(fd);
+
+	if (filp == nullptr)
+		return __real_read(fd, buffer, buflen);
+
+	return driver_ret(filp->f_inode->i_ops->read(filp, (char *)buffer, buflen));
+}
+
+ssize_t
+__wrap_write(int fd, const void *buffer, size_t buflen)
+{
+	struct file *filp = fd_to_file(fd);
+
+	if (filp == nullptr)
+		return __real_write(fd, buffer, buflen);
+
+	return driver_ret(filp->f_inode->i_ops->write(filp, (const char *)buffer, buflen));
+}
+
+int
+__wrap_ioctl(int fd, int cmd, unsigned long arg)
+{
+	struct file *filp = fd_to_file(fd);
+
+	if (filp == nullptr) {
+		errno = ENOTTY;
+		return -1;
+	}
+
+	return driver_ret(filp->f_inode->i_ops->ioctl(filp, cmd, arg));
+}
+
+int
+__wrap_poll(struct pollfd *fds, nfds_t nfds, int timeout)
+{
+	struct poll_sem sem;
+	int count = 0;
+
+	pthread_mutex_init(&sem.mutex, nullptr);
+	pthread_condattr_t attr;
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	pthread_cond_init(&sem.cond, &attr);
+	pthread_condattr_destroy(&attr);
+	sem.semcount = 0;
+
+	/* set up the waiters; drivers post the semaphore if they are ready now */
+	for (unsigned i = 0; i < nfds; i++) {
+		struct file *filp = fd_to_file(fds[i].fd);
+
+		fds[i].sem = &sem;
+		fds[i].revents = 0;
+
+		if (filp == nullptr) {
+			fds[i].revents = POLLNVAL;
+			sem_post(&sem);
+
+		} else if (filp->f_inode->i_ops->poll != nullptr) {
+			filp->f_inode->i_ops->poll(filp, &fds[i], true);
+		}
+	}
+
+	pthread_mutex_lock(&sem.mutex);
+
+	if (timeout < 0) {
+		while (sem.semcount <= 0)
+			pthread_cond_wait(&sem.cond, &sem.mutex);
+
+	} else if (timeout > 0) {
+		struct timespec ts;
+
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		ts.tv_sec += timeout / 1000;
+		ts.tv_nsec += (timeout % 1000) * 1000000;
+
+		if (ts.tv_nsec >= 1000000000) {
+			ts.tv_sec++;
+			ts.tv_nsec -= 1000000000;
+		}
+
+		while (sem.semcount <= 0) {
+			if (pthread_cond_timedwait(&sem.cond, &sem.mutex, &ts) == ETIMEDOUT)
+				break;
+		}
+	}
+
+	pthread_mutex_unlock(&sem.mutex);
+
+	/* tear down and count the descriptors with events */
+	for (unsigned i = 0; i < nfds; i++) {
+		struct file *filp = fd_to_file(fds[i].fd);
+
+		if ((filp != nullptr) && (filp->f_inode->i_ops->poll != nullptr))
+			filp->f_inode->i_ops->poll(filp, &fds[i], false);
+
+		if (fds[i].revents != 0)
+			count++;
+	}
+
+	pthread_cond_destroy(&sem.cond);
+	pthread_mutex_destroy(&sem.mutex);
+
+	return count;
+}
+
+pid_t
+__wrap_getpid(void)
+{
+	return syscall(SYS_gettid);
+}
@@ -0,0 +1,185 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2012 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file Exercises the driver report ring buffer on the host.
+ */
+
+#include <nuttx/config.h>
+
+#include <stdio.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#include <drivers/device/ringbuffer.h>
+
+#include "test_util.h"
+
+namespace
+{
+
+struct report {
+	uint32_t	seq;
+	uint32_t	check;		/**< ~seq, to catch torn copies */
+	uint64_t	pad[4];
+};
+
+const unsigned	produced = 500000;
+
+device::RingBuffer<struct report> *ring;
+volatile bool	producer_done;
+
+void *
+producer(void *arg)
+{
+	struct report r = {};
+
+	for (unsigned i = 0; i < produced; i++) {
+		r.seq = i;
+		r.check = ~i;
+		ring->force(r);
+
+		/* leave the consumer a chance to keep up some of the time */
+		for (volatile unsigned j = 0; j < (i % 100); j++)
+			;
+	}
+
+	producer_done = true;
+	return nullptr;
+}
+
+/**
+ * A consumer racing a producer that keeps overwriting.
+ *
+ * Small rings wrap the slot index constantly, which is where a stale tail
+ * could be mistaken for a current one.
+ */
+int
+race(unsigned size)
+{
+	struct report r;
+
+	ring = new device::RingBuffer<struct report>(size);
+	producer_done = false;
+
+	pthread_t thread;
+	pthread_create(&thread, nullptr, producer, nullptr);
+
+	unsigned received = 0;
+	unsigned next = 0;
+
+	for (;;) {
+		bool done = producer_done;
+
+		while (ring->get(r)) {
+			if (r.check != ~r.seq)
+				return fail("torn report %u", r.seq);
+
+			if (r.seq < next)
+				return fail("report %u after %u", r.seq, next - 1);
+
+			next = r.seq + 1;
+			received++;
+		}
+
+		/* the ring was drained after the producer finished */
+		if (done)
+			break;
+	}
+
+	pthread_join(thread, nullptr);
+
+	if (received + ring->overflows() != produced)
+		return fail("%u received + overflows, expected %u", received + ring->overflows(), produced);
+
+	printf("ring of %u: %u of %u reports received, %u overflows\n", size, received, produced, ring->overflows());
+	delete ring;
+
+	return 0;
+}
+
+} // namespace
+
+int
+main(int argc, char *argv[])
+{
+	device::RingBuffer<struct report> small(3);
+	struct report r = {};
+	struct report out[4];
+
+	/* basic queue semantics */
+	if ((small.size() != 3) || !small.empty())
+		return fail("new ring not empty");
+
+	for (unsigned i = 0; i < 3; i++) {
+		r.seq = i;
+
+		if (!small.put(r))
+			return fail("put %u failed", i);
+	}
+
+	r.seq = 3;
+
+	if (!small.full() || small.put(r))
+		return fail("put into a full ring succeeded");
+
+	if (!small.force(r) || (small.overflows() != 1) || (small.count() != 3))
+		return fail("force into a full ring: %u overflows, %u queued", small.overflows(), small.count());
+
+	if (small.get(out, 4) != 3)
+		return fail("get of several reports");
+
+	for (unsigned i = 0; i < 3; i++) {
+		if (out[i].seq != i + 1)
+			return fail("report %u is %u", i + 1, out[i].seq);
+	}
+
+	if (!small.empty() || small.get(r))
+		return fail("get from an empty ring succeeded");
+
+	if (!small.resize(0) || small.put(r) || small.force(r))
+		return fail("freed ring accepted a report");
+
+	/* racing producer and consumer, over several ring sizes and runs */
+	const unsigned sizes[] = { 1, 2, 3, 8 };
+
+	for (unsigned run = 0; run < 3; run++) {
+		for (unsigned i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+			if (race(sizes[i]))
+				return 1;
+		}
+	}
+
+	printf("PASS\n");
+	return 0;
+}
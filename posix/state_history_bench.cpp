@@ -0,0 +1,140 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2012 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file Cost of fusing a delayed GPS fix on the host: carried forward
+ * through the state history, against re-running the filter from the
+ * measurement time.
+ *
+ * Absolute numbers reflect the host, not the target; the benchmark is meant
+ * for comparing the approaches.
+ */
+
+#include <nuttx/config.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#include <position_estimator/state_history.h>
+
+extern "C" {
+#include <position_estimator/codegen/position_estimator.h>
+}
+
+#include "test_util.h"
+
+namespace
+{
+
+const unsigned	N = STATE_HISTORY_STATES;
+const unsigned	fixes = 20000;
+const unsigned	age = 150000 / 4000;	/* steps, for a fix 150 ms old */
+const float	gps_covariance[3] = { 1.0f, 1.0f, 4.0f };
+const float	z_none[3] = { 0, 0, 0 };
+
+state_history_s	history;
+
+/** a full history of predictions, ending at the returned state */
+void
+record(float x[N], float P[N * N])
+{
+	const float u[2] = { 0.01f, -0.01f };
+	float x_pred[N], P_pred[N * N];
+
+	memset(x, 0, N * sizeof(float));
+	memset(P, 0, N * N * sizeof(float));
+
+	for (unsigned i = 0; i < N; i++)
+		P[i + N * i] = 3.0f;
+
+	state_history_reset(&history);
+
+	for (unsigned i = 0; i < STATE_HISTORY_LENGTH; i++) {
+		position_estimator(u, z_none, x, P, gps_covariance, 1, x_pred, P_pred);
+		memcpy(x, x_pred, N * sizeof(float));
+		memcpy(P, P_pred, N * N * sizeof(float));
+		state_history_push(&history, i, u, x, P);
+	}
+}
+
+} // namespace
+
+int
+main(int argc, char *argv[])
+{
+	float x[N], P[N * N], x_new[N], P_new[N * N];
+	float z[3] = { 1.0f, -1.0f, 0.5f };
+	uint64_t fix_time = STATE_HISTORY_LENGTH - 1 - age;
+
+	record(x, P);
+
+	/* through the history; each fix corrects the last, so the work can't be hoisted */
+	uint64_t start = now_ns();
+
+	for (unsigned f = 0; f < fixes; f++) {
+		z[0] = 0.001f * (f & 7);
+		state_history_fuse(&history, fix_time, z, gps_covariance, x, P);
+	}
+
+	double carried = (double)(now_ns() - start) / fixes;
+
+	/* re-running the filter: the update step, then a prediction for each later one */
+	record(x, P);
+	unsigned first = (history.newest + STATE_HISTORY_LENGTH - age - 1) % STATE_HISTORY_LENGTH;
+
+	start = now_ns();
+
+	for (unsigned f = 0; f < fixes; f++) {
+		unsigned k = first;
+		z[0] = 0.001f * (f & 7);
+
+		memcpy(x, history.x[k], sizeof(x));
+		memcpy(P, history.P[k], sizeof(P));
+
+		for (unsigned step = 0; step <= age; step++) {
+			k = (k + 1) % STATE_HISTORY_LENGTH;
+			position_estimator(history.u[k], z, x, P, gps_covariance, (step == 0) ? 0 : 1, x_new, P_new);
+			memcpy(x, x_new, sizeof(x));
+			memcpy(P, P_new, sizeof(P));
+		}
+	}
+
+	double replayed = (double)(now_ns() - start) / fixes;
+
+	printf("fix %u steps old:\n", age);
+	printf("%-24s %8.1f ns/fix\n", "state_history_fuse", carried);
+	printf("%-24s %8.1f ns/fix\n", "re-run filter", replayed);
+	printf("speedup: %.1fx\n", replayed / carried);
+	return 0;
+}
@@ -0,0 +1,227 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2012 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file Checks the position estimator's delayed GPS fusion.
+ */
+
+#include <nuttx/config.h>
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#include <position_estimator/state_history.h>
+
+extern "C" {
+#include <position_estimator/codegen/position_estimator.h>
+}
+
+#include "test_util.h"
+
+namespace
+{
+
+const unsigned	N = STATE_HISTORY_STATES;
+const uint64_t	step_us = 4000;
+const float	gps_covariance[3] = { 1.0f, 1.0f, 4.0f };
+
+state_history_s	history;
+
+void
+initial(float x[N], float P[N * N])
+{
+	memset(x, 0, N * sizeof(float));
+	memset(P, 0, N * N * sizeof(float));
+
+	for (unsigned i = 0; i < N; i++)
+		P[i + N * i] = 3.0f;
+}
+
+} // namespace
+
+int
+main(int argc, char *argv[])
+{
+	/*
+	 * Fusing into the history must give what re-running the filter from
+	 * the measurement time would: record a run, then replay it with the
+	 * measurements applied at their steps.
+	 */
+	const unsigned	run = 200;
+	const unsigned	fix_step[2] = { 100, 130 };
+	const unsigned	fix_at[2] = { 140, 175 };	/* steps at which each fix arrives */
+	float		u[run][2];
+	float		fix_z[2][3];
+	float		x[N], P[N * N], x_pred[N], P_pred[N * N];
+
+	for (unsigned i = 0; i < run; i++) {
+		u[i][0] = 0.01f * noise();
+		u[i][1] = 0.01f * noise();
+	}
+
+	for (unsigned f = 0; f < 2; f++) {
+		for (unsigned i = 0; i < 3; i++)
+			fix_z[f][i] = 2.0f * noise();
+	}
+
+	const float	z_none[3] = { 0, 0, 0 };
+
+	state_history_reset(&history);
+	initial(x, P);
+
+	for (unsigned i = 0; i < run; i++) {
+		position_estimator(u[i], z_none, x, P, gps_covariance, 1, x_pred, P_pred);
+		memcpy(x, x_pred, sizeof(x));
+		memcpy(P, P_pred, sizeof(P));
+		state_history_push(&history, i * step_us, u[i], x, P);
+
+		for (unsigned f = 0; f < 2; f++) {
+			/* measurement times between steps belong to the earlier one */
+			if ((i == fix_at[f]) &&
+			    !state_history_fuse(&history, fix_step[f] * step_us + step_us / 2, fix_z[f], gps_covariance, x, P))
+				return fail("fix %u at step %u rejected", f, i);
+		}
+	}
+
+	float x_ref[N], P_ref[N * N];
+	initial(x_ref, P_ref);
+
+	for (unsigned i = 0; i < run; i++) {
+		const float *z = z_none;
+		uint8_t predict_only = 1;
+
+		for (unsigned f = 0; f < 2; f++) {
+			if (i == fix_step[f]) {
+				z = fix_z[f];
+				predict_only = 0;
+			}
+		}
+
+		position_estimator(u[i], z, x_ref, P_ref, gps_covariance, predict_only, x_pred, P_pred);
+		memcpy(x_ref, x_pred, sizeof(x_ref));
+		memcpy(P_ref, P_pred, sizeof(P_ref));
+	}
+
+	if (!(difference(x_ref, x, N) < 1e-4) || !(difference(P_ref, P, N * N) < 1e-4))
+		return fail("fused state differs from replay by %g, covariance by %g",
+			    difference(x_ref, x, N), difference(P_ref, P, N * N));
+
+	printf("delayed fusion against replay: state %.2g, covariance %.2g\n",
+	       difference(x_ref, x, N), difference(P_ref, P, N * N));
+
+	/* a fix older than the history is refused, and leaves the outputs alone */
+	float x_kept[N], P_kept[N * N];
+	memcpy(x_kept, x, sizeof(x));
+	memcpy(P_kept, P, sizeof(P));
+
+	if (state_history_fuse(&history, (run - STATE_HISTORY_LENGTH) * step_us, fix_z[0], gps_covariance, x, P))
+		return fail("fix older than the history accepted");
+
+	if (memcmp(x, x_kept, sizeof(x)) || memcmp(P, P_kept, sizeof(P)))
+		return fail("rejected fix changed the state");
+
+	/* the step the fix falls on needs its predecessor */
+	state_history_reset(&history);
+	state_history_push(&history, 0, u[0], x, P);
+
+	if (state_history_fuse(&history, 0, fix_z[0], gps_covariance, x, P))
+		return fail("fix accepted without a step before it");
+
+	/*
+	 * A vehicle moving at constant velocity, with 5 Hz fixes that arrive
+	 * 150 ms late: fused as current they drag the estimate back along the
+	 * track, fused at their time they don't.
+	 */
+	const unsigned	flight = 5000;
+	const unsigned	latency = 150000 / step_us;
+	const float	v[3] = { 4.0f, -3.0f, 0.5f };
+	const float	u_level[2] = { 0, 0 };
+	float		x_naive[N], P_naive[N * N];
+	double		err_naive = 0, err_fused = 0;
+	unsigned	compared = 0;
+
+	state_history_reset(&history);
+	initial(x, P);
+	initial(x_naive, P_naive);
+
+	for (unsigned i = 0; i < flight; i++) {
+		position_estimator(u_level, z_none, x, P, gps_covariance, 1, x_pred, P_pred);
+		memcpy(x, x_pred, sizeof(x));
+		memcpy(P, P_pred, sizeof(P));
+		state_history_push(&history, i * step_us, u_level, x, P);
+
+		bool fix = (i >= latency) && ((i % 50) == 0);
+		float z[3];
+
+		if (fix) {
+			float t = (i - latency) * STATE_HISTORY_DT;
+
+			for (unsigned j = 0; j < 3; j++)
+				z[j] = v[j] * t + 0.1f * noise();
+
+			if (!state_history_fuse(&history, (i - latency) * step_us, z, gps_covariance, x, P))
+				return fail("fix at step %u rejected", i);
+		}
+
+		position_estimator(u_level, z, x_naive, P_naive, gps_covariance, fix ? 0 : 1, x_pred, P_pred);
+		memcpy(x_naive, x_pred, sizeof(x_naive));
+		memcpy(P_naive, P_pred, sizeof(P_naive));
+
+		if (i < flight / 2)
+			continue;
+
+		float t = i * STATE_HISTORY_DT;
+
+		for (unsigned j = 0; j < 3; j++) {
+			float truth = v[j] * t;
+			err_naive += (x_naive[2 * j] - truth) * (x_naive[2 * j] - truth);
+			err_fused += (x[2 * j] - truth) * (x[2 * j] - truth);
+		}
+
+		compared++;
+	}
+
+	err_naive = sqrt(err_naive / compared);
+	err_fused = sqrt(err_fused / compared);
+
+	printf("150 ms GPS latency: rms position error fused as current %.2f m, at measurement time %.2f m\n",
+	       err_naive, err_fused);
+
+	if (!(err_fused < 0.5 * err_naive))
+		return fail("delayed fusion error %g m, fused as current %g m", err_fused, err_naive);
+
+	printf("PASS\n");
+	return 0;
+}
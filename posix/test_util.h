@@ -0,0 +1,100 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2012 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file Helpers shared by the host tests and benchmarks.
+ */
+
+#ifndef _POSIX_TEST_UTIL_H
+#define _POSIX_TEST_UTIL_H
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+
+/**
+ * Report a failed check.
+ *
+ * @param reason	printf format describing the failure, followed by
+ *			its arguments.
+ * @return		1, so that a test can return fail(...) from main.
+ */
+inline int __attribute__((format(printf, 1, 2)))
+fail(const char *reason, ...)
+{
+	va_list ap;
+
+	va_start(ap, reason);
+	fprintf(stderr, "FAIL: ");
+	vfprintf(stderr, reason, ap);
+	fprintf(stderr, "\n");
+	va_end(ap);
+
+	return 1;
+}
+
+/** deterministic noise in [-1, 1] */
+inline float
+noise()
+{
+	static uint32_t state = 1;
+	state = state * 1664525u + 1013904223u;
+	return (float)(int32_t)state / 2147483648.0f;
+}
+
+/** largest difference relative to the largest reference value */
+inline double
+difference(const float *ref, const float *val, unsigned n)
+{
+	double diff = 0, scale = 0;
+
+	for (unsigned i = 0; i < n; i++) {
+		diff = fmax(diff, fabs((double)ref[i] - val[i]));
+		scale = fmax(scale, fabs((double)ref[i]));
+	}
+
+	return diff / fmax(scale, 1e-20);
+}
+
+/** monotonic time for the benchmarks */
+inline uint64_t
+now_ns()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+#endif /* _POSIX_TEST_UTIL_H */
@@ -0,0 +1,543 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2012 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file uORB latency and throughput benchmarks for the host build.
+ *
+ * Measures orb_publish and orb_copy cost against topic size, and the
+ * publish->poll wakeup latency and publish cost against the number of
+ * subscribers blocked in poll(), the CPU cost of waiting on many
+ * topics with poll() and with a wait set, and the cost of CDev poll waiter
+ * bookkeeping against the number of waiters. Absolute numbers reflect the host, not
+ * the target; the benchmarks are meant for comparing uORB changes.
+ */
+
+#include <nuttx/config.h>
+
+#include <drivers/drv_orb_dev.h>
+#include <drivers/device/device.h>
+#include <arch/board/up_hrt.h>
+
+#include <pthread.h>
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <errno.h>
+#include <time.h>
+#include <stdlib.h>
+
+extern "C" int uorb_main(int argc, char *argv[]);
+
+namespace
+{
+
+template <unsigned _size>
+struct bench_topic {
+	hrt_abstime	timestamp;
+	uint8_t		payload[_size - sizeof(hrt_abstime)];
+};
+
+ORB_DEFINE(bench_16, struct bench_topic<16>);
+ORB_DEFINE(bench_64, struct bench_topic<64>);
+ORB_DEFINE(bench_256, struct bench_topic<256>);
+ORB_DEFINE(bench_1024, struct bench_topic<1024>);
+ORB_DEFINE(bench_latency, struct bench_topic<64>);
+ORB_DEFINE(bench_set0, struct bench_topic<64>);
+ORB_DEFINE(bench_set1, struct bench_topic<64>);
+ORB_DEFINE(bench_set2, struct bench_topic<64>);
+ORB_DEFINE(bench_set3, struct bench_topic<64>);
+ORB_DEFINE(bench_set4, struct bench_topic<64>);
+ORB_DEFINE(bench_set5, struct bench_topic<64>);
+ORB_DEFINE(bench_set6, struct bench_topic<64>);
+ORB_DEFINE(bench_set7, struct bench_topic<64>);
+ORB_DEFINE(bench_set8, struct bench_topic<64>);
+ORB_DEFINE(bench_set9, struct bench_topic<64>);
+
+const struct orb_metadata *const set_topics[] = {
+	ORB_ID(bench_set0), ORB_ID(bench_set1), ORB_ID(bench_set2), ORB_ID(bench_set3), ORB_ID(bench_set4),
+	ORB_ID(bench_set5), ORB_ID(bench_set6), ORB_ID(bench_set7), ORB_ID(bench_set8), ORB_ID(bench_set9),
+};
+
+static const unsigned	set_size = sizeof(set_topics) / sizeof(set_topics[0]);
+static const unsigned	set_updates = 5000;
+
+static const hrt_abstime throughput_duration = 200000;	/**< microseconds per size */
+static const unsigned	latency_updates = 2000;
+static const unsigned	latency_max_subscribers = 32;
+static const unsigned	waiters_max = 64;
+
+/**
+ * Time orb_publish and orb_copy on a topic with one subscriber.
+ */
+template <unsigned _size>
+void
+bench_throughput(const struct orb_metadata *meta)
+{
+	struct bench_topic<_size> t;
+	hrt_abstime start, elapsed;
+	unsigned count;
+
+	memset(&t, 0, sizeof(t));
+
+	int pfd = orb_advertise(meta, &t);
+	int sfd = orb_subscribe(meta);
+
+	if ((pfd < 0) || (sfd < 0)) {
+		fprintf(stderr, "%s: advertise/subscribe failed: %d\n", meta->o_name, errno);
+		return;
+	}
+
+	start = hrt_absolute_time();
+	count = 0;
+
+	do {
+		orb_publish(meta, pfd, &t);
+		count++;
+	} while ((elapsed = hrt_absolute_time() - start) < throughput_duration);
+
+	double publish_ns = (elapsed * 1000.0) / count;
+
+	start = hrt_absolute_time();
+	count = 0;
+
+	do {
+		orb_copy(meta, sfd, &t);
+		count++;
+	} while ((elapsed = hrt_absolute_time() - start) < throughput_duration);
+
+	double copy_ns = (elapsed * 1000.0) / count;
+
+	orb_sub_t sub = orb_subscribe_direct(meta);
+
+	if (sub == nullptr) {
+		fprintf(stderr, "%s: direct subscribe failed: %d\n", meta->o_name, errno);
+		return;
+	}
+
+	start = hrt_absolute_time();
+	count = 0;
+
+	do {
+		orb_copy_direct(meta, sub, &t);
+		count++;
+	} while ((elapsed = hrt_absolute_time() - start) < throughput_duration);
+
+	double direct_ns = (elapsed * 1000.0) / count;
+
+	printf("%6u  %12.0f  %12.0f  %10.1f  %12.0f\n", _size, publish_ns, copy_ns,
+	       (_size * 1000.0) / copy_ns, direct_ns);
+
+	orb_unsubscribe_direct(sub);
+	orb_unsubscribe(sfd);
+	close(pfd);
+}
+
+/**
+ * Time subscribing to and unsubscribing from an existing topic.
+ */
+void
+bench_subscribe(const struct orb_metadata *meta)
+{
+	hrt_abstime start, elapsed;
+	unsigned count;
+
+	start = hrt_absolute_time();
+	count = 0;
+
+	do {
+		orb_unsubscribe(orb_subscribe(meta));
+		count++;
+	} while ((elapsed = hrt_absolute_time() - start) < throughput_duration);
+
+	double fd_ns = (elapsed * 1000.0) / count;
+
+	start = hrt_absolute_time();
+	count = 0;
+
+	do {
+		orb_unsubscribe_direct(orb_subscribe_direct(meta));
+		count++;
+	} while ((elapsed = hrt_absolute_time() - start) < throughput_duration);
+
+	double direct_ns = (elapsed * 1000.0) / count;
+
+	printf("%12.0f  %12.0f\n", fd_ns, direct_ns);
+}
+
+volatile bool	set_done;
+volatile unsigned set_handled;
+hrt_abstime	set_cpu;
+
+hrt_abstime
+thread_cpu_time()
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+	return (ts.tv_sec * 1000000ULL) + (ts.tv_nsec / 1000);
+}
+
+/**
+ * Wait on all the set topics with poll() and copy whatever updated.
+ */
+void *
+set_poll_thread(void *arg)
+{
+	struct pollfd fds[set_size];
+	struct bench_topic<64> t;
+
+	for (unsigned i = 0; i < set_size; i++) {
+		fds[i].fd = orb_subscribe(set_topics[i]);
+		fds[i].events = POLLIN;
+	}
+
+	hrt_abstime start = thread_cpu_time();
+
+	while (!set_done) {
+		if (poll(fds, set_size, 100) < 1)
+			continue;
+
+		for (unsigned i = 0; i < set_size; i++) {
+			if (fds[i].revents & POLLIN) {
+				orb_copy(set_topics[i], fds[i].fd, &t);
+				set_handled++;
+			}
+		}
+	}
+
+	set_cpu = thread_cpu_time() - start;
+
+	for (unsigned i = 0; i < set_size; i++)
+		orb_unsubscribe(fds[i].fd);
+
+	return nullptr;
+}
+
+/**
+ * Wait on all the set topics with a wait set and copy whatever updated.
+ */
+void *
+set_waitset_thread(void *arg)
+{
+	int subs[set_size];
+	struct bench_topic<64> t;
+	orb_waitset_t ws = orb_waitset_create();
+
+	for (unsigned i = 0; i < set_size; i++) {
+		subs[i] = orb_subscribe(set_topics[i]);
+		orb_waitset_add(ws, subs[i]);
+	}
+
+	hrt_abstime start = thread_cpu_time();
+
+	while (!set_done) {
+		uint32_t ready;
+
+		if (orb_waitset_wait(ws, 100, &ready) < 1)
+			continue;
+
+		for (unsigned i = 0; i < set_size; i++) {
+			if (ready & (1 << i)) {
+				orb_copy(set_topics[i], subs[i], &t);
+				set_handled++;
+			}
+		}
+	}
+
+	set_cpu = thread_cpu_time() - start;
+
+	orb_waitset_destroy(ws);
+
+	for (unsigned i = 0; i < set_size; i++)
+		orb_unsubscribe(subs[i]);
+
+	return nullptr;
+}
+
+/**
+ * Publish to the set topics in turn while a thread waits on all of them,
+ * and report the waiting thread's CPU time per update.
+ */
+void
+bench_set(const char *name, void *(*thread)(void *))
+{
+	struct bench_topic<64> t;
+	int pfds[set_size];
+	pthread_t waiter;
+
+	memset(&t, 0, sizeof(t));
+
+	for (unsigned i = 0; i < set_size; i++)
+		pfds[i] = orb_advertise(set_topics[i], &t);
+
+	set_done = false;
+	set_handled = 0;
+	pthread_create(&waiter, nullptr, thread, nullptr);
+
+	/* let the waiter subscribe before the first update */
+	usleep(10000);
+
+	for (unsigned i = 0; i < set_updates; i++) {
+		orb_publish(set_topics[i % set_size], pfds[i % set_size], &t);
+		usleep(50);
+	}
+
+	usleep(10000);
+	set_done = true;
+	pthread_join(waiter, nullptr);
+
+	printf("%-8s  %8u  %12.2f\n", name, set_handled,
+	       (set_handled > 0) ? ((double)set_cpu / set_handled) : 0.0);
+
+	for (unsigned i = 0; i < set_size; i++)
+		close(pfds[i]);
+}
+
+struct latency_subscriber {
+	pthread_t	thread;
+	unsigned	wakeups;
+	hrt_abstime	total;
+	hrt_abstime	max;
+};
+
+volatile bool	latency_done;
+
+/**
+ * Wait for updates and record how long after publication each was seen.
+ */
+void *
+latency_subscriber_thread(void *arg)
+{
+	struct latency_subscriber *s = (struct latency_subscriber *)arg;
+	struct bench_topic<64> t;
+	struct pollfd fds;
+
+	fds.fd = orb_subscribe(ORB_ID(bench_latency));
+	fds.events = POLLIN;
+
+	if (fds.fd < 0)
+		return nullptr;
+
+	while (!latency_done) {
+		if (poll(&fds, 1, 100) < 1)
+			continue;
+
+		orb_copy(ORB_ID(bench_latency), fds.fd, &t);
+
+		hrt_abstime latency = hrt_absolute_time() - t.timestamp;
+
+		s->wakeups++;
+		s->total += latency;
+
+		if (latency > s->max)
+			s->max = latency;
+	}
+
+	orb_unsubscribe(fds.fd);
+
+	return nullptr;
+}
+
+/**
+ * Publish to a number of subscribers blocked in poll() and measure the
+ * publish cost and the wakeup latency.
+ */
+void
+bench_latency(unsigned subscribers)
+{
+	struct latency_subscriber subs[latency_max_subscribers];
+	struct bench_topic<64> t;
+
+	memset(&t, 0, sizeof(t));
+	memset(subs, 0, sizeof(subs));
+	latency_done = false;
+
+	int pfd = orb_advertise(ORB_ID(bench_latency), &t);
+
+	if (pfd < 0) {
+		fprintf(stderr, "latency: advertise failed: %d\n", errno);
+		return;
+	}
+
+	for (unsigned i = 0; i < subscribers; i++)
+		pthread_create(&subs[i].thread, nullptr, latency_subscriber_thread, &subs[i]);
+
+	/* let the subscribers settle into poll() */
+	usleep(100000);
+
+	hrt_abstime publish_total = 0;
+
+	for (unsigned i = 0; i < latency_updates; i++) {
+		t.timestamp = hrt_absolute_time();
+		orb_publish(ORB_ID(bench_latency), pfd, &t);
+		publish_total += hrt_absolute_time() - t.timestamp;
+
+		/* give every subscriber time to collect the update */
+		usleep(500);
+	}
+
+	latency_done = true;
+
+	unsigned wakeups = 0;
+	hrt_abstime total = 0;
+	hrt_abstime max = 0;
+
+	for (unsigned i = 0; i < subscribers; i++) {
+		pthread_join(subs[i].thread, nullptr);
+		wakeups += subs[i].wakeups;
+		total += subs[i].total;
+
+		if (subs[i].max > max)
+			max = subs[i].max;
+	}
+
+	printf("%11u  %12.2f  %12.2f  %8llu  %8u\n", subscribers,
+	       (double)publish_total / latency_updates,
+	       wakeups ? ((double)total / wakeups) : 0.0,
+	       (unsigned long long)max, wakeups);
+
+	close(pfd);
+}
+
+/**
+ * A device whose poll_notify can be called directly.
+ */
+class BenchDev : public device::CDev
+{
+public:
+	BenchDev() : CDev("bench_poll", "/dev/bench_poll") {}
+
+	void		notify() { poll_notify(POLLIN); }
+};
+
+/**
+ * Time poll_notify, and a poll setup and teardown, on a device with a
+ * number of polls in progress.
+ */
+void
+bench_waiters(unsigned waiters)
+{
+	BenchDev dev;
+	struct file filp;
+	struct pollfd fds[waiters_max + 1];
+	struct poll_sem sems[waiters_max + 1];
+	hrt_abstime start, elapsed;
+	unsigned count;
+
+	memset(&filp, 0, sizeof(filp));
+	memset(sems, 0, sizeof(sems));
+
+	for (unsigned i = 0; i <= waiters; i++) {
+		fds[i].fd = i;
+		fds[i].sem = &sems[i];
+		fds[i].events = POLLIN;
+		fds[i].revents = 0;
+	}
+
+	for (unsigned i = 0; i < waiters; i++) {
+		if (OK != dev.poll(&filp, &fds[i], true)) {
+			printf("%8u  poll setup failed\n", waiters);
+			return;
+		}
+	}
+
+	start = hrt_absolute_time();
+	count = 0;
+
+	do {
+		dev.notify();
+		count++;
+	} while ((elapsed = hrt_absolute_time() - start) < throughput_duration);
+
+	double notify_ns = (elapsed * 1000.0) / count;
+
+	/* one more poll coming and going while the others wait */
+	start = hrt_absolute_time();
+	count = 0;
+
+	do {
+		dev.poll(&filp, &fds[waiters], true);
+		dev.poll(&filp, &fds[waiters], false);
+		count++;
+	} while ((elapsed = hrt_absolute_time() - start) < throughput_duration);
+
+	double setup_ns = (elapsed * 1000.0) / count;
+
+	for (unsigned i = 0; i < waiters; i++)
+		dev.poll(&filp, &fds[i], false);
+
+	printf("%8u  %10.0f  %10.1f  %12.0f\n", waiters, notify_ns, notify_ns / waiters, setup_ns);
+}
+
+} // namespace
+
+int
+main(int argc, char *argv[])
+{
+	char *start[] = { (char *)"uorb", (char *)"start", nullptr };
+
+	if (OK != uorb_main(2, start))
+		return 1;
+
+	printf("\norb_publish / orb_copy cost by topic size\n");
+	printf("%6s  %12s  %12s  %10s  %12s\n", "bytes", "publish ns", "copy ns", "copy MB/s", "direct ns");
+	bench_throughput<16>(ORB_ID(bench_16));
+	bench_throughput<64>(ORB_ID(bench_64));
+	bench_throughput<256>(ORB_ID(bench_256));
+	bench_throughput<1024>(ORB_ID(bench_1024));
+
+	printf("\nsubscribe + unsubscribe cost\n");
+	printf("%12s  %12s\n", "file ns", "direct ns");
+	bench_subscribe(ORB_ID(bench_64));
+
+	printf("\nwaiting on %u topics, CPU time of the waiting thread\n", set_size);
+	printf("%-8s  %8s  %12s\n", "method", "updates", "us/update");
+	bench_set("poll", set_poll_thread);
+	bench_set("waitset", set_waitset_thread);
+
+	printf("\npublish -> poll wakeup by subscriber count (64 byte topic)\n");
+	printf("%11s  %12s  %12s  %8s  %8s\n", "subscribers", "publish us", "latency us", "max us", "wakeups");
+
+	for (unsigned n = 1; n <= latency_max_subscribers; n *= 2)
+		bench_latency(n);
+
+	printf("\nCDev poll waiters: poll_notify and poll setup + teardown cost\n");
+	printf("%8s  %10s  %10s  %12s\n", "waiters", "notify ns", "ns/waiter", "setup ns");
+
+	for (unsigned n = 1; n <= waiters_max; n *= 2)
+		bench_waiters(n);
+
+	return 0;
+}